@@ -0,0 +1,135 @@
+#include "btree.h"
+#include <glog/logging.h>
+
+using namespace innodb;
+
+uint16_t BTree::search_page(const IndexPageView &page, const SearchKey &key,
+                            SearchMode mode, const IndexDef &index,
+                            RecOffsets &offsets) {
+  const byte *pg = page.buf();
+  const ulint page_size = page.page_size();
+  auto goes_right = [&](uint16_t offset) {
+    int c = cmp_key_rec(key, pg + offset, index, offsets);
+    return c > 0 || (c == 0 && mode == SearchMode::LE);
+  };
+  auto valid_offset = [&](uint16_t offset) {
+    return offset >= PAGE_NEW_INFIMUM &&
+           offset < page_size - IndexPageDirectory::PAGE_DIR;
+  };
+  uint16_t n_slots = page.n_dir_slots();
+  if (n_slots < 2) {
+    LOG(ERROR) << "page " << page.page_no() << " has " << n_slots
+               << " directory slots";
+    return PAGE_NEW_INFIMUM;
+  }
+  // the slot 0 owns the infimum, the last one the supremum
+  uint32_t low = 0;
+  uint32_t up = n_slots - 1;
+  while (up - low > 1) {
+    uint32_t mid = (low + up) / 2;
+    uint16_t offset = mach_read_from_2(page.nth_slot(mid));
+    if (!valid_offset(offset)) {
+      LOG(ERROR) << "page " << page.page_no() << " slot " << mid
+                 << " points to " << offset;
+      return PAGE_NEW_INFIMUM;
+    }
+    if (goes_right(offset))
+      low = mid;
+    else
+      up = mid;
+  }
+  // walk the records owned by the up slot
+  uint16_t cur = mach_read_from_2(page.nth_slot(low));
+  uint16_t up_rec = mach_read_from_2(page.nth_slot(up));
+  if (!valid_offset(cur))
+    return PAGE_NEW_INFIMUM;
+  const uint32_t max_owned = IndexPageDirectory::PAGE_DIR_SLOT_MAX_N_OWNED;
+  for (uint32_t n = 0; n <= max_owned; ++n) {
+    uint16_t next = RecordHeader::next_offs(pg, cur, page_size);
+    if (next == up_rec || !valid_offset(next) || !goes_right(next))
+      break;
+    cur = next;
+  }
+  return cur;
+}
+
+template <typename Position> BTreeCursor BTree::descend(Position position) {
+  pages_visited_ = 0;
+  leaf_parent_ = UINT32_MAX;
+  uint32_t page_no = root_page_no_;
+  int32_t expected_level = -1;
+  for (uint32_t height = 0; height < BTR_MAX_LEVELS; ++height) {
+    PageGuard pg = reader_->fetch_page(page_no);
+    if (!pg) {
+      LOG(ERROR) << "btree search fails to read page " << page_no;
+      return BTreeCursor();
+    }
+    ++pages_visited_;
+    auto view = pg.as<IndexPageView>();
+    if (!fil_page_is_index(view.page_type()) || !view.is_compact()) {
+      LOG(ERROR) << "page " << page_no << " isn't a compact index page";
+      return BTreeCursor();
+    }
+    if (index_.index_id_ != 0 && view.index_id() != index_.index_id_) {
+      LOG(ERROR) << "page " << page_no << " belongs to index "
+                 << view.index_id() << ", expected " << index_.index_id_;
+      return BTreeCursor();
+    }
+    int32_t level = view.level();
+    if (expected_level >= 0 && level != expected_level) {
+      LOG(ERROR) << "page " << page_no << " is at level " << level
+                 << ", expected " << expected_level;
+      return BTreeCursor();
+    }
+    uint16_t offset = position(view);
+    if (level == 0) {
+      BTreeCursor cursor;
+      cursor.rec_ = RecordView(pg.buf(), offset);
+      cursor.page_no_ = page_no;
+      cursor.page_ = std::move(pg);
+      return cursor;
+    }
+    const byte *rec = pg.buf() + offset;
+    if (offset == PAGE_NEW_INFIMUM || !offsets_.init(rec, index_) ||
+        !offsets_.node_ptr()) {
+      LOG(ERROR) << "no node pointer found on page " << page_no;
+      return BTreeCursor();
+    }
+    if (level == 1)
+      leaf_parent_ = page_no;
+    page_no = offsets_.child_page_no(rec);
+    expected_level = level - 1;
+  }
+  LOG(ERROR) << "btree with root " << root_page_no_ << " is higher than "
+             << BTR_MAX_LEVELS;
+  return BTreeCursor();
+}
+
+BTreeCursor BTree::search(const SearchKey &key, SearchMode mode) {
+  return descend([&](const IndexPageView &view) {
+    return search_page(view, key, mode, index_, offsets_);
+  });
+}
+
+BTreeCursor BTree::first() {
+  return descend([](const IndexPageView &view) -> uint16_t {
+    if (view.level() == 0)
+      return PAGE_NEW_INFIMUM;
+    // the min rec of the level, the leftmost child
+    return RecordHeader::next_offs(view.buf(), PAGE_NEW_INFIMUM,
+                                   view.page_size());
+  });
+}
+
+BTreeCursor BTree::lookup(const SearchKey &key) {
+  if (key.size() < index_.n_uniq_) {
+    LOG(ERROR) << "lookup key has " << key.size() << " fields, "
+               << index_.n_uniq_ << " needed";
+    return BTreeCursor();
+  }
+  BTreeCursor cursor = search(key, SearchMode::LE);
+  if (!cursor.valid() || !cursor.rec_.is_user_rec() ||
+      cmp_key_rec(key, cursor.rec_.data(), index_, offsets_) != 0)
+    return BTreeCursor();
+  return cursor;
+}
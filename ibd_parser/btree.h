@@ -0,0 +1,84 @@
+#pragma once
+#include "file_space_reader.h"
+#include "index_def.h"
+#include "rec_offsets.h"
+#include "record_iterator.h"
+
+namespace innodb {
+
+/// @brief how a search positions on a page, like PAGE_CUR_L and PAGE_CUR_LE
+/// of innodb
+enum class SearchMode {
+  L,  // the last record less than the key
+  LE, // the last record less than or equal to the key
+};
+
+/// @brief a record of the tree, its page stays pinned while the cursor
+/// holds it
+struct BTreeCursor {
+  PageGuard page_;
+  uint32_t page_no_ = UINT32_MAX;
+  RecordView rec_; // may be the infimum of the leaf
+  bool valid() const { return static_cast<bool>(page_); }
+};
+
+/// @brief read only access to one B+tree of a tablespace
+class BTree {
+public:
+  /// the tree is never this high, a deeper descent means a corrupt tree
+  static constexpr uint32_t BTR_MAX_LEVELS = 100;
+
+  BTree(FileSpaceReader *reader, uint32_t root_page_no, const IndexDef &index)
+      : reader_(reader), root_page_no_(root_page_no), index_(index) {}
+
+  /// @brief descend from the root to the leaf with the key, at every level
+  /// binary search the page directory then walk the owned records of the
+  /// slot. Non leaf levels are searched with SearchMode::L for a L search
+  /// and SearchMode::LE for a LE one.
+  /// @return the cursor on the leaf record, invalid if a page is unreadable
+  /// or the tree is corrupt
+  BTreeCursor search(const SearchKey &key, SearchMode mode);
+
+  /// @brief find the record with the key, the key must have all the n_uniq
+  /// fields to identify one record
+  /// @return the cursor on the record, invalid if not found
+  BTreeCursor lookup(const SearchKey &key);
+
+  /// @brief descend along the leftmost node pointers to the first leaf
+  /// @return the cursor on the infimum of the leftmost leaf, invalid if a
+  /// page is unreadable or the tree is corrupt
+  BTreeCursor first();
+
+  /// @brief pages read by the last search, the tree height
+  uint32_t pages_visited() const { return pages_visited_; }
+  /// @brief the level 1 page passed by the last search, the parent of the
+  /// found leaf, UINT32_MAX if the root is a leaf
+  uint32_t leaf_parent() const { return leaf_parent_; }
+
+  FileSpaceReader *reader() const { return reader_; }
+  const IndexDef &index() const { return index_; }
+  uint32_t root_page_no() const { return root_page_no_; }
+
+  /// @brief position on the page with the directory, the records of the
+  /// page must be compact
+  /// @return the offset of the found record, the infimum if all the
+  /// records are greater
+  static uint16_t search_page(const IndexPageView &page, const SearchKey &key,
+                              SearchMode mode, const IndexDef &index,
+                              RecOffsets &offsets);
+
+private:
+  /// @brief descend from the root, position(const IndexPageView &) returns
+  /// the offset of the record to follow on each page
+  template <typename Position> BTreeCursor descend(Position position);
+
+private:
+  FileSpaceReader *reader_;
+  uint32_t root_page_no_;
+  IndexDef index_;
+  RecOffsets offsets_;
+  uint32_t pages_visited_ = 0;
+  uint32_t leaf_parent_ = UINT32_MAX;
+};
+
+} // namespace innodb
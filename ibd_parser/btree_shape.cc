@@ -0,0 +1,288 @@
+#include "btree_shape.h"
+#include "btree.h"
+#include <algorithm>
+#include <cmath>
+#include <glog/logging.h>
+#include <numeric>
+#include <random>
+
+using namespace innodb;
+
+namespace {
+
+/// @brief the mean of the samples and its interval
+ShapeEstimate mean_estimate(const std::vector<double> &samples) {
+  const size_t n = samples.size();
+  double mean = 0;
+  for (double v : samples)
+    mean += v;
+  mean /= n;
+  if (n < 2)
+    return ShapeEstimate::exact(mean);
+  double sq = 0;
+  for (double v : samples)
+    sq += (v - mean) * (v - mean);
+  double half =
+      BTreeShapeAnalyzer::CONFIDENCE_Z * std::sqrt(sq / (n - 1) / n);
+  return {mean, std::max(0.0, mean - half), mean + half};
+}
+
+/// @brief sum(num) / sum(den) and its interval by the linearization of the
+/// ratio estimator
+ShapeEstimate ratio_estimate(const std::vector<double> &num,
+                             const std::vector<double> &den) {
+  const size_t n = num.size();
+  double sum_num = 0;
+  double sum_den = 0;
+  for (size_t i = 0; i < n; ++i) {
+    sum_num += num[i];
+    sum_den += den[i];
+  }
+  if (sum_den == 0)
+    return ShapeEstimate();
+  const double ratio = sum_num / sum_den;
+  if (n < 2)
+    return ShapeEstimate::exact(ratio);
+  double sq = 0;
+  for (size_t i = 0; i < n; ++i) {
+    double e = num[i] - ratio * den[i];
+    sq += e * e;
+  }
+  const double mean_den = sum_den / n;
+  double half = BTreeShapeAnalyzer::CONFIDENCE_Z *
+                std::sqrt(sq / (n - 1) / n) / mean_den;
+  return {ratio, std::max(0.0, ratio - half), ratio + half};
+}
+
+/// @brief the bytes of the record heap of a page
+double heap_capacity(ulint page_size) {
+  return page_size - PAGE_NEW_SUPREMUM_END - FILHeader::FIL_PAGE_DATA_END;
+}
+
+} // namespace
+
+PageGuard BTreeShapeAnalyzer::fetch(uint32_t page_no, int32_t level) {
+  PageGuard pg = reader_->fetch_page(page_no);
+  if (!pg) {
+    LOG(ERROR) << "btree shape fails to read page " << page_no;
+    return PageGuard();
+  }
+  ++pages_read_;
+  auto view = pg.as<IndexPageView>();
+  if (!fil_page_is_index(view.page_type()) || !view.is_compact()) {
+    LOG(ERROR) << "page " << page_no << " isn't a compact index page";
+    return PageGuard();
+  }
+  if (index_.index_id_ != 0 && view.index_id() != index_.index_id_) {
+    LOG(ERROR) << "page " << page_no << " belongs to index "
+               << view.index_id() << ", expected " << index_.index_id_;
+    return PageGuard();
+  }
+  if (level >= 0 && view.level() != level) {
+    LOG(ERROR) << "page " << page_no << " is at level " << view.level()
+               << ", expected " << level;
+    return PageGuard();
+  }
+  return pg;
+}
+
+uint32_t BTreeShapeAnalyzer::nth_child(const IndexPageView &page,
+                                       uint32_t n) {
+  const ulint page_size = page.page_size();
+  uint16_t offset = PAGE_NEW_INFIMUM;
+  for (uint32_t i = 0; i <= n; ++i) {
+    offset = RecordHeader::next_offs(page.buf(), offset, page_size);
+    if (offset < PAGE_NEW_SUPREMUM_END ||
+        offset >= page_size - IndexPageDirectory::PAGE_DIR) {
+      LOG(ERROR) << "page " << page.page_no() << " has no record " << n;
+      return UINT32_MAX;
+    }
+  }
+  const byte *rec = page.buf() + offset;
+  if (!offsets_.init(rec, index_) || !offsets_.node_ptr()) {
+    LOG(ERROR) << "no node pointer found on page " << page.page_no();
+    return UINT32_MAX;
+  }
+  return offsets_.child_page_no(rec);
+}
+
+BTreeShape BTreeShapeAnalyzer::exact() {
+  BTreeShape s;
+  s.root_page_no_ = root_page_no_;
+  PageGuard root = fetch(root_page_no_, -1);
+  if (!root)
+    return s;
+  auto root_view = root.as<IndexPageView>();
+  s.index_id_ = root_view.index_id();
+  s.height_ = root_view.level() + 1;
+  root = PageGuard();
+  pages_read_ = 0; // the root is counted again when the tree is read
+  if (s.height_ > BTree::BTR_MAX_LEVELS) {
+    LOG(ERROR) << "btree with root " << root_page_no_ << " is higher than "
+               << BTree::BTR_MAX_LEVELS;
+    return s;
+  }
+
+  const uint32_t max_pages = reader_->get_page_count();
+  std::vector<uint64_t> pages(s.height_);
+  uint64_t node_ptrs = 0;
+  uint64_t leaf_recs = 0;
+  uint64_t leaf_bytes = 0;
+  uint64_t links = 0;
+  uint64_t contiguous = 0;
+  // every level from its leftmost page, the leftmost child of the level
+  // above
+  uint32_t first = root_page_no_;
+  for (int32_t level = s.height_ - 1; level >= 0; --level) {
+    uint32_t page_no = first;
+    first = UINT32_MAX;
+    while (page_no != UINT32_MAX) {
+      if (pages[level] >= max_pages) {
+        LOG(ERROR) << "the pages of level " << level << " of the btree with "
+                   << "root " << root_page_no_ << " form a cycle";
+        return s;
+      }
+      PageGuard pg = fetch(page_no, level);
+      if (!pg)
+        return s;
+      auto view = pg.as<IndexPageView>();
+      ++pages[level];
+      const uint32_t next = view.next_page();
+      if (level > 0) {
+        node_ptrs += view.n_recs();
+        if (first == UINT32_MAX &&
+            (first = nth_child(view, 0)) == UINT32_MAX)
+          return s;
+      } else {
+        leaf_recs += view.n_recs();
+        leaf_bytes += view.record_bytes();
+        if (next != UINT32_MAX) {
+          ++links;
+          contiguous += next == page_no + 1;
+        }
+      }
+      page_no = next;
+    }
+  }
+
+  for (uint64_t n : pages)
+    s.pages_per_level_.push_back(ShapeEstimate::exact(n));
+  const uint64_t non_leaf = std::accumulate(pages.begin() + 1, pages.end(),
+                                            (uint64_t)0);
+  s.avg_fanout_ =
+      ShapeEstimate::exact(non_leaf ? (double)node_ptrs / non_leaf : 0);
+  s.recs_per_leaf_ = ShapeEstimate::exact((double)leaf_recs / pages[0]);
+  s.fill_factor_ = ShapeEstimate::exact(
+      leaf_bytes / (pages[0] * heap_capacity(reader_->get_page_size())));
+  s.leaf_contiguity_ =
+      ShapeEstimate::exact(links ? (double)contiguous / links : 1);
+  s.pages_read_ = pages_read_;
+  s.valid_ = true;
+  return s;
+}
+
+BTreeShape BTreeShapeAnalyzer::sample(uint32_t n_samples, uint64_t seed) {
+  BTreeShape s;
+  s.root_page_no_ = root_page_no_;
+  s.exact_ = false;
+  PageGuard root = fetch(root_page_no_, -1);
+  if (!root || n_samples == 0)
+    return s;
+  auto root_view = root.as<IndexPageView>();
+  s.index_id_ = root_view.index_id();
+  s.height_ = root_view.level() + 1;
+  root = PageGuard();
+  pages_read_ = 0; // the root is counted again when the tree is read
+  if (s.height_ > BTree::BTR_MAX_LEVELS) {
+    LOG(ERROR) << "btree with root " << root_page_no_ << " is higher than "
+               << BTree::BTR_MAX_LEVELS;
+    return s;
+  }
+
+  const double capacity = heap_capacity(reader_->get_page_size());
+  std::mt19937_64 rng(seed);
+  // the estimate of every descent of the pages of each level
+  std::vector<std::vector<double>> level_pages(
+      s.height_, std::vector<double>(n_samples));
+  // the node pointers and the non leaf pages, the leaves are weighted by
+  // the estimate of the leaves
+  std::vector<double> node_ptrs(n_samples), non_leaf(n_samples);
+  std::vector<double> weights(n_samples), recs(n_samples);
+  std::vector<double> bytes(n_samples), contiguous(n_samples);
+  std::vector<double> linked(n_samples);
+  for (uint32_t i = 0; i < n_samples; ++i) {
+    uint32_t page_no = root_page_no_;
+    double product = 1;
+    for (int32_t level = s.height_ - 1; level >= 0; --level) {
+      PageGuard pg = fetch(page_no, level);
+      if (!pg)
+        return s;
+      auto view = pg.as<IndexPageView>();
+      level_pages[level][i] = product;
+      if (level == 0) {
+        weights[i] = product;
+        recs[i] = product * view.n_recs();
+        bytes[i] = product * view.record_bytes() / capacity;
+        // the last leaf has no next one to be contiguous with
+        linked[i] = product * (view.next_page() != UINT32_MAX);
+        contiguous[i] = product * (view.next_page() == page_no + 1);
+        break;
+      }
+      const uint32_t n_recs = view.n_recs();
+      if (n_recs == 0) {
+        LOG(ERROR) << "non leaf page " << page_no << " has no record";
+        return s;
+      }
+      non_leaf[i] += product;
+      node_ptrs[i] += product * n_recs;
+      page_no = nth_child(view, rng() % n_recs);
+      if (page_no == UINT32_MAX)
+        return s;
+      product *= n_recs;
+    }
+  }
+
+  for (const auto &samples : level_pages)
+    s.pages_per_level_.push_back(mean_estimate(samples));
+  if (s.height_ > 1)
+    s.avg_fanout_ = ratio_estimate(node_ptrs, non_leaf);
+  s.recs_per_leaf_ = ratio_estimate(recs, weights);
+  s.fill_factor_ = ratio_estimate(bytes, weights);
+  if (std::accumulate(linked.begin(), linked.end(), 0.0) > 0)
+    s.leaf_contiguity_ = ratio_estimate(contiguous, linked);
+  else
+    s.leaf_contiguity_ = ShapeEstimate::exact(1);
+  // a share can't exceed 1
+  s.leaf_contiguity_.high_ = std::min(1.0, s.leaf_contiguity_.high_);
+  s.n_samples_ = n_samples;
+  s.pages_read_ = pages_read_;
+  s.valid_ = true;
+  return s;
+}
+
+void BTreeShape::dump(std::ostringstream &oss) const {
+  auto print = [&oss](const char *name, const ShapeEstimate &e) {
+    oss << name << ": " << e.value_;
+    if (e.low_ != e.high_)
+      oss << " [" << e.low_ << ", " << e.high_ << "]";
+  };
+  oss << "BTreeShape of index " << index_id_ << " root " << root_page_no_
+      << (exact_ ? " exact" : " sampled") << ": height: " << height_
+      << ", pages read: " << pages_read_;
+  if (!exact_)
+    oss << ", samples: " << n_samples_;
+  oss << std::endl;
+  for (size_t l = 0; l < pages_per_level_.size(); ++l) {
+    oss << "level " << l << " ";
+    print("pages", pages_per_level_[l]);
+    oss << std::endl;
+  }
+  print("avg fanout", avg_fanout_);
+  oss << ", ";
+  print("fill factor", fill_factor_);
+  oss << ", ";
+  print("records per leaf", recs_per_leaf_);
+  oss << ", ";
+  print("leaf contiguity", leaf_contiguity_);
+  oss << std::endl;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "file_space_reader.h"
+#include "index_def.h"
+#include "rec_offsets.h"
+#include <sstream>
+#include <vector>
+
+namespace innodb {
+
+/// @brief a statistic of a tree, with its 95% confidence interval when it
+/// is estimated from samples, the interval is the value itself when exact
+struct ShapeEstimate {
+  double value_ = 0;
+  double low_ = 0;
+  double high_ = 0;
+
+  static ShapeEstimate exact(double value) { return {value, value, value}; }
+};
+
+/// @brief the shape of one B+tree
+struct BTreeShape {
+  uint64_t index_id_ = 0;
+  uint32_t root_page_no_ = UINT32_MAX;
+  uint32_t height_ = 0;
+  /// pages_per_level_[0] is the leaves, the root level has one page
+  std::vector<ShapeEstimate> pages_per_level_;
+  /// the children of a non leaf page, 0 if the root is a leaf
+  ShapeEstimate avg_fanout_;
+  /// the share of the record heap of the leaves taken by user records
+  ShapeEstimate fill_factor_;
+  ShapeEstimate recs_per_leaf_;
+  /// the share of the leaves whose next leaf is the next page of the file,
+  /// a range scan of a contiguous tree reads sequentially
+  ShapeEstimate leaf_contiguity_;
+  bool exact_ = true;
+  uint32_t n_samples_ = 0; // the descents of the sampling mode
+  uint64_t pages_read_ = 0;
+  bool valid_ = false;
+
+  void dump(std::ostringstream &oss) const;
+};
+
+/// @brief computes the shape of a B+tree, exactly by walking every level
+/// from left to right along the sibling links, or estimated from random
+/// descents. A descent follows a random node pointer of every non leaf
+/// page, so it reaches a leaf with the probability 1 / (the product of the
+/// fanouts on its path), and the product is an unbiased estimate of the
+/// leaves (Knuth's estimator), the partial products of the pages of the
+/// upper levels. The statistics of the leaves are averaged with the
+/// products as the weights, and the intervals come from the spread of the
+/// descents, so a few thousand pages are enough on a tree of any size.
+class BTreeShapeAnalyzer {
+public:
+  static constexpr uint32_t DEFAULT_SAMPLES = 1000;
+  /// the normal quantile of the 95% confidence intervals
+  static constexpr double CONFIDENCE_Z = 1.96;
+
+  /// @param index the fields of the node pointers, to find the child page
+  /// numbers, its index_id_ is checked on every page if not 0
+  BTreeShapeAnalyzer(FileSpaceReader *reader, uint32_t root_page_no,
+                     const IndexDef &index)
+      : reader_(reader), root_page_no_(root_page_no), index_(index) {}
+
+  /// @brief read every page of the tree
+  /// @return invalid if a page is unreadable or the tree is corrupt
+  BTreeShape exact();
+
+  /// @brief estimate from n_samples random descents from the root
+  BTreeShape sample(uint32_t n_samples = DEFAULT_SAMPLES, uint64_t seed = 0);
+
+private:
+  /// @brief fetch a page of the tree at the level, -1 for any level
+  PageGuard fetch(uint32_t page_no, int32_t level);
+  /// @brief the child of the nth user record of the non leaf page
+  /// @return UINT32_MAX if the page is corrupt
+  uint32_t nth_child(const IndexPageView &page, uint32_t n);
+
+private:
+  FileSpaceReader *reader_;
+  uint32_t root_page_no_;
+  IndexDef index_;
+  RecOffsets offsets_;
+  uint64_t pages_read_ = 0;
+};
+
+} // namespace innodb
@@ -0,0 +1,296 @@
+#include "checksum.h"
+#include "headers.h"
+#include "parallel_scanner.h"
+#include <algorithm>
+#include <cstring>
+#include <glog/logging.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+using namespace innodb;
+
+namespace {
+
+constexpr uint32_t CRC32C_POLY = 0x82F63B78U; // reflected Castagnoli
+
+/// @brief slice by 8 tables, table[0] is the classic byte table
+struct Crc32cTable {
+  uint32_t table_[8][256];
+  Crc32cTable() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c >> 1) ^ (CRC32C_POLY & (0U - (c & 1)));
+      table_[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (int t = 1; t < 8; ++t)
+        table_[t][i] =
+            (table_[t - 1][i] >> 8) ^ table_[0][table_[t - 1][i] & 0xff];
+    }
+  }
+};
+
+uint32_t crc32c_sw(const byte *buf, size_t len, uint32_t crc) {
+  static const Crc32cTable tables;
+  const auto &t = tables.table_;
+  const auto *p = reinterpret_cast<const unsigned char *>(buf);
+  uint32_t c = ~crc;
+  while (len >= 8) {
+    uint32_t lo = c ^ (p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+    uint32_t hi = p[4] | p[5] << 8 | p[6] << 16 | (uint32_t)p[7] << 24;
+    c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^
+        t[4][lo >> 24] ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+        t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    p += 8;
+    len -= 8;
+  }
+  while (len--)
+    c = (c >> 8) ^ t[0][(c ^ *p++) & 0xff];
+  return ~c;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t
+crc32c_sse42(const byte *buf, size_t len, uint32_t crc) {
+  const auto *p = reinterpret_cast<const unsigned char *>(buf);
+  uint32_t c = ~crc;
+  while (len > 0 && (reinterpret_cast<uintptr_t>(p) & 7)) {
+    c = _mm_crc32_u8(c, *p++);
+    --len;
+  }
+  uint64_t c64 = c;
+  while (len >= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    c64 = _mm_crc32_u64(c64, v);
+    p += 8;
+    len -= 8;
+  }
+  c = static_cast<uint32_t>(c64);
+  while (len--)
+    c = _mm_crc32_u8(c, *p++);
+  return ~c;
+}
+#elif defined(__aarch64__)
+__attribute__((target("arch=armv8-a+crc"))) uint32_t
+crc32c_armv8(const byte *buf, size_t len, uint32_t crc) {
+  const auto *p = reinterpret_cast<const unsigned char *>(buf);
+  uint32_t c = ~crc;
+  while (len > 0 && (reinterpret_cast<uintptr_t>(p) & 7)) {
+    c = __crc32cb(c, *p++);
+    --len;
+  }
+  while (len >= 8) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    c = __crc32cd(c, v);
+    p += 8;
+    len -= 8;
+  }
+  while (len--)
+    c = __crc32cb(c, *p++);
+  return ~c;
+}
+#endif
+
+using crc32c_func = uint32_t (*)(const byte *, size_t, uint32_t);
+
+struct Crc32cImpl {
+  crc32c_func func_;
+  const char *name_;
+};
+
+Crc32cImpl pick_crc32c() {
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("sse4.2"))
+    return {crc32c_sse42, "sse4.2"};
+#elif defined(__aarch64__)
+  if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+    return {crc32c_armv8, "armv8"};
+#endif
+  return {crc32c_sw, "table"};
+}
+
+const Crc32cImpl &crc32c_impl_instance() {
+  static const Crc32cImpl impl = pick_crc32c();
+  return impl;
+}
+
+constexpr ulint UT_HASH_RANDOM_MASK = 1463735687;
+constexpr ulint UT_HASH_RANDOM_MASK2 = 1653893711;
+
+inline ulint fold_ulint_pair(ulint n1, ulint n2) {
+  return ((((n1 ^ n2 ^ UT_HASH_RANDOM_MASK2) << 8) + n1) ^
+          UT_HASH_RANDOM_MASK) +
+         n2;
+}
+
+/// @brief ut_fold_binary of innodb, every byte is folded in turn
+ulint fold_binary(const byte *buf, ulint len) {
+  const auto *p = reinterpret_cast<const unsigned char *>(buf);
+  ulint fold = 0;
+  for (ulint i = 0; i < len; ++i)
+    fold = fold_ulint_pair(fold, p[i]);
+  return fold;
+}
+
+} // namespace
+
+uint32_t innodb::crc32c(const byte *buf, size_t len, uint32_t crc) {
+  return crc32c_impl_instance().func_(buf, len, crc);
+}
+
+const char *innodb::crc32c_impl() { return crc32c_impl_instance().name_; }
+
+const char *innodb::checksum_algorithm_str(ChecksumAlgorithm algorithm) {
+  switch (algorithm) {
+  case ChecksumAlgorithm::NONE:
+    return "none";
+  case ChecksumAlgorithm::CRC32:
+    return "crc32";
+  case ChecksumAlgorithm::INNODB:
+    return "innodb";
+  case ChecksumAlgorithm::EMPTY:
+    return "empty";
+  default:
+    return "invalid";
+  }
+}
+
+uint32_t PageChecksum::crc32(const byte *page, ulint page_size) {
+  uint32_t c1 =
+      crc32c(page + FILHeader::FIL_PAGE_OFFSET,
+             FILHeader::FIL_PAGE_FILE_FLUSH_LSN - FILHeader::FIL_PAGE_OFFSET);
+  uint32_t c2 = crc32c(page + FILHeader::FIL_PAGE_DATA,
+                       page_size - FILHeader::FIL_PAGE_DATA -
+                           FILHeader::FIL_PAGE_END_LSN_OLD_CHKSUM);
+  return c1 ^ c2;
+}
+
+uint32_t PageChecksum::innodb_new(const byte *page, ulint page_size) {
+  ulint fold =
+      fold_binary(page + FILHeader::FIL_PAGE_OFFSET,
+                  FILHeader::FIL_PAGE_FILE_FLUSH_LSN -
+                      FILHeader::FIL_PAGE_OFFSET) +
+      fold_binary(page + FILHeader::FIL_PAGE_DATA,
+                  page_size - FILHeader::FIL_PAGE_DATA -
+                      FILHeader::FIL_PAGE_END_LSN_OLD_CHKSUM);
+  return static_cast<uint32_t>(fold & 0xFFFFFFFFUL);
+}
+
+uint32_t PageChecksum::innodb_old(const byte *page) {
+  return static_cast<uint32_t>(
+      fold_binary(page, FILHeader::FIL_PAGE_FILE_FLUSH_LSN) & 0xFFFFFFFFUL);
+}
+
+bool PageChecksum::lsn_match(const byte *page, ulint page_size) {
+  return mach_read_from_4(page + FILHeader::FIL_PAGE_LSN + 4) ==
+         FILHeader::tailer_lsn(page, page_size);
+}
+
+bool PageChecksum::is_empty(const byte *page, ulint page_size) {
+  // the frames are page aligned, compare 8 bytes at a time
+  for (ulint i = 0; i < page_size; i += 8) {
+    uint64_t v;
+    memcpy(&v, page + i, 8);
+    if (v != 0)
+      return false;
+  }
+  return true;
+}
+
+ChecksumAlgorithm PageChecksum::verify(const byte *page, ulint page_size) {
+  uint32_t field1 = FILHeader::check_sum(page);
+  uint32_t field2 = FILHeader::tailer_check_sum(page, page_size);
+  if (field1 == 0 && field2 == 0 && is_empty(page, page_size))
+    return ChecksumAlgorithm::EMPTY;
+  if (field1 == NO_CHECKSUM_MAGIC && field2 == NO_CHECKSUM_MAGIC)
+    return ChecksumAlgorithm::NONE;
+  // crc32 writes the same value into both fields
+  if (field1 == field2 && field1 == crc32(page, page_size))
+    return ChecksumAlgorithm::CRC32;
+  // very old versions kept the lsn in the tailer field and 0 in the header
+  if ((field2 == innodb_old(page) ||
+       field2 == mach_read_from_4(page + FILHeader::FIL_PAGE_LSN)) &&
+      (field1 == 0 || field1 == innodb_new(page, page_size)))
+    return ChecksumAlgorithm::INNODB;
+  return ChecksumAlgorithm::INVALID;
+}
+
+void ChecksumReport::merge(ChecksumReport &other) {
+  pages_checked_ += other.pages_checked_;
+  empty_pages_ += other.empty_pages_;
+  crc32_pages_ += other.crc32_pages_;
+  innodb_pages_ += other.innodb_pages_;
+  none_pages_ += other.none_pages_;
+  unreadable_pages_ += other.unreadable_pages_;
+  corrupt_pages_.insert(corrupt_pages_.end(), other.corrupt_pages_.begin(),
+                        other.corrupt_pages_.end());
+  lsn_mismatch_pages_.insert(lsn_mismatch_pages_.end(),
+                             other.lsn_mismatch_pages_.begin(),
+                             other.lsn_mismatch_pages_.end());
+}
+
+void ChecksumReport::dump(std::ostringstream &oss) const {
+  oss << "ChecksumReport: pages: " << pages_checked_ << "\t"
+      << "empty: " << empty_pages_ << "\t"
+      << "crc32: " << crc32_pages_ << "\t"
+      << "innodb: " << innodb_pages_ << "\t"
+      << "none: " << none_pages_ << "\t"
+      << "unreadable: " << unreadable_pages_ << "\t"
+      << "corrupt: " << corrupt_pages_.size() << "\t"
+      << "lsn mismatch: " << lsn_mismatch_pages_.size() << std::endl;
+  for (auto page_no : corrupt_pages_)
+    oss << "corrupt page: " << page_no << std::endl;
+  for (auto page_no : lsn_mismatch_pages_)
+    oss << "lsn mismatch page: " << page_no << std::endl;
+}
+
+ChecksumReport innodb::verify_space_checksums(FileSpaceReader *reader,
+                                              uint32_t n_threads) {
+  const ulint page_size = reader->get_page_size();
+  ParallelScanner scanner(reader, n_threads);
+  auto report = scanner.scan<ChecksumReport>(
+      [page_size](ChecksumReport &r, uint32_t page_no, const PageGuard &pg) {
+        ++r.pages_checked_;
+        const byte *page = pg.buf();
+        switch (PageChecksum::verify(page, page_size)) {
+        case ChecksumAlgorithm::EMPTY:
+          ++r.empty_pages_;
+          return; // no lsn to compare
+        case ChecksumAlgorithm::CRC32:
+          ++r.crc32_pages_;
+          break;
+        case ChecksumAlgorithm::INNODB:
+          ++r.innodb_pages_;
+          break;
+        case ChecksumAlgorithm::NONE:
+          ++r.none_pages_;
+          break;
+        case ChecksumAlgorithm::INVALID:
+          r.corrupt_pages_.push_back(page_no);
+          break;
+        }
+        if (!PageChecksum::lsn_match(page, page_size))
+          r.lsn_mismatch_pages_.push_back(page_no);
+      },
+      [](ChecksumReport &into, ChecksumReport &from) { into.merge(from); });
+  report.unreadable_pages_ = scanner.page_errors();
+  std::sort(report.corrupt_pages_.begin(), report.corrupt_pages_.end());
+  std::sort(report.lsn_mismatch_pages_.begin(),
+            report.lsn_mismatch_pages_.end());
+  if (!report.ok()) {
+    LOG(ERROR) << "space has " << report.corrupt_pages_.size()
+               << " corrupt pages, " << report.lsn_mismatch_pages_.size()
+               << " torn pages and " << report.unreadable_pages_
+               << " unreadable pages";
+  }
+  return report;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "defines.h"
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+namespace innodb {
+
+class FileSpaceReader;
+
+/// @brief crc32c (Castagnoli) of the buffer, with the SSE4.2 or ARMv8 crc
+/// instructions when the cpu has them, a table driven one otherwise
+uint32_t crc32c(const byte *buf, size_t len, uint32_t crc = 0);
+
+/// @brief name of the crc32c implementation picked for this cpu
+const char *crc32c_impl();
+
+/// @brief the algorithm a page checksum matched
+enum class ChecksumAlgorithm {
+  NONE,   // the page is written with innodb_checksum_algorithm=none
+  CRC32,  // crc32c of the header and the body, the default since 5.7
+  INNODB, // the fold based checksum before 5.6
+  EMPTY,  // a page of all zero bytes, never written
+  INVALID,
+};
+
+const char *checksum_algorithm_str(ChecksumAlgorithm algorithm);
+
+struct PageChecksum {
+  static constexpr uint32_t NO_CHECKSUM_MAGIC = 0xDEADBEEFUL;
+
+  /// @brief the crc32 checksum, crc32c of the bytes between the checksum
+  /// field and the flush lsn, xor the crc32c of the page body before the
+  /// tailer
+  static uint32_t crc32(const byte *page, ulint page_size);
+  /// @brief the innodb checksum stored in the header
+  static uint32_t innodb_new(const byte *page, ulint page_size);
+  /// @brief the innodb checksum stored in the tailer, of the first bytes of
+  /// the header only
+  static uint32_t innodb_old(const byte *page);
+
+  /// @brief the low 4 bytes of the header lsn are repeated in the tailer, a
+  /// mismatch means a torn write
+  static bool lsn_match(const byte *page, ulint page_size);
+  static bool is_empty(const byte *page, ulint page_size);
+
+  /// @brief check the header and the tailer checksums against all the
+  /// algorithms
+  /// @return the algorithm both checksums match, INVALID if none does
+  static ChecksumAlgorithm verify(const byte *page, ulint page_size);
+};
+
+/// @brief result of verifying a whole tablespace
+struct ChecksumReport {
+  uint64_t pages_checked_ = 0;
+  uint64_t empty_pages_ = 0;
+  uint64_t crc32_pages_ = 0;
+  uint64_t innodb_pages_ = 0;
+  uint64_t none_pages_ = 0;
+  uint64_t unreadable_pages_ = 0;
+  std::vector<uint32_t> corrupt_pages_;      // checksum mismatch, sorted
+  std::vector<uint32_t> lsn_mismatch_pages_; // torn pages, sorted
+
+  bool ok() const {
+    return corrupt_pages_.empty() && lsn_mismatch_pages_.empty() &&
+           unreadable_pages_ == 0;
+  }
+  void merge(ChecksumReport &other);
+  void dump(std::ostringstream &oss) const;
+};
+
+/// @brief verify the checksums and the tailer lsn of every page of the
+/// space with n_threads threads, 0 for one per hardware thread
+ChecksumReport verify_space_checksums(FileSpaceReader *reader,
+                                      uint32_t n_threads = 0);
+
+} // namespace innodb
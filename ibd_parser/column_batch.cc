@@ -0,0 +1,215 @@
+#include "column_batch.h"
+#include <algorithm>
+#include <cstring>
+#include <glog/logging.h>
+
+using namespace innodb;
+
+const char *innodb::column_type_str(ColumnType type) {
+  switch (type) {
+  case ColumnType::INT:
+    return "INT";
+  case ColumnType::UINT:
+    return "UINT";
+  case ColumnType::FLOAT:
+    return "FLOAT";
+  case ColumnType::DOUBLE:
+    return "DOUBLE";
+  case ColumnType::FIXED_BINARY:
+    return "FIXED_BINARY";
+  case ColumnType::VARBINARY:
+    return "VARBINARY";
+  case ColumnType::TRX_ID:
+    return "TRX_ID";
+  case ColumnType::ROLL_PTR:
+    return "ROLL_PTR";
+  }
+  return "UNKNOWN";
+}
+
+FieldDef ColumnDef::field_def() const {
+  if (type_ == ColumnType::VARBINARY)
+    return FieldDef::variable(name_, len_, nullable_, blob_);
+  return FieldDef::fixed(name_, len_, nullable_);
+}
+
+TableSchema TableSchema::clustered(uint64_t index_id,
+                                   std::vector<ColumnDef> pk_columns,
+                                   std::vector<ColumnDef> other_columns) {
+  TableSchema schema;
+  schema.index_id_ = index_id;
+  schema.n_pk_ = pk_columns.size();
+  schema.columns_ = std::move(pk_columns);
+  schema.columns_.push_back(ColumnDef::trx_id());
+  schema.columns_.push_back(ColumnDef::roll_ptr());
+  for (auto &c : other_columns)
+    schema.columns_.push_back(std::move(c));
+  return schema;
+}
+
+int TableSchema::find(const std::string &name) const {
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    if (columns_[i].name_ == name)
+      return i;
+  }
+  return -1;
+}
+
+IndexDef TableSchema::index_def() const {
+  IndexDef index;
+  index.index_id_ = index_id_;
+  index.n_uniq_ = n_pk_;
+  index.clustered_ = true;
+  for (const auto &c : columns_)
+    index.fields_.push_back(c.field_def());
+  return index;
+}
+
+void ColumnVector::clear() {
+  ints_.clear();
+  reals_.clear();
+  offsets_.assign(1, 0);
+  data_.clear();
+  flags_.clear();
+}
+
+void ColumnVector::reserve(size_t n_rows) {
+  if (def_.is_int())
+    ints_.reserve(n_rows);
+  else if (def_.is_real())
+    reals_.reserve(n_rows);
+  else
+    offsets_.reserve(n_rows + 1);
+  flags_.reserve(n_rows);
+}
+
+void ColumnBatch::clear() {
+  for (auto &c : columns_)
+    c.clear();
+  n_rows_ = 0;
+}
+
+int ColumnBatch::find(const std::string &name) const {
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    if (columns_[i].def_.name_ == name)
+      return i;
+  }
+  return -1;
+}
+
+BatchDecoder::BatchDecoder(const TableSchema &schema,
+                           std::vector<uint16_t> columns)
+    : schema_(schema), index_(schema.index_def()),
+      columns_(std::move(columns)) {
+  if (columns_.empty()) {
+    for (uint16_t i = 0; i < schema_.columns_.size(); ++i)
+      columns_.push_back(i);
+  }
+  for (auto i : columns_) {
+    if (i >= schema_.columns_.size()) {
+      LOG(ERROR) << "column " << i << " out of " << schema_.columns_.size();
+      valid_ = false;
+      continue;
+    }
+    n_fields_ = std::max<uint16_t>(n_fields_, i + 1);
+    const ColumnDef &c = schema_.columns_[i];
+    bool ok = true;
+    if (c.is_int())
+      ok = c.len_ >= 1 && c.len_ <= 8;
+    else if (c.type_ == ColumnType::FLOAT)
+      ok = c.len_ == sizeof(float);
+    else if (c.type_ == ColumnType::DOUBLE)
+      ok = c.len_ == sizeof(double);
+    if (!ok || (c.blob_ && c.type_ != ColumnType::VARBINARY)) {
+      LOG(ERROR) << "column " << c.name_ << " of type "
+                 << column_type_str(c.type_) << " can't have length "
+                 << c.len_;
+      valid_ = false;
+    }
+  }
+}
+
+ColumnBatch BatchDecoder::make_batch() const {
+  ColumnBatch batch;
+  for (auto i : columns_) {
+    if (i >= schema_.columns_.size())
+      continue;
+    batch.columns_.emplace_back();
+    batch.columns_.back().def_ = schema_.columns_[i];
+  }
+  return batch;
+}
+
+bool BatchDecoder::decode_record(const byte *rec, ColumnBatch &batch,
+                                 uint32_t max_data_size) {
+  if (!valid_ || batch.columns_.size() != columns_.size())
+    return false;
+  if (!offsets_.init(rec, index_, n_fields_) || offsets_.node_ptr() ||
+      offsets_.data_size() > max_data_size)
+    return false;
+  append(rec, batch);
+  return true;
+}
+
+void BatchDecoder::append(const byte *rec, ColumnBatch &batch) {
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    uint16_t i = columns_[c];
+    ColumnVector &col = batch.columns_[c];
+    const ColumnDef &def = col.def_;
+    bool is_null = offsets_.is_null(i);
+    col.flags_.push_back((is_null ? ColumnVector::NULL_FLAG : 0) |
+                         (offsets_.is_extern(i) ? ColumnVector::EXTERN_FLAG
+                                                : 0));
+    const byte *field = offsets_.field(rec, i);
+    if (def.is_int()) {
+      col.ints_.push_back(is_null ? 0
+                                  : decode_int(field, def.len_,
+                                               def.type_ != ColumnType::INT));
+    } else if (def.type_ == ColumnType::FLOAT) {
+      float v = 0;
+      if (!is_null)
+        memcpy(&v, field, sizeof(v));
+      col.reals_.push_back(v);
+    } else if (def.type_ == ColumnType::DOUBLE) {
+      double v = 0;
+      if (!is_null)
+        memcpy(&v, field, sizeof(v));
+      col.reals_.push_back(v);
+    } else {
+      if (!is_null)
+        col.data_.append(reinterpret_cast<const char *>(field),
+                         offsets_.len(i));
+      col.offsets_.push_back(col.data_.size());
+    }
+  }
+  ++batch.n_rows_;
+}
+
+int BatchDecoder::decode_page(const IndexPageView &page, ColumnBatch &batch,
+                              bool skip_deleted) {
+  if (!fil_page_is_index(page.page_type()) || !page.is_compact() ||
+      !page.is_leaf() ||
+      (index_.index_id_ != 0 && page.index_id() != index_.index_id_)) {
+    LOG(ERROR) << "page " << page.page_no()
+               << " isn't a compact leaf of index " << index_.index_id_;
+    return -1;
+  }
+  if (!valid_ || batch.columns_.size() != columns_.size())
+    return -1;
+  int n = 0;
+  const ulint page_size = page.page_size();
+  page.for_each_record([&](const RecordView &rec) {
+    if (skip_deleted && rec.is_deleted())
+      return;
+    if (!offsets_.init(rec.data(), index_, n_fields_) ||
+        offsets_.node_ptr() ||
+        rec.offset() + offsets_.data_size() > page_size) {
+      LOG(ERROR) << "page " << page.page_no() << " has a bad record at "
+                 << rec.offset();
+      return;
+    }
+    append(rec.data(), batch);
+    ++n;
+  });
+  return n;
+}
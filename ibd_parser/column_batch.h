@@ -0,0 +1,171 @@
+#pragma once
+#include "index_def.h"
+#include "page_view.h"
+#include "rec_offsets.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace innodb {
+
+/// @brief how the value of a column is stored and decoded
+enum class ColumnType : uint8_t {
+  INT,          // signed integer, 1 to 8 bytes big endian, sign bit flipped
+  UINT,         // unsigned integer, 1 to 8 bytes big endian
+  FLOAT,        // 4 bytes little endian
+  DOUBLE,       // 8 bytes little endian
+  FIXED_BINARY, // CHAR, BINARY, DECIMAL, temporal types, kept as raw bytes
+  VARBINARY,    // VARCHAR, VARBINARY, BLOB, TEXT, JSON, kept as raw bytes
+  TRX_ID,       // the hidden DB_TRX_ID, 6 bytes
+  ROLL_PTR,     // the hidden DB_ROLL_PTR, 7 bytes
+};
+
+const char *column_type_str(ColumnType type);
+
+/// @brief a column of the clustered index of a table
+struct ColumnDef {
+  std::string name_;
+  ColumnType type_ = ColumnType::INT;
+  uint32_t len_ = 4; // the bytes of a fixed length type, the max bytes of a
+                     // VARBINARY
+  bool nullable_ = false;
+  bool blob_ = false; // could be stored off page
+
+  /// @brief values of the type are decoded into ColumnVector::ints_
+  bool is_int() const {
+    return type_ == ColumnType::INT || type_ == ColumnType::UINT ||
+           type_ == ColumnType::TRX_ID || type_ == ColumnType::ROLL_PTR;
+  }
+  bool is_real() const {
+    return type_ == ColumnType::FLOAT || type_ == ColumnType::DOUBLE;
+  }
+  bool is_binary() const { return !is_int() && !is_real(); }
+
+  /// @brief the field of the index records storing the column
+  FieldDef field_def() const;
+
+  static ColumnDef make(std::string name, ColumnType type, uint32_t len,
+                        bool nullable = false, bool blob = false) {
+    ColumnDef c;
+    c.name_ = std::move(name);
+    c.type_ = type;
+    c.len_ = len;
+    c.nullable_ = nullable;
+    c.blob_ = blob;
+    return c;
+  }
+  static ColumnDef trx_id() {
+    return make("DB_TRX_ID", ColumnType::TRX_ID, IndexDef::DATA_TRX_ID_LEN);
+  }
+  static ColumnDef roll_ptr() {
+    return make("DB_ROLL_PTR", ColumnType::ROLL_PTR,
+                IndexDef::DATA_ROLL_PTR_LEN);
+  }
+};
+
+/// @brief the columns of a table in the order of the clustered index
+/// records: the primary key, DB_TRX_ID, DB_ROLL_PTR and the other columns
+struct TableSchema {
+  uint64_t index_id_ = 0;
+  std::vector<ColumnDef> columns_;
+  uint16_t n_pk_ = 1;
+
+  /// @brief build the schema from the user visible columns, the hidden
+  /// columns are inserted after the primary key
+  static TableSchema clustered(uint64_t index_id,
+                               std::vector<ColumnDef> pk_columns,
+                               std::vector<ColumnDef> other_columns);
+
+  /// @brief -1 if no such column
+  int find(const std::string &name) const;
+  /// @brief the record format of the clustered index
+  IndexDef index_def() const;
+};
+
+/// @brief the values of one column of a batch. Integers and the hidden
+/// columns go to ints_, FLOAT and DOUBLE to reals_, the binary types are
+/// appended to data_ and the value i is data_[offsets_[i], offsets_[i+1]).
+/// A NULL takes a zero slot or an empty string so that the arrays stay
+/// aligned with the rows.
+struct ColumnVector {
+  static constexpr uint8_t NULL_FLAG = 1;
+  static constexpr uint8_t EXTERN_FLAG = 2; // data_ has the local prefix and
+                                            // the 20 byte LOB reference
+
+  ColumnDef def_;
+  std::vector<int64_t> ints_;
+  std::vector<double> reals_;
+  std::vector<uint32_t> offsets_{0};
+  std::string data_;
+  std::vector<uint8_t> flags_;
+
+  size_t size() const { return flags_.size(); }
+  bool is_null(size_t i) const { return flags_[i] & NULL_FLAG; }
+  bool is_extern(size_t i) const { return flags_[i] & EXTERN_FLAG; }
+  std::string_view str(size_t i) const {
+    return std::string_view(data_).substr(offsets_[i],
+                                          offsets_[i + 1] - offsets_[i]);
+  }
+  void clear();
+  void reserve(size_t n_rows);
+};
+
+/// @brief rows decoded column by column
+struct ColumnBatch {
+  std::vector<ColumnVector> columns_;
+  size_t n_rows_ = 0;
+
+  /// @brief drop the rows, keep the columns and their buffers
+  void clear();
+  /// @brief -1 if no such column
+  int find(const std::string &name) const;
+};
+
+/// @brief decodes the compact and dynamic records of the leaves of a
+/// clustered index into column batches, the buffers of the batch and the
+/// offsets are reused so that a page is decoded without allocating once the
+/// batch has grown
+class BatchDecoder {
+public:
+  /// @param columns the indexes into schema.columns_ of the columns to
+  /// decode, all of them if empty
+  BatchDecoder(const TableSchema &schema, std::vector<uint16_t> columns = {});
+
+  /// @brief false if a column has an unsupported length
+  bool valid() const { return valid_; }
+
+  /// @brief a batch with the decoded columns, in the order they were asked
+  ColumnBatch make_batch() const;
+
+  /// @brief append the user records of a leaf page to the batch
+  /// @param skip_deleted skip the delete marked records
+  /// @return the rows appended, -1 if the page isn't a compact leaf of the
+  /// index or the batch wasn't made by this decoder
+  int decode_page(const IndexPageView &page, ColumnBatch &batch,
+                  bool skip_deleted = true);
+
+  /// @brief append one record
+  /// @param max_data_size the bytes after the origin the fields may span,
+  /// bounds the records not trusted to be well formed
+  /// @return false if the record isn't a leaf record of the index, its
+  /// fields are longer than max_data_size or the batch wasn't made by this
+  /// decoder
+  bool decode_record(const byte *rec, ColumnBatch &batch,
+                     uint32_t max_data_size = UINT32_MAX);
+
+  const IndexDef &index() const { return index_; }
+
+private:
+  /// @brief append the record whose offsets are decoded
+  void append(const byte *rec, ColumnBatch &batch);
+
+private:
+  TableSchema schema_;
+  IndexDef index_;
+  std::vector<uint16_t> columns_;
+  uint16_t n_fields_ = 0; // fields to decode, up to the last asked column
+  RecOffsets offsets_;
+  bool valid_ = true;
+};
+
+} // namespace innodb
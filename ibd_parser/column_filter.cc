@@ -0,0 +1,663 @@
+#include "column_filter.h"
+#include "kernel_dispatch.h"
+#include <algorithm>
+#include <glog/logging.h>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace innodb;
+
+namespace {
+
+/// an IN list this long is evaluated as a compare for each value, a longer
+/// one by a binary search for each row
+constexpr size_t IN_LIST_SIMD_MAX_VALUES = 16;
+/// xor'ed into the values of an unsigned column, a signed compare then
+/// orders them unsigned
+constexpr int64_t UNSIGNED_FLIP = INT64_MIN;
+
+template <CompareOp OP, typename T> inline bool compare(T a, T b) {
+  if constexpr (OP == CompareOp::EQ)
+    return a == b;
+  else if constexpr (OP == CompareOp::NE)
+    return a != b;
+  else if constexpr (OP == CompareOp::LT)
+    return a < b;
+  else if constexpr (OP == CompareOp::LE)
+    return a <= b;
+  else if constexpr (OP == CompareOp::GT)
+    return a > b;
+  else
+    return a >= b;
+}
+
+/// @brief call f(std::integral_constant<CompareOp, op>), the kernels are
+/// instantiated for each op so that the loops don't branch on it
+template <typename F> void dispatch_op(CompareOp op, F &&f) {
+  using C = CompareOp;
+  switch (op) {
+  case C::EQ:
+    return f(std::integral_constant<C, C::EQ>());
+  case C::NE:
+    return f(std::integral_constant<C, C::NE>());
+  case C::LT:
+    return f(std::integral_constant<C, C::LT>());
+  case C::LE:
+    return f(std::integral_constant<C, C::LE>());
+  case C::GT:
+    return f(std::integral_constant<C, C::GT>());
+  case C::GE:
+    return f(std::integral_constant<C, C::GE>());
+  }
+}
+
+/// @brief the bits of pred(i) for the n rows, whole words
+template <typename Pred> void scalar_bits(size_t n, Pred pred, uint64_t *out) {
+  for (size_t base = 0; base < n; base += 64) {
+    size_t end = std::min<size_t>(n - base, 64);
+    uint64_t bits = 0;
+    for (size_t i = 0; i < end; ++i)
+      bits |= static_cast<uint64_t>(pred(base + i)) << i;
+    out[base / 64] = bits;
+  }
+}
+
+template <CompareOp OP>
+void cmp_int_scalar_op(const int64_t *v, size_t n, int64_t c, int64_t flip,
+                       uint64_t *out) {
+  const int64_t fc = c ^ flip;
+  scalar_bits(
+      n, [&](size_t i) { return compare<OP>(v[i] ^ flip, fc); }, out);
+}
+
+void between_int_scalar(const int64_t *v, size_t n, int64_t low,
+                        int64_t high, int64_t flip, uint64_t *out) {
+  const int64_t fl = low ^ flip;
+  const int64_t fh = high ^ flip;
+  scalar_bits(
+      n,
+      [&](size_t i) {
+        int64_t x = v[i] ^ flip;
+        return fl <= x && x <= fh;
+      },
+      out);
+}
+
+template <CompareOp OP>
+void cmp_real_scalar_op(const double *v, size_t n, double c, uint64_t *out) {
+  scalar_bits(
+      n, [&](size_t i) { return compare<OP>(v[i], c); }, out);
+}
+
+void between_real_scalar(const double *v, size_t n, double low, double high,
+                         uint64_t *out) {
+  scalar_bits(
+      n, [&](size_t i) { return low <= v[i] && v[i] <= high; }, out);
+}
+
+void flags_scalar(const uint8_t *flags, size_t n, uint8_t flag,
+                  uint64_t *out) {
+  scalar_bits(
+      n, [&](size_t i) { return (flags[i] & flag) != 0; }, out);
+}
+
+void cmp_int_scalar(const int64_t *v, size_t n, CompareOp op, int64_t c,
+                    int64_t flip, uint64_t *out) {
+  dispatch_op(op, [&](auto o) {
+    cmp_int_scalar_op<decltype(o)::value>(v, n, c, flip, out);
+  });
+}
+
+void cmp_real_scalar(const double *v, size_t n, CompareOp op, double c,
+                     uint64_t *out) {
+  dispatch_op(op, [&](auto o) {
+    cmp_real_scalar_op<decltype(o)::value>(v, n, c, out);
+  });
+}
+
+#if defined(__x86_64__)
+/// the predicate of _mm256_cmp_pd and _mm512_cmp_pd_mask, NE is unordered
+/// so that a NaN matches it like in the scalar compare
+template <CompareOp OP> constexpr int real_pred() {
+  switch (OP) {
+  case CompareOp::EQ:
+    return _CMP_EQ_OQ;
+  case CompareOp::NE:
+    return _CMP_NEQ_UQ;
+  case CompareOp::LT:
+    return _CMP_LT_OQ;
+  case CompareOp::LE:
+    return _CMP_LE_OQ;
+  case CompareOp::GT:
+    return _CMP_GT_OQ;
+  default:
+    return _CMP_GE_OQ;
+  }
+}
+
+/// the predicate of _mm512_cmp_epi64_mask
+template <CompareOp OP> constexpr int int_pred() {
+  switch (OP) {
+  case CompareOp::EQ:
+    return _MM_CMPINT_EQ;
+  case CompareOp::NE:
+    return _MM_CMPINT_NE;
+  case CompareOp::LT:
+    return _MM_CMPINT_LT;
+  case CompareOp::LE:
+    return _MM_CMPINT_LE;
+  case CompareOp::GT:
+    return _MM_CMPINT_NLE;
+  default:
+    return _MM_CMPINT_NLT;
+  }
+}
+
+// AVX2 has only the == and > compares of 64 bit integers, NE, LE and GE
+// are computed as the negation of EQ, GT and LT
+template <CompareOp OP>
+__attribute__((target("avx2"))) void
+cmp_int_avx2_op(const int64_t *v, size_t n, int64_t c, int64_t flip,
+                uint64_t *out) {
+  const __m256i vc = _mm256_set1_epi64x(c ^ flip);
+  const __m256i vf = _mm256_set1_epi64x(flip);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const int64_t *p = v + w * 64;
+    uint64_t bits = 0;
+    for (int j = 0; j < 16; ++j) {
+      __m256i x = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + j * 4)),
+          vf);
+      __m256i m;
+      if constexpr (OP == CompareOp::EQ || OP == CompareOp::NE)
+        m = _mm256_cmpeq_epi64(x, vc);
+      else if constexpr (OP == CompareOp::LT || OP == CompareOp::GE)
+        m = _mm256_cmpgt_epi64(vc, x);
+      else
+        m = _mm256_cmpgt_epi64(x, vc);
+      bits |= static_cast<uint64_t>(
+                  _mm256_movemask_pd(_mm256_castsi256_pd(m)))
+              << (j * 4);
+    }
+    if constexpr (OP == CompareOp::NE || OP == CompareOp::LE ||
+                  OP == CompareOp::GE)
+      bits = ~bits;
+    out[w] = bits;
+  }
+  cmp_int_scalar_op<OP>(v + full * 64, n - full * 64, c, flip, out + full);
+}
+
+__attribute__((target("avx2"))) void
+between_int_avx2(const int64_t *v, size_t n, int64_t low, int64_t high,
+                 int64_t flip, uint64_t *out) {
+  const __m256i vl = _mm256_set1_epi64x(low ^ flip);
+  const __m256i vh = _mm256_set1_epi64x(high ^ flip);
+  const __m256i vf = _mm256_set1_epi64x(flip);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const int64_t *p = v + w * 64;
+    uint64_t outside = 0;
+    for (int j = 0; j < 16; ++j) {
+      __m256i x = _mm256_xor_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + j * 4)),
+          vf);
+      __m256i m = _mm256_or_si256(_mm256_cmpgt_epi64(vl, x),
+                                  _mm256_cmpgt_epi64(x, vh));
+      outside |= static_cast<uint64_t>(
+                     _mm256_movemask_pd(_mm256_castsi256_pd(m)))
+                 << (j * 4);
+    }
+    out[w] = ~outside;
+  }
+  between_int_scalar(v + full * 64, n - full * 64, low, high, flip,
+                     out + full);
+}
+
+template <CompareOp OP>
+__attribute__((target("avx2"))) void
+cmp_real_avx2_op(const double *v, size_t n, double c, uint64_t *out) {
+  constexpr int pred = real_pred<OP>();
+  const __m256d vc = _mm256_set1_pd(c);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const double *p = v + w * 64;
+    uint64_t bits = 0;
+    for (int j = 0; j < 16; ++j) {
+      __m256d m = _mm256_cmp_pd(_mm256_loadu_pd(p + j * 4), vc, pred);
+      bits |= static_cast<uint64_t>(_mm256_movemask_pd(m)) << (j * 4);
+    }
+    out[w] = bits;
+  }
+  cmp_real_scalar_op<OP>(v + full * 64, n - full * 64, c, out + full);
+}
+
+__attribute__((target("avx2"))) void between_real_avx2(const double *v,
+                                                       size_t n, double low,
+                                                       double high,
+                                                       uint64_t *out) {
+  const __m256d vl = _mm256_set1_pd(low);
+  const __m256d vh = _mm256_set1_pd(high);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const double *p = v + w * 64;
+    uint64_t bits = 0;
+    for (int j = 0; j < 16; ++j) {
+      __m256d x = _mm256_loadu_pd(p + j * 4);
+      __m256d m = _mm256_and_pd(_mm256_cmp_pd(x, vl, _CMP_GE_OQ),
+                                _mm256_cmp_pd(x, vh, _CMP_LE_OQ));
+      bits |= static_cast<uint64_t>(_mm256_movemask_pd(m)) << (j * 4);
+    }
+    out[w] = bits;
+  }
+  between_real_scalar(v + full * 64, n - full * 64, low, high, out + full);
+}
+
+__attribute__((target("avx2"))) void
+flags_avx2(const uint8_t *flags, size_t n, uint8_t flag, uint64_t *out) {
+  const __m256i vf = _mm256_set1_epi8(static_cast<char>(flag));
+  const __m256i zero = _mm256_setzero_si256();
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const uint8_t *p = flags + w * 64;
+    uint64_t clear = 0;
+    for (int j = 0; j < 2; ++j) {
+      __m256i x = _mm256_and_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + j * 32)),
+          vf);
+      clear |= static_cast<uint64_t>(static_cast<uint32_t>(
+                   _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, zero))))
+               << (j * 32);
+    }
+    out[w] = ~clear;
+  }
+  flags_scalar(flags + full * 64, n - full * 64, flag, out + full);
+}
+
+void cmp_int_avx2(const int64_t *v, size_t n, CompareOp op, int64_t c,
+                  int64_t flip, uint64_t *out) {
+  dispatch_op(op, [&](auto o) {
+    cmp_int_avx2_op<decltype(o)::value>(v, n, c, flip, out);
+  });
+}
+
+void cmp_real_avx2(const double *v, size_t n, CompareOp op, double c,
+                   uint64_t *out) {
+  dispatch_op(op, [&](auto o) {
+    cmp_real_avx2_op<decltype(o)::value>(v, n, c, out);
+  });
+}
+
+#define FILTER_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+template <CompareOp OP>
+FILTER_AVX512 void cmp_int_avx512_op(const int64_t *v, size_t n, int64_t c,
+                                     int64_t flip, uint64_t *out) {
+  constexpr int pred = int_pred<OP>();
+  const __m512i vc = _mm512_set1_epi64(c ^ flip);
+  const __m512i vf = _mm512_set1_epi64(flip);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const int64_t *p = v + w * 64;
+    uint64_t bits = 0;
+    for (int j = 0; j < 8; ++j) {
+      __m512i x = _mm512_xor_si512(_mm512_loadu_si512(p + j * 8), vf);
+      bits |= static_cast<uint64_t>(_mm512_cmp_epi64_mask(x, vc, pred))
+              << (j * 8);
+    }
+    out[w] = bits;
+  }
+  cmp_int_scalar_op<OP>(v + full * 64, n - full * 64, c, flip, out + full);
+}
+
+FILTER_AVX512 void between_int_avx512(const int64_t *v, size_t n,
+                                      int64_t low, int64_t high, int64_t flip,
+                                      uint64_t *out) {
+  const __m512i vl = _mm512_set1_epi64(low ^ flip);
+  const __m512i vh = _mm512_set1_epi64(high ^ flip);
+  const __m512i vf = _mm512_set1_epi64(flip);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const int64_t *p = v + w * 64;
+    uint64_t bits = 0;
+    for (int j = 0; j < 8; ++j) {
+      __m512i x = _mm512_xor_si512(_mm512_loadu_si512(p + j * 8), vf);
+      __mmask8 m = _mm512_cmp_epi64_mask(x, vl, _MM_CMPINT_NLT);
+      m = _mm512_mask_cmp_epi64_mask(m, x, vh, _MM_CMPINT_LE);
+      bits |= static_cast<uint64_t>(m) << (j * 8);
+    }
+    out[w] = bits;
+  }
+  between_int_scalar(v + full * 64, n - full * 64, low, high, flip,
+                     out + full);
+}
+
+template <CompareOp OP>
+FILTER_AVX512 void cmp_real_avx512_op(const double *v, size_t n, double c,
+                                      uint64_t *out) {
+  constexpr int pred = real_pred<OP>();
+  const __m512d vc = _mm512_set1_pd(c);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const double *p = v + w * 64;
+    uint64_t bits = 0;
+    for (int j = 0; j < 8; ++j) {
+      bits |= static_cast<uint64_t>(
+                  _mm512_cmp_pd_mask(_mm512_loadu_pd(p + j * 8), vc, pred))
+              << (j * 8);
+    }
+    out[w] = bits;
+  }
+  cmp_real_scalar_op<OP>(v + full * 64, n - full * 64, c, out + full);
+}
+
+FILTER_AVX512 void between_real_avx512(const double *v, size_t n, double low,
+                                       double high, uint64_t *out) {
+  const __m512d vl = _mm512_set1_pd(low);
+  const __m512d vh = _mm512_set1_pd(high);
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w) {
+    const double *p = v + w * 64;
+    uint64_t bits = 0;
+    for (int j = 0; j < 8; ++j) {
+      __m512d x = _mm512_loadu_pd(p + j * 8);
+      __mmask8 m = _mm512_cmp_pd_mask(x, vl, _CMP_GE_OQ);
+      m = _mm512_mask_cmp_pd_mask(m, x, vh, _CMP_LE_OQ);
+      bits |= static_cast<uint64_t>(m) << (j * 8);
+    }
+    out[w] = bits;
+  }
+  between_real_scalar(v + full * 64, n - full * 64, low, high, out + full);
+}
+
+FILTER_AVX512 void flags_avx512(const uint8_t *flags, size_t n, uint8_t flag,
+                                uint64_t *out) {
+  const __m512i vf = _mm512_set1_epi8(static_cast<char>(flag));
+  const size_t full = n / 64;
+  for (size_t w = 0; w < full; ++w)
+    out[w] = _mm512_test_epi8_mask(_mm512_loadu_si512(flags + w * 64), vf);
+  flags_scalar(flags + full * 64, n - full * 64, flag, out + full);
+}
+
+void cmp_int_avx512(const int64_t *v, size_t n, CompareOp op, int64_t c,
+                    int64_t flip, uint64_t *out) {
+  dispatch_op(op, [&](auto o) {
+    cmp_int_avx512_op<decltype(o)::value>(v, n, c, flip, out);
+  });
+}
+
+void cmp_real_avx512(const double *v, size_t n, CompareOp op, double c,
+                     uint64_t *out) {
+  dispatch_op(op, [&](auto o) {
+    cmp_real_avx512_op<decltype(o)::value>(v, n, c, out);
+  });
+}
+#endif
+
+/// @brief the kernels of one instruction set for a KernelTable, each fills
+/// the whole words of the bitmap of n rows
+struct FilterKernels {
+  const char *name_;
+  void (*cmp_int_)(const int64_t *v, size_t n, CompareOp op, int64_t c,
+                   int64_t flip, uint64_t *out);
+  void (*between_int_)(const int64_t *v, size_t n, int64_t low, int64_t high,
+                       int64_t flip, uint64_t *out);
+  void (*cmp_real_)(const double *v, size_t n, CompareOp op, double c,
+                    uint64_t *out);
+  void (*between_real_)(const double *v, size_t n, double low, double high,
+                        uint64_t *out);
+  /// the rows whose flags have the flag
+  void (*flags_)(const uint8_t *flags, size_t n, uint8_t flag, uint64_t *out);
+  bool (*supported_)();
+};
+
+const FilterKernels FILTER_KERNELS[] = {
+#if defined(__x86_64__)
+    {"avx512", cmp_int_avx512, between_int_avx512, cmp_real_avx512,
+     between_real_avx512, flags_avx512,
+     []() {
+       return __builtin_cpu_supports("avx512f") &&
+              __builtin_cpu_supports("avx512bw");
+     }},
+    {"avx2", cmp_int_avx2, between_int_avx2, cmp_real_avx2, between_real_avx2,
+     flags_avx2, []() { return (bool)__builtin_cpu_supports("avx2"); }},
+#endif
+    {"scalar", cmp_int_scalar, between_int_scalar, cmp_real_scalar,
+     between_real_scalar, flags_scalar, []() { return true; }},
+};
+
+KernelTable<FilterKernels> &filter_kernels() {
+  static KernelTable<FilterKernels> kernels(FILTER_KERNELS);
+  return kernels;
+}
+
+/// @brief scratch bitmaps reused by the filters of a thread
+std::vector<uint64_t> &scratch_words(size_t n_rows) {
+  thread_local std::vector<uint64_t> words;
+  words.resize(SelectionBitmap::n_words(n_rows));
+  return words;
+}
+
+bool check_column(const ColumnVector &col, bool fits, const char *filter) {
+  if (!fits)
+    LOG(ERROR) << filter << " doesn't apply to the "
+               << column_type_str(col.def_.type_) << " column "
+               << col.def_.name_;
+  return fits;
+}
+
+bool is_unsigned(const ColumnDef &def) { return def.type_ != ColumnType::INT; }
+
+/// @brief unselect the NULL rows
+void drop_nulls(const ColumnVector &col, SelectionBitmap &out) {
+  if (!col.def_.nullable_)
+    return;
+  auto &nulls = scratch_words(col.size());
+  filter_kernels()->flags_(col.flags_.data(), col.size(),
+                           ColumnVector::NULL_FLAG, nulls.data());
+  for (size_t w = 0; w < nulls.size(); ++w)
+    out.words_[w] &= ~nulls[w];
+}
+
+} // namespace
+
+const char *innodb::compare_op_str(CompareOp op) {
+  switch (op) {
+  case CompareOp::EQ:
+    return "=";
+  case CompareOp::NE:
+    return "!=";
+  case CompareOp::LT:
+    return "<";
+  case CompareOp::LE:
+    return "<=";
+  case CompareOp::GT:
+    return ">";
+  case CompareOp::GE:
+    return ">=";
+  }
+  return "?";
+}
+
+void SelectionBitmap::resize(size_t n_rows, bool selected) {
+  n_rows_ = n_rows;
+  words_.assign(n_words(n_rows), selected ? ~0ULL : 0);
+  if (selected && n_rows % 64)
+    words_.back() = (1ULL << (n_rows % 64)) - 1;
+}
+
+size_t SelectionBitmap::count() const {
+  size_t n = 0;
+  for (uint64_t w : words_)
+    n += __builtin_popcountll(w);
+  return n;
+}
+
+void SelectionBitmap::and_with(const SelectionBitmap &other) {
+  for (size_t w = 0; w < words_.size(); ++w)
+    words_[w] &= other.words_[w];
+}
+
+void SelectionBitmap::or_with(const SelectionBitmap &other) {
+  for (size_t w = 0; w < words_.size(); ++w)
+    words_[w] |= other.words_[w];
+}
+
+void SelectionBitmap::invert() {
+  for (auto &w : words_)
+    w = ~w;
+  if (n_rows_ % 64)
+    words_.back() &= (1ULL << (n_rows_ % 64)) - 1;
+}
+
+const char *innodb::filter_impl() { return filter_kernels().name(); }
+
+bool innodb::set_filter_impl(const std::string &name) {
+  return filter_kernels().select(name);
+}
+
+bool innodb::filter_compare(const ColumnVector &col, CompareOp op,
+                            int64_t value, SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_int(), "filter_compare"))
+    return false;
+  out.resize(col.size());
+  filter_kernels()->cmp_int_(col.ints_.data(), col.size(), op, value,
+                             is_unsigned(col.def_) ? UNSIGNED_FLIP : 0,
+                             out.words_.data());
+  drop_nulls(col, out);
+  return true;
+}
+
+bool innodb::filter_between(const ColumnVector &col, int64_t low,
+                            int64_t high, SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_int(), "filter_between"))
+    return false;
+  out.resize(col.size());
+  filter_kernels()->between_int_(col.ints_.data(), col.size(), low, high,
+                                 is_unsigned(col.def_) ? UNSIGNED_FLIP : 0,
+                                 out.words_.data());
+  drop_nulls(col, out);
+  return true;
+}
+
+bool innodb::filter_in(const ColumnVector &col,
+                       const std::vector<int64_t> &values,
+                       SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_int(), "filter_in"))
+    return false;
+  const size_t n = col.size();
+  out.resize(n);
+  if (values.size() <= IN_LIST_SIMD_MAX_VALUES) {
+    const int64_t flip = is_unsigned(col.def_) ? UNSIGNED_FLIP : 0;
+    auto &eq = scratch_words(n);
+    for (int64_t v : values) {
+      filter_kernels()->cmp_int_(col.ints_.data(), n, CompareOp::EQ, v, flip,
+                                 eq.data());
+      for (size_t w = 0; w < eq.size(); ++w)
+        out.words_[w] |= eq[w];
+    }
+  } else {
+    std::vector<int64_t> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    const int64_t *v = col.ints_.data();
+    scalar_bits(
+        n,
+        [&](size_t i) {
+          return std::binary_search(sorted.begin(), sorted.end(), v[i]);
+        },
+        out.words_.data());
+  }
+  drop_nulls(col, out);
+  return true;
+}
+
+bool innodb::filter_compare_real(const ColumnVector &col, CompareOp op,
+                                 double value, SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_real(), "filter_compare_real"))
+    return false;
+  out.resize(col.size());
+  filter_kernels()->cmp_real_(col.reals_.data(), col.size(), op, value,
+                              out.words_.data());
+  drop_nulls(col, out);
+  return true;
+}
+
+bool innodb::filter_between_real(const ColumnVector &col, double low,
+                                 double high, SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_real(), "filter_between_real"))
+    return false;
+  out.resize(col.size());
+  filter_kernels()->between_real_(col.reals_.data(), col.size(), low, high,
+                                  out.words_.data());
+  drop_nulls(col, out);
+  return true;
+}
+
+bool innodb::filter_compare_binary(const ColumnVector &col, CompareOp op,
+                                   std::string_view value,
+                                   SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_binary(), "filter_compare_binary"))
+    return false;
+  out.resize(col.size());
+  // char_traits<char> compares the bytes unsigned, like memcmp
+  dispatch_op(op, [&](auto o) {
+    scalar_bits(
+        col.size(),
+        [&](size_t i) {
+          return compare<decltype(o)::value>(col.str(i).compare(value), 0);
+        },
+        out.words_.data());
+  });
+  drop_nulls(col, out);
+  return true;
+}
+
+bool innodb::filter_between_binary(const ColumnVector &col,
+                                   std::string_view low,
+                                   std::string_view high,
+                                   SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_binary(), "filter_between_binary"))
+    return false;
+  out.resize(col.size());
+  scalar_bits(
+      col.size(),
+      [&](size_t i) {
+        std::string_view s = col.str(i);
+        return s.compare(low) >= 0 && s.compare(high) <= 0;
+      },
+      out.words_.data());
+  drop_nulls(col, out);
+  return true;
+}
+
+bool innodb::filter_in_binary(const ColumnVector &col,
+                              const std::vector<std::string_view> &values,
+                              SelectionBitmap &out) {
+  if (!check_column(col, col.def_.is_binary(), "filter_in_binary"))
+    return false;
+  out.resize(col.size());
+  // string_view orders the bytes like memcmp, a binary search for each row
+  std::vector<std::string_view> sorted(values);
+  std::sort(sorted.begin(), sorted.end());
+  scalar_bits(
+      col.size(),
+      [&](size_t i) {
+        return std::binary_search(sorted.begin(), sorted.end(), col.str(i));
+      },
+      out.words_.data());
+  drop_nulls(col, out);
+  return true;
+}
+
+void innodb::filter_null(const ColumnVector &col, bool is_null,
+                         SelectionBitmap &out) {
+  out.resize(col.size());
+  if (col.def_.nullable_)
+    filter_kernels()->flags_(col.flags_.data(), col.size(),
+                             ColumnVector::NULL_FLAG, out.words_.data());
+  if (!is_null)
+    out.invert();
+}
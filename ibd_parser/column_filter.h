@@ -0,0 +1,88 @@
+#pragma once
+#include "column_batch.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace innodb {
+
+enum class CompareOp : uint8_t { EQ, NE, LT, LE, GT, GE };
+
+const char *compare_op_str(CompareOp op);
+
+/// @brief one bit for each row of a batch, set for the selected rows. The
+/// bits past n_rows_ in the last word are always 0.
+struct SelectionBitmap {
+  std::vector<uint64_t> words_;
+  size_t n_rows_ = 0;
+
+  static size_t n_words(size_t n_rows) { return (n_rows + 63) / 64; }
+
+  /// @brief n_rows rows, all selected or none
+  void resize(size_t n_rows, bool selected = false);
+  bool test(size_t i) const { return words_[i / 64] >> (i % 64) & 1; }
+  void set(size_t i) { words_[i / 64] |= 1ULL << (i % 64); }
+  /// @brief the selected rows
+  size_t count() const;
+  /// @brief keep the rows selected by both, the bitmaps have the same rows
+  void and_with(const SelectionBitmap &other);
+  void or_with(const SelectionBitmap &other);
+  void invert();
+
+  /// @brief call f(size_t row) for each selected row in order
+  template <typename F> void for_each_selected(F &&f) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      for (uint64_t bits = words_[w]; bits; bits &= bits - 1)
+        f(w * 64 + __builtin_ctzll(bits));
+    }
+  }
+};
+
+/// @brief name of the filter kernels picked for this cpu, "avx512", "avx2"
+/// or "scalar"
+const char *filter_impl();
+/// @brief use other filter kernels, for the tests and the benchmarks, not
+/// while filters run on other threads
+/// @return false if the name is unknown or the cpu lacks the instructions
+bool set_filter_impl(const std::string &name);
+
+/// The filters below select the rows of the column matching the predicate
+/// into out, resized to the rows of the column. A NULL matches no predicate
+/// but filter_null. They return false if the column type doesn't fit the
+/// filter.
+
+/// @brief compare an integer column, the value of an UINT column is the
+/// uint64_t cast to int64_t and compared unsigned
+bool filter_compare(const ColumnVector &col, CompareOp op, int64_t value,
+                    SelectionBitmap &out);
+/// @brief low <= v <= high on an integer column
+bool filter_between(const ColumnVector &col, int64_t low, int64_t high,
+                    SelectionBitmap &out);
+/// @brief v is one of the values of an integer column
+bool filter_in(const ColumnVector &col, const std::vector<int64_t> &values,
+               SelectionBitmap &out);
+
+/// @brief compare a FLOAT or DOUBLE column, a NaN only matches NE
+bool filter_compare_real(const ColumnVector &col, CompareOp op, double value,
+                         SelectionBitmap &out);
+bool filter_between_real(const ColumnVector &col, double low, double high,
+                         SelectionBitmap &out);
+
+/// @brief compare a binary column byte by byte like memcmp, the order of
+/// the DECIMAL, DATE, DATETIME and TIMESTAMP columns as innodb stores them.
+/// A value stored off page is compared by its local prefix.
+bool filter_compare_binary(const ColumnVector &col, CompareOp op,
+                           std::string_view value, SelectionBitmap &out);
+bool filter_between_binary(const ColumnVector &col, std::string_view low,
+                           std::string_view high, SelectionBitmap &out);
+/// @brief v is one of the values of a binary column, equal bytes and length
+bool filter_in_binary(const ColumnVector &col,
+                      const std::vector<std::string_view> &values,
+                      SelectionBitmap &out);
+
+/// @brief select the NULL rows, or the rows not NULL
+void filter_null(const ColumnVector &col, bool is_null,
+                 SelectionBitmap &out);
+
+} // namespace innodb
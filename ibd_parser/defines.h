@@ -6,7 +6,9 @@
 using byte = std::byte;
 #define ulint unsigned long
 
-#define PAGE_SIZE 16384
+#define PAGE_SIZE 16384 // the default innodb_page_size
+#define PAGE_SIZE_MIN 4096
+#define PAGE_SIZE_MAX 65536
 #define PAGE_BTR_SEG_LEAF 36
 
 template <typename T> T e(const T &t) {
@@ -65,6 +67,51 @@ static inline void* align_down(const void*ptr, ulint align_no) {
   return ((void*)((((ulint)ptr)) & ~(align_no - 1)));
 }
 
+/// @brief pages in one extent, an extent is 1MB for the page sizes up to 16K,
+/// 2MB for 32K pages and 4MB for 64K pages
+static constexpr inline ulint extent_pages(ulint page_size) {
+  return page_size <= 16384 ? (1UL << 20) / page_size : 64;
+}
+
+static constexpr inline bool is_valid_page_size(ulint page_size) {
+  return page_size >= PAGE_SIZE_MIN && page_size <= PAGE_SIZE_MAX &&
+         (page_size & (page_size - 1)) == 0;
+}
+
+/// @brief constants of one page size, the helpers templated on it get the
+/// masks and offsets folded at compile time
+template <ulint page_size> struct PageSizeTraits {
+  static_assert(is_valid_page_size(page_size), "invalid page size");
+  static constexpr ulint SIZE = page_size;
+  static constexpr ulint MASK = page_size - 1;
+  static constexpr ulint EXTENT_PAGES = extent_pages(page_size);
+};
+
+/// @brief call f with the PageSizeTraits of the runtime page size, so the
+/// hot loops inside f are compiled once per page size
+/// @return the result of f, the default page size is used for an invalid
+/// page size
+template <typename F>
+static inline auto dispatch_page_size(ulint page_size, F &&f) {
+  switch (page_size) {
+  case 4096:
+    return f(PageSizeTraits<4096>());
+  case 8192:
+    return f(PageSizeTraits<8192>());
+  case 32768:
+    return f(PageSizeTraits<32768>());
+  case 65536:
+    return f(PageSizeTraits<65536>());
+  default:
+    return f(PageSizeTraits<16384>());
+  }
+}
+
+template <ulint page_size = PAGE_SIZE>
 static inline byte* page_align(const void* ptr) {
-    return (byte*)align_down(ptr, PAGE_SIZE);
+    return (byte*)align_down(ptr, page_size);
+}
+
+static inline byte* page_align(const void* ptr, ulint page_size) {
+    return (byte*)align_down(ptr, page_size);
 }
@@ -0,0 +1,248 @@
+#include "extent_map.h"
+#include "kernel_dispatch.h"
+#include "parallel_scanner.h"
+#include <algorithm>
+#include <cstring>
+#include <glog/logging.h>
+#include <map>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace innodb;
+
+namespace {
+
+/// the free bits, the first of the 2 bits of every page
+constexpr uint64_t FREE_BITS_MASK = 0x5555555555555555ULL;
+/// the reports only read the XDES pages, a small cache is enough
+constexpr size_t REPORT_CACHE_BYTES = 1 << 20;
+
+/// @brief counts[i] = the free bits of words[i]
+void count_free_scalar(const uint64_t *words, size_t n, uint8_t *counts) {
+  for (size_t i = 0; i < n; ++i)
+    counts[i] = __builtin_popcountll(words[i] & FREE_BITS_MASK);
+}
+
+#if defined(__x86_64__)
+// no popcount instruction for vectors before AVX512, the bits of every
+// nibble are looked up with a shuffle and the bytes of a word summed by sad
+__attribute__((target("avx2"))) void
+count_free_avx2(const uint64_t *words, size_t n, uint8_t *counts) {
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2,
+                                       3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                       2, 3, 2, 3, 3, 4);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+  const __m256i mask = _mm256_set1_epi64x((int64_t)FREE_BITS_MASK);
+  const __m256i zero = _mm256_setzero_si256();
+  const size_t full = n / 4;
+  for (size_t i = 0; i < full; ++i) {
+    __m256i v = _mm256_and_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i * 4)),
+        mask);
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low_nibble));
+    __m256i hi = _mm256_shuffle_epi8(
+        lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble));
+    __m256i sums = _mm256_sad_epu8(_mm256_add_epi8(lo, hi), zero);
+    alignas(32) uint64_t out[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(out), sums);
+    for (int j = 0; j < 4; ++j)
+      counts[i * 4 + j] = out[j];
+  }
+  count_free_scalar(words + full * 4, n - full * 4, counts + full * 4);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq"))) void
+count_free_avx512(const uint64_t *words, size_t n, uint8_t *counts) {
+  const __m512i mask = _mm512_set1_epi64((int64_t)FREE_BITS_MASK);
+  const size_t full = n / 8;
+  for (size_t i = 0; i < full; ++i) {
+    __m512i v = _mm512_and_si512(_mm512_loadu_si512(words + i * 8), mask);
+    __m128i c = _mm512_cvtepi64_epi8(_mm512_popcnt_epi64(v));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(counts + i * 8), c);
+  }
+  count_free_scalar(words + full * 8, n - full * 8, counts + full * 8);
+}
+#endif
+
+struct PopcountKernels {
+  const char *name_;
+  void (*count_free_)(const uint64_t *words, size_t n, uint8_t *counts);
+  bool (*supported_)();
+};
+
+const PopcountKernels POPCOUNT_KERNELS[] = {
+#if defined(__x86_64__)
+    {"avx512", count_free_avx512,
+     []() {
+       return __builtin_cpu_supports("avx512f") &&
+              __builtin_cpu_supports("avx512vpopcntdq");
+     }},
+    {"avx2", count_free_avx2,
+     []() { return (bool)__builtin_cpu_supports("avx2"); }},
+#endif
+    {"scalar", count_free_scalar, []() { return true; }},
+};
+
+KernelTable<PopcountKernels> &popcount_kernels() {
+  static KernelTable<PopcountKernels> kernels(POPCOUNT_KERNELS);
+  return kernels;
+}
+
+bool is_in_use(uint32_t state) {
+  return state == XDesEntryView::XDES_FREE_FRAG ||
+         state == XDesEntryView::XDES_FULL_FRAG ||
+         state == XDesEntryView::XDES_FSEG ||
+         state == XDesEntryView::XDES_FSEG_FRAG;
+}
+
+} // namespace
+
+const char *innodb::popcount_impl() { return popcount_kernels().name(); }
+
+bool innodb::set_popcount_impl(const std::string &name) {
+  return popcount_kernels().select(name);
+}
+
+bool ExtentMap::is_page_free(uint32_t page_no) const {
+  size_t extent = page_no / extent_pages_;
+  if (extent >= n_extents())
+    return false;
+  uint32_t i = page_no % extent_pages_;
+  return bitmaps_[extent * words_per_extent_ + i / 32] >> (i % 32 * 2) & 1;
+}
+
+void ExtentMap::count_free() {
+  std::vector<uint8_t> counts(bitmaps_.size());
+  popcount_kernels()->count_free_(bitmaps_.data(), bitmaps_.size(),
+                                  counts.data());
+  n_free_.resize(n_extents());
+  const uint8_t *c = counts.data();
+  for (size_t e = 0; e < n_free_.size(); ++e) {
+    uint16_t n = 0;
+    for (uint32_t w = 0; w < words_per_extent_; ++w)
+      n += *c++;
+    n_free_[e] = n;
+  }
+}
+
+bool ExtentMap::load(FileSpaceReader *reader) {
+  page_size_ = reader->get_page_size();
+  extent_pages_ = extent_pages(page_size_);
+  words_per_extent_ = extent_pages_ * XDesEntryView::XDES_BITS_PER_PAGE / 64;
+  bad_xdes_pages_ = 0;
+  const uint32_t n_pages = reader->get_page_count();
+  if (n_pages == 0) {
+    LOG(ERROR) << "the space has no page";
+    return false;
+  }
+  const size_t n = (n_pages + extent_pages_ - 1) / extent_pages_;
+  seg_ids_.assign(n, 0);
+  states_.assign(n, XDesEntryView::XDES_NOT_INITED);
+  bitmaps_.assign(n * words_per_extent_, 0);
+
+  const uint32_t per_page = XDES_E::entries_per_page(page_size_);
+  const size_t bitmap_bytes = words_per_extent_ * sizeof(uint64_t);
+  for (uint32_t page_no = 0; page_no < n_pages; page_no += page_size_) {
+    PageGuard pg = reader->fetch_page(page_no);
+    uint16_t type = pg ? pg.as<PageView>().page_type() : 0;
+    if (pg && type == FIL_PAGE_TYPE_ALOCATED)
+      continue; // past the free limit, not initialized yet
+    if (!pg ||
+        (type != FIL_PAGE_TYPE_FSP_HDR && type != FIL_PAGE_TYPE_XDES)) {
+      LOG(ERROR) << "page " << page_no << " isn't an XDES page";
+      ++bad_xdes_pages_;
+      continue;
+    }
+    XDESPageView view(pg.buf(), page_size_);
+    const size_t first = page_no / extent_pages_;
+    for (uint32_t i = 0; i < per_page && first + i < n; ++i) {
+      XDesEntryView entry = view.xdes_entry(i);
+      seg_ids_[first + i] = entry.seg_id();
+      states_[first + i] = entry.state();
+      memcpy(&bitmaps_[(first + i) * words_per_extent_], entry.bitmap(),
+             bitmap_bytes);
+    }
+  }
+  count_free();
+  return true;
+}
+
+FragmentationReport FragmentationReport::build(const ExtentMap &map) {
+  FragmentationReport r;
+  r.page_size_ = map.page_size_;
+  r.n_extents_ = map.n_extents();
+  std::map<uint64_t, SegmentUsage> segments;
+  for (size_t e = 0; e < map.n_extents(); ++e) {
+    uint32_t state = map.states_[e];
+    if (state < XDesEntryView::XDES_N_STATES)
+      ++r.extents_by_state_[state];
+    if (!is_in_use(state))
+      continue;
+    r.used_pages_ += map.n_used(e);
+    r.free_pages_in_use_ += map.n_free_[e];
+    if (state != XDesEntryView::XDES_FSEG &&
+        state != XDesEntryView::XDES_FSEG_FRAG)
+      continue;
+    SegmentUsage &s = segments[map.seg_ids_[e]];
+    s.seg_id_ = map.seg_ids_[e];
+    ++s.n_extents_;
+    s.used_pages_ += map.n_used(e);
+    s.free_pages_ += map.n_free_[e];
+  }
+  for (auto &it : segments)
+    r.segments_.push_back(it.second);
+  r.valid_ = true;
+  return r;
+}
+
+FragmentationReport FragmentationReport::of_file(const std::string &file) {
+  FileSpaceReader reader(file.c_str(), ReadMode::PREAD, REPORT_CACHE_BYTES);
+  PageGuard page0 = reader.fetch_page(0);
+  if (!page0) {
+    LOG(ERROR) << "no fragmentation report of " << file
+               << ", page 0 is unreadable";
+    FragmentationReport r;
+    r.file_ = file;
+    return r;
+  }
+  uint32_t space_id = page0.as<PageView>().space_id();
+  page0 = PageGuard();
+  ExtentMap map;
+  FragmentationReport r;
+  if (map.load(&reader))
+    r = build(map);
+  r.file_ = file;
+  r.space_id_ = space_id;
+  r.n_pages_ = reader.get_page_count();
+  return r;
+}
+
+std::vector<FragmentationReport>
+FragmentationReport::of_files(const std::vector<std::string> &files,
+                              uint32_t n_threads) {
+  std::vector<FragmentationReport> reports(files.size());
+  parallel_for(files.size(), n_threads,
+               [&](size_t i) { reports[i] = of_file(files[i]); });
+  return reports;
+}
+
+void FragmentationReport::dump(std::ostringstream &oss) const {
+  static const char *STATES[XDesEntryView::XDES_N_STATES] = {
+      "not_inited", "free", "free_frag", "full_frag", "fseg", "fseg_frag"};
+  oss << "FragmentationReport of " << file_ << " space " << space_id_
+      << ": pages: " << n_pages_ << ", extents: " << n_extents_
+      << ", used pages: " << used_pages_
+      << ", free pages in use: " << free_pages_in_use_
+      << ", fragmentation: " << fragmentation() << "\nextents:";
+  for (uint32_t s = 0; s < XDesEntryView::XDES_N_STATES; ++s)
+    oss << " " << STATES[s] << ": " << extents_by_state_[s];
+  oss << std::endl;
+  for (const auto &s : segments_) {
+    oss << "segment " << s.seg_id_ << ": extents: " << s.n_extents_
+        << ", used pages: " << s.used_pages_
+        << ", free pages: " << s.free_pages_
+        << ", fill factor: " << s.fill_factor() << std::endl;
+  }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "file_space_reader.h"
+#include "page_view.h"
+#include <string>
+#include <vector>
+
+namespace innodb {
+
+/// @brief name of the popcount kernels picked for this cpu, "avx512",
+/// "avx2" or "scalar"
+const char *popcount_impl();
+/// @brief use other popcount kernels, for the tests and the benchmarks,
+/// not while extent maps are loaded on other threads
+/// @return false if the name is unknown or the cpu lacks the instructions
+bool set_popcount_impl(const std::string &name);
+
+/// @brief the extent descriptors of a whole tablespace, decoded from all the
+/// XDES pages, the FSP header page and one XDES page every page_size pages,
+/// into a structure of arrays indexed by the extent number. The page state
+/// bitmaps are packed back to back so that the free pages of all the
+/// extents are counted by vectorized popcounts in one pass.
+struct ExtentMap {
+  uint32_t page_size_ = PAGE_SIZE;
+  uint32_t extent_pages_ = XDES_E::PAGES_PER_EXTENT;
+  /// the bitmap of an extent, 2 words for the 64 pages extents
+  uint32_t words_per_extent_ = 2;
+  std::vector<uint64_t> seg_ids_;
+  std::vector<uint32_t> states_;
+  /// the bitmaps as read from the pages, bit 2 * i of the bitmap is the
+  /// free bit of page i of the extent
+  std::vector<uint64_t> bitmaps_;
+  /// the free pages of each extent, counted when loaded
+  std::vector<uint16_t> n_free_;
+  /// XDES pages which couldn't be read, their extents are left NOT_INITED
+  uint32_t bad_xdes_pages_ = 0;
+
+  size_t n_extents() const { return states_.size(); }
+  uint32_t n_used(size_t extent) const {
+    return extent_pages_ - n_free_[extent];
+  }
+  bool is_page_free(uint32_t page_no) const;
+
+  /// @brief decode the extents of the pages of the space
+  bool load(FileSpaceReader *reader);
+  /// @brief count n_free_ from the bitmaps, done by load
+  void count_free();
+};
+
+/// @brief the pages of the extents of one segment
+struct SegmentUsage {
+  uint64_t seg_id_ = 0;
+  uint32_t n_extents_ = 0;
+  uint64_t used_pages_ = 0;
+  uint64_t free_pages_ = 0; // inside the extents of the segment
+
+  /// @brief the used share of the pages of its extents
+  double fill_factor() const {
+    uint64_t total = used_pages_ + free_pages_;
+    return total ? (double)used_pages_ / total : 1.0;
+  }
+};
+
+/// @brief how the pages of a tablespace are spread over its extents. The
+/// free pages inside the extents in use are space a rebuild would give back,
+/// the free extents are already reusable by the space.
+struct FragmentationReport {
+  std::string file_;
+  uint32_t space_id_ = 0;
+  uint32_t page_size_ = PAGE_SIZE;
+  uint32_t n_pages_ = 0;
+  uint32_t n_extents_ = 0;
+  uint32_t extents_by_state_[XDesEntryView::XDES_N_STATES] = {};
+  uint64_t used_pages_ = 0;
+  /// free pages inside the extents of the segments and the fragment extents
+  uint64_t free_pages_in_use_ = 0;
+  /// segments by their id
+  std::vector<SegmentUsage> segments_;
+  bool valid_ = false;
+
+  /// @brief the free share of the pages of the extents in use, 0 for a
+  /// compact space
+  double fragmentation() const {
+    uint64_t total = used_pages_ + free_pages_in_use_;
+    return total ? (double)free_pages_in_use_ / total : 0;
+  }
+  /// @brief the bytes a rebuild would reclaim from the extents in use
+  uint64_t reclaimable_bytes() const {
+    return free_pages_in_use_ * page_size_;
+  }
+
+  static FragmentationReport build(const ExtentMap &map);
+  /// @brief the report of one file, invalid if it couldn't be read
+  static FragmentationReport of_file(const std::string &file);
+  /// @brief the reports of the files in the order given, read by a pool of
+  /// threads
+  /// @param n_threads 0 means one thread per hardware thread
+  static std::vector<FragmentationReport>
+  of_files(const std::vector<std::string> &files, uint32_t n_threads = 0);
+
+  void dump(std::ostringstream &oss) const;
+};
+
+} // namespace innodb
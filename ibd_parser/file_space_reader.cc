@@ -1,83 +1,300 @@
 #include "file_space_reader.h"
+#include "page_trace.h"
 #include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
 #include <filesystem>
 #include <glog/logging.h>
 #include <iostream>
+#include <sys/uio.h>
+#include <unistd.h>
 
 using namespace innodb;
 
-FileSpaceReader::FileSpaceReader(const char *file)
-    : file_name_(file), file_opened_(false), ifs_() {
+FileSpaceReader::FileSpaceReader(const char *file, ReadMode mode,
+                                 size_t cache_capacity_bytes, bool huge_pages)
+    : file_name_(file), file_opened_(false), open_result_(-1),
+      read_mode_(mode), page_size_(PAGE_SIZE), fd_(-1), mmap_file_(file_name_),
+      frame_pool_(huge_pages),
+      page_cache_(cache_capacity_bytes, PageCache::DEFAULT_SHARDS,
+                  &frame_pool_),
+      trace_(nullptr) {
   assert(file);
 }
 FileSpaceReader::~FileSpaceReader() {
-  if (ifs_.is_open())
-    ifs_.close();
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+PageGuard FileSpaceReader::fetch_page(unsigned int index) {
+  if (!trace_)
+    return load_page(index, nullptr);
+  bool hit = false;
+  auto start = std::chrono::steady_clock::now();
+  PageGuard guard = load_page(index, &hit);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  trace_->record(PageAccess(index, hit, !guard, ns));
+  return guard;
+}
+
+PageGuard FileSpaceReader::load_page(unsigned int index, bool *hit) {
+  // the page size must be known before anything goes into the cache
+  if (0 != open_file()) {
+    return PageGuard();
+  }
+  PageGuard guard = page_cache_.lookup(index);
+  if (hit)
+    *hit = (bool)guard;
+  if (guard)
+    return guard;
+  // read page and put into the page cache
+  if (read_mode_ == ReadMode::MMAP) {
+    const byte *mapped = mapped_page(index);
+    if (!mapped) {
+      LOG(ERROR) << "map page error at index: " << index;
+      return PageGuard();
+    }
+    return page_cache_.insert(index, mapped, nullptr);
+  }
+  uint64_t offset = static_cast<uint64_t>(index) * page_size_;
+  unsigned char *buf = frame_pool_.alloc();
+  if (!buf) {
+    LOG(ERROR) << "no frame for page: " << index;
+    return PageGuard();
+  }
+  if (static_cast<long>(page_size_) != read_page(offset, buf, page_size_)) {
+    LOG(ERROR) << "read page error at index: " << index;
+    frame_pool_.free(buf);
+    return PageGuard();
+  }
+  return page_cache_.insert(index, (const byte *)buf, buf);
 }
 
 Page *FileSpaceReader::get_page(unsigned int index) {
-  if (index >= pages_.size() || pages_[index] == nullptr) {
-    // read page and set into pages_
-    std::streampos offset{};
-    offset = index * PAGE_SIZE;
-    Page *page = nullptr;
-    unsigned char *buf = (unsigned char *)calloc(1, PAGE_SIZE);
-    if (0 > read_page(offset, buf, PAGE_SIZE)) {
-      LOG(ERROR) << "read page error at index: " << index;
-      free(buf);
-      return nullptr;
-    }
-    Page::init_page((const byte *)buf, &page);
-    pages_.resize(index + 1, nullptr);
-    pages_[index] = page;
-    return page;
-  } else {
-    return pages_[index];
+  return fetch_page(index).get();
+}
+
+long FileSpaceReader::read_page(uint64_t offset, unsigned char *buf,
+                                size_t size) {
+  size_t bytes_read = 0;
+  while (bytes_read < size) {
+    auto n = ::pread(fd_, buf + bytes_read, size - bytes_read,
+                     offset + bytes_read);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      LOG(ERROR) << "file read err " << file_name_ << " " << strerror(errno);
+      return -1;
+    }
+    if (n == 0)
+      break; // end of the file
+    bytes_read += n;
   }
+  return bytes_read;
 }
 
-long FileSpaceReader::read_page(std::streampos offset, unsigned char *buf,
-                                std::streamsize size) {
-  if (!ifs_.is_open() && 0 != open_file()) {
+long FileSpaceReader::read_pages(uint32_t first_page, uint32_t n_pages) {
+  if (0 != open_file()) {
     return -1;
   }
-  std::streamsize bytes_read = 0;
-  try {
-    auto &s = ifs_.seekg(offset);
-    bytes_read = s.readsome((char *)buf, size);
-  } catch (std::ios_base::failure &e) {
-    LOG(ERROR) << "file read err " << e.code() << " " << e.what();
-    return -1;
+  if (read_mode_ == ReadMode::MMAP) {
+    if (0 != mmap_file_.advise(AccessPattern::WILLNEED,
+                               static_cast<size_t>(first_page) * page_size_,
+                               static_cast<size_t>(n_pages) * page_size_))
+      return -1;
+    return n_pages;
+  }
+  long pages_read = 0;
+  std::vector<unsigned char *> bufs;
+  uint32_t end = first_page + n_pages;
+  uint32_t cur = first_page;
+  while (cur < end) {
+    // find the next run of pages which are not cached
+    while (cur < end && page_cache_.contains(cur))
+      ++cur;
+    uint32_t run_end = cur;
+    while (run_end < end && !page_cache_.contains(run_end))
+      ++run_end;
+    if (cur == run_end)
+      break;
+    bufs.clear();
+    for (uint32_t i = cur; i < run_end; ++i) {
+      unsigned char *buf = frame_pool_.alloc();
+      if (!buf) {
+        LOG(ERROR) << "no frame for page: " << i;
+        break;
+      }
+      bufs.push_back(buf);
+    }
+    if (bufs.empty()) {
+      return -1;
+    }
+    long bytes = read_pages_v(static_cast<uint64_t>(cur) * page_size_,
+                              bufs.data(), bufs.size());
+    size_t n_full = bytes < 0 ? 0 : bytes / page_size_;
+    for (size_t i = 0; i < bufs.size(); ++i) {
+      if (i >= n_full) {
+        frame_pool_.free(bufs[i]);
+        continue;
+      }
+      page_cache_.insert(cur + i, (const byte *)bufs[i], bufs[i]);
+    }
+    if (bytes < 0)
+      return -1;
+    pages_read += n_full;
+    if (n_full < bufs.size())
+      break; // reached the end of the file
+    cur += bufs.size();
   }
+  return pages_read;
+}
 
+long FileSpaceReader::read_pages_v(uint64_t offset,
+                                   unsigned char *const *bufs,
+                                   size_t n_pages) {
+  const size_t total = n_pages * page_size_;
+  size_t bytes_read = 0;
+  std::vector<struct iovec> iov;
+  while (bytes_read < total) {
+    size_t page = bytes_read / page_size_;
+    size_t in_page = bytes_read % page_size_;
+    iov.clear();
+    for (size_t i = page; i < n_pages && iov.size() < IOV_MAX; ++i) {
+      size_t skip = i == page ? in_page : 0;
+      iov.push_back({bufs[i] + skip, page_size_ - skip});
+    }
+    auto n = ::preadv(fd_, iov.data(), iov.size(), offset + bytes_read);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      LOG(ERROR) << "file read err " << file_name_ << " " << strerror(errno);
+      return -1;
+    }
+    if (n == 0)
+      break; // end of the file
+    bytes_read += n;
+  }
   return bytes_read;
 }
 
+const byte *FileSpaceReader::mapped_page(unsigned int index) {
+  if (0 != open_file()) {
+    return nullptr;
+  }
+  size_t offset = static_cast<size_t>(index) * page_size_;
+  if (offset + page_size_ > mmap_file_.size()) {
+    LOG(ERROR) << "page " << index << " is out of file " << file_name_
+               << " with size: " << mmap_file_.size();
+    return nullptr;
+  }
+  return reinterpret_cast<const byte *>(mmap_file_.data() + offset);
+}
+
+int FileSpaceReader::advise(AccessPattern pattern) {
+  if (read_mode_ != ReadMode::MMAP)
+    return 0;
+  if (0 != open_file()) {
+    return -1;
+  }
+  return mmap_file_.advise(pattern);
+}
+
 int FileSpaceReader::open_file() {
+  if (file_opened_.load(std::memory_order_acquire))
+    return open_result_;
+  std::lock_guard<std::mutex> lock(open_mutex_);
+  if (file_opened_.load(std::memory_order_relaxed))
+    return open_result_;
+  open_result_ = -1;
   if (!std::filesystem::exists(std::filesystem::path(file_name_))) {
     LOG(ERROR) << "File Space reader open file error, file not exists "
                << file_name_;
-    return -1;
+  } else if (read_mode_ == ReadMode::MMAP) {
+    open_result_ = mmap_file_.open();
+  } else {
+    if (read_mode_ == ReadMode::DIRECT) {
+      fd_ = ::open(file_name_.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+      if (fd_ < 0 && errno == EINVAL) {
+        // file systems like tmpfs don't support O_DIRECT
+        LOG(WARNING) << "O_DIRECT isn't supported for " << file_name_
+                     << ", fall back to buffered reads";
+      }
+    }
+    if (fd_ < 0)
+      fd_ = ::open(file_name_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      LOG(ERROR) << "file " << file_name_
+                 << " isn't opened: " << strerror(errno);
+    } else {
+      open_result_ = 0;
+    }
   }
-  ifs_.open(file_name_, std::ios::in);
-  if (!ifs_.is_open()) {
-    LOG(ERROR) << "file " << file_name_ << " isn't opened";
+  if (open_result_ == 0)
+    open_result_ = detect_page_size();
+  file_opened_.store(true, std::memory_order_release);
+  return open_result_;
+}
+
+int FileSpaceReader::detect_page_size() {
+  uint32_t flags = 0;
+  if (read_mode_ == ReadMode::MMAP) {
+    if (mmap_file_.size() < PAGE_SIZE_MIN) {
+      LOG(ERROR) << "file " << file_name_ << " is smaller than a page";
+      return -1;
+    }
+    flags = FSPHeader::space_flags(
+        reinterpret_cast<const byte *>(mmap_file_.data()));
+  } else {
+    // the smallest page holds the fsp header, the buffer is aligned for
+    // O_DIRECT
+    void *buf = nullptr;
+    if (0 != ::posix_memalign(&buf, PAGE_SIZE_MIN, PAGE_SIZE_MIN)) {
+      LOG(ERROR) << "no memory to read the fsp header of " << file_name_;
+      return -1;
+    }
+    long n = read_page(0, static_cast<unsigned char *>(buf), PAGE_SIZE_MIN);
+    if (n == static_cast<long>(PAGE_SIZE_MIN))
+      flags = FSPHeader::space_flags(static_cast<const byte *>(buf));
+    ::free(buf);
+    if (n != static_cast<long>(PAGE_SIZE_MIN)) {
+      LOG(ERROR) << "file " << file_name_ << " is smaller than a page";
+      return -1;
+    }
+  }
+  uint32_t page_size = FSPHeader::page_size_from_flags(flags);
+  if (page_size == 0) {
+    LOG(ERROR) << "invalid page size in the space flags: " << flags
+               << " of file " << file_name_;
     return -1;
   }
+  if (!frame_pool_.set_frame_bytes(page_size) ||
+      !page_cache_.set_page_size(page_size))
+    return -1;
+  page_size_ = page_size;
   return 0;
 }
 
+unsigned int FileSpaceReader::get_page_size() {
+  open_file();
+  return page_size_;
+}
+
 const FSPHeaderPage *FileSpaceReader::get_fsp_header_page() const {
   return static_cast<const FSPHeaderPage *>(get_page(FSP_HEADER_PAGE_NUM));
 }
 
 uint32_t FileSpaceReader::get_page_count() {
-  auto fsp_header_page = get_fsp_header_page();
+  auto fsp_header_page = fetch_page(FSP_HEADER_PAGE_NUM);
   if (!fsp_header_page) {
     LOG(ERROR) << "Fail to get fsp header page";
     return 0;
   }
-  return fsp_header_page->fsp_header_.fsp_size_;
+  return fsp_header_page.as<FSPHeaderPageView>().fsp_size();
 }
 
 void FileSpaceReader::dump_space() {
@@ -87,13 +304,19 @@ void FileSpaceReader::dump_space() {
   printf("%s", oss.str().c_str());
   oss.str("");
 
-  const auto *fsp_header_page = get_fsp_header_page();
+  auto fsp_header_guard = fetch_page(FSP_HEADER_PAGE_NUM);
+  if (!fsp_header_guard) {
+    LOG(ERROR) << "Fail to get fsp header page";
+    return;
+  }
+  const auto *fsp_header_page =
+      static_cast<const FSPHeaderPage *>(fsp_header_guard.get());
   oss << "fsp header page: " << "\n";
   fsp_header_page->dump(oss);
   printf("%s", oss.str().c_str());
   oss.str("");
   for (uint32_t i = 1; i < 5; ++i) {
-    auto pg = get_page(i);
+    auto pg = fetch_page(i);
     if (!pg) {
       LOG(ERROR) << "Fail to get page: " << i;
       continue;
@@ -170,14 +393,25 @@ void FileSpaceReader::traverse_xdes_list(const ListBaseNode &base_node,
     cur.page_number_ = base_node.first_page_number_;
     cur.offset_ = base_node.first_offset_;
     while (cur.valid()) {
-      auto pg = get_page(cur.page_number_);
-      uint32_t entry_num = (cur.offset_ - FILHeader::FIL_PAGE_DATA -
-                            FSPHeader::FSP_HEADER_SIZE) /
-                           XDES_E::XDES_E_SIZE;
-      const XDES_E *xdes_entry = pg->get_xdes_entry(entry_num);
-      func(*xdes_entry, cur);
-      cur.page_number_ = xdes_entry->list_node_for_xdes_e_.next_page_number_;
-      cur.offset_ = xdes_entry->list_node_for_xdes_e_.next_offset_;
+      auto pg = fetch_page(cur.page_number_);
+      if (!pg) {
+        LOG(ERROR) << "Fail to get xdes page: " << cur.page_number_;
+        break;
+      }
+      uint32_t entry_num = (cur.offset_ - XDES_E::XDES_ARR_OFFSET) /
+                           XDES_E::entry_size(page_size_);
+      auto xdes_page = pg.as<XDESPageView>();
+      if (cur.offset_ < XDES_E::XDES_ARR_OFFSET ||
+          entry_num >= xdes_page.n_xdes_entries()) {
+        LOG(ERROR) << "Fail to get xdes entry at page: " << cur.page_number_
+                   << " offset: " << cur.offset_;
+        break;
+      }
+      // decode only the entry, the page object isn't needed
+      const XDES_E xdes_entry = xdes_page.xdes_entry(entry_num).decode();
+      func(xdes_entry, cur);
+      cur.page_number_ = xdes_entry.list_node_for_xdes_e_.next_page_number_;
+      cur.offset_ = xdes_entry.list_node_for_xdes_e_.next_offset_;
     }
   }
 }
@@ -189,8 +423,12 @@ void FileSpaceReader::traverse_inode_list(
     cur.page_number_ = base_node.first_page_number_;
     cur.offset_ = base_node.first_offset_;
     while (cur.valid()) {
-      auto pg = get_page(cur.page_number_);
-      const INodePage *inode_page = static_cast<INodePage *>(pg);
+      auto pg = fetch_page(cur.page_number_);
+      if (!pg) {
+        LOG(ERROR) << "Fail to get inode page: " << cur.page_number_;
+        break;
+      }
+      const INodePage *inode_page = static_cast<INodePage *>(pg.get());
       func(*inode_page, cur);
       cur.page_number_ =
           inode_page->list_node_for_INODE_page_list_.next_page_number_;
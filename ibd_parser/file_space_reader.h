@@ -1,31 +1,92 @@
 #pragma once
+#include "mmap_file.h"
 #include "page.h"
-#include <fstream>
+#include "page_cache.h"
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <string>
 
 namespace innodb {
 
-/// @brief
+class PageTrace;
+
+/// @brief how the reader gets the page data from the file
+enum class ReadMode {
+  PREAD,  // every page is copied into a pooled frame with pread
+  MMAP,   // the file is mapped, pages point straight into the mapping
+  DIRECT, // like PREAD but with O_DIRECT, bypasses the OS page cache
+};
+
+/// @brief reads and caches the pages of one tablespace file. fetch_page is
+/// thread safe and its PageGuard keeps the page valid, the file is read with
+/// positional reads on a shared fd and the page cache is sharded, so several
+/// threads could decode one file in parallel. The unpinned pages of get_page
+/// and get_fsp_header_page may be evicted by any other call, they are for
+/// single threaded use only.
 class FileSpaceReader {
 public:
   static constexpr int32_t FSP_HEADER_PAGE_NUM = 0;
-  FileSpaceReader(const char *file);
+  /// @param huge_pages back the page frames with huge pages
+  FileSpaceReader(
+      const char *file, ReadMode mode = ReadMode::PREAD,
+      size_t cache_capacity_bytes = PageCache::DEFAULT_CAPACITY_BYTES,
+      bool huge_pages = false);
   ~FileSpaceReader();
 
+  ReadMode get_read_mode() const { return read_mode_; }
+
+  /// @brief hint the expected access pattern of the whole file, only takes
+  /// effect in ReadMode::MMAP
+  /// @return -1 when got error, 0 for succeed.
+  int advise(AccessPattern pattern);
+
+  /// @brief get the specified page and pin it in the page cache
+  /// @param index the index of the page
+  /// @return empty guard if reader got error, the page stays valid while the
+  /// guard is alive
+  PageGuard fetch_page(unsigned int index);
+
+  /// @brief read continuous pages with as few large I/Os as possible and put
+  /// them into the page cache unpinned, the cached ones are skipped. In
+  /// ReadMode::MMAP the range is only advised as WILLNEED.
+  /// @param first_page the first page of the range
+  /// @param n_pages the number of pages in the range
+  /// @return the number of pages read, -1 for error
+  long read_pages(uint32_t first_page, uint32_t n_pages);
+
   /// @brief get the specified page
   /// @param index the index of the page
-  /// @return nullptr if reader got error, other the pageptr is returned
+  /// @return nullptr if reader got error, other the pageptr is returned. The
+  /// page isn't pinned, it's valid until the page cache evicts it, which may
+  /// happen on the following get_page calls, use fetch_page to hold a page.
+  /// Single threaded only, another thread may evict the page at any time.
   Page* get_page(unsigned int index);
 
   const Page* get_page(unsigned int index) const {
     return const_cast<FileSpaceReader*>(this)->get_page(index);
   }
 
+  /// @brief the unpinned page 0, single threaded only like get_page
   const FSPHeaderPage* get_fsp_header_page() const ;
 
+  /// @brief record every fetch_page and get_page into the trace, nullptr
+  /// turns the tracing off. Set it before the reader is shared by threads,
+  /// the trace must outlive the reader or be detached first.
+  void set_trace(PageTrace *trace) { trace_ = trace; }
+  PageTrace *get_trace() const { return trace_; }
+
+  const PageCache &get_page_cache() const { return page_cache_; }
+  const FramePool &get_frame_pool() const { return frame_pool_; }
+
   uint32_t get_page_count();
 
+  /// @brief the page size of the tablespace, detected from the space flags
+  /// of page 0 when the file is opened, opens the file if not yet
+  unsigned int get_page_size();
+  /// @brief pages in one extent of the tablespace
+  uint32_t get_extent_size() { return extent_pages(get_page_size()); }
+
   void dump_space();
 
   using traverse_xdes_entry_func = std::function<void(const XDES_E &, Addr addr)>;
@@ -38,23 +99,51 @@ public:
       std::function<void(const INodePage &, Addr addr)> func);
 
 private:
-  /// @brief open the file
+  /// @brief open the file, or map it in ReadMode::MMAP, only the first call
+  /// opens, the later ones return the result of the first one
   /// @return -1 when got error, check errno, 0 for succeed.
   int open_file();
 
-  /// @brief read data from the opened file, call open_file first
+  /// @brief read the space flags of page 0 and set the page size of the
+  /// reader, the page cache and the frame pool, called by open_file
+  /// @return -1 if the page size is invalid or the read failed
+  int detect_page_size();
+
+  /// @brief fetch_page without the tracing
+  /// @param hit set to whether the page was cached, if not nullptr
+  PageGuard load_page(unsigned int index, bool *hit);
+
+  /// @brief read data from the file at the offset, safe to be called
+  /// concurrently, the file must be opened
   /// @param offset the offset to read from
   /// @param buf the buffer to store the data read
   /// @param size the size to read
-  /// @return return the bytes read, -1 for error, check errno
-  long read_page(std::streampos offset, unsigned char *buf,
-                 std::streamsize size = PAGE_SIZE);
+  /// @return return the bytes read, less than size if reached the end of the
+  /// file, -1 for error, check errno
+  long read_page(uint64_t offset, unsigned char *buf, size_t size);
+
+  /// @brief scatter read into the page buffers with preadv
+  /// @return the bytes read, -1 for error
+  long read_pages_v(uint64_t offset, unsigned char *const *bufs,
+                    size_t n_pages);
+
+  /// @brief get the pointer of the page inside the mapping, map the file
+  /// first if not mapped yet
+  /// @return nullptr if the page is out of the file or mmap failed
+  const byte *mapped_page(unsigned int index);
 
 private:
   std::string file_name_;
-  bool file_opened_;
-  std::ifstream ifs_;
-  std::vector<Page*> pages_;
+  std::atomic<bool> file_opened_;
+  std::mutex open_mutex_;
+  int open_result_;
+  ReadMode read_mode_;
+  unsigned int page_size_;
+  int fd_;
+  MmapFile mmap_file_;
+  FramePool frame_pool_;
+  PageCache page_cache_;
+  PageTrace *trace_;
 
   std::vector<XDES_E> full_frag_extents_;
   std::vector<XDES_E> free_frag_extents_;
@@ -0,0 +1,125 @@
+#include "frame_pool.h"
+#include "defines.h"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <glog/logging.h>
+#include <sys/mman.h>
+
+using namespace innodb;
+
+FramePool::FramePool(bool huge_pages, size_t slab_bytes, size_t frame_bytes)
+    : huge_pages_(huge_pages), slab_bytes_(slab_bytes),
+      frame_bytes_(is_valid_page_size(frame_bytes) ? frame_bytes : PAGE_SIZE),
+      mutex_(), slabs_(), free_frames_(), n_frames_(0) {}
+
+bool FramePool::set_frame_bytes(size_t frame_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!is_valid_page_size(frame_bytes)) {
+    LOG(ERROR) << "invalid frame size: " << frame_bytes;
+    return false;
+  }
+  if (frame_bytes == frame_bytes_)
+    return true;
+  if (!slabs_.empty()) {
+    LOG(ERROR) << "can't change the frame size after frames are allocated";
+    return false;
+  }
+  frame_bytes_ = frame_bytes;
+  return true;
+}
+
+FramePool::~FramePool() {
+  if (free_frames_.size() != n_frames_)
+    LOG(ERROR) << n_frames_ - free_frames_.size()
+               << " frames are still in use when destroying the pool";
+  for (auto &slab : slabs_)
+    ::munmap(slab.addr_, slab.bytes_);
+}
+
+bool FramePool::add_slab() {
+  void *addr = MAP_FAILED;
+  size_t slab_bytes =
+      (std::max(slab_bytes_, frame_bytes_) + frame_bytes_ - 1) /
+      frame_bytes_ * frame_bytes_;
+  size_t bytes = slab_bytes;
+  unsigned char *start = nullptr;
+  if (huge_pages_) {
+    bytes = (slab_bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES *
+            HUGE_PAGE_BYTES;
+    addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      start = static_cast<unsigned char *>(addr);
+    } else {
+      // no reserved huge page, align the slab to a huge page ourselves and
+      // ask for transparent huge pages
+      bytes += HUGE_PAGE_BYTES;
+      addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (addr != MAP_FAILED) {
+        start = static_cast<unsigned char *>(
+            align_down(static_cast<unsigned char *>(addr) + HUGE_PAGE_BYTES -
+                           1,
+                       HUGE_PAGE_BYTES));
+        ::madvise(start, bytes - HUGE_PAGE_BYTES, MADV_HUGEPAGE);
+      }
+    }
+  } else {
+    // mmap only aligns to the system page, over allocate to align to
+    // the frame size
+    bytes += frame_bytes_;
+    addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr != MAP_FAILED) {
+      start = reinterpret_cast<unsigned char *>(
+          page_align(static_cast<unsigned char *>(addr) + frame_bytes_ - 1,
+                     frame_bytes_));
+    }
+  }
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "frame pool mmap slab error: " << strerror(errno);
+    return false;
+  }
+  slabs_.push_back({addr, bytes});
+  size_t n = slab_bytes / frame_bytes_;
+  // hand out the frames from the start of the slab first
+  for (size_t i = n; i > 0; --i)
+    free_frames_.push_back(start + (i - 1) * frame_bytes_);
+  n_frames_ += n;
+  return true;
+}
+
+unsigned char *FramePool::alloc() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_frames_.empty() && !add_slab())
+    return nullptr;
+  unsigned char *frame = free_frames_.back();
+  free_frames_.pop_back();
+  return frame;
+}
+
+void FramePool::free(unsigned char *frame) {
+  if (!frame)
+    return;
+  assert(align_offset(frame, frame_bytes_) == 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_frames_.push_back(frame);
+}
+
+size_t FramePool::n_slabs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return slabs_.size();
+}
+
+size_t FramePool::n_free_frames() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_frames_.size();
+}
+
+size_t FramePool::n_used_frames() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return n_frames_ - free_frames_.size();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "defines.h"
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace innodb {
+
+/// @brief hands out page frames carved from large slabs. Freed frames are
+/// kept in a free list and reused, slabs are only returned to the system when
+/// the pool is destroyed. The frames are aligned to the frame size, so
+/// page_align() works on any pointer into them, and they are suitable
+/// buffers for O_DIRECT reads.
+class FramePool {
+public:
+  static constexpr size_t DEFAULT_SLAB_BYTES = 2UL * 1024 * 1024;
+  static constexpr size_t HUGE_PAGE_BYTES = 2UL * 1024 * 1024;
+
+  /// @param huge_pages back the slabs with huge pages, MAP_HUGETLB first and
+  /// transparent huge pages if no huge page is reserved
+  /// @param slab_bytes size of each slab, rounded up to the frame size
+  /// @param frame_bytes the page size of the tablespace
+  explicit FramePool(bool huge_pages = false,
+                     size_t slab_bytes = DEFAULT_SLAB_BYTES,
+                     size_t frame_bytes = PAGE_SIZE);
+  ~FramePool();
+  FramePool(const FramePool &) = delete;
+  FramePool &operator=(const FramePool &) = delete;
+
+  /// @brief get a frame, the content is not zeroed
+  /// @return nullptr if no memory
+  unsigned char *alloc();
+
+  /// @brief give the frame back to the pool, nullptr is ignored
+  void free(unsigned char *frame);
+
+  /// @brief change the frame size, only allowed before the first alloc
+  /// @return false if frames were already handed out or the size is not a
+  /// valid page size
+  bool set_frame_bytes(size_t frame_bytes);
+  size_t frame_bytes() const { return frame_bytes_; }
+
+  size_t n_slabs() const;
+  size_t n_free_frames() const;
+  size_t n_used_frames() const;
+  bool huge_pages() const { return huge_pages_; }
+
+private:
+  /// @brief map a new slab and put its frames into the free list, called
+  /// with the mutex held
+  /// @return false if no memory
+  bool add_slab();
+
+private:
+  struct Slab {
+    void *addr_;   // start of the mapping
+    size_t bytes_; // length of the mapping
+  };
+  bool huge_pages_;
+  size_t slab_bytes_;
+  size_t frame_bytes_;
+  mutable std::mutex mutex_;
+  std::vector<Slab> slabs_;
+  std::vector<unsigned char *> free_frames_;
+  size_t n_frames_;
+};
+
+} // namespace innodb
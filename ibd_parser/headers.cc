@@ -16,7 +16,20 @@ const std::unordered_map<uint16_t, std::string> innodb::PAGE_TYPE_STR = {
     {FIL_PAGE_TYPE_TRX_SYS, "FIL_PAGE_TYPE_TRX_SYS"},
     {FIL_PAGE_TYPE_FSP_HDR, "FIL_PAGE_TYPE_FSP_HDR"},
     {FIL_PAGE_TYPE_XDES, "FIL_PAGE_TYPE_XDES"},
+    {FIL_PAGE_TYPE_BLOB, "FIL_PAGE_TYPE_BLOB"},
+    {FIL_PAGE_TYPE_ZBLOB, "FIL_PAGE_TYPE_ZBLOB"},
+    {FIL_PAGE_TYPE_ZBLOB2, "FIL_PAGE_TYPE_ZBLOB2"},
     {FIL_PAGE_TYPE_UNKNOWN, "FIL_PAGE_TYPE_UNKNOWN"},
+    {FIL_PAGE_SDI_BLOB, "FIL_PAGE_SDI_BLOB"},
+    {FIL_PAGE_SDI_ZBLOB, "FIL_PAGE_SDI_ZBLOB"},
+    {FIL_PAGE_TYPE_LOB_INDEX, "FIL_PAGE_TYPE_LOB_INDEX"},
+    {FIL_PAGE_TYPE_LOB_DATA, "FIL_PAGE_TYPE_LOB_DATA"},
+    {FIL_PAGE_TYPE_LOB_FIRST, "FIL_PAGE_TYPE_LOB_FIRST"},
+    {FIL_PAGE_TYPE_ZLOB_FIRST, "FIL_PAGE_TYPE_ZLOB_FIRST"},
+    {FIL_PAGE_TYPE_ZLOB_DATA, "FIL_PAGE_TYPE_ZLOB_DATA"},
+    {FIL_PAGE_TYPE_ZLOB_INDEX, "FIL_PAGE_TYPE_ZLOB_INDEX"},
+    {FIL_PAGE_TYPE_ZLOB_FRAG, "FIL_PAGE_TYPE_ZLOB_FRAG"},
+    {FIL_PAGE_TYPE_ZLOB_FRAG_ENTRY, "FIL_PAGE_TYPE_ZLOB_FRAG_ENTRY"},
     {FIL_PAGE_TYPE_SDI, "FIL_PAGE_SDI"},
     {FIL_PAGE_RTREE, "FIL_PAGE_RTREE"},
     {FIL_PAGE_INDEX, "FIL_PAGE_INDEX"}};
@@ -93,23 +106,27 @@ const char *innodb::get_rec_type(uint8_t rec_t) {
   return p;
 }
 
-void RecordHeader::dump(const byte *rec, std::ostringstream &oss) {
+void RecordHeader::dump(const byte *rec, std::ostringstream &oss,
+                        ulint page_size) {
   using namespace std;
-  oss << "rec: off: " << (ulint)(rec - (const byte *)align_down(rec, PAGE_SIZE))
+  const byte *pg = page_align(rec, page_size);
+  oss << "rec: off: " << (ulint)(rec - pg)
       << "\tinfo_bits: " << std::to_string(info_bits(rec)) << "\t"
       << "num_of_recs_owned: " << std::to_string(num_of_recs_owned(rec)) << "\t"
       << "heap_no_new: " << heap_no_new(rec) << "\t"
       << "rec_status: " << get_rec_type(rec_status(rec)) << "\t";
 
+  uint16_t next = dispatch_page_size(page_size, [rec](auto traits) {
+    return next_offs<decltype(traits)::SIZE>(rec);
+  });
   switch (rec_status(rec)) {
   case REC_STATUS_INFIMUM:
   case REC_STATUS_SUPREMUM:
   case REC_STATUS_ORDINARY:
-    oss << "next_offs: " << next_offs(rec) << "\t";
+    oss << "next_offs: " << next << "\t";
     break;
   case REC_STATUS_NODE_PTR:
-    oss << "next_ptr: "
-        << next_ptr(rec) - (const byte *)align_down(rec, PAGE_SIZE) << "\t";
+    oss << "next_ptr: " << next << "\t";
     break;
   default:
     break;
@@ -117,202 +134,36 @@ void RecordHeader::dump(const byte *rec, std::ostringstream &oss) {
   oss << endl;
 }
 
-void Records::dump(const byte *pg, std::ostringstream &oss) {
+template <ulint page_size>
+static void dump_records(const byte *pg, std::ostringstream &oss) {
   auto *const infimum = pg + PAGE_NEW_INFIMUM;
   auto *const supremum = pg + PAGE_NEW_SUPREMUM;
 
   auto *cur = infimum;
   while (cur != supremum) {
-    if (RecordHeader::rec_status(cur) == REC_STATUS_ORDINARY ||
-        RecordHeader::rec_status(cur) == REC_STATUS_INFIMUM) {
-      RecordHeader::dump(cur, oss);
-      cur = pg + RecordHeader::next_offs(cur);
-    } else {
-      RecordHeader::dump(cur, oss);
-      assert(RecordHeader::rec_status(cur) == REC_STATUS_NODE_PTR);
-      cur = RecordHeader::next_ptr(cur);
+    RecordHeader::dump(cur, oss, page_size);
+    uint16_t next = RecordHeader::next_offs<page_size>(cur);
+    if (next == 0) {
+      oss << "broken record list, no next record" << std::endl;
+      return;
     }
+    cur = pg + next;
   }
-  RecordHeader::dump(supremum, oss);
+  RecordHeader::dump(supremum, oss, page_size);
 }
 
-void IndexPageDirectory::dump(const byte *pg, std::ostringstream &oss) {
+void Records::dump(const byte *pg, std::ostringstream &oss, ulint page_size) {
+  dispatch_page_size(page_size, [&](auto traits) {
+    dump_records<decltype(traits)::SIZE>(pg, oss);
+  });
+}
+
+void IndexPageDirectory::dump(const byte *pg, std::ostringstream &oss,
+                              ulint page_size) {
   ulint n_slot = IndexHeader::n_of_dir_slots(pg);
   oss << "page directory: n of slots: " << n_slot << "\t";
   for (ulint i = 0; i < n_slot; ++i) {
-    oss << get_slot_rec(get_nth_slot(pg, i)) - pg << "\t";
+    oss << mach_read_from_2(get_nth_slot(pg, i, page_size)) << "\t";
   }
   oss << std::endl;
 }
-
-const ListNode *XDesEntryList::get_xdes_entry_list_node(FileSpaceReader *reader,
-                                                        Addr &addr) const {
-  auto *page = reader->get_page(addr.page_number_);
-  if (!page) {
-    return nullptr; // Error handling: page not found
-  }
-  uint32_t entry_num =
-      (addr.offset_ - FILHeader::FIL_PAGE_DATA - FSPHeader::FSP_HEADER_SIZE) /
-      XDES_E::XDES_E_SIZE;
-  auto *xdes_entry = page->get_xdes_entry(entry_num);
-  if (!xdes_entry) {
-    return nullptr; // Error handling: xdes entry not found
-  }
-  const_cast<XDES_E *>(xdes_entry)->list_node_for_xdes_e_.addr.page_number_ =
-      addr.page_number_;
-  const_cast<XDES_E *>(xdes_entry)->list_node_for_xdes_e_.addr.offset_ =
-      addr.offset_;
-  return &xdes_entry->list_node_for_xdes_e_;
-}
-const ListNode *XDesEntryList::first(FileSpaceReader *reader) const {
-  if (list_length_ == 0) {
-    return nullptr;
-  }
-  Addr addr(first_page_number_, first_offset_);
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  return get_xdes_entry_list_node(reader, addr);
-}
-const ListNode *XDesEntryList::last(FileSpaceReader *reader) const {
-  if (list_length_ == 0) {
-    return nullptr;
-  }
-  Addr addr(last_page_number_, last_offset_);
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  return get_xdes_entry_list_node(reader, addr);
-}
-
-const ListNode *XDesEntryListNode::next(FileSpaceReader *reader) const {
-  Addr addr(next_page_number_, next_offset_);
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  auto *page = reader->get_page(addr.page_number_);
-  if (!page) {
-    return nullptr; // Error handling: page not found
-  }
-  int32_t entry_num =
-      (addr.offset_ - FILHeader::FIL_PAGE_DATA - FSPHeader::FSP_HEADER_SIZE) /
-      XDES_E::XDES_E_SIZE;
-  auto *xdes_entry = page->get_xdes_entry(entry_num);
-  if (!xdes_entry) {
-    return nullptr; // Error handling: xdes entry not found
-  }
-  const_cast<XDES_E *>(xdes_entry)->list_node_for_xdes_e_.addr.page_number_ =
-      addr.page_number_;
-  const_cast<XDES_E *>(xdes_entry)->list_node_for_xdes_e_.addr.offset_ =
-      addr.offset_;
-  return &xdes_entry->list_node_for_xdes_e_;
-}
-const XDES_E *XDesEntryListNode::xdes(FileSpaceReader *reader) const {
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  auto *page = reader->get_page(addr.page_number_);
-  if (!page) {
-    return nullptr; // Error handling: page not found
-  }
-  int32_t entry_num =
-      (addr.offset_ - FILHeader::FIL_PAGE_DATA - FSPHeader::FSP_HEADER_SIZE) /
-      XDES_E::XDES_E_SIZE;
-  auto *xdes_entry = page->get_xdes_entry(entry_num);
-  if (!xdes_entry) {
-    return nullptr; // Error handling: xdes entry not found
-  }
-  return xdes_entry;
-}
-
-const ListNode *INodeEntryList::first(FileSpaceReader *reader) const {
-  if (list_length_ == 0) {
-    return nullptr;
-  }
-  Addr addr(first_page_number_, first_offset_);
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  auto *page = reader->get_page(addr.page_number_);
-  if (!page) {
-    return nullptr; // Error handling: page not found
-  }
-  auto *inode_page = static_cast<const INodePage *>(page);
-  const_cast<INodePage *>(inode_page)
-      ->list_node_for_INODE_page_list_.addr.page_number_ = addr.page_number_;
-  const_cast<INodePage *>(inode_page)
-      ->list_node_for_INODE_page_list_.addr.offset_ = addr.offset_;
-  return &inode_page->list_node_for_INODE_page_list_;
-}
-const ListNode *INodeEntryList::last(FileSpaceReader *reader) const {
-  if (list_length_ == 0) {
-    return nullptr;
-  }
-  Addr addr(last_page_number_, last_offset_);
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  auto *page = reader->get_page(addr.page_number_);
-  if (!page) {
-    return nullptr; // Error handling: page not found
-  }
-  auto *inode_page = static_cast<const INodePage *>(page);
-  return &inode_page->list_node_for_INODE_page_list_;
-}
-
-const ListNode *INodeEntryListNode::next(FileSpaceReader *reader) const {
-  Addr addr(next_page_number_, next_offset_);
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  auto *page = reader->get_page(addr.page_number_);
-  if (!page) {
-    return nullptr; // Error handling: page not found
-  }
-  auto *inode_page = static_cast<const INodePage *>(page);
-  const_cast<INodePage *>(inode_page)
-      ->list_node_for_INODE_page_list_.addr.page_number_ = addr.page_number_;
-  const_cast<INodePage *>(inode_page)
-      ->list_node_for_INODE_page_list_.addr.offset_ = addr.offset_;
-  return &inode_page->list_node_for_INODE_page_list_;
-}
-const std::vector<INode_E> *
-INodeEntryListNode::inode_arr(FileSpaceReader *reader) const {
-  if (!addr.valid()) {
-    return nullptr; // Error handling: invalid address
-  }
-  auto *page = reader->get_page(addr.page_number_);
-  if (!page) {
-    return nullptr; // Error handling: page not found
-  }
-  auto *inode_page = static_cast<const INodePage *>(page);
-  return &inode_page->inode_arr_;
-}
-
-const std::vector<INode_E> *
-FSEG_HEADER::leaf_inode(FileSpaceReader *reader) const {
-  Addr addr(leaf_page_inode_addr_.page_number_, leaf_page_inode_addr_.offset_);
-  if (!addr.valid()) {
-    return nullptr;
-  }
-  auto *pg = reader->get_page(addr.page_number_);
-  if (!pg) {
-    return nullptr; // Error handling: page not found
-  }
-  auto *inode_page = static_cast<INodePage *>(pg);
-  return &inode_page->inode_arr_;
-}
-const std::vector<INode_E> *
-FSEG_HEADER::external_inode(FileSpaceReader *reader) const {
-  Addr addr(internal_page_inode_addr_.page_number_,
-            internal_page_inode_addr_.offset_);
-  if (!addr.valid()) {
-    return nullptr;
-  }
-  auto *pg = reader->get_page(addr.page_number_);
-  if (!pg) {
-    return nullptr; // Error handling: page not found
-  }
-  auto inode_page = static_cast<INodePage *>(pg);
-  return &inode_page->inode_arr_;
-}
\ No newline at end of file
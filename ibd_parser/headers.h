@@ -25,12 +25,31 @@ enum PAGE_TYPE {
   FIL_PAGE_TYPE_TRX_SYS = 7,
   FIL_PAGE_TYPE_FSP_HDR = 8,
   FIL_PAGE_TYPE_XDES = 9,
+  FIL_PAGE_TYPE_BLOB = 10,   // the uncompressed BLOB pages of 5.7
+  FIL_PAGE_TYPE_ZBLOB = 11,  // the first compressed BLOB page
+  FIL_PAGE_TYPE_ZBLOB2 = 12, // the next compressed BLOB pages
   FIL_PAGE_TYPE_UNKNOWN = 13,
+  FIL_PAGE_SDI_BLOB = 18,
+  FIL_PAGE_SDI_ZBLOB = 19,
+  FIL_PAGE_TYPE_LOB_INDEX = 20, // the LOB index entries of 8.0
+  FIL_PAGE_TYPE_LOB_DATA = 21,
+  FIL_PAGE_TYPE_LOB_FIRST = 22,
+  FIL_PAGE_TYPE_ZLOB_FIRST = 23, // the compressed LOBs of 8.0
+  FIL_PAGE_TYPE_ZLOB_DATA = 24,
+  FIL_PAGE_TYPE_ZLOB_INDEX = 25,
+  FIL_PAGE_TYPE_ZLOB_FRAG = 26,
+  FIL_PAGE_TYPE_ZLOB_FRAG_ENTRY = 27,
   FIL_PAGE_TYPE_SDI = 17853,
   FIL_PAGE_RTREE = 17854,
   FIL_PAGE_INDEX = 17855
 };
 
+/// @brief the page belongs to a B+tree of compact records, a user index or
+/// the SDI index
+inline bool fil_page_is_index(uint16_t page_type) {
+  return page_type == FIL_PAGE_INDEX || page_type == FIL_PAGE_TYPE_SDI;
+}
+
 constexpr ulint FIL_ADDR_SIZE = 6;
 constexpr ulint FLST_BASE_NODE_SIZE = 4 + 2 * FIL_ADDR_SIZE;
 
@@ -66,11 +85,6 @@ struct ListNode {
         << "next_page_number: " << next_page_number_ << "\t"
         << "next_offset: " << next_offset_ << std::endl;
   }
-  virtual const ListNode *next(FileSpaceReader *reader) const = 0;
-  virtual const XDES_E *xdes(FileSpaceReader *) const { return nullptr; }
-  virtual const std::vector<INode_E> *inode_arr(FileSpaceReader *) const {
-    return nullptr;
-  }
 };
 
 struct ListBaseNode {
@@ -116,8 +130,6 @@ struct ListBaseNode {
       oss << "(empty list)" << "\n";
     }
   }
-  virtual const ListNode *first(FileSpaceReader *reader) const = 0;
-  virtual const ListNode *last(FileSpaceReader *reader) const = 0;
 };
 
 struct Addr {
@@ -137,15 +149,12 @@ struct Addr {
 };
 
 struct XDesEntryListNode : public ListNode {
-  Addr addr;
   XDesEntryListNode() = default;
 
   void dump(std::ostringstream &oss) const {
     oss << "XDesEntryListNode: ";
     ListNode::dump(oss);
   }
-  const ListNode *next(FileSpaceReader *reader) const override;
-  const XDES_E *xdes(FileSpaceReader *reader) const override;
 };
 
 struct XDesEntryList : public ListBaseNode {
@@ -156,22 +165,15 @@ struct XDesEntryList : public ListBaseNode {
     oss << "XDesEntryList: ";
     ListBaseNode::dump(oss);
   }
-  const ListNode *get_xdes_entry_list_node(FileSpaceReader *reader,
-                                           Addr &addr) const;
-  const ListNode *first(FileSpaceReader *reader) const override;
-  const ListNode *last(FileSpaceReader *reader) const override;
 };
 
 struct INodeEntryListNode : public ListNode {
   int a;
-  Addr addr;
   INodeEntryListNode() = default;
   void dump(std::ostringstream &oss) const {
     oss << "INodeListNode: ";
     ListNode::dump(oss);
   }
-  const ListNode *next(FileSpaceReader *reader) const override;
-  const std::vector<INode_E> *inode_arr(FileSpaceReader *reader) const override;
 };
 
 struct INodeEntryList : public ListBaseNode {
@@ -182,8 +184,6 @@ struct INodeEntryList : public ListBaseNode {
     oss << "INodeEntryList: ";
     ListBaseNode::dump(oss);
   }
-  const ListNode *first(FileSpaceReader *reader) const override;
-  const ListNode *last(FileSpaceReader *reader) const override;
 };
 
 struct FILHeader {
@@ -205,7 +205,7 @@ struct FILHeader {
   uint16_t page_type_;
   uint64_t flush_lsn_;
   uint32_t space_id_;
-  static constexpr uint8_t FIL_PAGE_SPACE_OR_CHKSUM = 8;
+  static constexpr uint8_t FIL_PAGE_SPACE_OR_CHKSUM = 0;
   static constexpr uint8_t FIL_PAGE_OFFSET = 4;
   static constexpr uint8_t FIL_PAGE_PREV = 8;
   static constexpr uint8_t FIL_PAGE_SRV_VERSION = 8;
@@ -218,6 +218,8 @@ struct FILHeader {
 
   static constexpr uint8_t FIL_PAGE_DATA = 38;
   static constexpr uint8_t FIL_PAGE_DATA_END = 8; // size of the page tailer
+  // the old style checksum and the low 4 bytes of the LSN in the tailer
+  static constexpr uint8_t FIL_PAGE_END_LSN_OLD_CHKSUM = 8;
 
   static uint32_t check_sum(const byte *p) {
     return mach_read_from_4(p + FIL_PAGE_SPACE_OR_CHKSUM);
@@ -243,6 +245,12 @@ struct FILHeader {
   static uint32_t space_id(const byte *p) {
     return mach_read_from_4(p + FIL_PAGE_SPACE_ID);
   }
+  static uint32_t tailer_check_sum(const byte *p, ulint page_size) {
+    return mach_read_from_4(p + page_size - FIL_PAGE_END_LSN_OLD_CHKSUM);
+  }
+  static uint32_t tailer_lsn(const byte *p, ulint page_size) {
+    return mach_read_from_4(p + page_size - FIL_PAGE_END_LSN_OLD_CHKSUM + 4);
+  }
   void dump(std::ostringstream &oss) const;
 };
 
@@ -317,6 +325,18 @@ struct FSPHeader {
   static uint32_t space_flags(const byte *pg) {
     return mach_read_from_4(pg + FSP_HEADER_OFFSET + FSP_SPACE_FLAGS);
   }
+  static constexpr uint32_t FSP_FLAGS_POS_PAGE_SSIZE = 6;
+  static constexpr uint32_t FSP_FLAGS_MASK_PAGE_SSIZE =
+      0xFU << FSP_FLAGS_POS_PAGE_SSIZE;
+  /// @brief the page size in bytes from the space flags, 0 for invalid
+  static uint32_t page_size_from_flags(uint32_t flags) {
+    uint32_t ssize =
+        (flags & FSP_FLAGS_MASK_PAGE_SSIZE) >> FSP_FLAGS_POS_PAGE_SSIZE;
+    if (ssize == 0)
+      return PAGE_SIZE; // the flags of 16K pages have no ssize
+    uint32_t page_size = 512U << ssize;
+    return is_valid_page_size(page_size) ? page_size : 0;
+  }
   static uint32_t frag_n_used(const byte *pg) {
     return mach_read_from_4(pg + FSP_HEADER_OFFSET + FSP_FRAG_N_USED);
   }
@@ -352,7 +372,27 @@ struct XDES_E {
   XDesEntryListNode list_node_for_xdes_e_;
   uint32_t state;
   byte page_state[16];
-  static constexpr unsigned char XDES_E_SIZE = 40;
+  static constexpr unsigned char XDES_E_SIZE = 40; // of 16K pages
+  static constexpr uint32_t PAGES_PER_EXTENT = 64;  // of 16K pages
+  static constexpr uint32_t XDES_ARR_OFFSET =
+      FILHeader::FIL_PAGE_DATA + FSPHeader::FSP_HEADER_SIZE;
+  static constexpr uint32_t XDES_BITMAP = 24;
+  /// @brief size of an entry, 2 bits per page of the extent
+  static constexpr uint32_t entry_size(ulint page_size) {
+    return XDES_BITMAP + extent_pages(page_size) * 2 / 8;
+  }
+  /// @brief entries of an xdes page, an xdes page every page_size pages
+  static constexpr uint32_t entries_per_page(ulint page_size) {
+    return page_size / extent_pages(page_size);
+  }
+  /// @brief the first page of the extent described by the entry at addr, the
+  /// xdes page at page N describes the extents from page N on
+  static uint32_t extent_first_page(const Addr &addr,
+                                    ulint page_size = PAGE_SIZE) {
+    return addr.page_number_ + (addr.offset_ - XDES_ARR_OFFSET) /
+                                   entry_size(page_size) *
+                                   extent_pages(page_size);
+  }
   XDES_E() : fi_seg_id(UINT64_MAX), list_node_for_xdes_e_(), state(0) {}
   bool inited() const { return fi_seg_id != UINT64_MAX; }
   void init(const byte *buf) {
@@ -376,12 +416,13 @@ struct XDES_E {
     list_node_for_xdes_e_.dump(oss);
     dump_page_state_bitmap(oss);
   }
+  /// @brief the free bit, the first of the 2 bits of the page, is set
   bool is_page_free(uint32_t page_num) const {
-    if (page_num >= 64) {
+    if (page_num >= PAGES_PER_EXTENT) {
       return false; // Invalid page number
     }
-    byte b = page_state[page_num / 4];
-    return ((char)b & (1 << (page_num * 2))) == 0;
+    uint8_t b = (uint8_t)page_state[page_num / 4];
+    return (b >> (page_num % 4 * 2)) & 1;
   }
 };
 
@@ -525,7 +566,7 @@ struct FSEG_HEADER {
         mach_read_from_2(FSEG_HDR_LEAF_OFFSET + fseg_header(pg));
 
     internal_page_inode_space_id_ =
-        mach_read_from_4(fseg_header(pg) + FSEG_HDR_INTERNAL_PAGE_NO);
+        mach_read_from_4(fseg_header(pg) + FSEG_HDR_INTERNAL_SPACE);
     internal_page_inode_addr_.page_number_ =
         mach_read_from_4(fseg_header(pg) + FSEG_HDR_INTERNAL_PAGE_NO);
     internal_page_inode_addr_.offset_ =
@@ -535,10 +576,11 @@ struct FSEG_HEADER {
   static constexpr uint8_t FSEG_HDR_LEAF_SPACE = 0;
   static constexpr uint8_t FSEG_HDR_LEAF_PAGE_NO = 4;
   static constexpr uint8_t FSEG_HDR_LEAF_OFFSET = 8;
-  static constexpr uint8_t FSEG_HDR_INTERNAL_SPACE = 12;
-  static constexpr uint8_t FSEG_HDR_INTERNAL_PAGE_NO = 16;
-  static constexpr uint8_t FSEG_HDR_INTERNAL_OFFSET = 20;
   static constexpr uint8_t FSEG_HEADER_SIZE = 10;
+  /// the header of the non leaf segment follows the one of the leaves
+  static constexpr uint8_t FSEG_HDR_INTERNAL_SPACE = FSEG_HEADER_SIZE;
+  static constexpr uint8_t FSEG_HDR_INTERNAL_PAGE_NO = FSEG_HEADER_SIZE + 4;
+  static constexpr uint8_t FSEG_HDR_INTERNAL_OFFSET = FSEG_HEADER_SIZE + 8;
   static constexpr uint8_t FSEG_PAGE_DATA = FILHeader::FIL_PAGE_DATA;
   static const byte *fseg_header(const byte *pg) {
     return pg + FSPHeader::FSP_HEADER_OFFSET + PAGE_BTR_SEG_LEAF;
@@ -560,8 +602,6 @@ struct FSEG_HEADER {
         << ", internal_page_inode_addr: ";
     internal_page_inode_addr_.dump(oss);
   }
-  const std::vector<INode_E> *leaf_inode(FileSpaceReader *reader) const;
-  const std::vector<INode_E> *external_inode(FileSpaceReader *reader) const;
 };
 
 const char *get_rec_type(uint8_t rec_t);
@@ -582,13 +622,16 @@ constexpr auto PAGE_NEW_SUPREMUM = PAGE_DATA + 2 * REC_N_EXTRA_BYTES + 8;
 constexpr auto PAGE_NEW_SUPREMUM_END = PAGE_NEW_SUPREMUM + 8;
 
 struct Records {
-  static void dump(const byte *pg, std::ostringstream &oss);
+  static void dump(const byte *pg, std::ostringstream &oss,
+                   ulint page_size = PAGE_SIZE);
 };
 
 struct RecordHeader {
   static constexpr uint8_t REC_NEW_INFO_BITS = 5;
   static constexpr auto REC_INFO_BITS_MASK = 0xF0UL;
   static constexpr uint8_t REC_INFO_BITS_SHIFT = 0;
+  static constexpr uint8_t REC_INFO_MIN_REC_FLAG = 0x10;
+  static constexpr uint8_t REC_INFO_DELETED_FLAG = 0x20;
 
   static constexpr uint8_t REC_NEW_N_OWNED = 5;
   static constexpr auto REC_N_OWNED_MASK = 0xFUL;
@@ -621,39 +664,71 @@ struct RecordHeader {
     return rec_get_bit_field_1(rec, REC_NEW_STATUS, REC_NEW_STAUTS_MASK,
                                REC_NEW_STATUS_SHIFT);
   }
+  /// @brief offset of the next record inside the page, the record pointers
+  /// wrap around inside the page, so it depends on the page size
+  template <ulint page_size = PAGE_SIZE>
   static inline uint16_t next_offs(const byte *rec) {
     ulint field_value = mach_read_from_2(rec - REC_NEXT);
 
     if (field_value == 0)
       return 0;
-    return align_offset(rec + field_value, PAGE_SIZE);
+    return align_offset(rec + field_value, page_size);
+  }
+
+  /// @brief offset of the next record of the record at offset of the page,
+  /// unlike the one above the page buffer needn't be page aligned
+  template <ulint page_size = PAGE_SIZE>
+  static inline uint16_t next_offs(const byte *pg, uint16_t offset) {
+    ulint field_value = mach_read_from_2(pg + offset - REC_NEXT);
+    if (field_value == 0)
+      return 0;
+    return (offset + field_value) & (page_size - 1);
+  }
+
+  static inline uint16_t next_offs(const byte *pg, uint16_t offset,
+                                   ulint page_size) {
+    ulint field_value = mach_read_from_2(pg + offset - REC_NEXT);
+    if (field_value == 0)
+      return 0;
+    return (offset + field_value) & (page_size - 1);
   }
 
+  template <ulint page_size = PAGE_SIZE>
   static inline byte *next_ptr(const byte *rec) {
     ulint field_value = mach_read_from_2(rec - REC_NEXT);
     if (field_value == 0)
       return nullptr;
 
-    return ((byte *)align_down(rec, PAGE_SIZE) +
-            align_offset(rec + field_value, PAGE_SIZE));
+    return ((byte *)align_down(rec, page_size) +
+            align_offset(rec + field_value, page_size));
   }
 
-  static void dump(const byte *rec, std::ostringstream &oss);
+  static void dump(const byte *rec, std::ostringstream &oss,
+                   ulint page_size = PAGE_SIZE);
 };
 
 struct IndexPageDirectory {
   static constexpr uint8_t PAGE_DIR_SLOT_SIZE = 2;
   static constexpr uint8_t PAGE_DIR = FILHeader::FIL_PAGE_DATA_END;
+  static constexpr uint8_t PAGE_DIR_SLOT_MAX_N_OWNED = 8;
+  template <ulint page_size = PAGE_SIZE>
   static inline const byte *get_nth_slot(const byte *pg, ulint n) {
-    return pg + PAGE_SIZE - PAGE_DIR - (n + 1) * PAGE_DIR_SLOT_SIZE;
+    return pg + page_size - PAGE_DIR - (n + 1) * PAGE_DIR_SLOT_SIZE;
+  }
+  static inline const byte *get_nth_slot(const byte *pg, ulint n,
+                                         ulint page_size) {
+    return pg + page_size - PAGE_DIR - (n + 1) * PAGE_DIR_SLOT_SIZE;
   }
+  template <ulint page_size = PAGE_SIZE>
   static inline const byte *get_slot_rec(const byte *slot) {
-    return page_align(slot) + mach_read_from_2(slot);
+    return page_align<page_size>(slot) + mach_read_from_2(slot);
   }
+  template <ulint page_size = PAGE_SIZE>
   static inline ulint slot_get_n_owned(const byte *slot) {
-    return RecordHeader::num_of_recs_owned(get_slot_rec(slot));
+    return RecordHeader::num_of_recs_owned(get_slot_rec<page_size>(slot));
   }
-  static void dump(const byte *pg, std::ostringstream &oss);
+  static void dump(const byte *pg, std::ostringstream &oss,
+                   ulint page_size = PAGE_SIZE);
 };
 
 struct DictHeader {
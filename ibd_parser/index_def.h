@@ -0,0 +1,114 @@
+#pragma once
+#include "defines.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace innodb {
+
+/// @brief a field of an index record as laid out on disk. For the clustered
+/// index the fields are the primary key columns, DB_TRX_ID, DB_ROLL_PTR and
+/// then the other columns, for a secondary index the key columns and then
+/// the primary key columns missing from them.
+struct FieldDef {
+  std::string name_;
+  uint16_t fixed_len_ = 0; // 0 for a variable length field
+  uint32_t max_len_ = 0;   // max bytes of a variable length field
+  bool nullable_ = false;
+  bool blob_ = false; // BLOB/TEXT/JSON, could be stored off page
+
+  /// @brief the length of a variable length field takes 2 bytes when it
+  /// could be longer than 255 bytes
+  bool two_byte_len() const { return blob_ || max_len_ > 255; }
+
+  static FieldDef fixed(std::string name, uint16_t len,
+                        bool nullable = false) {
+    FieldDef f;
+    f.name_ = std::move(name);
+    f.fixed_len_ = len;
+    f.nullable_ = nullable;
+    return f;
+  }
+  static FieldDef variable(std::string name, uint32_t max_len,
+                           bool nullable = false, bool blob = false) {
+    FieldDef f;
+    f.name_ = std::move(name);
+    f.max_len_ = max_len;
+    f.nullable_ = nullable;
+    f.blob_ = blob;
+    return f;
+  }
+};
+
+/// @brief the record format of an index, enough to find the fields of its
+/// compact records and compare keys
+struct IndexDef {
+  static constexpr uint16_t DATA_TRX_ID_LEN = 6;
+  static constexpr uint16_t DATA_ROLL_PTR_LEN = 7;
+  static constexpr uint16_t REC_NODE_PTR_SIZE = 4;
+
+  uint64_t index_id_ = 0;
+  std::vector<FieldDef> fields_;
+  /// fields identifying a record in the tree, the key of the node pointers
+  uint16_t n_uniq_ = 1;
+  bool clustered_ = true;
+
+  uint16_t n_fields() const { return fields_.size(); }
+  /// @brief nullable fields of the leaf records, the size of the null bitmap
+  /// of both the leaf and the node pointer records
+  uint16_t n_nullable() const {
+    uint16_t n = 0;
+    for (const auto &f : fields_)
+      n += f.nullable_;
+    return n;
+  }
+};
+
+/// @brief a search key, the fields are encoded like in the records, e.g.
+/// integers big endian with the sign bit flipped, see encode_int
+struct SearchKey {
+  std::vector<std::string> fields_;
+  std::vector<bool> nulls_;
+
+  SearchKey &add(std::string field) {
+    fields_.push_back(std::move(field));
+    nulls_.push_back(false);
+    return *this;
+  }
+  SearchKey &add_null() {
+    fields_.emplace_back();
+    nulls_.push_back(true);
+    return *this;
+  }
+  uint16_t size() const { return fields_.size(); }
+};
+
+/// @brief encode an integer column the way innodb stores it, big endian and
+/// the sign bit flipped for signed ones, so memcmp orders them
+inline std::string encode_int(int64_t v, uint8_t len, bool is_unsigned) {
+  uint64_t u = static_cast<uint64_t>(v);
+  if (!is_unsigned)
+    u ^= 1ULL << (len * 8 - 1);
+  std::string s(len, '\0');
+  for (int i = len - 1; i >= 0; --i) {
+    s[i] = static_cast<char>(u & 0xff);
+    u >>= 8;
+  }
+  return s;
+}
+
+/// @brief decode an integer column written by encode_int
+inline int64_t decode_int(const byte *p, uint8_t len, bool is_unsigned) {
+  uint64_t u = 0;
+  for (uint8_t i = 0; i < len; ++i)
+    u = (u << 8) | static_cast<uint8_t>(p[i]);
+  if (!is_unsigned) {
+    u ^= 1ULL << (len * 8 - 1);
+    // sign extend
+    if (len < 8 && (u >> (len * 8 - 1)) & 1)
+      u |= ~0ULL << (len * 8);
+  }
+  return static_cast<int64_t>(u);
+}
+
+} // namespace innodb
@@ -0,0 +1,300 @@
+#include "json.h"
+#include <cstdlib>
+
+using namespace innodb;
+
+namespace {
+
+/// nested arrays and objects deeper than this are rejected
+constexpr uint32_t JSON_MAX_DEPTH = 256;
+
+class JsonParser {
+public:
+  explicit JsonParser(std::string_view text) : text_(text) {}
+
+  bool parse(JsonValue &value, std::string *err) {
+    bool ok = parse_value(value, 0);
+    skip_ws();
+    if (ok && pos_ != text_.size())
+      ok = fail("trailing characters");
+    if (!ok && err)
+      *err = error_ + " at " + std::to_string(pos_);
+    return ok;
+  }
+
+private:
+  bool fail(const char *what) {
+    if (error_.empty())
+      error_ = what;
+    return false;
+  }
+
+  void skip_ws() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+            text_[pos_] == '\r'))
+      ++pos_;
+  }
+
+  bool consume(std::string_view word) {
+    if (text_.substr(pos_, word.size()) != word)
+      return fail("unexpected token");
+    pos_ += word.size();
+    return true;
+  }
+
+  bool parse_value(JsonValue &value, uint32_t depth) {
+    if (depth > JSON_MAX_DEPTH)
+      return fail("nested too deep");
+    skip_ws();
+    if (pos_ >= text_.size())
+      return fail("unexpected end");
+    switch (text_[pos_]) {
+    case '{':
+      return parse_object(value, depth);
+    case '[':
+      return parse_array(value, depth);
+    case '"':
+      value.type_ = JsonValue::Type::STRING;
+      return parse_string(value.str_);
+    case 't':
+      value.type_ = JsonValue::Type::BOOL;
+      value.bool_ = true;
+      return consume("true");
+    case 'f':
+      value.type_ = JsonValue::Type::BOOL;
+      value.bool_ = false;
+      return consume("false");
+    case 'n':
+      value.type_ = JsonValue::Type::NUL;
+      return consume("null");
+    default:
+      return parse_number(value);
+    }
+  }
+
+  bool parse_object(JsonValue &value, uint32_t depth) {
+    value.type_ = JsonValue::Type::OBJECT;
+    ++pos_; // {
+    skip_ws();
+    if (pos_ < text_.size() && text_[pos_] == '}') {
+      ++pos_;
+      return true;
+    }
+    while (true) {
+      skip_ws();
+      if (pos_ >= text_.size() || text_[pos_] != '"')
+        return fail("expect a member name");
+      value.obj_.emplace_back();
+      auto &member = value.obj_.back();
+      if (!parse_string(member.first))
+        return false;
+      skip_ws();
+      if (pos_ >= text_.size() || text_[pos_] != ':')
+        return fail("expect ':'");
+      ++pos_;
+      if (!parse_value(member.second, depth + 1))
+        return false;
+      skip_ws();
+      if (pos_ < text_.size() && text_[pos_] == ',') {
+        ++pos_;
+        continue;
+      }
+      if (pos_ < text_.size() && text_[pos_] == '}') {
+        ++pos_;
+        return true;
+      }
+      return fail("expect ',' or '}'");
+    }
+  }
+
+  bool parse_array(JsonValue &value, uint32_t depth) {
+    value.type_ = JsonValue::Type::ARRAY;
+    ++pos_; // [
+    skip_ws();
+    if (pos_ < text_.size() && text_[pos_] == ']') {
+      ++pos_;
+      return true;
+    }
+    while (true) {
+      value.arr_.emplace_back();
+      if (!parse_value(value.arr_.back(), depth + 1))
+        return false;
+      skip_ws();
+      if (pos_ < text_.size() && text_[pos_] == ',') {
+        ++pos_;
+        continue;
+      }
+      if (pos_ < text_.size() && text_[pos_] == ']') {
+        ++pos_;
+        return true;
+      }
+      return fail("expect ',' or ']'");
+    }
+  }
+
+  bool parse_hex4(uint32_t &cp) {
+    if (pos_ + 4 > text_.size())
+      return fail("bad \\u escape");
+    cp = 0;
+    for (int i = 0; i < 4; ++i) {
+      char c = text_[pos_++];
+      cp <<= 4;
+      if (c >= '0' && c <= '9')
+        cp |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        cp |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        cp |= c - 'A' + 10;
+      else
+        return fail("bad \\u escape");
+    }
+    return true;
+  }
+
+  static void append_utf8(std::string &s, uint32_t cp) {
+    if (cp < 0x80) {
+      s += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+      s += static_cast<char>(0xc0 | (cp >> 6));
+      s += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+      s += static_cast<char>(0xe0 | (cp >> 12));
+      s += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      s += static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+      s += static_cast<char>(0xf0 | (cp >> 18));
+      s += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+      s += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+      s += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+  }
+
+  bool parse_string(std::string &s) {
+    ++pos_; // "
+    while (pos_ < text_.size()) {
+      char c = text_[pos_++];
+      if (c == '"')
+        return true;
+      if (c != '\\') {
+        s += c;
+        continue;
+      }
+      if (pos_ >= text_.size())
+        break;
+      c = text_[pos_++];
+      switch (c) {
+      case '"':
+      case '\\':
+      case '/':
+        s += c;
+        break;
+      case 'b':
+        s += '\b';
+        break;
+      case 'f':
+        s += '\f';
+        break;
+      case 'n':
+        s += '\n';
+        break;
+      case 'r':
+        s += '\r';
+        break;
+      case 't':
+        s += '\t';
+        break;
+      case 'u': {
+        uint32_t cp;
+        if (!parse_hex4(cp))
+          return false;
+        // a surrogate pair
+        if (cp >= 0xd800 && cp < 0xdc00 && text_.substr(pos_, 2) == "\\u") {
+          pos_ += 2;
+          uint32_t low;
+          if (!parse_hex4(low))
+            return false;
+          cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+        }
+        append_utf8(s, cp);
+        break;
+      }
+      default:
+        return fail("bad escape");
+      }
+    }
+    return fail("unterminated string");
+  }
+
+  bool parse_number(JsonValue &value) {
+    size_t start = pos_;
+    bool is_int = true;
+    if (pos_ < text_.size() && text_[pos_] == '-')
+      ++pos_;
+    while (pos_ < text_.size()) {
+      char c = text_[pos_];
+      if (c >= '0' && c <= '9') {
+        ++pos_;
+      } else if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+        is_int = false;
+        ++pos_;
+      } else {
+        break;
+      }
+    }
+    if (pos_ == start)
+      return fail("unexpected character");
+    std::string num(text_.substr(start, pos_ - start));
+    char *end = nullptr;
+    value.type_ = JsonValue::Type::NUMBER;
+    value.num_ = strtod(num.c_str(), &end);
+    if (end != num.c_str() + num.size())
+      return fail("bad number");
+    if (!is_int)
+      value.int_ = static_cast<int64_t>(value.num_);
+    else if (num[0] == '-')
+      value.int_ = strtoll(num.c_str(), nullptr, 10);
+    else // the ids of the dictionary are unsigned 64 bits
+      value.int_ = static_cast<int64_t>(strtoull(num.c_str(), nullptr, 10));
+    return true;
+  }
+
+private:
+  std::string_view text_;
+  size_t pos_ = 0;
+  std::string error_;
+};
+
+} // namespace
+
+const JsonValue *JsonValue::get(std::string_view key) const {
+  if (type_ != Type::OBJECT)
+    return nullptr;
+  for (const auto &member : obj_) {
+    if (member.first == key)
+      return &member.second;
+  }
+  return nullptr;
+}
+
+int64_t JsonValue::get_int(std::string_view key, int64_t def) const {
+  const JsonValue *v = get(key);
+  return v && v->type_ == Type::NUMBER ? v->int_ : def;
+}
+
+bool JsonValue::get_bool(std::string_view key, bool def) const {
+  const JsonValue *v = get(key);
+  return v && v->type_ == Type::BOOL ? v->bool_ : def;
+}
+
+std::string JsonValue::get_str(std::string_view key,
+                               const std::string &def) const {
+  const JsonValue *v = get(key);
+  return v && v->type_ == Type::STRING ? v->str_ : def;
+}
+
+bool innodb::parse_json(std::string_view text, JsonValue &value,
+                        std::string *err) {
+  value = JsonValue();
+  return JsonParser(text).parse(value, err);
+}
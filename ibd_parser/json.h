@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace innodb {
+
+/// @brief a parsed JSON document, just enough for the serialized
+/// dictionary. Integers are kept exactly in int_, the object members keep
+/// their order.
+struct JsonValue {
+  enum class Type : uint8_t { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+  Type type_ = Type::NUL;
+  bool bool_ = false;
+  int64_t int_ = 0; // the integer part of a NUMBER
+  double num_ = 0;
+  std::string str_;
+  std::vector<JsonValue> arr_;
+  std::vector<std::pair<std::string, JsonValue>> obj_;
+
+  bool is_null() const { return type_ == Type::NUL; }
+  bool is_object() const { return type_ == Type::OBJECT; }
+  bool is_array() const { return type_ == Type::ARRAY; }
+
+  /// @brief the member of an object
+  /// @return nullptr if not an object or no such member
+  const JsonValue *get(std::string_view key) const;
+
+  /// @brief the member as a type, def if it is missing or of another type
+  int64_t get_int(std::string_view key, int64_t def = 0) const;
+  bool get_bool(std::string_view key, bool def = false) const;
+  std::string get_str(std::string_view key,
+                      const std::string &def = std::string()) const;
+};
+
+/// @brief parse a JSON text
+/// @param err the reason and the position on error, could be nullptr
+/// @return false if the text isn't valid JSON
+bool parse_json(std::string_view text, JsonValue &value,
+                std::string *err = nullptr);
+
+} // namespace innodb
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace innodb {
+
+/// @brief picks a set of kernels at runtime from a table of them, one entry
+/// for each instruction set, fastest first and ending with a portable one
+/// which is always supported. Kernels is a struct of function pointers with
+/// a const char *name_ and a bool (*supported_)() checking the cpu.
+template <typename Kernels> class KernelTable {
+public:
+  template <size_t N>
+  explicit KernelTable(const Kernels (&kernels)[N])
+      : begin_(kernels), end_(kernels + N), active_(end_ - 1) {
+    for (const Kernels *k = begin_; k != end_; ++k) {
+      if (k->supported_()) {
+        active_ = k;
+        break;
+      }
+    }
+  }
+
+  const Kernels *operator->() const { return active_; }
+  const char *name() const { return active_->name_; }
+
+  /// @brief use the kernels of the name, for tests and benchmarks, not
+  /// thread safe
+  /// @return false if there is no such kernels or the cpu can't run them
+  bool select(const std::string &name) {
+    for (const Kernels *k = begin_; k != end_; ++k) {
+      if (name == k->name_) {
+        if (!k->supported_())
+          return false;
+        active_ = k;
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  const Kernels *begin_;
+  const Kernels *end_;
+  const Kernels *active_;
+};
+
+} // namespace innodb
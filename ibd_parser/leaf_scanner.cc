@@ -0,0 +1,133 @@
+#include "leaf_scanner.h"
+#include <algorithm>
+#include <glog/logging.h>
+
+using namespace innodb;
+
+LeafScanner::LeafScanner(BTree *tree, Prefetcher *prefetcher,
+                         uint32_t readahead)
+    : tree_(tree), reader_(tree->reader()), prefetcher_(prefetcher),
+      readahead_(std::max<uint32_t>(1, readahead)) {}
+
+bool LeafScanner::load_parent() {
+  if (next_parent_ == UINT32_MAX)
+    return false;
+  uint32_t page_no = next_parent_;
+  next_parent_ = UINT32_MAX;
+  PageGuard pg = reader_->fetch_page(page_no);
+  if (!pg) {
+    LOG(ERROR) << "readahead fails to read the level 1 page " << page_no;
+    return false;
+  }
+  auto view = pg.as<IndexPageView>();
+  const IndexDef &index = tree_->index();
+  if (!fil_page_is_index(view.page_type()) || !view.is_compact() ||
+      view.level() != 1 ||
+      (index.index_id_ != 0 && view.index_id() != index.index_id_)) {
+    LOG(ERROR) << "readahead stops, page " << page_no
+               << " isn't a level 1 page of index " << index.index_id_;
+    return false;
+  }
+  view.for_each_record([&](const RecordView &rec) {
+    if (offsets_.init(rec.data(), index) && offsets_.node_ptr())
+      pending_.push_back(offsets_.child_page_no(rec.data()));
+  });
+  next_parent_ = view.next_page();
+  return true;
+}
+
+void LeafScanner::readahead(uint32_t page_no) {
+  if (!prefetcher_)
+    return;
+  auto it = std::find(ahead_.begin(), ahead_.end(), page_no);
+  if (it != ahead_.end()) {
+    ahead_.erase(ahead_.begin(), it + 1);
+  } else if (!ahead_.empty()) {
+    // the chain left the predicted order, skip to the leaf if it's still
+    // ahead, the prefetched leaves in between are wasted
+    ++readahead_misses_;
+    ahead_.clear();
+    it = std::find(pending_.begin(), pending_.end(), page_no);
+    if (it != pending_.end())
+      pending_.erase(pending_.begin(), it + 1);
+  }
+  // refill in large steps so that the adjacent leaves share one read
+  if (ahead_.size() > readahead_ / 2)
+    return;
+  std::vector<uint32_t> batch;
+  while (ahead_.size() < readahead_) {
+    if (pending_.empty() && !load_parent())
+      break;
+    if (pending_.empty())
+      continue;
+    ahead_.push_back(pending_.front());
+    batch.push_back(pending_.front());
+    pending_.pop_front();
+  }
+  if (!batch.empty()) {
+    leaves_prefetched_ += batch.size();
+    prefetcher_->prefetch_pages(std::move(batch));
+  }
+}
+
+bool LeafScanner::for_each_leaf(leaf_func func, BTreeCursor start) {
+  ahead_.clear();
+  pending_.clear();
+  leaves_scanned_ = 0;
+  leaves_prefetched_ = 0;
+  readahead_misses_ = 0;
+  const bool has_start = start.valid();
+  BTreeCursor cursor = has_start ? std::move(start) : tree_->first();
+  if (!cursor.valid())
+    return false;
+  next_parent_ = UINT32_MAX;
+  if (prefetcher_) {
+    next_parent_ = tree_->leaf_parent();
+    // the descent has read the first leaf already, the leaves left of it
+    // aren't visited
+    if (load_parent()) {
+      auto it = std::find(pending_.begin(), pending_.end(), cursor.page_no_);
+      if (it != pending_.end())
+        pending_.erase(pending_.begin(), it + 1);
+    }
+  }
+
+  const uint64_t index_id = tree_->index().index_id_;
+  const uint32_t max_leaves = reader_->get_page_count();
+  PageGuard pg = std::move(cursor.page_);
+  uint32_t page_no = cursor.page_no_;
+  // the leftmost leaf has no left sibling, a given start has any
+  uint32_t prev = has_start ? FILHeader::previous_page(pg.buf()) : UINT32_MAX;
+  while (true) {
+    auto view = pg.as<IndexPageView>();
+    if (!fil_page_is_index(view.page_type()) || !view.is_compact() ||
+        !view.is_leaf() || (index_id != 0 && view.index_id() != index_id)) {
+      LOG(ERROR) << "page " << page_no << " isn't a compact leaf of index "
+                 << index_id;
+      return false;
+    }
+    if (view.prev_page() != prev) {
+      LOG(ERROR) << "leaf " << page_no << " links back to "
+                 << view.prev_page() << ", expected " << prev;
+      return false;
+    }
+    readahead(page_no);
+    ++leaves_scanned_;
+    if (!func(page_no, pg))
+      return true;
+    uint32_t next = view.next_page();
+    if (next == UINT32_MAX)
+      return true;
+    if (leaves_scanned_ >= max_leaves) {
+      LOG(ERROR) << "the leaf chain of index " << index_id << " loops";
+      return false;
+    }
+    prev = page_no;
+    page_no = next;
+    pg = reader_->fetch_page(page_no);
+    if (!pg) {
+      LOG(ERROR) << "leaf scan fails to read page " << page_no;
+      return false;
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "btree.h"
+#include "prefetcher.h"
+#include <deque>
+#include <functional>
+
+namespace innodb {
+
+/// @brief full ordered scan of a B+tree, starts from the leftmost leaf and
+/// follows the FIL_PAGE_NEXT links of the leaves. With a prefetcher the
+/// leaves ahead of the scan are read asynchronously: their page numbers are
+/// taken from the node pointers of the level 1 pages, so the siblings are
+/// known before the scan reaches them, and the adjacent ones are coalesced
+/// into batched reads. The leaf chain stays the authority on the order, the
+/// node pointers are only a hint.
+class LeafScanner {
+public:
+  /// leaves read ahead of the scan
+  static constexpr uint32_t DEFAULT_READAHEAD = 64;
+
+  /// @param prefetcher nullptr to read the leaves one by one
+  LeafScanner(BTree *tree, Prefetcher *prefetcher = nullptr,
+              uint32_t readahead = DEFAULT_READAHEAD);
+
+  /// return false to stop the scan
+  using leaf_func = std::function<bool(uint32_t page_no, const PageGuard &)>;
+
+  /// @brief call func for each leaf page in key order
+  /// @param start the leaf to start from, positioned by a BTree::search,
+  /// invalid to start from the leftmost leaf
+  /// @return false if the scan stopped on an error, a broken or looping
+  /// leaf chain or a page of another index, true if all the leaves were
+  /// visited or func stopped the scan
+  bool for_each_leaf(leaf_func func, BTreeCursor start = BTreeCursor());
+
+  /// @brief call func(const RecordView &, uint32_t page_no) for each user
+  /// record in key order, return false from func to stop
+  template <typename F> bool for_each_record(F &&func) {
+    bool stop = false;
+    return for_each_leaf([&](uint32_t page_no, const PageGuard &pg) {
+      pg.as<IndexPageView>().for_each_record([&](const RecordView &rec) {
+        if (!stop && !func(rec, page_no))
+          stop = true;
+      });
+      return !stop;
+    });
+  }
+
+  uint64_t leaves_scanned() const { return leaves_scanned_; }
+  /// @brief leaves handed to the prefetcher
+  uint64_t leaves_prefetched() const { return leaves_prefetched_; }
+  /// @brief leaves reached by the chain that weren't the next prefetched
+  /// ones, the node pointers didn't predict them
+  uint64_t readahead_misses() const { return readahead_misses_; }
+
+private:
+  /// @brief drop the visited leaf from the readahead window and refill the
+  /// window once half of it is consumed
+  void readahead(uint32_t page_no);
+  /// @brief append the children of the next level 1 page to pending_
+  /// @return false if there are no more level 1 pages
+  bool load_parent();
+
+private:
+  BTree *tree_;
+  FileSpaceReader *reader_;
+  Prefetcher *prefetcher_;
+  uint32_t readahead_;
+  RecOffsets offsets_;
+  uint32_t next_parent_ = UINT32_MAX;
+  std::deque<uint32_t> ahead_;   // prefetched, not yet visited
+  std::deque<uint32_t> pending_; // known from the parents, not prefetched
+  uint64_t leaves_scanned_ = 0;
+  uint64_t leaves_prefetched_ = 0;
+  uint64_t readahead_misses_ = 0;
+};
+
+} // namespace innodb
@@ -0,0 +1,181 @@
+#include "lob.h"
+#include <glog/logging.h>
+
+using namespace innodb;
+
+LobStream::LobStream(FileSpaceReader *reader, const LobRef &ref)
+    : reader_(reader), ref_(ref) {}
+
+bool LobStream::fail(uint32_t page_no, const char *what) {
+  LOG(ERROR) << "LOB at page " << ref_.page_no_ << " of " << ref_.length_
+             << " bytes, page " << page_no << ": " << what << " at offset "
+             << offset_;
+  failed_ = true;
+  page_ = PageGuard();
+  index_page_ = PageGuard();
+  return false;
+}
+
+PageGuard LobStream::fetch(uint32_t page_no) {
+  // every page holds a part, a longer walk loops
+  if (pages_read_ >= reader_->get_page_count()) {
+    fail(page_no, "the chain loops");
+    return PageGuard();
+  }
+  ++pages_read_;
+  PageGuard pg = reader_->fetch_page(page_no);
+  if (!pg)
+    fail(page_no, "unreadable page");
+  return pg;
+}
+
+bool LobStream::start() {
+  PageGuard pg = fetch(ref_.page_no_);
+  if (!pg)
+    return false;
+  uint16_t type = pg.as<PageView>().page_type();
+  switch (type) {
+  case FIL_PAGE_TYPE_BLOB:
+  case FIL_PAGE_SDI_BLOB:
+    format_ = Format::BLOB;
+    blob_type_ = type;
+    next_page_ = ref_.page_no_;
+    next_offset_ = ref_.offset_;
+    break;
+  case FIL_PAGE_TYPE_LOB_FIRST: {
+    format_ = Format::LOB;
+    auto first = pg.as<LobFirstPageView>();
+    next_page_ = first.index_first_page();
+    next_offset_ = first.index_first_offset();
+    // the first entries and the first part are on it
+    index_page_ = std::move(pg);
+    return true;
+  }
+  case FIL_PAGE_TYPE_ZBLOB:
+  case FIL_PAGE_TYPE_ZBLOB2:
+  case FIL_PAGE_SDI_ZBLOB:
+  case FIL_PAGE_TYPE_ZLOB_FIRST:
+    return fail(ref_.page_no_, "compressed LOBs are not supported");
+  default:
+    return fail(ref_.page_no_, "not the first page of a LOB");
+  }
+  page_ = std::move(pg);
+  return true;
+}
+
+PageGuard LobStream::take_or_fetch(uint32_t page_no) {
+  if (page_ && page_.as<PageView>().page_no() == page_no)
+    return std::move(page_);
+  return fetch(page_no);
+}
+
+bool LobStream::next_blob(std::string_view &part) {
+  PageGuard pg = take_or_fetch(next_page_);
+  if (!pg)
+    return false;
+  const ulint page_size = reader_->get_page_size();
+  if (pg.as<PageView>().page_type() != blob_type_ ||
+      next_offset_ + BlobPage::BTR_BLOB_HDR_SIZE > page_size)
+    return fail(next_page_, "not a BLOB page of the chain");
+  const byte *hdr = pg.buf() + next_offset_;
+  uint32_t part_len = mach_read_from_4(hdr + BlobPage::BTR_BLOB_HDR_PART_LEN);
+  const ulint data_end = page_size - FILHeader::FIL_PAGE_DATA_END;
+  if (part_len > ref_.length_ - offset_ ||
+      next_offset_ + BlobPage::BTR_BLOB_HDR_SIZE + part_len > data_end)
+    return fail(next_page_, "bad part length");
+  part = std::string_view(
+      reinterpret_cast<const char *>(hdr + BlobPage::BTR_BLOB_HDR_SIZE),
+      part_len);
+  next_page_ = mach_read_from_4(hdr + BlobPage::BTR_BLOB_HDR_NEXT_PAGE_NO);
+  next_offset_ = FILHeader::FIL_PAGE_DATA;
+  page_ = std::move(pg);
+  return true;
+}
+
+bool LobStream::next_lob(std::string_view &part) {
+  const ulint page_size = reader_->get_page_size();
+  // the entry is on the first page or on a LOB index page, it stays
+  // pinned for the next entries on the same page
+  if (!index_page_ || index_page_.as<PageView>().page_no() != next_page_) {
+    if (!(index_page_ = fetch(next_page_)))
+      return false;
+  }
+  uint16_t type = index_page_.as<PageView>().page_type();
+  if ((type != FIL_PAGE_TYPE_LOB_FIRST && type != FIL_PAGE_TYPE_LOB_INDEX) ||
+      next_offset_ < FILHeader::FIL_PAGE_DATA ||
+      next_offset_ + LobIndexEntryView::SIZE >
+          page_size - FILHeader::FIL_PAGE_DATA_END)
+    return fail(next_page_, "bad LOB index entry");
+  LobIndexEntryView entry(index_page_.buf() + next_offset_);
+  const uint32_t data_page_no = entry.page_no();
+  const uint32_t len = entry.data_len();
+  next_page_ = entry.next_page();
+  next_offset_ = entry.next_offset();
+
+  const byte *pg = nullptr;
+  if (index_page_.as<PageView>().page_no() == data_page_no) {
+    pg = index_page_.buf();
+  } else {
+    if (!(page_ = take_or_fetch(data_page_no)))
+      return false;
+    pg = page_.buf();
+  }
+  const byte *data = nullptr;
+  uint32_t max_len = 0;
+  uint16_t data_type = FILHeader::page_type(pg);
+  if (data_page_no == ref_.page_no_ && data_type == FIL_PAGE_TYPE_LOB_FIRST) {
+    LobFirstPageView first(pg, page_size);
+    data = pg + first.data_offset();
+    max_len = first.max_data_len();
+  } else if (data_type == FIL_PAGE_TYPE_LOB_DATA) {
+    data = pg + LobDataPageView::LOB_PAGE_DATA;
+    max_len = LobDataPageView(pg, page_size).max_data_len();
+  } else {
+    return fail(data_page_no, "not a LOB data page");
+  }
+  if (len > max_len || len > ref_.length_ - offset_)
+    return fail(data_page_no, "bad part length");
+  part = std::string_view(reinterpret_cast<const char *>(data), len);
+  return true;
+}
+
+bool LobStream::next(std::string_view &part) {
+  if (failed_)
+    return false;
+  if (offset_ >= ref_.length_) {
+    page_ = PageGuard();
+    index_page_ = PageGuard();
+    return false;
+  }
+  if (format_ == Format::UNKNOWN && !start())
+    return false;
+  if (next_page_ == UINT32_MAX)
+    return fail(UINT32_MAX, "the chain ends early");
+  // a part on the pinned page isn't fetched, so the parts are bounded too,
+  // no page holds two parts of one value
+  if (parts_ >= reader_->get_page_count())
+    return fail(next_page_, "the chain loops");
+  ++parts_;
+  bool ok = format_ == Format::BLOB ? next_blob(part) : next_lob(part);
+  if (!ok)
+    return false;
+  if (part.empty())
+    return fail(next_page_, "empty part");
+  offset_ += part.size();
+  return true;
+}
+
+bool LobStream::read(FileSpaceReader *reader, const LobRef &ref,
+                     std::string &out, uint64_t max_len) {
+  if (ref.length_ > max_len) {
+    LOG(ERROR) << "LOB at page " << ref.page_no_ << " has " << ref.length_
+               << " bytes, more than " << max_len;
+    return false;
+  }
+  out.reserve(out.size() + ref.length_);
+  LobStream stream(reader, ref);
+  std::string_view part;
+  while (stream.next(part))
+    out.append(part);
+  return !stream.failed();
+}
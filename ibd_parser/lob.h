@@ -0,0 +1,210 @@
+#pragma once
+#include "file_space_reader.h"
+#include "page_view.h"
+#include <string>
+#include <string_view>
+
+namespace innodb {
+
+/// @brief the reference to the off page part of a field, the last 20 bytes
+/// of the local part of a field stored externally
+struct LobRef {
+  static constexpr uint32_t BTR_EXTERN_SPACE_ID = 0;
+  static constexpr uint32_t BTR_EXTERN_PAGE_NO = 4;
+  /// the offset of the BLOB header on the first page, the LOB version of
+  /// the LOBs of 8.0
+  static constexpr uint32_t BTR_EXTERN_OFFSET = 8;
+  /// 8 bytes, the flags in the first byte and the length in the last 4
+  static constexpr uint32_t BTR_EXTERN_LEN = 12;
+  static constexpr uint32_t BTR_EXTERN_FIELD_REF_SIZE = 20;
+  static constexpr uint8_t BTR_EXTERN_OWNER_FLAG = 128;
+  static constexpr uint8_t BTR_EXTERN_INHERITED_FLAG = 64;
+  static constexpr uint8_t BTR_EXTERN_BEING_MODIFIED_FLAG = 32;
+
+  uint32_t space_id_ = 0;
+  uint32_t page_no_ = UINT32_MAX;
+  uint32_t offset_ = 0;
+  uint32_t length_ = 0; // the bytes stored off page
+  uint8_t flags_ = 0;
+
+  static LobRef parse(const byte *ref) {
+    LobRef r;
+    r.space_id_ = mach_read_from_4(ref + BTR_EXTERN_SPACE_ID);
+    r.page_no_ = mach_read_from_4(ref + BTR_EXTERN_PAGE_NO);
+    r.offset_ = mach_read_from_4(ref + BTR_EXTERN_OFFSET);
+    r.flags_ = mach_read_from_1(ref + BTR_EXTERN_LEN);
+    r.length_ = mach_read_from_4(ref + BTR_EXTERN_LEN + 4);
+    return r;
+  }
+  /// @brief the reference is written zero before the LOB is, a crash
+  /// during an insert leaves it so
+  bool is_zero() const {
+    return space_id_ == 0 && page_no_ == 0 && offset_ == 0 && length_ == 0 &&
+           flags_ == 0;
+  }
+};
+
+/// @brief the BLOB pages of 5.7 and the SDI BLOB pages, a singly linked
+/// chain of parts, each part a header then the data
+struct BlobPage {
+  static constexpr uint32_t BTR_BLOB_HDR_PART_LEN = 0;
+  static constexpr uint32_t BTR_BLOB_HDR_NEXT_PAGE_NO = 4;
+  static constexpr uint32_t BTR_BLOB_HDR_SIZE = 8;
+};
+
+/// @brief an entry of the index of a LOB of 8.0, the entries are a list
+/// in the order of the data, each one points to a page with a part of it.
+/// They are on the first page and on the LOB index pages.
+class LobIndexEntryView {
+public:
+  static constexpr uint32_t OFFSET_PREV = 0;
+  static constexpr uint32_t OFFSET_NEXT = OFFSET_PREV + FIL_ADDR_SIZE;
+  /// the older versions of the part, for MVCC
+  static constexpr uint32_t OFFSET_VERSIONS = OFFSET_NEXT + FIL_ADDR_SIZE;
+  static constexpr uint32_t OFFSET_TRXID =
+      OFFSET_VERSIONS + FLST_BASE_NODE_SIZE;
+  static constexpr uint32_t OFFSET_TRXID_MODIFIER = OFFSET_TRXID + 6;
+  static constexpr uint32_t OFFSET_TRX_UNDO_NO = OFFSET_TRXID_MODIFIER + 6;
+  static constexpr uint32_t OFFSET_TRX_UNDO_NO_MODIFIER =
+      OFFSET_TRX_UNDO_NO + 4;
+  static constexpr uint32_t OFFSET_PAGE_NO = OFFSET_TRX_UNDO_NO_MODIFIER + 4;
+  static constexpr uint32_t OFFSET_DATA_LEN = OFFSET_PAGE_NO + 4;
+  static constexpr uint32_t OFFSET_LOB_VERSION = OFFSET_DATA_LEN + 4;
+  static constexpr uint32_t SIZE = OFFSET_LOB_VERSION + 4;
+
+  explicit LobIndexEntryView(const byte *p) : p_(p) {}
+
+  uint32_t next_page() const { return mach_read_from_4(p_ + OFFSET_NEXT); }
+  uint16_t next_offset() const {
+    return mach_read_from_2(p_ + OFFSET_NEXT + 4);
+  }
+  /// @brief the page with the data of the part
+  uint32_t page_no() const { return mach_read_from_4(p_ + OFFSET_PAGE_NO); }
+  uint32_t data_len() const { return mach_read_from_4(p_ + OFFSET_DATA_LEN); }
+  uint32_t lob_version() const {
+    return mach_read_from_4(p_ + OFFSET_LOB_VERSION);
+  }
+
+private:
+  const byte *p_;
+};
+
+/// @brief the first page of a LOB of 8.0, the header, an array of index
+/// entries and then the first part of the data
+class LobFirstPageView : public PageView {
+public:
+  static constexpr uint32_t OFFSET_VERSION = FILHeader::FIL_PAGE_DATA;
+  static constexpr uint32_t OFFSET_FLAGS = OFFSET_VERSION + 1;
+  static constexpr uint32_t OFFSET_LOB_VERSION = OFFSET_FLAGS + 1;
+  static constexpr uint32_t OFFSET_LAST_TRX_ID = OFFSET_LOB_VERSION + 4;
+  static constexpr uint32_t OFFSET_LAST_UNDO_NO = OFFSET_LAST_TRX_ID + 6;
+  /// the bytes of the data on this page
+  static constexpr uint32_t OFFSET_DATA_LEN = OFFSET_LAST_UNDO_NO + 4;
+  static constexpr uint32_t OFFSET_TRX_ID = OFFSET_DATA_LEN + 4;
+  static constexpr uint32_t OFFSET_INDEX_LIST = OFFSET_TRX_ID + 6;
+  static constexpr uint32_t OFFSET_INDEX_FREE_NODES =
+      OFFSET_INDEX_LIST + FLST_BASE_NODE_SIZE;
+  static constexpr uint32_t LOB_PAGE_DATA =
+      OFFSET_INDEX_FREE_NODES + FLST_BASE_NODE_SIZE;
+
+  explicit LobFirstPageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : PageView(buf, page_size) {}
+
+  uint8_t version() const { return mach_read_from_1(buf_ + OFFSET_VERSION); }
+  uint32_t data_len() const { return mach_read_from_4(buf_ + OFFSET_DATA_LEN); }
+  uint32_t index_list_len() const {
+    return mach_read_from_4(buf_ + OFFSET_INDEX_LIST);
+  }
+  uint32_t index_first_page() const {
+    return mach_read_from_4(buf_ + OFFSET_INDEX_LIST + 4);
+  }
+  uint16_t index_first_offset() const {
+    return mach_read_from_2(buf_ + OFFSET_INDEX_LIST + 8);
+  }
+
+  /// @brief the index entries on the first page, 10 for 16K pages
+  static uint32_t n_index_entries(ulint page_size) {
+    return page_size <= 1024 ? 0 : page_size <= 2048 ? 1
+                               : page_size <= 4096   ? 2
+                                                     : 10 * page_size / 16384;
+  }
+  uint32_t data_offset() const {
+    return LOB_PAGE_DATA +
+           n_index_entries(page_size_) * LobIndexEntryView::SIZE;
+  }
+  /// @brief the room for data on the page
+  uint32_t max_data_len() const {
+    return page_size_ - data_offset() - FILHeader::FIL_PAGE_DATA_END;
+  }
+};
+
+/// @brief a data page of a LOB of 8.0, a short header then the data
+class LobDataPageView : public PageView {
+public:
+  static constexpr uint32_t OFFSET_VERSION = FILHeader::FIL_PAGE_DATA;
+  static constexpr uint32_t OFFSET_DATA_LEN = OFFSET_VERSION + 1;
+  static constexpr uint32_t OFFSET_TRX_ID = OFFSET_DATA_LEN + 4;
+  static constexpr uint32_t LOB_PAGE_DATA = OFFSET_TRX_ID + 6;
+
+  explicit LobDataPageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : PageView(buf, page_size) {}
+
+  uint32_t data_len() const { return mach_read_from_4(buf_ + OFFSET_DATA_LEN); }
+  uint32_t max_data_len() const {
+    return page_size_ - LOB_PAGE_DATA - FILHeader::FIL_PAGE_DATA_END;
+  }
+};
+
+/// @brief reads an externally stored field part by part, each part a view
+/// into its page, so that a value of many MB is never held in memory at
+/// once. Follows the BLOB page chains of 5.7 and of the SDI and the index
+/// entry lists of the LOBs of 8.0, the compressed LOBs are not supported.
+class LobStream {
+public:
+  LobStream(FileSpaceReader *reader, const LobRef &ref);
+
+  /// @brief the next part of the value, it stays valid until the next call
+  /// or the stream is destroyed, its page is pinned meanwhile
+  /// @return false at the end of the value or on an error, see failed()
+  bool next(std::string_view &part);
+
+  bool failed() const { return failed_; }
+  /// @brief the bytes handed out so far
+  uint64_t offset() const { return offset_; }
+  uint32_t length() const { return ref_.length_; }
+  /// @brief pages read by the stream
+  uint32_t pages_read() const { return pages_read_; }
+
+  /// @brief append the whole value to out, for the values known to be small
+  /// @return false on an error or if the value is longer than max_len
+  static bool read(FileSpaceReader *reader, const LobRef &ref,
+                   std::string &out, uint64_t max_len = UINT64_MAX);
+
+private:
+  enum class Format : uint8_t { UNKNOWN, BLOB, LOB };
+
+  bool start();
+  bool next_blob(std::string_view &part);
+  bool next_lob(std::string_view &part);
+  PageGuard fetch(uint32_t page_no);
+  /// @brief the pinned page of the last part if it is the page, so that a
+  /// page holding several parts or entries is read once
+  PageGuard take_or_fetch(uint32_t page_no);
+  bool fail(uint32_t page_no, const char *what);
+
+private:
+  FileSpaceReader *reader_;
+  LobRef ref_;
+  Format format_ = Format::UNKNOWN;
+  uint16_t blob_type_ = 0; // the page type of the BLOB chain
+  PageGuard page_;         // the page of the last part
+  PageGuard index_page_;   // the page of the next LOB index entry
+  uint32_t next_page_ = UINT32_MAX;
+  uint32_t next_offset_ = 0; // of the BLOB header or of the index entry
+  uint64_t offset_ = 0;
+  uint32_t pages_read_ = 0;
+  uint32_t parts_ = 0; // handed out or being read
+  bool failed_ = false;
+};
+
+} // namespace innodb
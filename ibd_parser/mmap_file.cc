@@ -0,0 +1,91 @@
+#include "mmap_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace innodb;
+
+MmapFile::MmapFile(const std::string &file_name)
+    : file_name_(file_name), fd_(-1), data_(nullptr), size_(0) {}
+
+MmapFile::~MmapFile() { close(); }
+
+int MmapFile::open() {
+  if (is_open())
+    return 0;
+  fd_ = ::open(file_name_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    LOG(ERROR) << "mmap file open error: " << file_name_ << " "
+               << strerror(errno);
+    return -1;
+  }
+  struct stat st {};
+  if (0 != ::fstat(fd_, &st)) {
+    LOG(ERROR) << "mmap file stat error: " << file_name_ << " "
+               << strerror(errno);
+    close();
+    return -1;
+  }
+  if (st.st_size == 0) {
+    LOG(ERROR) << "mmap file is empty: " << file_name_;
+    close();
+    return -1;
+  }
+  void *addr =
+      ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0 /*offset*/);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "mmap error: " << file_name_ << " " << strerror(errno);
+    close();
+    return -1;
+  }
+  data_ = static_cast<unsigned char *>(addr);
+  size_ = st.st_size;
+  return 0;
+}
+
+void MmapFile::close() {
+  if (data_) {
+    ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+int MmapFile::advise(AccessPattern pattern, size_t offset, size_t len) const {
+  if (!is_open() || offset >= size_)
+    return -1;
+  int advice = MADV_NORMAL;
+  switch (pattern) {
+  case AccessPattern::NORMAL:
+    advice = MADV_NORMAL;
+    break;
+  case AccessPattern::SEQUENTIAL:
+    advice = MADV_SEQUENTIAL;
+    break;
+  case AccessPattern::RANDOM:
+    advice = MADV_RANDOM;
+    break;
+  case AccessPattern::WILLNEED:
+    advice = MADV_WILLNEED;
+    break;
+  }
+  // madvise wants the start address aligned to the system page
+  static const size_t sys_page = ::sysconf(_SC_PAGESIZE);
+  size_t start = offset & ~(sys_page - 1);
+  if (len == 0 || offset + len > size_)
+    len = size_ - offset;
+  len += offset - start;
+  if (0 != ::madvise(data_ + start, len, advice)) {
+    LOG(ERROR) << "madvise error: " << file_name_ << " " << strerror(errno);
+    return -1;
+  }
+  return 0;
+}
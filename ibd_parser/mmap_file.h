@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace innodb {
+
+/// @brief access pattern hint, maps to madvise advice
+enum class AccessPattern {
+  NORMAL,
+  SEQUENTIAL,
+  RANDOM,
+  WILLNEED,
+};
+
+/// @brief read only shared mapping of a whole file, pages handed out by the
+/// reader point straight into the mapping, so nothing is copied and the OS
+/// page cache is shared with every other process reading the same file.
+class MmapFile {
+public:
+  explicit MmapFile(const std::string &file_name);
+  ~MmapFile();
+  MmapFile(const MmapFile &) = delete;
+  MmapFile &operator=(const MmapFile &) = delete;
+
+  /// @brief open and map the file
+  /// @return -1 when got error, check errno, 0 for succeed.
+  int open();
+  void close();
+  bool is_open() const { return data_ != nullptr; }
+
+  const unsigned char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+  /// @brief give the kernel a hint on how the range will be accessed
+  /// @param offset start of the range, rounded down to the system page
+  /// @param len length of the range, 0 means till the end of the file
+  /// @return -1 when got error, check errno, 0 for succeed.
+  int advise(AccessPattern pattern, size_t offset = 0, size_t len = 0) const;
+
+private:
+  std::string file_name_;
+  int fd_;
+  unsigned char *data_;
+  size_t size_;
+};
+
+} // namespace innodb
@@ -19,45 +19,75 @@ void FSPHeaderPage::dump(std::ostringstream &oss) const {
   get_fsp_header().dump(oss);
 }
 
+/// @brief decode the whole xdes array of a FSP header or XDES page, XDES_E
+/// keeps the bits of the first 64 pages of the extent, use XDesEntryView for
+/// the whole bitmap of the 4K and 8K pages
+static void init_xdes_arr(const byte *buf, unsigned int page_size,
+                          std::vector<XDES_E> &xdes_arr) {
+  XDESPageView view(buf, page_size);
+  xdes_arr.resize(view.n_xdes_entries());
+  for (uint32_t i = 0; i < xdes_arr.size(); ++i) {
+    xdes_arr[i].init(view.xdes_entry(i).entry());
+  }
+}
+
 const XDES_E *FSPHeaderPage::get_xdes_entry(uint32_t index) {
-  if (!xdes_arr_[index].inited()) {
-    std::streampos offset = FILHeader::FIL_PAGE_DATA +
-                            FSPHeader::FSP_HEADER_SIZE +
-                            index * XDES_E::XDES_E_SIZE;
-    xdes_arr_[index].init(buf() + offset);
+  if (index >= XDES_E::entries_per_page(get_page_size())) {
+    LOG(ERROR) << "xdes entry index out of bounds: " << index;
+    return nullptr;
+  }
+  std::call_once(xdes_arr_once_, [this]() {
+    init_xdes_arr(buf(), get_page_size(), xdes_arr_);
+  });
+  return &xdes_arr_[index];
+}
+
+const XDES_E *XDESPage::get_xdes_entry(uint32_t index) {
+  if (index >= XDES_E::entries_per_page(get_page_size())) {
+    LOG(ERROR) << "xdes entry index out of bounds: " << index;
+    return nullptr;
   }
+  std::call_once(xdes_arr_once_, [this]() {
+    init_xdes_arr(buf(), get_page_size(), xdes_arr_);
+  });
   return &xdes_arr_[index];
 }
 
-void Page::init_page(const byte *buf, Page **page) {
+void Page::init_page(const byte *buf, Page **page, unsigned int page_size) {
   FILHeader header;
   header.init_fil_header(buf);
   Page *p = nullptr;
   switch (header.page_type_) {
   case FIL_PAGE_TYPE_FSP_HDR: {
-    p = new FSPHeaderPage(buf, 0, PAGE_SIZE);
+    p = new FSPHeaderPage(buf, 0, page_size);
+    break;
+  }
+  case FIL_PAGE_TYPE_XDES: {
+    p = new XDESPage(buf, 0, page_size);
     break;
   }
   case FIL_PAGE_TYPE_INODE: {
-    p = new INodePage(buf, 0, PAGE_SIZE);
+    p = new INodePage(buf, 0, page_size);
     break;
   }
   case FIL_PAGE_INDEX: {
-    p = new IndexPage(buf, 0, PAGE_SIZE);
+    p = new IndexPage(buf, 0, page_size);
     break;
   }
   case FIL_PAGE_IBUF_BITMAP: {
-    p = new IBufBitMapPage(buf, 0, PAGE_SIZE);
+    p = new IBufBitMapPage(buf, 0, page_size);
     break;
   }
   case FIL_PAGE_TYPE_SDI: {
-    p = new SDIPage(buf, 0, PAGE_SIZE);
+    p = new SDIPage(buf, 0, page_size);
     break;
   }
   case FIL_PAGE_TYPE_SYS: {
-    p = new SYSPage(buf, 0, PAGE_SIZE);
+    p = new SYSPage(buf, 0, page_size);
+    break;
   }
   default:
+    p = new GenericPage(buf, 0, page_size);
     break;
   }
   p->init(buf);
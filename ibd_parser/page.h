@@ -1,9 +1,11 @@
 #pragma once
 #include "headers.h"
+#include "page_view.h"
 #include <cassert>
 #include <glog/logging.h>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 namespace innodb {
@@ -23,9 +25,10 @@ class Page;
 
 class Page {
 public:
-  static void init_page(const byte *buf, Page **page);
+  static void init_page(const byte *buf, Page **page,
+                        unsigned int page_size = PAGE_SIZE);
   Page(const byte *buf, unsigned int page_size, std::streampos offset);
-  ~Page();
+  virtual ~Page();
   virtual PageType get_type() const = 0;
   const byte *get_buf() const { return buf_; }
   virtual void init(const byte *buf);
@@ -37,6 +40,7 @@ public:
   virtual const INode_E *get_inode_entry(uint32_t) const { return nullptr; }
 
   const byte *buf() const { return (const byte *)buf_; }
+  unsigned int get_page_size() const { return page_size_; }
 
 private:
   FILHeader fil_header_;
@@ -51,10 +55,7 @@ using PagePtr = std::unique_ptr<Page>;
 struct FSPHeaderPage : public Page {
   FSPHeaderPage(const byte *buf, std::streampos offset = 0,
                 unsigned int page_size = PAGE_SIZE)
-      : Page(buf, page_size, offset) {
-    xdes_arr_.resize(256); // TODO check if page with other PAGE_SIZE has 256
-                           // extent entries too.
-  }
+      : Page(buf, page_size, offset) {}
   void init(const byte *buf) override;
   PageType get_type() const override { return PageType::FSP_HDR; }
   uint32_t page_num() const { return fsp_header_.fsp_size_; }
@@ -78,17 +79,23 @@ struct FSPHeaderPage : public Page {
   }
   const XDES_E *get_xdes_entry(uint32_t index) override;
   FSPHeader fsp_header_;
-  std::vector<XDES_E> xdes_arr_;
+  std::vector<XDES_E> xdes_arr_; // decoded on the first get_xdes_entry
+
+private:
+  std::once_flag xdes_arr_once_;
 };
 
 struct XDESPage : public Page {
   XDESPage(const byte *buf, std::streampos offset = 0,
            unsigned int page_size = PAGE_SIZE)
       : Page(buf, page_size, offset), xdes_arr_() {}
-  void init(const byte *buf) override { Page::init(buf); }
   PageType get_type() const override { return PageType::XDES_HDR; }
   void dump(std::ostringstream &oss) const override { Page::dump(oss); }
-  std::vector<XDES_E> xdes_arr_;
+  const XDES_E *get_xdes_entry(uint32_t index) override;
+  std::vector<XDES_E> xdes_arr_; // decoded on the first get_xdes_entry
+
+private:
+  std::once_flag xdes_arr_once_;
 };
 
 struct INodePage : public Page {
@@ -143,6 +150,11 @@ struct IndexPage : public Page {
     oss << std::endl;
   }
   PageType get_type() const override { return PageType::INDEX_PAGE; }
+  /// @brief the user records in key order, without copying the page
+  template <ulint page_size = PAGE_SIZE>
+  RecordRange<page_size> records() const {
+    return IndexPageView(buf(), get_page_size()).records<page_size>();
+  }
   IndexHeader index_header_;
   FSEG_HEADER fseg_header_;
   static constexpr int32_t FSEG_HEADER_OFFSET = FILHeader::FIL_PAGE_DATA + 36;
@@ -156,19 +168,27 @@ struct IBufBitMapPage : public Page {
   void dump(std::ostringstream &oss) const override { Page::dump(oss); }
   PageType get_type() const override { return PageType::IBUF_BITMAP; }
   struct IBUFBITMAP {
-    int free_space : 2;
-    int buffered_flag : 1;
-    int change_buf_fg : 1;
+    uint8_t free_space : 2;
+    uint8_t buffered_flag : 1;
+    uint8_t change_buf_fg : 1;
   };
-  IBUFBITMAP bitmap[16384];
+  /// @brief decode the bits of the page from the buffer
+  IBUFBITMAP bitmap(uint32_t page_no) const {
+    IBufBitMapPageView view(buf(), get_page_size());
+    IBUFBITMAP b{};
+    b.free_space = view.free_space(page_no);
+    b.buffered_flag = view.buffered(page_no);
+    b.change_buf_fg = view.is_ibuf_page(page_no);
+    return b;
+  }
 };
 
-struct SDIPage : public Page {
+/// @brief a page of the SDI index, laid out like the other index pages,
+/// the records are decoded by SdiReader
+struct SDIPage : public IndexPage {
   SDIPage(const byte *buf, std::streampos offset = 0,
           unsigned int page_size = PAGE_SIZE)
-      : Page(buf, page_size, offset) {}
-  void init(const byte *buf) override { Page::init(buf); }
-  void dump(std::ostringstream &oss) const override { Page::dump(oss); }
+      : IndexPage(buf, offset, page_size) {}
   PageType get_type() const override { return PageType::SDI; }
 };
 
@@ -185,4 +205,13 @@ struct SYSPage : public Page {
   PageType get_type() const override { return PageType::UNKNOWN; }
 };
 
+/// @brief pages that have no specific decoder, only the fil header is parsed,
+/// e.g. the allocated but unused pages inside an extent
+struct GenericPage : public Page {
+  GenericPage(const byte *buf, std::streampos offset = 0,
+              unsigned int page_size = PAGE_SIZE)
+      : Page(buf, page_size, offset) {}
+  PageType get_type() const override { return PageType::UNKNOWN; }
+};
+
 } // namespace innodb
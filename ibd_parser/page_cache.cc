@@ -0,0 +1,266 @@
+#include "page_cache.h"
+#include <glog/logging.h>
+
+using namespace innodb;
+
+PageGuard &PageGuard::operator=(PageGuard &&other) noexcept {
+  if (this != &other) {
+    release();
+    cache_ = other.cache_;
+    shard_ = other.shard_;
+    frame_ = other.frame_;
+    data_ = other.data_;
+    page_ = other.page_;
+    other.cache_ = nullptr;
+    other.data_ = nullptr;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+Page *PageGuard::get() const {
+  if (!page_ && cache_ && data_)
+    page_ = cache_->get_page(shard_, frame_);
+  return page_;
+}
+
+void PageGuard::release() {
+  if (cache_ && data_)
+    cache_->unpin(shard_, frame_);
+  cache_ = nullptr;
+  data_ = nullptr;
+  page_ = nullptr;
+}
+
+PageCache::PageCache(size_t capacity_bytes, uint32_t n_shards,
+                     FramePool *frame_pool)
+    : capacity_bytes_(capacity_bytes), page_size_(PAGE_SIZE),
+      requested_shards_(n_shards), n_shards_(1), shards_(),
+      frame_pool_(frame_pool) {
+  init_shards(n_shards);
+}
+
+void PageCache::init_shards(uint32_t n_shards) {
+  size_t max_frames = std::max<size_t>(1, capacity_bytes_ / page_size_);
+  // a tiny budget gets fewer shards, every shard holds at least one frame
+  n_shards_ = std::max<uint32_t>(
+      1, std::min<size_t>(n_shards, max_frames));
+  shards_.reset(new Shard[n_shards_]);
+  for (uint32_t i = 0; i < n_shards_; ++i) {
+    // spread the remainder so the shards add up to the budget
+    shards_[i].max_frames_ = std::max<size_t>(
+        1, max_frames / n_shards_ + (i < max_frames % n_shards_ ? 1 : 0));
+  }
+}
+
+bool PageCache::set_page_size(unsigned int page_size) {
+  if (!is_valid_page_size(page_size)) {
+    LOG(ERROR) << "invalid page size: " << page_size;
+    return false;
+  }
+  if (page_size == page_size_)
+    return true;
+  for (uint32_t s = 0; s < n_shards_; ++s) {
+    if (!shards_[s].frames_.empty()) {
+      LOG(ERROR) << "can't change the page size of a non-empty page cache";
+      return false;
+    }
+  }
+  // a smaller page gets more frames from the same budget, and maybe the
+  // shards that a tiny budget didn't allow
+  page_size_ = page_size;
+  init_shards(requested_shards_);
+  return true;
+}
+
+PageCache::~PageCache() {
+  for (uint32_t i = 0; i < n_shards_; ++i) {
+    for (auto &frame : shards_[i].frames_) {
+      if (frame.pin_count_ > 0)
+        LOG(ERROR) << "page " << frame.page_no_ << " is still pinned";
+      free_frame(frame);
+    }
+  }
+}
+
+PageGuard PageCache::lookup(uint32_t page_no) {
+  uint32_t s = shard_of(page_no);
+  Shard &shard = shards_[s];
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  auto it = shard.index_.find(page_no);
+  if (it == shard.index_.end()) {
+    shard.misses_.fetch_add(1, std::memory_order_relaxed);
+    return PageGuard();
+  }
+  shard.hits_.fetch_add(1, std::memory_order_relaxed);
+  Frame &frame = shard.frames_[it->second];
+  ++frame.pin_count_;
+  frame.referenced_ = true;
+  return PageGuard(this, s, it->second, frame.data_, frame.page_);
+}
+
+bool PageCache::contains(uint32_t page_no) const {
+  Shard &shard = shards_[shard_of(page_no)];
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  return shard.index_.count(page_no) > 0;
+}
+
+PageGuard PageCache::insert(uint32_t page_no, const byte *data,
+                            unsigned char *buf) {
+  assert(data);
+  uint32_t s = shard_of(page_no);
+  Shard &shard = shards_[s];
+  std::unique_lock<std::mutex> lock(shard.mutex_);
+  auto it = shard.index_.find(page_no);
+  if (it != shard.index_.end()) {
+    // already cached, keep the old one, the pointers to it may be in use
+    Frame &frame = shard.frames_[it->second];
+    ++frame.pin_count_;
+    frame.referenced_ = true;
+    PageGuard guard(this, s, it->second, frame.data_, frame.page_);
+    lock.unlock();
+    free_buf(buf);
+    return guard;
+  }
+  size_t idx = get_free_frame(shard);
+  Frame &frame = shard.frames_[idx];
+  frame.page_no_ = page_no;
+  frame.data_ = data;
+  frame.buf_ = buf;
+  frame.page_ = nullptr;
+  frame.pin_count_ = 1;
+  frame.referenced_ = true;
+  shard.index_.emplace(page_no, idx);
+  return PageGuard(this, s, idx, data, nullptr);
+}
+
+Page *PageCache::get_page(uint32_t shard, size_t frame) {
+  Shard &sh = shards_[shard];
+  std::lock_guard<std::mutex> lock(sh.mutex_);
+  Frame &f = sh.frames_[frame];
+  assert(f.in_use() && f.pin_count_ > 0);
+  if (!f.page_)
+    Page::init_page(f.data_, &f.page_, page_size_);
+  return f.page_;
+}
+
+void PageCache::unpin(uint32_t shard, size_t frame) {
+  Shard &sh = shards_[shard];
+  std::lock_guard<std::mutex> lock(sh.mutex_);
+  assert(frame < sh.frames_.size() && sh.frames_[frame].pin_count_ > 0);
+  --sh.frames_[frame].pin_count_;
+}
+
+void PageCache::free_buf(unsigned char *buf) {
+  if (frame_pool_)
+    frame_pool_->free(buf);
+  else
+    free(buf);
+}
+
+void PageCache::free_frame(Frame &frame) {
+  delete frame.page_;
+  free_buf(frame.buf_);
+  frame.page_ = nullptr;
+  frame.data_ = nullptr;
+  frame.buf_ = nullptr;
+  frame.pin_count_ = 0;
+  frame.referenced_ = false;
+}
+
+size_t PageCache::get_free_frame(Shard &shard) {
+  if (!shard.free_frames_.empty()) {
+    size_t idx = shard.free_frames_.back();
+    shard.free_frames_.pop_back();
+    return idx;
+  }
+  auto &frames = shard.frames_;
+  if (frames.size() < shard.max_frames_) {
+    frames.emplace_back();
+    return frames.size() - 1;
+  }
+  // two rounds give every referenced page a second chance
+  for (size_t n = 0; n < 2 * frames.size(); ++n) {
+    size_t idx = shard.clock_hand_;
+    shard.clock_hand_ = (shard.clock_hand_ + 1) % frames.size();
+    Frame &frame = frames[idx];
+    if (!frame.in_use()) {
+      return idx;
+    }
+    if (frame.pin_count_ > 0)
+      continue;
+    if (frame.referenced_) {
+      frame.referenced_ = false;
+      continue;
+    }
+    shard.index_.erase(frame.page_no_);
+    free_frame(frame);
+    shard.evictions_.fetch_add(1, std::memory_order_relaxed);
+    return idx;
+  }
+  // every page is pinned, go over the budget rather than failing the read
+  if (!shard.over_budget_) {
+    LOG(WARNING) << "all " << frames.size()
+                 << " cached pages of the shard are pinned, page cache "
+                    "exceeds the budget: "
+                 << capacity_bytes_;
+    shard.over_budget_ = true;
+  }
+  frames.emplace_back();
+  return frames.size() - 1;
+}
+
+void PageCache::clear() {
+  for (uint32_t s = 0; s < n_shards_; ++s) {
+    Shard &shard = shards_[s];
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    for (size_t i = 0; i < shard.frames_.size(); ++i) {
+      Frame &frame = shard.frames_[i];
+      if (!frame.in_use() || frame.pin_count_ > 0)
+        continue;
+      shard.index_.erase(frame.page_no_);
+      free_frame(frame);
+      shard.free_frames_.push_back(i);
+    }
+  }
+}
+
+size_t PageCache::size() const {
+  size_t n = 0;
+  for (uint32_t s = 0; s < n_shards_; ++s) {
+    std::lock_guard<std::mutex> lock(shards_[s].mutex_);
+    n += shards_[s].index_.size();
+  }
+  return n;
+}
+
+uint64_t PageCache::hits() const {
+  uint64_t n = 0;
+  for (uint32_t s = 0; s < n_shards_; ++s)
+    n += shards_[s].hits_.load(std::memory_order_relaxed);
+  return n;
+}
+
+uint64_t PageCache::misses() const {
+  uint64_t n = 0;
+  for (uint32_t s = 0; s < n_shards_; ++s)
+    n += shards_[s].misses_.load(std::memory_order_relaxed);
+  return n;
+}
+
+uint64_t PageCache::evictions() const {
+  uint64_t n = 0;
+  for (uint32_t s = 0; s < n_shards_; ++s)
+    n += shards_[s].evictions_.load(std::memory_order_relaxed);
+  return n;
+}
+
+void PageCache::dump(std::ostringstream &oss) const {
+  oss << "PageCache: capacity: " << capacity_bytes_ << "\t"
+      << "shards: " << n_shards_ << "\t"
+      << "size: " << size_bytes() << "\t"
+      << "pages: " << size() << "\t"
+      << "hits: " << hits() << "\t"
+      << "misses: " << misses() << "\t"
+      << "evictions: " << evictions() << std::endl;
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include "frame_pool.h"
+#include "page.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace innodb {
+
+class PageCache;
+
+/// @brief pins a cached page, the page will not be evicted until the guard
+/// is released or destroyed. The raw buffer could be read through the typed
+/// views with as<View>(), the polymorphic Page object is only built on the
+/// first get().
+class PageGuard {
+public:
+  PageGuard() = default;
+  PageGuard(PageCache *cache, uint32_t shard, size_t frame, const byte *data,
+            Page *page)
+      : cache_(cache), shard_(shard), frame_(frame), data_(data),
+        page_(page) {}
+  ~PageGuard() { release(); }
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+  PageGuard(PageGuard &&other) noexcept { *this = std::move(other); }
+  PageGuard &operator=(PageGuard &&other) noexcept;
+
+  const byte *buf() const { return data_; }
+  template <typename View> View as() const;
+
+  /// @brief the decoded Page, built on the first call
+  Page *get() const;
+  Page *operator->() const { return get(); }
+  explicit operator bool() const { return data_ != nullptr; }
+
+  /// @brief unpin the page, the guard is empty afterwards
+  void release();
+
+private:
+  PageCache *cache_ = nullptr;
+  uint32_t shard_ = 0;
+  size_t frame_ = 0;
+  const byte *data_ = nullptr;
+  mutable Page *page_ = nullptr;
+};
+
+/// @brief page cache with a byte budget, pages are evicted with the CLOCK
+/// algorithm when the budget is exceeded, pinned pages are never evicted.
+/// The cache is split into shards by page number, each shard has its own
+/// lock and clock hand, so concurrent readers rarely contend.
+class PageCache {
+public:
+  static constexpr size_t DEFAULT_CAPACITY_BYTES = 256UL * 1024 * 1024;
+  static constexpr uint32_t DEFAULT_SHARDS = 16;
+
+  /// @param frame_pool where the page buffers go back to on eviction,
+  /// nullptr means they are malloc'd
+  explicit PageCache(size_t capacity_bytes = DEFAULT_CAPACITY_BYTES,
+                     uint32_t n_shards = DEFAULT_SHARDS,
+                     FramePool *frame_pool = nullptr);
+  ~PageCache();
+  PageCache(const PageCache &) = delete;
+  PageCache &operator=(const PageCache &) = delete;
+
+  /// @brief lookup the page and pin it
+  /// @return empty guard if the page is not cached
+  PageGuard lookup(uint32_t page_no);
+
+  /// @brief check if the page is cached, doesn't pin or count hit/miss
+  bool contains(uint32_t page_no) const;
+
+  /// @brief put the page data into the cache and pin it, evict other pages
+  /// if the budget is exceeded. The cache takes the ownership of buf, buf is
+  /// nullptr if data isn't owned by the reader (mmap). If another thread
+  /// inserted the same page first, buf is freed and the cached one is
+  /// returned.
+  PageGuard insert(uint32_t page_no, const byte *data, unsigned char *buf);
+
+  /// @brief drop all the unpinned pages
+  void clear();
+
+  /// @brief set the page size of the cached pages, the frame budget of the
+  /// shards is recomputed, only allowed while the cache is empty
+  /// @return false if pages are cached or the size is not a valid page size
+  bool set_page_size(unsigned int page_size);
+  unsigned int page_size() const { return page_size_; }
+
+  size_t capacity_bytes() const { return capacity_bytes_; }
+  size_t size_bytes() const { return size() * page_size_; }
+  size_t size() const;
+  uint64_t hits() const;
+  uint64_t misses() const;
+  uint64_t evictions() const;
+
+  void dump(std::ostringstream &oss) const;
+
+private:
+  friend class PageGuard;
+  struct Frame {
+    uint32_t page_no_ = 0;
+    const byte *data_ = nullptr;
+    unsigned char *buf_ = nullptr; // owned buffer of data_, if any
+    Page *page_ = nullptr;         // built on demand
+    uint32_t pin_count_ = 0;
+    bool referenced_ = false;
+    bool in_use() const { return data_ != nullptr; }
+  };
+  struct Shard {
+    std::mutex mutex_;
+    size_t max_frames_ = 1;
+    std::vector<Frame> frames_;
+    std::vector<size_t> free_frames_;
+    std::unordered_map<uint32_t, size_t> index_;
+    size_t clock_hand_ = 0;
+    bool over_budget_ = false; // warned about going over the budget
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+  };
+  uint32_t shard_of(uint32_t page_no) const { return page_no % n_shards_; }
+  void unpin(uint32_t shard, size_t frame);
+  Page *get_page(uint32_t shard, size_t frame);
+  void free_frame(Frame &frame);
+  void free_buf(unsigned char *buf);
+
+  /// @brief find a free frame, run the clock hand to evict one if the budget
+  /// is used up, called with the shard mutex held
+  /// @return index of the frame
+  size_t get_free_frame(Shard &shard);
+
+  /// @brief split the byte budget into the shards by the page size
+  void init_shards(uint32_t n_shards);
+
+private:
+  size_t capacity_bytes_;
+  unsigned int page_size_;
+  uint32_t requested_shards_; // n_shards passed to the constructor
+  uint32_t n_shards_;
+  std::unique_ptr<Shard[]> shards_;
+  FramePool *frame_pool_;
+};
+
+template <typename View> View PageGuard::as() const {
+  return View(data_, cache_ ? cache_->page_size() : PAGE_SIZE);
+}
+
+} // namespace innodb
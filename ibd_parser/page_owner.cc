@@ -0,0 +1,172 @@
+#include "page_owner.h"
+#include <glog/logging.h>
+
+using namespace innodb;
+
+namespace {
+
+uint64_t inode_key(const Addr &addr) {
+  return (uint64_t)addr.page_number_ << 16 | addr.offset_;
+}
+
+} // namespace
+
+const char *innodb::segment_role_str(SegmentRole role) {
+  switch (role) {
+  case SegmentRole::UNKNOWN:
+    return "UNKNOWN";
+  case SegmentRole::LEAF:
+    return "LEAF";
+  case SegmentRole::NON_LEAF:
+    return "NON_LEAF";
+  }
+  return "UNKNOWN";
+}
+
+bool PageOwnerIndex::build(FileSpaceReader *reader) {
+  page_size_ = reader->get_page_size();
+  const uint32_t ext_pages = extent_pages(page_size_);
+  extent_shift_ = __builtin_ctz(ext_pages);
+  const uint32_t n_pages = reader->get_page_count();
+  extent_owners_.assign((n_pages + ext_pages - 1) / ext_pages, NO_OWNER);
+  frag_owners_.clear();
+  segments_.clear();
+  first_frag_pages_.clear();
+  conflicts_ = 0;
+
+  PageGuard page0 = reader->fetch_page(0);
+  if (!page0 ||
+      page0.as<PageView>().page_type() != FIL_PAGE_TYPE_FSP_HDR) {
+    LOG(ERROR) << "page 0 isn't the FSP header page";
+    return false;
+  }
+  FSPHeaderPageView fsp(page0.buf(), page_size_);
+  const INodeEntryList full = fsp.full_inodes_list();
+  const INodeEntryList free_list = fsp.free_inodes_list();
+  page0 = PageGuard();
+  if (!add_inode_pages(reader, full) || !add_inode_pages(reader, free_list))
+    return false;
+  find_indexes(reader);
+  return true;
+}
+
+bool PageOwnerIndex::add_inode_pages(FileSpaceReader *reader,
+                                     const ListBaseNode &list) {
+  const uint32_t n_entries = INodePageView::n_inode_entries(page_size_);
+  const uint32_t max_pages = reader->get_page_count();
+  uint32_t page_no = list.first_page_number_;
+  for (uint32_t n = 0; n < list.list_length_ && page_no != UINT32_MAX; ++n) {
+    PageGuard pg = reader->fetch_page(page_no);
+    if (!pg || pg.as<PageView>().page_type() != FIL_PAGE_TYPE_INODE ||
+        n >= max_pages) {
+      LOG(ERROR) << "page " << page_no << " isn't an inode page";
+      return false;
+    }
+    for (uint32_t i = 0; i < n_entries; ++i) {
+      uint16_t offset = INodePageView::inode_entry_offset(i);
+      INodeEntryView inode(pg.buf() + offset);
+      if (inode.is_used())
+        add_segment(reader, inode, Addr(page_no, offset));
+    }
+    page_no = INodePageView(pg.buf(), page_size_).next_inode_page()
+                  .page_number_;
+  }
+  return true;
+}
+
+void PageOwnerIndex::add_segment(FileSpaceReader *reader,
+                                 const INodeEntryView &inode, Addr addr) {
+  const uint32_t slot = segments_.size();
+  segments_.emplace_back();
+  SegmentOwner &s = segments_.back();
+  s.seg_id_ = inode.fseg_id();
+  s.inode_ = addr;
+  uint32_t first_frag = UINT32_MAX;
+  for (uint32_t n = 0; n < INode_E::FRAG_ARRAY_SIZE; ++n) {
+    uint32_t page_no = inode.frag_page(n);
+    if (page_no == UINT32_MAX)
+      continue;
+    if (first_frag == UINT32_MAX)
+      first_frag = page_no;
+    if (frag_owners_.emplace(page_no, slot).second)
+      ++s.n_frag_pages_;
+    else
+      ++conflicts_;
+  }
+  first_frag_pages_.push_back(first_frag);
+  add_extent_list(reader, inode.free_list(), slot);
+  add_extent_list(reader, inode.not_full_list(), slot);
+  add_extent_list(reader, inode.full_list(), slot);
+}
+
+void PageOwnerIndex::add_extent_list(FileSpaceReader *reader,
+                                     const XDesEntryList &list,
+                                     uint32_t slot) {
+  const uint32_t entry_size = XDES_E::entry_size(page_size_);
+  const uint32_t per_page = XDES_E::entries_per_page(page_size_);
+  Addr addr(list.first_page_number_, list.first_offset_);
+  PageGuard pg;
+  for (uint32_t n = 0; n < list.list_length_ && addr.valid(); ++n) {
+    if (!pg || pg.as<PageView>().page_no() != addr.page_number_)
+      pg = reader->fetch_page(addr.page_number_);
+    const uint32_t index = (addr.offset_ - XDES_E::XDES_ARR_OFFSET) /
+                           entry_size;
+    if (!pg || addr.page_number_ % page_size_ != 0 ||
+        addr.offset_ < XDES_E::XDES_ARR_OFFSET ||
+        (addr.offset_ - XDES_E::XDES_ARR_OFFSET) % entry_size != 0 ||
+        index >= per_page) {
+      LOG(ERROR) << "segment " << segments_[slot].seg_id_
+                 << " lists a bad extent at page " << addr.page_number_
+                 << " offset " << addr.offset_;
+      ++conflicts_;
+      return;
+    }
+    size_t extent =
+        XDES_E::extent_first_page(addr, page_size_) >> extent_shift_;
+    if (extent >= extent_owners_.size() ||
+        extent_owners_[extent] != NO_OWNER) {
+      ++conflicts_;
+    } else {
+      extent_owners_[extent] = slot;
+      ++segments_[slot].n_extents_;
+    }
+    addr = XDesEntryView(pg.buf() + addr.offset_).next();
+  }
+}
+
+void PageOwnerIndex::find_indexes(FileSpaceReader *reader) {
+  std::unordered_map<uint64_t, uint32_t> by_inode;
+  for (uint32_t i = 0; i < segments_.size(); ++i)
+    by_inode[inode_key(segments_[i].inode_)] = i;
+  // the root is the first page of the non leaf segment, btr_create
+  // allocates it there
+  for (uint32_t i = 0; i < segments_.size(); ++i) {
+    if (first_frag_pages_[i] == UINT32_MAX ||
+        segments_[i].role_ != SegmentRole::UNKNOWN)
+      continue;
+    PageGuard pg = reader->fetch_page(first_frag_pages_[i]);
+    if (!pg || !fil_page_is_index(pg.as<PageView>().page_type()))
+      continue;
+    auto root = pg.as<IndexPageView>();
+    if (inode_key(root.top_inode()) != inode_key(segments_[i].inode_))
+      continue;
+    auto leaf = by_inode.find(inode_key(root.leaf_inode()));
+    for (uint32_t slot : {i, leaf == by_inode.end() ? NO_OWNER
+                                                    : leaf->second}) {
+      if (slot == NO_OWNER)
+        continue;
+      SegmentOwner &s = segments_[slot];
+      s.index_id_ = root.index_id();
+      s.root_page_no_ = first_frag_pages_[i];
+      s.role_ = slot == i ? SegmentRole::NON_LEAF : SegmentRole::LEAF;
+    }
+  }
+}
+
+const SegmentOwner *PageOwnerIndex::find_segment(uint64_t seg_id) const {
+  for (const auto &s : segments_) {
+    if (s.seg_id_ == seg_id)
+      return &s;
+  }
+  return nullptr;
+}
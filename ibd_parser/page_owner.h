@@ -0,0 +1,102 @@
+#pragma once
+#include "file_space_reader.h"
+#include "page_view.h"
+#include <unordered_map>
+#include <vector>
+
+namespace innodb {
+
+/// @brief the pages a segment holds in an index
+enum class SegmentRole : uint8_t {
+  UNKNOWN,  // no index root points to it, e.g. the segments of the undo logs
+  LEAF,     // the leaves of an index, and the LOB pages of its columns
+  NON_LEAF, // the root and the other non leaf pages of an index
+};
+
+const char *segment_role_str(SegmentRole role);
+
+/// @brief a used segment of the space
+struct SegmentOwner {
+  uint64_t seg_id_ = 0;
+  Addr inode_;
+  uint64_t index_id_ = 0; // 0 if the role is UNKNOWN
+  uint32_t root_page_no_ = UINT32_MAX;
+  SegmentRole role_ = SegmentRole::UNKNOWN;
+  uint32_t n_extents_ = 0;
+  uint32_t n_frag_pages_ = 0;
+};
+
+/// @brief maps every page of a tablespace to the segment holding it and to
+/// the index of the segment, built once from the inodes and then answering
+/// in O(1). A segment holds whole extents, listed in the free, not full and
+/// full lists of its inode, and up to 32 single pages of the fragment
+/// extents, listed in its fragment array. So the owners of the extents are
+/// kept in a dense array indexed by the extent number, and the few fragment
+/// pages in a hash map.
+///
+/// The index of a segment is found from the root page of the index, the
+/// first fragment page of its non leaf segment, whose segment headers point
+/// to the inodes of both segments.
+///
+/// A page of an extent of a segment is owned by the segment even if it is
+/// free, the extent is reserved for the segment.
+class PageOwnerIndex {
+public:
+  static constexpr uint32_t NO_OWNER = UINT32_MAX;
+
+  /// @brief walk the inodes of the space and the extent lists of each one
+  /// @return false if the FSP header or an inode page can't be read
+  bool build(FileSpaceReader *reader);
+
+  /// @brief the segment holding the page, nullptr if none does: a page of
+  /// a free or a fragment extent not given to a segment, or a page past the
+  /// end of the space
+  const SegmentOwner *owner(uint32_t page_no) const {
+    uint32_t slot = NO_OWNER;
+    size_t extent = page_no >> extent_shift_;
+    if (extent < extent_owners_.size())
+      slot = extent_owners_[extent];
+    if (slot == NO_OWNER) {
+      auto it = frag_owners_.find(page_no);
+      if (it == frag_owners_.end())
+        return nullptr;
+      slot = it->second;
+    }
+    return &segments_[slot];
+  }
+  /// @brief the index of the page, 0 if no index owns it
+  uint64_t index_id(uint32_t page_no) const {
+    const SegmentOwner *s = owner(page_no);
+    return s ? s->index_id_ : 0;
+  }
+
+  const std::vector<SegmentOwner> &segments() const { return segments_; }
+  /// @brief nullptr if no such segment
+  const SegmentOwner *find_segment(uint64_t seg_id) const;
+
+  /// @brief extents or fragment pages claimed by two segments, or list
+  /// entries which couldn't be read, the index keeps the first owner
+  uint32_t conflicts() const { return conflicts_; }
+
+private:
+  /// @brief the inodes of one of the inode lists of the FSP header
+  bool add_inode_pages(FileSpaceReader *reader, const ListBaseNode &list);
+  void add_segment(FileSpaceReader *reader, const INodeEntryView &inode,
+                   Addr addr);
+  /// @brief mark the extents of one of the extent lists of the inode
+  void add_extent_list(FileSpaceReader *reader, const XDesEntryList &list,
+                       uint32_t slot);
+  /// @brief find the root of the index of the non leaf segments
+  void find_indexes(FileSpaceReader *reader);
+
+private:
+  uint32_t page_size_ = PAGE_SIZE;
+  uint32_t extent_shift_ = 6; // log2 of the pages of an extent
+  std::vector<uint32_t> extent_owners_;
+  std::unordered_map<uint32_t, uint32_t> frag_owners_;
+  std::vector<SegmentOwner> segments_;
+  std::vector<uint32_t> first_frag_pages_; // of each segment
+  uint32_t conflicts_ = 0;
+};
+
+} // namespace innodb
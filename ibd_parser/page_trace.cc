@@ -0,0 +1,170 @@
+#include "page_trace.h"
+#include <chrono>
+#include <fstream>
+#include <glog/logging.h>
+#include <unordered_set>
+
+using namespace innodb;
+
+namespace {
+
+constexpr char TRACE_MAGIC[8] = {'V', 'I', 'B', 'D', 'T', 'R', 'C', '\0'};
+constexpr uint32_t TRACE_VERSION = 1;
+/// magic, version, page size and the number of accesses
+constexpr size_t TRACE_HEADER_SIZE = sizeof(TRACE_MAGIC) + 16;
+
+void put_4(std::string &buf, uint32_t v) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    buf.push_back((char)(v >> shift));
+}
+
+void put_8(std::string &buf, uint64_t v) {
+  put_4(buf, v >> 32);
+  put_4(buf, (uint32_t)v);
+}
+
+} // namespace
+
+PageTrace::PageTrace(size_t capacity) {
+  size_t n = 1;
+  while (n < capacity)
+    n <<= 1;
+  mask_ = n - 1;
+  slots_.reset(new std::atomic<uint64_t>[n]);
+}
+
+std::vector<PageAccess> PageTrace::snapshot() const {
+  const uint64_t end = recorded();
+  const uint64_t begin = dropped();
+  std::vector<PageAccess> accesses;
+  accesses.reserve(end - begin);
+  for (uint64_t n = begin; n < end; ++n)
+    accesses.push_back(PageAccess::unpack(
+        slots_[n & mask_].load(std::memory_order_relaxed)));
+  return accesses;
+}
+
+bool PageTrace::save(const std::string &path, uint32_t page_size) const {
+  const std::vector<PageAccess> accesses = snapshot();
+  std::string buf(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  buf.reserve(TRACE_HEADER_SIZE + accesses.size() * 8);
+  put_4(buf, TRACE_VERSION);
+  put_4(buf, page_size);
+  put_8(buf, accesses.size());
+  for (const auto &a : accesses) {
+    put_4(buf, a.page_no_);
+    put_4(buf, a.info_);
+  }
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(buf.data(), buf.size());
+  if (!out) {
+    LOG(ERROR) << "fails to write the page trace " << path;
+    return false;
+  }
+  return true;
+}
+
+bool PageTraceFile::load(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+  std::ostringstream oss;
+  oss << in.rdbuf();
+  const std::string buf = oss.str();
+  if (buf.size() < TRACE_HEADER_SIZE ||
+      buf.compare(0, sizeof(TRACE_MAGIC),
+                  std::string(TRACE_MAGIC, sizeof(TRACE_MAGIC))) != 0) {
+    LOG(ERROR) << path << " isn't a page trace";
+    return false;
+  }
+  const byte *p = reinterpret_cast<const byte *>(buf.data()) +
+                  sizeof(TRACE_MAGIC);
+  if (mach_read_from_4(p) != TRACE_VERSION) {
+    LOG(ERROR) << "the page trace " << path << " is of another version";
+    return false;
+  }
+  const uint32_t page_size = mach_read_from_4(p + 4);
+  const uint64_t n = mach_read_from_8(p + 8);
+  if (n != (buf.size() - TRACE_HEADER_SIZE) / 8) {
+    LOG(ERROR) << "the page trace " << path << " is truncated";
+    return false;
+  }
+  page_size_ = page_size;
+  accesses_.resize(n);
+  p += 16;
+  for (uint64_t i = 0; i < n; ++i, p += 8) {
+    accesses_[i].page_no_ = mach_read_from_4(p);
+    accesses_[i].info_ = mach_read_from_4(p + 4);
+  }
+  return true;
+}
+
+void ReplayResult::dump(std::ostringstream &oss) const {
+  static const char *MODES[] = {"pread", "mmap", "direct"};
+  oss << "replay " << MODES[(int)config_.read_mode_]
+      << " cache: " << config_.cache_capacity_bytes_
+      << " readahead: " << config_.readahead_pages_
+      << ": accesses: " << accesses_ << ", hits: " << hits_
+      << ", misses: " << misses_ << ", errors: " << errors_
+      << ", hit ratio: " << hit_ratio()
+      << ", wasted readahead pages: " << wasted_pages_
+      << ", elapsed ns: " << elapsed_ns_ << std::endl;
+}
+
+ReplayResult PageTraceReplayer::replay(const ReplayConfig &config) const {
+  ReplayResult r;
+  r.config_ = config;
+  FileSpaceReader reader(file_.c_str(), config.read_mode_,
+                         config.cache_capacity_bytes_);
+  if (reader.get_page_size() != page_size_) {
+    LOG(ERROR) << "the trace of pages of " << page_size_
+               << " bytes can't be replayed against " << file_
+               << " of page size " << reader.get_page_size();
+    return r;
+  }
+  const PageCache &cache = reader.get_page_cache();
+  // the readahead stops at the end of the space, this reads page 0 first
+  const uint32_t n_pages =
+      config.readahead_pages_ > 1 ? reader.get_page_count() : 0;
+  // the pages brought in by the readahead and not accessed yet
+  std::unordered_set<uint32_t> read_ahead;
+  const bool track_readahead = config.read_mode_ != ReadMode::MMAP;
+
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &a : accesses_) {
+    ++r.accesses_;
+    const uint32_t page_no = a.page_no_;
+    if (track_readahead)
+      read_ahead.erase(page_no);
+    if (cache.contains(page_no)) {
+      ++r.hits_;
+    } else {
+      ++r.misses_;
+      if (config.readahead_pages_ > 1 && page_no < n_pages) {
+        uint32_t n = std::min(config.readahead_pages_, n_pages - page_no);
+        for (uint32_t p = page_no + 1; track_readahead && p < page_no + n;
+             ++p) {
+          if (!cache.contains(p))
+            read_ahead.insert(p);
+        }
+        reader.read_pages(page_no, n);
+      }
+    }
+    if (!reader.fetch_page(page_no))
+      ++r.errors_;
+  }
+  r.elapsed_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  r.wasted_pages_ = read_ahead.size();
+  r.valid_ = true;
+  return r;
+}
+
+std::vector<ReplayResult>
+PageTraceReplayer::replay_all(const std::vector<ReplayConfig> &configs) const {
+  std::vector<ReplayResult> results;
+  for (const auto &c : configs)
+    results.push_back(replay(c));
+  return results;
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include "file_space_reader.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace innodb {
+
+/// @brief one page access of a FileSpaceReader, packed into 8 bytes: the
+/// page number, a hit or a miss of the page cache, and the latency of the
+/// access, saturated at MAX_LATENCY_NS
+struct PageAccess {
+  static constexpr uint32_t MISS_BIT = 1U << 31;
+  static constexpr uint32_t ERROR_BIT = 1U << 30;
+  static constexpr uint32_t MAX_LATENCY_NS = ERROR_BIT - 1;
+
+  uint32_t page_no_ = 0;
+  uint32_t info_ = 0; // the bits above and the latency
+
+  PageAccess() = default;
+  PageAccess(uint32_t page_no, bool hit, bool error, uint64_t latency_ns)
+      : page_no_(page_no),
+        info_((hit ? 0 : MISS_BIT) | (error ? ERROR_BIT : 0) |
+              (uint32_t)std::min<uint64_t>(latency_ns, MAX_LATENCY_NS)) {}
+
+  bool hit() const { return !(info_ & MISS_BIT); }
+  /// @brief the page couldn't be read
+  bool error() const { return info_ & ERROR_BIT; }
+  uint32_t latency_ns() const { return info_ & MAX_LATENCY_NS; }
+
+  uint64_t pack() const { return (uint64_t)info_ << 32 | page_no_; }
+  static PageAccess unpack(uint64_t v) {
+    PageAccess a;
+    a.page_no_ = (uint32_t)v;
+    a.info_ = v >> 32;
+    return a;
+  }
+};
+
+/// @brief a ring buffer of the last page accesses of a reader, the oldest
+/// ones are overwritten once it's full. Recording is lock free, one
+/// fetch_add and one store, so it could stay on while the traversals run
+/// on several threads. Attach it with FileSpaceReader::set_trace.
+class PageTrace {
+public:
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+  /// @param capacity rounded up to a power of 2
+  explicit PageTrace(size_t capacity = DEFAULT_CAPACITY);
+  PageTrace(const PageTrace &) = delete;
+  PageTrace &operator=(const PageTrace &) = delete;
+
+  void record(const PageAccess &access) {
+    uint64_t n = head_.fetch_add(1, std::memory_order_relaxed);
+    slots_[n & mask_].store(access.pack(), std::memory_order_relaxed);
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+  /// @brief all the accesses recorded, including the overwritten ones
+  uint64_t recorded() const { return head_.load(std::memory_order_relaxed); }
+  /// @brief the accesses overwritten by later ones
+  uint64_t dropped() const {
+    uint64_t n = recorded();
+    return n > capacity() ? n - capacity() : 0;
+  }
+  /// @brief drop all the accesses, not while they are being recorded
+  void clear() { head_.store(0, std::memory_order_relaxed); }
+
+  /// @brief the accesses kept, oldest first. An access being recorded
+  /// concurrently may be missing or show the one it overwrites.
+  std::vector<PageAccess> snapshot() const;
+
+  /// @brief write the accesses kept to a binary trace file
+  /// @param page_size the page size of the traced space
+  bool save(const std::string &path, uint32_t page_size) const;
+
+private:
+  size_t mask_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  std::atomic<uint64_t> head_{0};
+};
+
+/// @brief a trace file written by PageTrace::save
+struct PageTraceFile {
+  uint32_t page_size_ = PAGE_SIZE;
+  std::vector<PageAccess> accesses_;
+
+  /// @return false if the file can't be read or isn't a trace
+  bool load(const std::string &path);
+};
+
+/// @brief the reader to replay a trace against
+struct ReplayConfig {
+  ReadMode read_mode_ = ReadMode::PREAD;
+  size_t cache_capacity_bytes_ = PageCache::DEFAULT_CAPACITY_BYTES;
+  /// on a miss read this many pages from the missing one in one I/O, the
+  /// readahead is off if it's 0 or 1
+  uint32_t readahead_pages_ = 0;
+};
+
+/// @brief how a trace ran against one ReplayConfig
+struct ReplayResult {
+  ReplayConfig config_;
+  uint64_t accesses_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t errors_ = 0;
+  /// the pages read by the readahead which were never accessed
+  uint64_t wasted_pages_ = 0;
+  uint64_t elapsed_ns_ = 0;
+  /// false if the space can't be read or its page size isn't the traced one
+  bool valid_ = false;
+
+  double hit_ratio() const {
+    return accesses_ ? (double)hits_ / accesses_ : 0;
+  }
+  void dump(std::ostringstream &oss) const;
+};
+
+/// @brief run the page accesses of a trace again, in order and on one
+/// thread, against fresh readers of the file, to compare cache sizes, read
+/// modes and readahead on the access patterns of real traversals. The OS
+/// page cache stays warm across the runs, use ReadMode::DIRECT to see the
+/// cost of the device.
+class PageTraceReplayer {
+public:
+  /// @param page_size the page size of the traced space, the file must have
+  /// the same
+  PageTraceReplayer(std::string file, std::vector<PageAccess> accesses,
+                    uint32_t page_size = PAGE_SIZE)
+      : file_(std::move(file)), accesses_(std::move(accesses)),
+        page_size_(page_size) {}
+  PageTraceReplayer(std::string file, const PageTraceFile &trace)
+      : PageTraceReplayer(std::move(file), trace.accesses_,
+                          trace.page_size_) {}
+
+  /// @return invalid if the page size of the file isn't the traced one
+  ReplayResult replay(const ReplayConfig &config) const;
+  std::vector<ReplayResult>
+  replay_all(const std::vector<ReplayConfig> &configs) const;
+
+private:
+  std::string file_;
+  std::vector<PageAccess> accesses_;
+  uint32_t page_size_;
+};
+
+} // namespace innodb
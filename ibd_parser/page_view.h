@@ -0,0 +1,373 @@
+#pragma once
+#include "headers.h"
+#include "record_iterator.h"
+#include <cassert>
+
+namespace innodb {
+
+/// @brief non-owning view over a raw page buffer. The fields are decoded on
+/// access straight from the buffer, creating a view allocates nothing, so a
+/// cached page costs only its frame. The buffer must outlive the view, keep
+/// the PageGuard the buffer came from alive.
+class PageView {
+public:
+  explicit PageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : buf_(buf), page_size_(page_size) {}
+  const byte *buf() const { return buf_; }
+  ulint page_size() const { return page_size_; }
+
+  uint32_t check_sum() const { return FILHeader::check_sum(buf_); }
+  uint32_t page_no() const { return FILHeader::page_number_offset(buf_); }
+  uint32_t prev_page() const { return FILHeader::previous_page(buf_); }
+  uint32_t next_page() const { return FILHeader::next_page(buf_); }
+  uint64_t lsn() const { return FILHeader::last_mod_page_lsn(buf_); }
+  uint16_t page_type() const { return FILHeader::page_type(buf_); }
+  uint64_t flush_lsn() const { return FILHeader::flush_lsn(buf_); }
+  uint32_t space_id() const { return FILHeader::space_id(buf_); }
+  FILHeader fil_header() const {
+    FILHeader header;
+    header.init_fil_header(buf_);
+    return header;
+  }
+
+protected:
+  const byte *buf_;
+  ulint page_size_;
+};
+
+/// @brief view of one extent descriptor, 40 bytes for 16K pages, the bitmap
+/// is longer for the smaller pages whose extents have more pages
+class XDesEntryView {
+public:
+  explicit XDesEntryView(const byte *entry) : entry_(entry) {}
+  static constexpr uint8_t XDES_ID = 0;
+  static constexpr uint8_t XDES_FLST_NODE = 8;
+  static constexpr uint8_t XDES_STATE = 20;
+  static constexpr uint8_t XDES_BITMAP = XDES_E::XDES_BITMAP;
+  static constexpr uint8_t XDES_BITS_PER_PAGE = 2;
+  static constexpr uint8_t XDES_FREE_BIT = 0;
+  static constexpr uint8_t XDES_CLEAN_BIT = 1;
+  /// the states of an extent
+  static constexpr uint32_t XDES_NOT_INITED = 0;
+  static constexpr uint32_t XDES_FREE = 1;
+  static constexpr uint32_t XDES_FREE_FRAG = 2;
+  static constexpr uint32_t XDES_FULL_FRAG = 3;
+  static constexpr uint32_t XDES_FSEG = 4;
+  static constexpr uint32_t XDES_FSEG_FRAG = 5;
+  static constexpr uint32_t XDES_N_STATES = 6;
+
+  const byte *entry() const { return entry_; }
+  uint64_t seg_id() const { return mach_read_from_8(entry_ + XDES_ID); }
+  uint32_t state() const { return mach_read_from_4(entry_ + XDES_STATE); }
+  Addr prev() const {
+    return Addr(ListNode::prev_page_number(entry_ + XDES_FLST_NODE),
+                ListNode::prev_offset(entry_ + XDES_FLST_NODE));
+  }
+  Addr next() const {
+    return Addr(ListNode::next_page_number(entry_ + XDES_FLST_NODE),
+                ListNode::next_offset(entry_ + XDES_FLST_NODE));
+  }
+  const byte *bitmap() const { return entry_ + XDES_BITMAP; }
+  bool get_bit(uint32_t page, uint8_t bit) const {
+    uint32_t index = page * XDES_BITS_PER_PAGE + bit;
+    return (mach_read_from_1(bitmap() + index / 8) >> (index % 8)) & 1;
+  }
+  bool is_page_free(uint32_t page) const {
+    return get_bit(page, XDES_FREE_BIT);
+  }
+  bool is_page_clean(uint32_t page) const {
+    return get_bit(page, XDES_CLEAN_BIT);
+  }
+  XDES_E decode() const {
+    XDES_E e;
+    e.init(entry_);
+    return e;
+  }
+
+private:
+  const byte *entry_;
+};
+
+/// @brief view of a page carrying the xdes array, the FSP header page and the
+/// XDES pages
+class XDESPageView : public PageView {
+public:
+  explicit XDESPageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : PageView(buf, page_size) {}
+  /// @brief number of entries, 256 for 16K pages
+  uint32_t n_xdes_entries() const {
+    return XDES_E::entries_per_page(page_size_);
+  }
+  /// @brief pages described by one entry
+  uint32_t extent_size() const { return extent_pages(page_size_); }
+  XDesEntryView xdes_entry(uint32_t index) const {
+    assert(index < n_xdes_entries());
+    return XDesEntryView(buf_ + XDES_E::XDES_ARR_OFFSET +
+                         index * XDES_E::entry_size(page_size_));
+  }
+};
+
+class FSPHeaderPageView : public XDESPageView {
+public:
+  explicit FSPHeaderPageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : XDESPageView(buf, page_size) {}
+  uint32_t fsp_space_id() const { return FSPHeader::space_id(buf_); }
+  uint32_t fsp_size() const { return FSPHeader::fsp_size(buf_); }
+  uint32_t fsp_free_limit() const { return FSPHeader::fsp_free_limit(buf_); }
+  uint32_t space_flags() const { return FSPHeader::space_flags(buf_); }
+  uint32_t frag_n_used() const { return FSPHeader::frag_n_used(buf_); }
+  uint64_t next_unused_segment_id() const {
+    return FSPHeader::next_unused_segment_id(buf_);
+  }
+  XDesEntryList free_list() const {
+    return list(FSPHeader::list_base_node_for_free_list(buf_));
+  }
+  XDesEntryList free_frag_list() const {
+    return list(FSPHeader::list_base_node_for_free_frag_list(buf_));
+  }
+  XDesEntryList full_frag_list() const {
+    return list(FSPHeader::list_base_node_for_full_frag_list(buf_));
+  }
+  INodeEntryList full_inodes_list() const {
+    INodeEntryList l;
+    l.init(FSPHeader::list_base_node_for_full_inodes_list(buf_));
+    return l;
+  }
+  INodeEntryList free_inodes_list() const {
+    INodeEntryList l;
+    l.init(FSPHeader::list_base_node_for_free_inodes_list(buf_));
+    return l;
+  }
+  FSPHeader fsp_header() const {
+    FSPHeader header;
+    header.init(buf_);
+    return header;
+  }
+
+private:
+  static XDesEntryList list(const byte *p) {
+    XDesEntryList l;
+    l.init(p);
+    return l;
+  }
+};
+
+/// @brief view of one 192 bytes segment inode
+class INodeEntryView {
+public:
+  explicit INodeEntryView(const byte *entry) : entry_(entry) {}
+  static constexpr uint8_t FSEG_ID = 0;
+  static constexpr uint8_t FSEG_NOT_FULL_N_USED = 8;
+  static constexpr uint8_t FSEG_FREE = 12;
+  static constexpr uint8_t FSEG_NOT_FULL = 28;
+  static constexpr uint8_t FSEG_FULL = 44;
+  static constexpr uint8_t FSEG_FRAG_ARR = INode_E::MAGIC_NUMBER_OFFSET + 4;
+
+  const byte *entry() const { return entry_; }
+  uint64_t fseg_id() const { return mach_read_from_8(entry_ + FSEG_ID); }
+  uint32_t n_used_in_not_full_list() const {
+    return mach_read_from_4(entry_ + FSEG_NOT_FULL_N_USED);
+  }
+  XDesEntryList free_list() const { return list(entry_ + FSEG_FREE); }
+  XDesEntryList not_full_list() const { return list(entry_ + FSEG_NOT_FULL); }
+  XDesEntryList full_list() const { return list(entry_ + FSEG_FULL); }
+  uint32_t magic_number() const {
+    return mach_read_from_4(entry_ + INode_E::MAGIC_NUMBER_OFFSET);
+  }
+  bool is_valid() const { return magic_number() == INode_E::MAGIC_NUMBER; }
+  /// @brief a used inode entry has a non zero segment id
+  bool is_used() const { return is_valid() && fseg_id() != 0; }
+  /// @return the page number of the nth fragment page, UINT32_MAX if unused
+  uint32_t frag_page(uint32_t n) const {
+    assert(n < INode_E::FRAG_ARRAY_SIZE);
+    return mach_read_from_4(entry_ + FSEG_FRAG_ARR + n * 4);
+  }
+  INode_E decode() const {
+    INode_E e;
+    e.init(entry_);
+    return e;
+  }
+
+private:
+  static XDesEntryList list(const byte *p) {
+    XDesEntryList l;
+    l.init(p);
+    return l;
+  }
+  const byte *entry_;
+};
+
+class INodePageView : public PageView {
+public:
+  explicit INodePageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : PageView(buf, page_size) {}
+  Addr prev_inode_page() const {
+    const byte *node = buf_ + FILHeader::FIL_PAGE_DATA;
+    return Addr(ListNode::prev_page_number(node), ListNode::prev_offset(node));
+  }
+  Addr next_inode_page() const {
+    const byte *node = buf_ + FILHeader::FIL_PAGE_DATA;
+    return Addr(ListNode::next_page_number(node), ListNode::next_offset(node));
+  }
+  static uint16_t inode_entry_offset(uint32_t index) {
+    return FILHeader::FIL_PAGE_DATA + ListNode::LIST_NODE_SIZE +
+           index * INode_E::INODE_ENTRY_SIZE;
+  }
+  INodeEntryView inode_entry(uint32_t index) const {
+    assert(index < INODE_E_COUNT);
+    return INodeEntryView(buf_ + inode_entry_offset(index));
+  }
+  static constexpr unsigned int INODE_E_COUNT = 85;
+  /// @brief the inode entries of a page, INODE_E_COUNT for 16K pages
+  static uint32_t n_inode_entries(ulint page_size) {
+    return (page_size - inode_entry_offset(0) - FILHeader::FIL_PAGE_DATA_END) /
+           INode_E::INODE_ENTRY_SIZE;
+  }
+};
+
+class IndexPageView : public PageView {
+public:
+  explicit IndexPageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : PageView(buf, page_size) {}
+  static constexpr uint16_t PAGE_N_HEAP_COMPACT_FLAG = 0x8000;
+  /// the directions of the last inserts
+  static constexpr uint16_t PAGE_LEFT = 1;
+  static constexpr uint16_t PAGE_RIGHT = 2;
+  static constexpr uint16_t PAGE_SAME_REC = 3;
+  static constexpr uint16_t PAGE_SAME_PAGE = 4;
+  static constexpr uint16_t PAGE_NO_DIRECTION = 5;
+
+  uint16_t n_dir_slots() const { return IndexHeader::n_of_dir_slots(buf_); }
+  uint16_t heap_top() const { return IndexHeader::heap_top_pos(buf_); }
+  uint16_t n_heap() const {
+    return IndexHeader::n_of_heap_recs_or_ft_fg(buf_) &
+           ~PAGE_N_HEAP_COMPACT_FLAG;
+  }
+  bool is_compact() const {
+    return IndexHeader::n_of_heap_recs_or_ft_fg(buf_) &
+           PAGE_N_HEAP_COMPACT_FLAG;
+  }
+  uint16_t free_rec_offset() const {
+    return IndexHeader::first_garbage_rec_offset(buf_);
+  }
+  uint16_t garbage_bytes() const {
+    return mach_read_from_2(buf_ + IndexHeader::PAGE_HEADER +
+                            IndexHeader::PAGE_GARBAGE);
+  }
+  /// @brief the bytes of the user records in the heap, the records of the
+  /// PAGE_FREE list excluded
+  uint32_t record_bytes() const {
+    uint32_t heap = heap_top() > PAGE_NEW_SUPREMUM_END
+                        ? heap_top() - PAGE_NEW_SUPREMUM_END
+                        : 0;
+    return heap > garbage_bytes() ? heap - garbage_bytes() : 0;
+  }
+  /// @brief the bytes between the heap top and the page directory
+  uint32_t free_gap_bytes() const {
+    uint32_t dir = IndexPageDirectory::PAGE_DIR +
+                   n_dir_slots() * IndexPageDirectory::PAGE_DIR_SLOT_SIZE;
+    return heap_top() + dir < page_size_ ? page_size_ - dir - heap_top() : 0;
+  }
+  uint16_t direction() const { return IndexHeader::pg_direction(buf_); }
+  uint16_t n_direction() const {
+    return mach_read_from_2(buf_ + IndexHeader::PAGE_HEADER +
+                            IndexHeader::PAGE_N_DIRECTION);
+  }
+  uint16_t n_recs() const { return IndexHeader::n_of_recs(buf_); }
+  uint64_t max_trx_id() const { return IndexHeader::max_trx_id(buf_); }
+  uint16_t level() const { return IndexHeader::page_level(buf_); }
+  bool is_leaf() const { return level() == 0; }
+  uint64_t index_id() const { return IndexHeader::index_id(buf_); }
+  /// @brief the inode of the leaf segment, only set on the root
+  Addr leaf_inode() const {
+    const byte *h = FSEG_HEADER::fseg_header(buf_);
+    return Addr(mach_read_from_4(h + FSEG_HEADER::FSEG_HDR_LEAF_PAGE_NO),
+                mach_read_from_2(h + FSEG_HEADER::FSEG_HDR_LEAF_OFFSET));
+  }
+  /// @brief the inode of the non leaf segment, only set on the root
+  Addr top_inode() const {
+    const byte *h = FSEG_HEADER::fseg_header(buf_);
+    return Addr(mach_read_from_4(h + FSEG_HEADER::FSEG_HDR_INTERNAL_PAGE_NO),
+                mach_read_from_2(h + FSEG_HEADER::FSEG_HDR_INTERNAL_OFFSET));
+  }
+  bool is_root() const {
+    return prev_page() == UINT32_MAX && next_page() == UINT32_MAX;
+  }
+  const byte *infimum() const { return buf_ + PAGE_NEW_INFIMUM; }
+  const byte *supremum() const { return buf_ + PAGE_NEW_SUPREMUM; }
+  const byte *nth_slot(ulint n) const {
+    return IndexPageDirectory::get_nth_slot(buf_, n, page_size_);
+  }
+  const byte *slot_rec(ulint n) const {
+    return buf_ + mach_read_from_2(nth_slot(n));
+  }
+  IndexHeader index_header() const {
+    IndexHeader header;
+    header.init(buf_);
+    return header;
+  }
+
+  /// @brief the user records in key order, page_size must be the size of
+  /// the page, use for_each_record when it is only known at runtime
+  template <ulint page_size = PAGE_SIZE>
+  RecordRange<page_size> records() const {
+    assert(page_size == page_size_);
+    return RecordRange<page_size>(buf_);
+  }
+  /// @brief call f(const RecordView &) for the user records in key order
+  template <typename F> void for_each_record(F &&f) const {
+    dispatch_page_size(page_size_, [&](auto traits) {
+      for (const auto &rec : records<decltype(traits)::SIZE>())
+        f(rec);
+    });
+  }
+  /// @brief call f(const RecordView &) for the records of the PAGE_FREE
+  /// list, the freed records whose space isn't reused yet, most recently
+  /// freed first. The walk stops at a pointer out of the heap or a cycle.
+  template <typename F> void for_each_free_record(F &&f) const {
+    const uint32_t max_recs = page_size_ / REC_N_EXTRA_BYTES;
+    const uint16_t top = heap_top();
+    uint16_t offset = free_rec_offset();
+    for (uint32_t n = 0; offset != 0 && n < max_recs; ++n) {
+      if (offset < PAGE_NEW_SUPREMUM_END + REC_N_EXTRA_BYTES || offset >= top)
+        break;
+      f(RecordView(buf_, offset));
+      offset = RecordHeader::next_offs(buf_, offset, page_size_);
+    }
+  }
+};
+
+/// @brief view of the change buffer bitmap page, 4 bits for each page
+class IBufBitMapPageView : public PageView {
+public:
+  explicit IBufBitMapPageView(const byte *buf, ulint page_size = PAGE_SIZE)
+      : PageView(buf, page_size) {}
+  static constexpr uint8_t IBUF_BITMAP_FREE = 0;
+  static constexpr uint8_t IBUF_BITMAP_BUFFERED = 2;
+  static constexpr uint8_t IBUF_BITMAP_IBUF = 3;
+  static constexpr uint8_t IBUF_BITS_PER_PAGE = 4;
+  static constexpr uint8_t IBUF_BITMAP = FILHeader::FIL_PAGE_DATA;
+
+  /// @param page_no any page described by this bitmap page
+  /// @return the free space level 0-3, the first bit is the high one as in
+  /// ibuf_bitmap_page_get_bits_low
+  uint8_t free_space(uint32_t page_no) const {
+    return (get_bit(page_no, IBUF_BITMAP_FREE) << 1) |
+           get_bit(page_no, IBUF_BITMAP_FREE + 1);
+  }
+  bool buffered(uint32_t page_no) const {
+    return get_bit(page_no, IBUF_BITMAP_BUFFERED);
+  }
+  bool is_ibuf_page(uint32_t page_no) const {
+    return get_bit(page_no, IBUF_BITMAP_IBUF);
+  }
+
+private:
+  uint8_t get_bit(uint32_t page_no, uint8_t bit) const {
+    uint32_t index = (page_no % page_size_) * IBUF_BITS_PER_PAGE + bit;
+    return (mach_read_from_1(buf_ + IBUF_BITMAP + index / 8) >> (index % 8)) &
+           1;
+  }
+};
+
+} // namespace innodb
@@ -0,0 +1,121 @@
+#include "parallel_scanner.h"
+#include <algorithm>
+#include <glog/logging.h>
+#include <thread>
+
+using namespace innodb;
+
+void innodb::parallel_for(size_t n, uint32_t n_threads,
+                          const std::function<void(size_t)> &f) {
+  if (n_threads == 0)
+    n_threads = std::max(1U, std::thread::hardware_concurrency());
+  n_threads = std::min<size_t>(n_threads, std::max<size_t>(1, n));
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    for (size_t i = next++; i < n; i = next++)
+      f(i);
+  };
+  std::vector<std::thread> threads;
+  for (uint32_t i = 1; i < n_threads; ++i)
+    threads.emplace_back(work);
+  work();
+  for (auto &t : threads)
+    t.join();
+}
+
+ParallelScanner::ParallelScanner(FileSpaceReader *reader, uint32_t n_threads)
+    : reader_(reader), n_threads_(n_threads),
+      unit_pages_(reader->get_extent_size()), queues_(), pages_scanned_(0),
+      page_errors_(0), steals_(0) {
+  if (n_threads_ == 0)
+    n_threads_ = std::max(1U, std::thread::hardware_concurrency());
+  queues_.reset(new WorkQueue[n_threads_]);
+}
+
+void ParallelScanner::set_unit_pages(uint32_t n_pages) {
+  unit_pages_ = std::max<uint32_t>(1, n_pages);
+}
+
+bool ParallelScanner::next_unit(uint32_t thread_no, ScanUnit &unit) {
+  {
+    WorkQueue &own = queues_[thread_no];
+    std::lock_guard<std::mutex> lock(own.mutex_);
+    if (!own.units_.empty()) {
+      unit = own.units_.front();
+      own.units_.pop_front();
+      return true;
+    }
+  }
+  // steal from the tail, the owner keeps reading its head sequentially
+  for (uint32_t i = 1; i < n_threads_; ++i) {
+    WorkQueue &victim = queues_[(thread_no + i) % n_threads_];
+    std::lock_guard<std::mutex> lock(victim.mutex_);
+    if (!victim.units_.empty()) {
+      unit = victim.units_.back();
+      victim.units_.pop_back();
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  // no unit is added during a scan, all the queues are drained
+  return false;
+}
+
+void ParallelScanner::run(uint32_t first_page, uint32_t n_pages,
+                          const unit_func &func) {
+  pages_scanned_ = 0;
+  page_errors_ = 0;
+  steals_ = 0;
+  uint32_t page_count = reader_->get_page_count();
+  if (first_page >= page_count)
+    return;
+  n_pages = std::min(n_pages, page_count - first_page);
+
+  // hand every thread a continuous share of the units, aligned to the units
+  // so a unit never straddles two extents
+  std::vector<ScanUnit> units;
+  uint32_t end = first_page + n_pages;
+  for (uint32_t p = first_page; p < end;) {
+    uint32_t unit_end = std::min(end, (p / unit_pages_ + 1) * unit_pages_);
+    units.push_back({p, unit_end - p});
+    p = unit_end;
+  }
+  for (uint32_t t = 0; t < n_threads_; ++t) {
+    size_t begin = units.size() * t / n_threads_;
+    size_t last = units.size() * (t + 1) / n_threads_;
+    std::lock_guard<std::mutex> lock(queues_[t].mutex_);
+    queues_[t].units_.assign(units.begin() + begin, units.begin() + last);
+  }
+
+  auto worker = [this, &func](uint32_t thread_no) {
+    ScanUnit unit{};
+    while (next_unit(thread_no, unit))
+      func(thread_no, unit);
+  };
+  std::vector<std::thread> threads;
+  for (uint32_t t = 1; t < n_threads_; ++t)
+    threads.emplace_back(worker, t);
+  worker(0);
+  for (auto &t : threads)
+    t.join();
+}
+
+void ParallelScanner::scan_unit(
+    const ScanUnit &unit,
+    const std::function<void(uint32_t, const PageGuard &)> &func) {
+  if (reader_->read_pages(unit.first_page_, unit.n_pages_) < 0) {
+    LOG(ERROR) << "scan read error at page: " << unit.first_page_
+               << " n_pages: " << unit.n_pages_;
+  }
+  for (uint32_t i = 0; i < unit.n_pages_; ++i) {
+    uint32_t page_no = unit.first_page_ + i;
+    // usually a cache hit, read again if it was evicted in between
+    auto pg = reader_->fetch_page(page_no);
+    if (!pg) {
+      page_errors_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    func(page_no, pg);
+    pages_scanned_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
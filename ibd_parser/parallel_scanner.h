@@ -0,0 +1,122 @@
+#pragma once
+#include "file_space_reader.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace innodb {
+
+/// @brief call f(i) for i in [0, n) with a pool of threads, the calling
+/// one included, each thread takes the next i until none is left, so a few
+/// slow items, e.g. large files, don't hold the others back
+/// @param n_threads 0 means one thread per hardware thread, no more threads
+/// than items are started
+void parallel_for(size_t n, uint32_t n_threads,
+                  const std::function<void(size_t)> &f);
+
+/// @brief a run of continuous pages scanned by one thread, an extent by
+/// default
+struct ScanUnit {
+  uint32_t first_page_;
+  uint32_t n_pages_;
+};
+
+/// @brief scans the pages of a tablespace with a pool of threads. The space
+/// is split into extent sized units, every thread starts with a continuous
+/// share of the units and works through it in file order, a thread which
+/// runs out of units steals from the tail of the others, so the threads
+/// finish together even if some extents are expensive to decode.
+///
+/// Every thread accumulates into its own State, no locking is needed in the
+/// callback, the states are merged in thread order at the end.
+class ParallelScanner {
+public:
+  /// @param n_threads 0 means one thread per hardware thread
+  explicit ParallelScanner(FileSpaceReader *reader, uint32_t n_threads = 0);
+  ParallelScanner(const ParallelScanner &) = delete;
+  ParallelScanner &operator=(const ParallelScanner &) = delete;
+
+  /// @brief pages per unit, an extent by default
+  void set_unit_pages(uint32_t n_pages);
+  uint32_t unit_pages() const { return unit_pages_; }
+  uint32_t n_threads() const { return n_threads_; }
+
+  /// @brief scan the pages [first_page, first_page + n_pages), n_pages is
+  /// clamped to the size of the space
+  /// @param func called as func(State &, uint32_t page_no, const PageGuard &)
+  /// for every page, the page is pinned during the call
+  /// @param merge called as merge(State &into, State &from) for the states of
+  /// the threads 1 to N - 1 into the state of thread 0
+  /// @return the merged state
+  template <typename State, typename ScanFunc, typename MergeFunc>
+  State scan(ScanFunc func, MergeFunc merge, uint32_t first_page = 0,
+             uint32_t n_pages = UINT32_MAX);
+
+  /// @brief scan without a per thread state
+  template <typename ScanFunc>
+  void for_each_page(ScanFunc func, uint32_t first_page = 0,
+                     uint32_t n_pages = UINT32_MAX) {
+    struct Empty {};
+    scan<Empty>(
+        [&](Empty &, uint32_t page_no, const PageGuard &pg) {
+          func(page_no, pg);
+        },
+        [](Empty &, Empty &) {}, first_page, n_pages);
+  }
+
+  /// @brief stats of the last scan
+  uint64_t pages_scanned() const { return pages_scanned_.load(); }
+  uint64_t page_errors() const { return page_errors_.load(); }
+  uint64_t steals() const { return steals_.load(); }
+
+private:
+  using unit_func = std::function<void(uint32_t thread_no, const ScanUnit &)>;
+
+  /// @brief split the range into units and run func on every unit with the
+  /// thread pool, returns after all the units are done
+  void run(uint32_t first_page, uint32_t n_pages, const unit_func &func);
+
+  /// @brief read the unit into the page cache with one batched read, then
+  /// pin and hand out its pages one by one
+  void scan_unit(const ScanUnit &unit,
+                 const std::function<void(uint32_t, const PageGuard &)> &func);
+
+  struct WorkQueue {
+    std::mutex mutex_;
+    std::deque<ScanUnit> units_;
+  };
+  /// @brief the next unit of the thread, from its own queue first, stolen
+  /// from the others if it is empty
+  /// @return false if no unit is left anywhere
+  bool next_unit(uint32_t thread_no, ScanUnit &unit);
+
+private:
+  FileSpaceReader *reader_;
+  uint32_t n_threads_;
+  uint32_t unit_pages_;
+  std::unique_ptr<WorkQueue[]> queues_;
+  std::atomic<uint64_t> pages_scanned_;
+  std::atomic<uint64_t> page_errors_;
+  std::atomic<uint64_t> steals_;
+};
+
+template <typename State, typename ScanFunc, typename MergeFunc>
+State ParallelScanner::scan(ScanFunc func, MergeFunc merge,
+                            uint32_t first_page, uint32_t n_pages) {
+  std::vector<State> states(n_threads_);
+  run(first_page, n_pages, [&](uint32_t thread_no, const ScanUnit &unit) {
+    State &state = states[thread_no];
+    scan_unit(unit, [&](uint32_t page_no, const PageGuard &pg) {
+      func(state, page_no, pg);
+    });
+  });
+  for (uint32_t i = 1; i < n_threads_; ++i)
+    merge(states[0], states[i]);
+  return std::move(states[0]);
+}
+
+} // namespace innodb
@@ -0,0 +1,134 @@
+#include "prefetcher.h"
+#include "file_space_reader.h"
+#include <algorithm>
+#include <glog/logging.h>
+
+using namespace innodb;
+
+Prefetcher::Prefetcher(FileSpaceReader *reader, uint32_t n_threads)
+    : reader_(reader), page_size_(reader->get_page_size()),
+      extent_size_(extent_pages(page_size_)),
+      max_batch_pages_(MAX_BATCH_EXTENTS * extent_size_), threads_(), mutex_(),
+      cv_(), idle_cv_(), tasks_(), running_(0), stop_(false), pages_read_(0),
+      batches_(0) {
+  n_threads = std::max<uint32_t>(1, n_threads);
+  for (uint32_t i = 0; i < n_threads; ++i)
+    threads_.emplace_back(&Prefetcher::worker, this);
+}
+
+Prefetcher::~Prefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &t : threads_)
+    t.join();
+}
+
+void Prefetcher::submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void Prefetcher::worker() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty())
+        return; // stopped and drained
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+      ++running_;
+    }
+    task();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --running_;
+      if (running_ == 0 && tasks_.empty())
+        idle_cv_.notify_all();
+    }
+  }
+}
+
+void Prefetcher::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this]() { return running_ == 0 && tasks_.empty(); });
+}
+
+void Prefetcher::read_batch(uint32_t first_page, uint32_t n_pages) {
+  long n = reader_->read_pages(first_page, n_pages);
+  if (n < 0) {
+    LOG(ERROR) << "prefetch error at page: " << first_page
+               << " n_pages: " << n_pages;
+    return;
+  }
+  pages_read_ += n;
+  ++batches_;
+}
+
+void Prefetcher::prefetch_range(uint32_t first_page, uint32_t n_pages) {
+  while (n_pages > 0) {
+    uint32_t n = std::min(n_pages, max_batch_pages_);
+    submit([this, first_page, n]() { read_batch(first_page, n); });
+    first_page += n;
+    n_pages -= n;
+  }
+}
+
+void Prefetcher::prefetch_extent(uint32_t page_no) {
+  uint32_t first = page_no - page_no % extent_size_;
+  prefetch_range(first, extent_size_);
+}
+
+void Prefetcher::collect_extents(const XDesEntryList &base_node,
+                                 std::vector<uint32_t> &pages) {
+  reader_->traverse_xdes_list(base_node, [&](const XDES_E &, Addr addr) {
+    uint32_t first = XDES_E::extent_first_page(addr, page_size_);
+    for (uint32_t i = 0; i < extent_size_; ++i)
+      pages.push_back(first + i);
+  });
+}
+
+void Prefetcher::prefetch_xdes_list(const XDesEntryList &base_node) {
+  // walking the list reads the xdes pages, do it in the pool as well
+  submit([this, base_node]() {
+    std::vector<uint32_t> pages;
+    collect_extents(base_node, pages);
+    prefetch_pages(std::move(pages));
+  });
+}
+
+void Prefetcher::prefetch_segment(const INode_E &inode) {
+  submit([this, inode]() {
+    std::vector<uint32_t> pages;
+    for (auto page_no : inode.frag_array_) {
+      if (static_cast<uint32_t>(page_no) != UINT32_MAX)
+        pages.push_back(page_no);
+    }
+    collect_extents(inode.full_list_base_node_, pages);
+    collect_extents(inode.not_full_list_base_node_, pages);
+    prefetch_pages(std::move(pages));
+  });
+}
+
+void Prefetcher::prefetch_pages(std::vector<uint32_t> pages) {
+  std::sort(pages.begin(), pages.end());
+  pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+  size_t i = 0;
+  while (i < pages.size()) {
+    size_t j = i + 1;
+    while (j < pages.size() && pages[j] == pages[j - 1] + 1 &&
+           j - i < max_batch_pages_)
+      ++j;
+    uint32_t first = pages[i];
+    uint32_t n = j - i;
+    submit([this, first, n]() { read_batch(first, n); });
+    i = j;
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "headers.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace innodb {
+
+class FileSpaceReader;
+
+/// @brief reads pages into the page cache of a reader ahead of the
+/// traversals. The pages to read are collected extent by extent from the
+/// XDES lists and the INode_E segments, adjacent pages are coalesced into
+/// large batched reads and handed to a pool of I/O threads.
+class Prefetcher {
+public:
+  static constexpr uint32_t DEFAULT_THREADS = 4;
+  /// coalesce at most 4 extents into one read
+  static constexpr uint32_t MAX_BATCH_EXTENTS = 4;
+
+  explicit Prefetcher(FileSpaceReader *reader,
+                      uint32_t n_threads = DEFAULT_THREADS);
+  ~Prefetcher();
+  Prefetcher(const Prefetcher &) = delete;
+  Prefetcher &operator=(const Prefetcher &) = delete;
+
+  /// @brief read the range asynchronously, split into batches of
+  /// MAX_BATCH_EXTENTS extents
+  void prefetch_range(uint32_t first_page, uint32_t n_pages);
+
+  /// @brief read the whole extent the page belongs to asynchronously
+  void prefetch_extent(uint32_t page_no);
+
+  /// @brief read all the extents of the xdes list asynchronously
+  void prefetch_xdes_list(const XDesEntryList &base_node);
+
+  /// @brief read the fragment pages and the extents of the full and not full
+  /// lists of the segment asynchronously, the free list is skipped since its
+  /// extents hold no data
+  void prefetch_segment(const INode_E &inode);
+
+  /// @brief read the pages asynchronously, in any order, the runs of
+  /// adjacent pages are coalesced into batched reads
+  void prefetch_pages(std::vector<uint32_t> pages);
+
+  /// @brief block until all the submitted reads are done
+  void wait();
+
+  uint64_t pages_read() const { return pages_read_.load(); }
+  uint64_t batches() const { return batches_.load(); }
+
+private:
+  void submit(std::function<void()> task);
+  void worker();
+  void collect_extents(const XDesEntryList &base_node,
+                       std::vector<uint32_t> &pages);
+  void read_batch(uint32_t first_page, uint32_t n_pages);
+
+private:
+  FileSpaceReader *reader_;
+  uint32_t page_size_;
+  uint32_t extent_size_;     // pages per extent
+  uint32_t max_batch_pages_; // MAX_BATCH_EXTENTS extents
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable idle_cv_;
+  std::deque<std::function<void()>> tasks_;
+  uint32_t running_;
+  bool stop_;
+  std::atomic<uint64_t> pages_read_;
+  std::atomic<uint64_t> batches_;
+};
+
+} // namespace innodb
@@ -0,0 +1,89 @@
+#include "range_scanner.h"
+#include <algorithm>
+#include <glog/logging.h>
+
+using namespace innodb;
+
+RangeScanner::RangeScanner(BTree *tree, Prefetcher *prefetcher,
+                           std::vector<uint16_t> pk_fields)
+    : tree_(tree), leaf_scanner_(tree, prefetcher),
+      pk_fields_(std::move(pk_fields)) {
+  for (uint16_t f : pk_fields_)
+    n_pk_offsets_ = std::max<uint16_t>(n_pk_offsets_, f + 1);
+}
+
+bool RangeScanner::past_high(const KeyBound &high, const byte *rec) {
+  if (high.unbounded())
+    return false;
+  ++records_compared_;
+  int c = cmp_key_rec(high.key_, rec, tree_->index(), offsets_);
+  return c < 0 || (c == 0 && !high.inclusive_);
+}
+
+bool RangeScanner::scan(const KeyRange &range, record_func func) {
+  records_compared_ = 0;
+  records_returned_ = 0;
+  // the last record before the range, an inclusive low bound stops before
+  // the records equal to it and an exclusive one after them
+  BTreeCursor cursor;
+  if (range.low_.unbounded())
+    cursor = tree_->first();
+  else
+    cursor = tree_->search(range.low_.key_, range.low_.inclusive_
+                                                ? SearchMode::L
+                                                : SearchMode::LE);
+  if (!cursor.valid())
+    return false;
+  const uint32_t first_leaf = cursor.page_no_;
+  const uint16_t first_offset = cursor.rec_.offset();
+
+  bool done = false;
+  bool ok = leaf_scanner_.for_each_leaf(
+      [&](uint32_t page_no, const PageGuard &pg) {
+        const byte *buf = pg.buf();
+        uint16_t from =
+            page_no == first_leaf ? first_offset : (uint16_t)PAGE_NEW_INFIMUM;
+        dispatch_page_size(pg.as<IndexPageView>().page_size(), [&](auto t) {
+          using iterator = RecordIterator<decltype(t)::SIZE>;
+          const iterator end(buf, PAGE_NEW_SUPREMUM);
+          for (iterator it = ++iterator(buf, from); it != end; ++it) {
+            if (past_high(range.high_, it->data())) {
+              done = true;
+              return;
+            }
+            if (skip_deleted_ && it->is_deleted())
+              continue;
+            ++records_returned_;
+            if (!func(*it, page_no)) {
+              done = true;
+              return;
+            }
+          }
+        });
+        return !done;
+      },
+      std::move(cursor));
+  return ok;
+}
+
+bool RangeScanner::primary_key(const RecordView &rec, SearchKey &pk) {
+  pk = SearchKey();
+  if (pk_fields_.empty()) {
+    LOG(ERROR) << "the primary key fields of index "
+               << tree_->index().index_id_ << " are unknown";
+    return false;
+  }
+  const byte *data = rec.data();
+  if (!pk_offsets_.init(data, tree_->index(), n_pk_offsets_) ||
+      pk_offsets_.n_fields() < n_pk_offsets_)
+    return false;
+  for (uint16_t f : pk_fields_) {
+    if (pk_offsets_.is_null(f))
+      pk.add_null();
+    else
+      pk.add(std::string(reinterpret_cast<const char *>(
+                             pk_offsets_.field(data, f)),
+                         pk_offsets_.len(f)));
+  }
+  return true;
+}
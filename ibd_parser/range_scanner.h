@@ -0,0 +1,83 @@
+#pragma once
+#include "leaf_scanner.h"
+#include <functional>
+#include <vector>
+
+namespace innodb {
+
+/// @brief one end of a key range, the key may be a prefix of the index key
+/// fields, a record matches a prefix when its first fields are equal to it
+struct KeyBound {
+  SearchKey key_; // no fields for no bound
+  bool inclusive_ = true;
+
+  bool unbounded() const { return key_.size() == 0; }
+};
+
+/// @brief the records between two bounds in key order
+struct KeyRange {
+  KeyBound low_;
+  KeyBound high_;
+
+  static KeyRange all() { return KeyRange(); }
+  /// @brief the records whose first key fields are equal to the prefix
+  static KeyRange prefix(const SearchKey &key) {
+    KeyRange range;
+    range.low_.key_ = key;
+    range.high_.key_ = key;
+    return range;
+  }
+};
+
+/// @brief range scan of a clustered or a secondary index. The low bound is
+/// found by a descent of the tree, the leaves are then walked with a
+/// LeafScanner up to the high bound. The bounds are compared with the raw
+/// key fields of the records, like the descent does, a record is never
+/// decoded to be filtered out.
+class RangeScanner {
+public:
+  /// @param prefetcher nullptr to read the leaves one by one
+  /// @param pk_fields the positions of the primary key fields in the
+  /// records of a secondary index, needed by primary_key
+  RangeScanner(BTree *tree, Prefetcher *prefetcher = nullptr,
+               std::vector<uint16_t> pk_fields = {});
+
+  /// return false to stop the scan
+  using record_func =
+      std::function<bool(const RecordView &rec, uint32_t page_no)>;
+
+  /// @brief call func for each user record in the range in key order
+  /// @return false if the descent or the leaf walk failed
+  bool scan(const KeyRange &range, record_func func);
+
+  /// @brief the primary key of a record of the secondary index, to look up
+  /// the row in the clustered index with BTree::lookup
+  /// @return false if pk_fields is empty or the record is corrupt
+  bool primary_key(const RecordView &rec, SearchKey &pk);
+
+  /// @brief return the delete marked records too, true by default is to
+  /// skip them
+  void set_skip_deleted(bool skip) { skip_deleted_ = skip; }
+
+  /// @brief records compared with the high bound by the last scan
+  uint64_t records_compared() const { return records_compared_; }
+  uint64_t records_returned() const { return records_returned_; }
+  uint64_t leaves_scanned() const { return leaf_scanner_.leaves_scanned(); }
+
+private:
+  /// @brief the record is after the high bound
+  bool past_high(const KeyBound &high, const byte *rec);
+
+private:
+  BTree *tree_;
+  LeafScanner leaf_scanner_;
+  std::vector<uint16_t> pk_fields_;
+  uint16_t n_pk_offsets_ = 0; // the fields to decode for the primary key
+  RecOffsets offsets_;
+  RecOffsets pk_offsets_;
+  bool skip_deleted_ = true;
+  uint64_t records_compared_ = 0;
+  uint64_t records_returned_ = 0;
+};
+
+} // namespace innodb
@@ -0,0 +1,110 @@
+#include "rec_offsets.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace innodb;
+
+bool RecOffsets::init(const byte *rec, const IndexDef &index,
+                      uint16_t n_fields) {
+  ends_.clear();
+  flags_.clear();
+  uint8_t status = RecordHeader::rec_status(rec);
+  if (status != REC_STATUS_ORDINARY && status != REC_STATUS_NODE_PTR)
+    return false;
+  node_ptr_ = status == REC_STATUS_NODE_PTR;
+  // a node pointer has the key fields and then the child page number
+  uint16_t n_total = node_ptr_ ? index.n_uniq_ + 1 : index.n_fields();
+  n_fields = std::min(n_fields, n_total);
+  if (node_ptr_ && index.n_uniq_ > index.n_fields())
+    return false;
+
+  // the null bitmap is right before the header and grows backwards, the
+  // lengths of the variable fields are before it
+  const byte *nulls = rec - (REC_N_EXTRA_BYTES + 1);
+  const byte *lens = nulls - (index.n_nullable() + 7) / 8;
+  uint32_t null_mask = 1;
+  uint32_t offs = 0;
+  for (uint16_t i = 0; i < n_fields; ++i) {
+    uint8_t flags = 0;
+    uint32_t len = 0;
+    if (node_ptr_ && i == index.n_uniq_) {
+      len = IndexDef::REC_NODE_PTR_SIZE;
+    } else {
+      const FieldDef &field = index.fields_[i];
+      if (field.nullable_) {
+        if (!(null_mask & 0xff)) {
+          --nulls;
+          null_mask = 1;
+        }
+        bool is_null = mach_read_from_1(nulls) & null_mask;
+        null_mask <<= 1;
+        if (is_null) {
+          ends_.push_back(offs);
+          flags_.push_back(NULL_FLAG);
+          continue;
+        }
+      }
+      if (field.fixed_len_) {
+        len = field.fixed_len_;
+      } else {
+        len = mach_read_from_1(lens--);
+        if (field.two_byte_len() && (len & REC_2BYTE_LEN_FLAG)) {
+          if (len & REC_EXTERN_FLAG)
+            flags |= EXTERN_FLAG;
+          len = ((len & 0x3f) << 8) | mach_read_from_1(lens--);
+        }
+      }
+    }
+    offs += len;
+    ends_.push_back(offs);
+    flags_.push_back(flags);
+  }
+  extra_size_ = rec - (lens + 1);
+  return true;
+}
+
+uint32_t RecOffsets::max_extra_size(const IndexDef &index) {
+  uint32_t size = REC_N_EXTRA_BYTES + (index.n_nullable() + 7) / 8;
+  for (const auto &field : index.fields_) {
+    if (!field.fixed_len_)
+      size += field.two_byte_len() ? 2 : 1;
+  }
+  return size;
+}
+
+int innodb::cmp_key_rec(const SearchKey &key, const byte *rec,
+                        const IndexDef &index, RecOffsets &offsets) {
+  switch (RecordHeader::rec_status(rec)) {
+  case REC_STATUS_INFIMUM:
+    return 1;
+  case REC_STATUS_SUPREMUM:
+    return -1;
+  case REC_STATUS_NODE_PTR:
+    if (RecordHeader::info_bits(rec) & RecordHeader::REC_INFO_MIN_REC_FLAG)
+      return 1;
+    break;
+  default:
+    break;
+  }
+  uint16_t n = std::min(key.size(), index.n_uniq_);
+  if (!offsets.init(rec, index, n))
+    return 1;
+  for (uint16_t i = 0; i < n; ++i) {
+    bool key_null = key.nulls_[i];
+    bool rec_null = offsets.is_null(i);
+    if (key_null || rec_null) {
+      if (key_null != rec_null)
+        return key_null ? -1 : 1;
+      continue;
+    }
+    const std::string &k = key.fields_[i];
+    uint32_t rec_len = offsets.len(i);
+    int c = memcmp(k.data(), offsets.field(rec, i),
+                   std::min<size_t>(k.size(), rec_len));
+    if (c != 0)
+      return c;
+    if (k.size() != rec_len)
+      return k.size() < rec_len ? -1 : 1;
+  }
+  return 0;
+}
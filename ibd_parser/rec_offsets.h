@@ -0,0 +1,70 @@
+#pragma once
+#include "headers.h"
+#include "index_def.h"
+#include <vector>
+
+namespace innodb {
+
+/// @brief the offsets of the fields of a compact record, decoded from the
+/// null bitmap and the variable field lengths stored before the record
+/// header. The buffers are reused between records, decoding a record of a
+/// known index allocates nothing after the first one.
+class RecOffsets {
+public:
+  static constexpr uint16_t REC_2BYTE_LEN_FLAG = 0x80;
+  static constexpr uint16_t REC_EXTERN_FLAG = 0x40;
+
+  /// @brief decode the offsets of the first n_fields fields of the record
+  /// @param rec the record origin
+  /// @param n_fields UINT16_MAX for all the fields, a node pointer record
+  /// has the n_uniq key fields and the child page number
+  /// @return false if the record isn't a user record of the index
+  bool init(const byte *rec, const IndexDef &index,
+            uint16_t n_fields = UINT16_MAX);
+
+  uint16_t n_fields() const { return ends_.size(); }
+  bool is_null(uint16_t i) const { return flags_[i] & NULL_FLAG; }
+  /// @brief the field is stored off page, the local part ends with a 20 byte
+  /// reference to the LOB
+  bool is_extern(uint16_t i) const { return flags_[i] & EXTERN_FLAG; }
+  uint32_t start(uint16_t i) const { return i == 0 ? 0 : ends_[i - 1]; }
+  uint32_t len(uint16_t i) const { return ends_[i] - start(i); }
+  const byte *field(const byte *rec, uint16_t i) const {
+    return rec + start(i);
+  }
+  /// @brief bytes from the origin to the end of the decoded fields
+  uint32_t data_size() const { return ends_.empty() ? 0 : ends_.back(); }
+  /// @brief bytes before the origin, the lengths, the null bitmap and the
+  /// header
+  uint32_t extra_size() const { return extra_size_; }
+  bool node_ptr() const { return node_ptr_; }
+
+  /// @brief the largest extra size a record of the index can have, all the
+  /// variable fields not NULL and with their longest length bytes
+  static uint32_t max_extra_size(const IndexDef &index);
+
+  /// @brief the child page of a node pointer record
+  uint32_t child_page_no(const byte *rec) const {
+    return mach_read_from_4(rec + data_size() - IndexDef::REC_NODE_PTR_SIZE);
+  }
+
+private:
+  static constexpr uint8_t NULL_FLAG = 1;
+  static constexpr uint8_t EXTERN_FLAG = 2;
+  std::vector<uint32_t> ends_;
+  std::vector<uint8_t> flags_;
+  uint32_t extra_size_ = 0;
+  bool node_ptr_ = false;
+};
+
+/// @brief compare a search key with the key fields of a record, field by
+/// field with memcmp, a NULL is less than any value and a shorter field is
+/// less than a longer one with the same prefix. Only the fields present in
+/// the key are compared.
+/// @param offsets scratch for the offsets of the record key fields
+/// @return <0, 0 or >0 as the key is less, equal or greater, the infimum and
+/// the min rec of a level are less and the supremum greater than any key
+int cmp_key_rec(const SearchKey &key, const byte *rec, const IndexDef &index,
+                RecOffsets &offsets);
+
+} // namespace innodb
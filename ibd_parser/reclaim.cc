@@ -0,0 +1,186 @@
+#include "reclaim.h"
+#include "extent_map.h"
+#include "page_owner.h"
+#include "parallel_scanner.h"
+#include <algorithm>
+#include <cmath>
+#include <glog/logging.h>
+#include <unordered_map>
+
+using namespace innodb;
+
+namespace {
+
+/// a bulk load owns every 4th record by a directory slot, half of
+/// PAGE_DIR_SLOT_MAX_N_OWNED
+constexpr uint32_t RECS_PER_SLOT =
+    IndexPageDirectory::PAGE_DIR_SLOT_MAX_N_OWNED / 2;
+
+using IndexMap = std::unordered_map<uint64_t, IndexReclaim>;
+
+void add_index_page(IndexMap &indexes, const IndexPageView &page) {
+  IndexReclaim &r = indexes[page.index_id()];
+  r.garbage_bytes_ += page.garbage_bytes();
+  r.free_gap_bytes_ += page.free_gap_bytes();
+  if (page.is_leaf()) {
+    ++r.leaf_pages_;
+    r.leaf_recs_ += page.n_recs();
+    r.leaf_record_bytes_ += page.record_bytes();
+    if (page.direction() == IndexPageView::PAGE_NO_DIRECTION)
+      ++r.random_insert_leaves_;
+  } else {
+    ++r.non_leaf_pages_;
+    r.non_leaf_recs_ += page.n_recs();
+    r.non_leaf_record_bytes_ += page.record_bytes();
+  }
+}
+
+void merge_indexes(IndexMap &into, IndexMap &from) {
+  for (auto &it : from) {
+    IndexReclaim &r = into[it.first];
+    const IndexReclaim &f = it.second;
+    r.leaf_pages_ += f.leaf_pages_;
+    r.non_leaf_pages_ += f.non_leaf_pages_;
+    r.leaf_recs_ += f.leaf_recs_;
+    r.non_leaf_recs_ += f.non_leaf_recs_;
+    r.leaf_record_bytes_ += f.leaf_record_bytes_;
+    r.non_leaf_record_bytes_ += f.non_leaf_record_bytes_;
+    r.garbage_bytes_ += f.garbage_bytes_;
+    r.free_gap_bytes_ += f.free_gap_bytes_;
+    r.random_insert_leaves_ += f.random_insert_leaves_;
+  }
+}
+
+/// @brief the pages of the tree rebuilt from the leaves up
+uint64_t rebuilt_tree_pages(const IndexReclaim &r, uint32_t page_size,
+                            double fill_factor) {
+  uint64_t pages = ReclaimReport::rebuilt_level_pages(
+      r.leaf_record_bytes_, r.leaf_recs_, page_size, fill_factor);
+  if (pages == 0)
+    return r.pages() ? 1 : 0; // an empty index keeps its root
+  // the node pointers hold the key prefix of the leaves and a page number,
+  // a tree of one page now has none to measure
+  double ptr_bytes =
+      r.non_leaf_recs_ ? (double)r.non_leaf_record_bytes_ / r.non_leaf_recs_
+                       : (double)r.leaf_record_bytes_ / r.leaf_recs_;
+  uint64_t total = pages;
+  while (pages > 1) {
+    pages = ReclaimReport::rebuilt_level_pages(
+        (uint64_t)std::ceil(pages * ptr_bytes), pages, page_size,
+        fill_factor);
+    total += pages;
+  }
+  return total;
+}
+
+} // namespace
+
+uint64_t ReclaimReport::rebuilt_level_pages(uint64_t record_bytes,
+                                            uint64_t n_recs,
+                                            uint32_t page_size,
+                                            double fill_factor) {
+  if (n_recs == 0)
+    return 0;
+  const uint32_t usable =
+      page_size - PAGE_NEW_SUPREMUM_END - FILHeader::FIL_PAGE_DATA_END;
+  const double per_page = usable * fill_factor;
+  const uint64_t dir_bytes = (n_recs + RECS_PER_SLOT - 1) / RECS_PER_SLOT *
+                             IndexPageDirectory::PAGE_DIR_SLOT_SIZE;
+  return std::max<uint64_t>(
+      1, (uint64_t)std::ceil((record_bytes + dir_bytes) / per_page));
+}
+
+ReclaimReport ReclaimReport::build(FileSpaceReader *reader,
+                                   uint32_t n_threads, double fill_factor) {
+  ReclaimReport report;
+  report.page_size_ = reader->get_page_size();
+  report.fill_factor_ = fill_factor;
+  if (!(fill_factor > 0 && fill_factor <= 1)) {
+    LOG(ERROR) << "invalid fill factor " << fill_factor;
+    return report;
+  }
+  ExtentMap map;
+  PageOwnerIndex owners;
+  if (!map.load(reader) || !owners.build(reader))
+    return report;
+
+  const uint32_t page_size = report.page_size_;
+  ParallelScanner scanner(reader, n_threads);
+  IndexMap indexes = scanner.scan<IndexMap>(
+      [&](IndexMap &state, uint32_t page_no, const PageGuard &pg) {
+        if (map.is_page_free(page_no) ||
+            !fil_page_is_index(pg.as<PageView>().page_type()))
+          return;
+        add_index_page(state, IndexPageView(pg.buf(), page_size));
+      },
+      merge_indexes);
+
+  // the free pages of the extents the segments of each index hold
+  for (size_t e = 0; e < map.n_extents(); ++e) {
+    if (map.states_[e] != XDesEntryView::XDES_FSEG &&
+        map.states_[e] != XDesEntryView::XDES_FSEG_FRAG)
+      continue;
+    const SegmentOwner *s = owners.owner(e * map.extent_pages_);
+    if (s && s->index_id_ != 0)
+      indexes[s->index_id_].free_extent_pages_ += map.n_free_[e];
+  }
+  for (const auto &s : owners.segments()) {
+    if (s.role_ == SegmentRole::NON_LEAF)
+      indexes[s.index_id_].root_page_no_ = s.root_page_no_;
+  }
+
+  for (auto &it : indexes) {
+    it.second.index_id_ = it.first;
+    it.second.rebuilt_pages_ =
+        rebuilt_tree_pages(it.second, page_size, fill_factor);
+    report.indexes_.push_back(it.second);
+  }
+  std::sort(report.indexes_.begin(), report.indexes_.end(),
+            [](const IndexReclaim &a, const IndexReclaim &b) {
+              return a.index_id_ < b.index_id_;
+            });
+  report.valid_ = true;
+  return report;
+}
+
+ReclaimReport ReclaimReport::of_file(const std::string &file,
+                                     uint32_t n_threads,
+                                     double fill_factor) {
+  FileSpaceReader reader(file.c_str());
+  ReclaimReport report = build(&reader, n_threads, fill_factor);
+  report.file_ = file;
+  return report;
+}
+
+uint64_t ReclaimReport::reclaimable_pages() const {
+  uint64_t n = 0;
+  for (const auto &i : indexes_)
+    n += i.reclaimable_pages();
+  return n;
+}
+
+const IndexReclaim *ReclaimReport::find_index(uint64_t index_id) const {
+  auto it = std::lower_bound(indexes_.begin(), indexes_.end(), index_id,
+                             [](const IndexReclaim &i, uint64_t id) {
+                               return i.index_id_ < id;
+                             });
+  return it != indexes_.end() && it->index_id_ == index_id ? &*it : nullptr;
+}
+
+void ReclaimReport::dump(std::ostringstream &oss) const {
+  oss << "ReclaimReport of " << file_ << ": fill factor: " << fill_factor_
+      << ", reclaimable pages: " << reclaimable_pages()
+      << ", reclaimable bytes: " << reclaimable_bytes() << std::endl;
+  for (const auto &i : indexes_) {
+    oss << "index " << i.index_id_ << " root " << i.root_page_no_
+        << ": leaf pages: " << i.leaf_pages_
+        << ", non leaf pages: " << i.non_leaf_pages_
+        << ", records: " << i.leaf_recs_
+        << ", garbage bytes: " << i.garbage_bytes_
+        << ", free gap bytes: " << i.free_gap_bytes_
+        << ", random insert leaves: " << i.random_insert_leaves_
+        << ", free extent pages: " << i.free_extent_pages_
+        << ", rebuilt pages: " << i.rebuilt_pages_
+        << ", reclaimable pages: " << i.reclaimable_pages() << std::endl;
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "file_space_reader.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace innodb {
+
+/// @brief the space of one index and what a rebuild of it would take
+struct IndexReclaim {
+  uint64_t index_id_ = 0;
+  uint32_t root_page_no_ = UINT32_MAX; // UINT32_MAX if no root was found
+  uint64_t leaf_pages_ = 0;
+  uint64_t non_leaf_pages_ = 0;
+  /// the user records of the leaves and the node pointers of the non leaf
+  /// pages
+  uint64_t leaf_recs_ = 0;
+  uint64_t non_leaf_recs_ = 0;
+  uint64_t leaf_record_bytes_ = 0;
+  uint64_t non_leaf_record_bytes_ = 0;
+  /// the records of the PAGE_FREE lists, reused only by inserts that fit
+  uint64_t garbage_bytes_ = 0;
+  /// between the heap tops and the page directories
+  uint64_t free_gap_bytes_ = 0;
+  /// leaves whose inserts went in no direction, split in the middle
+  uint64_t random_insert_leaves_ = 0;
+  /// the free pages of the extents of the segments of the index
+  uint64_t free_extent_pages_ = 0;
+  /// the pages the rebuilt tree would have, set by ReclaimReport
+  uint64_t rebuilt_pages_ = 0;
+
+  uint64_t pages() const { return leaf_pages_ + non_leaf_pages_; }
+  /// @brief the pages a rebuild gives back, the emptied pages and the free
+  /// pages reserved in the extents
+  uint64_t reclaimable_pages() const {
+    uint64_t tree = pages() > rebuilt_pages_ ? pages() - rebuilt_pages_ : 0;
+    return tree + free_extent_pages_;
+  }
+};
+
+/// @brief estimates per index how much space a rebuild, like OPTIMIZE
+/// TABLE, would reclaim, from an offline copy of the tablespace. A rebuild
+/// loads the records sorted into new pages, filled up to the fill factor,
+/// and into new segments. So the rebuilt leaves are the leaf record bytes
+/// over the bytes a page takes at the fill factor, every level above has a
+/// node pointer of the average size for each page below, and the space
+/// reclaimed is the pages of the tree above that plus the free pages of the
+/// extents the segments hold.
+///
+/// The index pages are read with a ParallelScanner, the pages left free in
+/// the XDES bitmaps are skipped since a freed page keeps its old header,
+/// the extents are mapped to the indexes through the inodes of the space.
+struct ReclaimReport {
+  /// innodb_fill_factor 100 still leaves 1/16 of a page free
+  static constexpr double DEFAULT_FILL_FACTOR = 15.0 / 16;
+
+  std::string file_;
+  uint32_t page_size_ = PAGE_SIZE;
+  double fill_factor_ = DEFAULT_FILL_FACTOR;
+  /// sorted by the index id
+  std::vector<IndexReclaim> indexes_;
+  bool valid_ = false;
+
+  uint64_t reclaimable_pages() const;
+  uint64_t reclaimable_bytes() const {
+    return reclaimable_pages() * page_size_;
+  }
+  const IndexReclaim *find_index(uint64_t index_id) const;
+
+  /// @param n_threads 0 means one thread per hardware thread
+  /// @param fill_factor the share of a page a rebuild fills, in (0, 1]
+  /// @return invalid if the XDES pages or the inodes can't be read
+  static ReclaimReport build(FileSpaceReader *reader, uint32_t n_threads = 0,
+                             double fill_factor = DEFAULT_FILL_FACTOR);
+  static ReclaimReport of_file(const std::string &file,
+                               uint32_t n_threads = 0,
+                               double fill_factor = DEFAULT_FILL_FACTOR);
+  /// @brief the pages a level of n_recs records taking record_bytes would
+  /// be rebuilt into
+  static uint64_t rebuilt_level_pages(uint64_t record_bytes, uint64_t n_recs,
+                                      uint32_t page_size,
+                                      double fill_factor);
+
+  void dump(std::ostringstream &oss) const;
+};
+
+} // namespace innodb
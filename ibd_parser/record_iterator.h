@@ -0,0 +1,112 @@
+#pragma once
+#include "headers.h"
+#include <cstddef>
+#include <iterator>
+
+namespace innodb {
+
+/// @brief non-owning view of one compact record. The record is addressed by
+/// its origin, the 5 byte header is right before it and the fields follow
+/// it. Nothing is decoded until asked for.
+class RecordView {
+public:
+  RecordView() = default;
+  RecordView(const byte *pg, uint16_t offset) : pg_(pg), offset_(offset) {}
+
+  /// @brief offset of the record origin inside the page
+  uint16_t offset() const { return offset_; }
+  /// @brief the record origin, the first field starts here
+  const byte *data() const { return pg_ + offset_; }
+  const byte *page() const { return pg_; }
+
+  uint8_t info_bits() const { return RecordHeader::info_bits(data()); }
+  bool is_deleted() const {
+    return info_bits() & RecordHeader::REC_INFO_DELETED_FLAG;
+  }
+  /// @brief the left most record of a non leaf level
+  bool is_min_rec() const {
+    return info_bits() & RecordHeader::REC_INFO_MIN_REC_FLAG;
+  }
+  uint8_t n_owned() const { return RecordHeader::num_of_recs_owned(data()); }
+  uint16_t heap_no() const { return RecordHeader::heap_no_new(data()); }
+  /// @brief one of rec_type
+  uint8_t status() const { return RecordHeader::rec_status(data()); }
+  bool is_user_rec() const {
+    return status() == REC_STATUS_ORDINARY || status() == REC_STATUS_NODE_PTR;
+  }
+
+private:
+  const byte *pg_ = nullptr;
+  uint16_t offset_ = 0;
+};
+
+/// @brief forward iterator following the next record pointers of a compact
+/// index page. It only holds the page and an offset, copying and advancing
+/// it allocates nothing. A broken chain, a pointer out of the record area
+/// or a cycle, ends the walk at the supremum.
+template <ulint page_size = PAGE_SIZE> class RecordIterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = RecordView;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const RecordView *;
+  using reference = const RecordView &;
+
+  /// every record takes at least its header
+  static constexpr uint32_t MAX_RECS = page_size / REC_N_EXTRA_BYTES;
+
+  RecordIterator() = default;
+  RecordIterator(const byte *pg, uint16_t offset) : rec_(pg, offset) {}
+
+  reference operator*() const { return rec_; }
+  pointer operator->() const { return &rec_; }
+
+  RecordIterator &operator++() {
+    uint16_t next =
+        RecordHeader::next_offs<page_size>(rec_.page(), rec_.offset());
+    if (next < PAGE_NEW_SUPREMUM ||
+        next >= page_size - IndexPageDirectory::PAGE_DIR ||
+        ++steps_ > MAX_RECS) {
+      broken_ = true;
+      next = PAGE_NEW_SUPREMUM;
+    }
+    rec_ = RecordView(rec_.page(), next);
+    return *this;
+  }
+  RecordIterator operator++(int) {
+    RecordIterator it = *this;
+    ++*this;
+    return it;
+  }
+
+  bool operator==(const RecordIterator &other) const {
+    return rec_.offset() == other.rec_.offset();
+  }
+  bool operator!=(const RecordIterator &other) const {
+    return !(*this == other);
+  }
+
+  /// @brief the walk was cut short by a broken record chain
+  bool broken() const { return broken_; }
+
+private:
+  RecordView rec_;
+  uint32_t steps_ = 0;
+  bool broken_ = false;
+};
+
+/// @brief the user records of a compact index page in key order, from the
+/// record after the infimum up to the supremum, for range based for loops
+template <ulint page_size = PAGE_SIZE> class RecordRange {
+public:
+  using iterator = RecordIterator<page_size>;
+  explicit RecordRange(const byte *pg) : pg_(pg) {}
+
+  iterator begin() const { return ++iterator(pg_, PAGE_NEW_INFIMUM); }
+  iterator end() const { return iterator(pg_, PAGE_NEW_SUPREMUM); }
+
+private:
+  const byte *pg_;
+};
+
+} // namespace innodb
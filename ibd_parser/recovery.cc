@@ -0,0 +1,118 @@
+#include "recovery.h"
+#include <glog/logging.h>
+#include <memory>
+
+using namespace innodb;
+
+const char *innodb::recovery_source_str(RecoverySource source) {
+  switch (source) {
+  case RecoverySource::DELETE_MARKED:
+    return "DELETE_MARKED";
+  case RecoverySource::FREE_LIST:
+    return "FREE_LIST";
+  }
+  return "UNKNOWN";
+}
+
+void RecoveredRows::clear() {
+  batch_.clear();
+  page_nos_.clear();
+  offsets_.clear();
+  sources_.clear();
+}
+
+/// the decoder keeps its offsets between records, one for each thread
+struct DeletedRecordScanner::ThreadState {
+  std::unique_ptr<BatchDecoder> decoder_;
+  RecoveredRows rows_;
+};
+
+DeletedRecordScanner::DeletedRecordScanner(FileSpaceReader *reader,
+                                           const TableSchema &schema,
+                                           uint32_t n_threads)
+    : scanner_(reader, n_threads), schema_(schema),
+      max_extra_size_(RecOffsets::max_extra_size(schema.index_def())) {}
+
+void DeletedRecordScanner::flush(ThreadState &state) {
+  if (state.rows_.size() == 0)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(func_mutex_);
+    (*func_)(state.rows_);
+  }
+  state.rows_.clear();
+}
+
+void DeletedRecordScanner::scan_page(ThreadState &state, uint32_t page_no,
+                                     const IndexPageView &page) {
+  if (!state.decoder_) {
+    state.decoder_.reset(new BatchDecoder(schema_));
+    state.rows_.batch_ = state.decoder_->make_batch();
+  }
+  ++leaves_scanned_;
+  // the fields of a record end before the top of the heap
+  const uint16_t top = page.heap_top();
+  RecoveredRows &rows = state.rows_;
+  auto recover = [&](const RecordView &rec, RecoverySource source) {
+    if (rec.offset() >= top ||
+        !state.decoder_->decode_record(rec.data(), rows.batch_,
+                                       top - rec.offset())) {
+      ++bad_records_;
+      return;
+    }
+    rows.page_nos_.push_back(page_no);
+    rows.offsets_.push_back(rec.offset());
+    rows.sources_.push_back(source);
+    if (source == RecoverySource::DELETE_MARKED)
+      ++delete_marked_recs_;
+    else
+      ++free_list_recs_;
+    if (rows.size() >= batch_rows_)
+      flush(state);
+  };
+  if (delete_marked_) {
+    page.for_each_record([&](const RecordView &rec) {
+      if (rec.is_deleted())
+        recover(rec, RecoverySource::DELETE_MARKED);
+    });
+  }
+  if (free_list_) {
+    page.for_each_free_record([&](const RecordView &rec) {
+      // the null bitmap and the lengths are walked backwards from a garbage
+      // offset, they must stay in the page
+      if (rec.offset() < max_extra_size_) {
+        ++bad_records_;
+        return;
+      }
+      recover(rec, RecoverySource::FREE_LIST);
+    });
+  }
+}
+
+bool DeletedRecordScanner::scan(const rows_func &func, uint32_t first_page,
+                                uint32_t n_pages) {
+  leaves_scanned_ = 0;
+  delete_marked_recs_ = 0;
+  free_list_recs_ = 0;
+  bad_records_ = 0;
+  if (!BatchDecoder(schema_).valid()) {
+    LOG(ERROR) << "the records of index " << schema_.index_id_
+               << " can't be decoded by the schema";
+    return false;
+  }
+  func_ = &func;
+  auto state = scanner_.scan<ThreadState>(
+      [this](ThreadState &state, uint32_t page_no, const PageGuard &pg) {
+        auto page = pg.as<IndexPageView>();
+        if (page.page_type() != FIL_PAGE_INDEX || !page.is_compact() ||
+            !page.is_leaf() ||
+            (schema_.index_id_ != 0 && page.index_id() != schema_.index_id_))
+          return;
+        scan_page(state, page_no, page);
+      },
+      [this](ThreadState &, ThreadState &from) { flush(from); }, first_page,
+      n_pages);
+  flush(state);
+  func_ = nullptr;
+  return true;
+}
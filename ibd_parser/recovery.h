@@ -0,0 +1,101 @@
+#pragma once
+#include "column_batch.h"
+#include "parallel_scanner.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace innodb {
+
+/// @brief where a recovered record was found on its page
+enum class RecoverySource : uint8_t {
+  DELETE_MARKED, // in the record list, delete marked and not purged yet
+  FREE_LIST,     // in the PAGE_FREE list, purged or moved away by an update
+};
+
+const char *recovery_source_str(RecoverySource source);
+
+/// @brief a batch of recovered rows and where each of them was found
+struct RecoveredRows {
+  ColumnBatch batch_;
+  std::vector<uint32_t> page_nos_;
+  std::vector<uint16_t> offsets_;
+  std::vector<RecoverySource> sources_;
+
+  size_t size() const { return batch_.n_rows_; }
+  void clear();
+};
+
+/// @brief recovers the deleted records of a clustered index by scanning all
+/// the leaves of the index in the tablespace with a ParallelScanner, in file
+/// order and without walking the tree, so it still works when the upper
+/// levels are damaged. A deleted record stays delete marked in the record
+/// list until purge removes it, then it sits in the PAGE_FREE list of its
+/// page until an insert reuses its space, both are decoded by the schema.
+///
+/// The free list also holds the old versions of the records an update had
+/// to move, the DB_TRX_ID of a row tells them apart. The records of the free
+/// list aren't trusted, one whose extra bytes could reach before the page or
+/// which doesn't decode inside the heap is counted in bad_records() and
+/// skipped.
+class DeletedRecordScanner {
+public:
+  static constexpr size_t DEFAULT_BATCH_ROWS = 1024;
+
+  /// @param n_threads 0 means one thread per hardware thread
+  DeletedRecordScanner(FileSpaceReader *reader, const TableSchema &schema,
+                       uint32_t n_threads = 0);
+
+  /// @brief the records to recover, both by default
+  void set_sources(bool delete_marked, bool free_list) {
+    delete_marked_ = delete_marked;
+    free_list_ = free_list;
+  }
+  /// @brief rows of the batches handed to the callback
+  void set_batch_rows(size_t n_rows) {
+    batch_rows_ = std::max<size_t>(1, n_rows);
+  }
+
+  /// called for every full batch, and for what is left of the batches at
+  /// the end, one call at a time in no particular order
+  using rows_func = std::function<void(const RecoveredRows &)>;
+
+  /// @brief recover the records of the pages [first_page, first_page +
+  /// n_pages), the rows are streamed to func as the threads fill batches
+  /// @return false if the schema can't be decoded
+  bool scan(const rows_func &func, uint32_t first_page = 0,
+            uint32_t n_pages = UINT32_MAX);
+
+  /// @brief stats of the last scan
+  uint64_t pages_scanned() const { return scanner_.pages_scanned(); }
+  uint64_t leaves_scanned() const { return leaves_scanned_.load(); }
+  uint64_t delete_marked() const { return delete_marked_recs_.load(); }
+  uint64_t free_list() const { return free_list_recs_.load(); }
+  uint64_t bad_records() const { return bad_records_.load(); }
+
+private:
+  struct ThreadState;
+
+  void scan_page(ThreadState &state, uint32_t page_no,
+                 const IndexPageView &page);
+  /// @brief hand the rows of the state to the callback and clear them
+  void flush(ThreadState &state);
+
+private:
+  ParallelScanner scanner_;
+  TableSchema schema_;
+  /// the extra bytes of the largest record header of the schema
+  uint32_t max_extra_size_;
+  bool delete_marked_ = true;
+  bool free_list_ = true;
+  size_t batch_rows_ = DEFAULT_BATCH_ROWS;
+  const rows_func *func_ = nullptr;
+  std::mutex func_mutex_;
+  std::atomic<uint64_t> leaves_scanned_{0};
+  std::atomic<uint64_t> delete_marked_recs_{0};
+  std::atomic<uint64_t> free_list_recs_{0};
+  std::atomic<uint64_t> bad_records_{0};
+};
+
+} // namespace innodb
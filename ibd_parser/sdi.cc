@@ -0,0 +1,457 @@
+#include "sdi.h"
+#include "btree.h"
+#include "leaf_scanner.h"
+#include "lob.h"
+#include <algorithm>
+#include <glog/logging.h>
+#include <zlib.h>
+
+using namespace innodb;
+
+namespace {
+
+/// a corrupt length is rejected rather than allocated
+constexpr uint32_t SDI_MAX_UNCOMPRESSED_LEN = 64 << 20;
+
+/// @brief a value of se_private_data, "id=157;root=4;space_id=3;"
+uint64_t se_private_value(const std::string &data, const std::string &key,
+                          uint64_t def) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    size_t end = data.find(';', pos);
+    if (end == std::string::npos)
+      end = data.size();
+    size_t eq = data.find('=', pos);
+    if (eq < end && data.compare(pos, eq - pos, key) == 0)
+      return strtoull(data.c_str() + eq + 1, nullptr, 10);
+    pos = end + 1;
+  }
+  return def;
+}
+
+/// @brief the bytes of a DECIMAL, 4 bytes for every 9 digits on both sides
+/// of the point and the bytes of the rest
+uint32_t decimal_bin_size(uint32_t precision, uint32_t scale) {
+  static const uint32_t dig2bytes[10] = {0, 1, 1, 2, 2, 3, 3, 4, 4, 4};
+  uint32_t intg = precision - std::min(precision, scale);
+  return intg / 9 * 4 + dig2bytes[intg % 9] + scale / 9 * 4 +
+         dig2bytes[scale % 9];
+}
+
+/// @brief innodb stores a CHAR of a multi byte charset with a variable
+/// length, these are the single byte collations, binary, latin1 and ascii
+bool is_single_byte_collation(uint32_t collation_id) {
+  switch (collation_id) {
+  case 5:
+  case 8:
+  case 11:
+  case 15:
+  case 31:
+  case 47:
+  case 48:
+  case 49:
+  case 63:
+  case 65:
+  case 94:
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+bool SdiColumn::column_def(ColumnDef &def) const {
+  if (name_ == "DB_TRX_ID") {
+    def = ColumnDef::trx_id();
+    return true;
+  }
+  if (name_ == "DB_ROLL_PTR") {
+    def = ColumnDef::roll_ptr();
+    return true;
+  }
+  if (name_ == "DB_ROW_ID") {
+    def = ColumnDef::make(name_, ColumnType::UINT, 6);
+    return true;
+  }
+  const ColumnType int_type = unsigned_ ? ColumnType::UINT : ColumnType::INT;
+  const uint32_t frac_bytes = (datetime_precision_ + 1) / 2;
+  ColumnType type = ColumnType::FIXED_BINARY;
+  uint32_t len = 0;
+  bool blob = false;
+  switch (type_) {
+  case TINY:
+    type = int_type;
+    len = 1;
+    break;
+  case SHORT:
+    type = int_type;
+    len = 2;
+    break;
+  case INT24:
+    type = int_type;
+    len = 3;
+    break;
+  case LONG:
+    type = int_type;
+    len = 4;
+    break;
+  case LONGLONG:
+    type = int_type;
+    len = 8;
+    break;
+  case YEAR:
+    type = ColumnType::UINT;
+    len = 1;
+    break;
+  case FLOAT:
+    type = ColumnType::FLOAT;
+    len = 4;
+    break;
+  case DOUBLE:
+    type = ColumnType::DOUBLE;
+    len = 8;
+    break;
+  case NEWDECIMAL:
+    len = decimal_bin_size(numeric_precision_, numeric_scale_);
+    break;
+  case NEWDATE:
+    len = 3;
+    break;
+  case TIME2:
+    len = 3 + frac_bytes;
+    break;
+  case TIMESTAMP2:
+    len = 4 + frac_bytes;
+    break;
+  case DATETIME2:
+    len = 5 + frac_bytes;
+    break;
+  case BIT:
+    len = (numeric_precision_ + 7) / 8;
+    break;
+  case ENUM:
+    type = ColumnType::UINT;
+    len = n_elements_ < 256 ? 1 : 2;
+    break;
+  case SET:
+    type = ColumnType::UINT;
+    len = (n_elements_ + 7) / 8;
+    if (len > 4)
+      len = 8;
+    break;
+  case STRING:
+    if (!is_single_byte_collation(collation_id_))
+      type = ColumnType::VARBINARY;
+    len = char_length_;
+    break;
+  case VARCHAR:
+  case VAR_STRING:
+    type = ColumnType::VARBINARY;
+    len = char_length_;
+    break;
+  case TINY_BLOB:
+  case MEDIUM_BLOB:
+  case LONG_BLOB:
+  case BLOB:
+  case GEOMETRY:
+  case JSON:
+    type = ColumnType::VARBINARY;
+    len = char_length_;
+    blob = true;
+    break;
+  default:
+    LOG(ERROR) << "column " << name_ << " has the unsupported type "
+               << type_;
+    return false;
+  }
+  def = ColumnDef::make(name_, type, len, nullable_, blob);
+  return true;
+}
+
+const SdiIndex *SdiTable::primary() const {
+  for (const auto &index : indexes_) {
+    if (index.type_ == SdiIndex::IT_PRIMARY)
+      return &index;
+  }
+  return nullptr;
+}
+
+bool SdiTable::table_schema(TableSchema &schema) const {
+  const SdiIndex *index = primary();
+  if (!index) {
+    LOG(ERROR) << "table " << name_ << " has no clustered index";
+    return false;
+  }
+  schema = TableSchema();
+  schema.index_id_ = index->id_;
+  schema.n_pk_ = 0;
+  for (const auto &element : index->elements_) {
+    if (element.column_opx_ >= columns_.size()) {
+      LOG(ERROR) << "index " << index->name_ << " of table " << name_
+                 << " refers to column " << element.column_opx_;
+      return false;
+    }
+    ColumnDef def;
+    if (!columns_[element.column_opx_].column_def(def))
+      return false;
+    schema.columns_.push_back(std::move(def));
+    schema.n_pk_ += !element.hidden_;
+  }
+  return schema.n_pk_ > 0;
+}
+
+bool SdiTable::from_json(const JsonValue &dd_object, SdiTable &table) {
+  if (!dd_object.is_object())
+    return false;
+  table = SdiTable();
+  table.name_ = dd_object.get_str("name");
+  table.schema_name_ = dd_object.get_str("schema_ref");
+  table.table_id_ =
+      se_private_value(dd_object.get_str("se_private_data"), "id", 0);
+  const JsonValue *columns = dd_object.get("columns");
+  if (!columns || !columns->is_array() || columns->arr_.empty())
+    return false;
+  for (const auto &c : columns->arr_) {
+    SdiColumn col;
+    col.name_ = c.get_str("name");
+    col.type_ = c.get_int("type");
+    col.column_type_utf8_ = c.get_str("column_type_utf8");
+    col.nullable_ = c.get_bool("is_nullable");
+    col.unsigned_ = c.get_bool("is_unsigned");
+    col.virtual_ = c.get_bool("is_virtual");
+    col.hidden_ = c.get_int("hidden", SdiColumn::HT_VISIBLE);
+    col.ordinal_position_ = c.get_int("ordinal_position");
+    col.char_length_ = c.get_int("char_length");
+    col.numeric_precision_ = c.get_int("numeric_precision");
+    col.numeric_scale_ = c.get_int("numeric_scale");
+    col.datetime_precision_ = c.get_int("datetime_precision");
+    col.collation_id_ = c.get_int("collation_id");
+    const JsonValue *elements = c.get("elements");
+    if (elements && elements->is_array())
+      col.n_elements_ = elements->arr_.size();
+    table.columns_.push_back(std::move(col));
+  }
+  const JsonValue *indexes = dd_object.get("indexes");
+  if (indexes && indexes->is_array()) {
+    for (const auto &i : indexes->arr_) {
+      SdiIndex index;
+      index.name_ = i.get_str("name");
+      index.type_ = i.get_int("type");
+      std::string se_data = i.get_str("se_private_data");
+      index.id_ = se_private_value(se_data, "id", 0);
+      index.root_page_no_ = se_private_value(se_data, "root", UINT32_MAX);
+      const JsonValue *elements = i.get("elements");
+      if (elements && elements->is_array()) {
+        for (const auto &e : elements->arr_) {
+          SdiIndexElement element;
+          element.column_opx_ = e.get_int("column_opx");
+          element.length_ = e.get_int("length");
+          element.hidden_ = e.get_bool("hidden");
+          index.elements_.push_back(element);
+        }
+      }
+      table.indexes_.push_back(std::move(index));
+    }
+  }
+  return true;
+}
+
+const SdiTable *SdiSpace::find_table(const std::string &name) const {
+  for (const auto &table : tables_) {
+    if (table.name_ == name)
+      return &table;
+  }
+  return nullptr;
+}
+
+SdiCache &SdiCache::global() {
+  static SdiCache cache;
+  return cache;
+}
+
+std::shared_ptr<const SdiSpace> SdiCache::get(uint32_t space_id,
+                                              uint64_t lsn) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = spaces_.find(space_id);
+  if (it == spaces_.end() || it->second->lsn_ != lsn) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  return it->second;
+}
+
+void SdiCache::put(std::shared_ptr<const SdiSpace> space) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  spaces_[space->space_id_] = std::move(space);
+}
+
+void SdiCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  spaces_.clear();
+  hits_ = 0;
+  misses_ = 0;
+}
+
+SdiReader::SdiReader(FileSpaceReader *reader, SdiCache *cache)
+    : reader_(reader), cache_(cache) {}
+
+uint32_t SdiReader::sdi_root_page(const byte *page0, ulint page_size) {
+  const byte *p = page0 + sdi_offset(page_size);
+  uint32_t version = mach_read_from_4(p);
+  uint32_t root = mach_read_from_4(p + 4);
+  if (version != SDI_VERSION || root == 0)
+    return UINT32_MAX;
+  return root;
+}
+
+const TableSchema &SdiReader::sdi_schema() {
+  static const TableSchema schema = TableSchema::clustered(
+      0,
+      {ColumnDef::make("type", ColumnType::UINT, 4),
+       ColumnDef::make("id", ColumnType::UINT, 8)},
+      {ColumnDef::make("uncompressed_len", ColumnType::UINT, 4),
+       ColumnDef::make("compressed_len", ColumnType::UINT, 4),
+       ColumnDef::make("data", ColumnType::VARBINARY, UINT32_MAX, false,
+                       true)});
+  return schema;
+}
+
+bool SdiReader::read_compressed(ColumnBatch &batch, uint64_t &lsn) {
+  PageGuard page0 = reader_->fetch_page(0);
+  if (!page0) {
+    LOG(ERROR) << "fails to read page 0";
+    return false;
+  }
+  uint32_t root = sdi_root_page(page0.buf(), reader_->get_page_size());
+  if (root == UINT32_MAX) {
+    LOG(ERROR) << "the space " << page0.as<PageView>().space_id()
+               << " has no SDI";
+    return false;
+  }
+  PageGuard root_page = reader_->fetch_page(root);
+  if (!root_page) {
+    LOG(ERROR) << "fails to read the SDI root page " << root;
+    return false;
+  }
+  lsn = root_page.as<PageView>().lsn();
+
+  BTree tree(reader_, root, sdi_schema().index_def());
+  LeafScanner scanner(&tree);
+  BatchDecoder decoder(sdi_schema());
+  batch = decoder.make_batch();
+  bool bad_page = false;
+  bool ok = scanner.for_each_leaf([&](uint32_t, const PageGuard &pg) {
+    lsn = std::max(lsn, pg.as<PageView>().lsn());
+    if (decoder.decode_page(pg.as<IndexPageView>(), batch) < 0) {
+      bad_page = true;
+      return false;
+    }
+    return true;
+  });
+  return ok && !bad_page;
+}
+
+bool SdiReader::decompress(const ColumnBatch &batch, size_t row,
+                           SdiRecord &rec) {
+  rec.type_ = batch.columns_[0].ints_[row];
+  rec.id_ = batch.columns_[1].ints_[row];
+  uint32_t uncompressed_len = batch.columns_[4].ints_[row];
+  uint32_t compressed_len = batch.columns_[5].ints_[row];
+  const ColumnVector &data = batch.columns_[6];
+  std::string_view compressed = data.str(row);
+  std::string buf;
+  if (data.is_extern(row)) {
+    if (compressed.size() < LobRef::BTR_EXTERN_FIELD_REF_SIZE)
+      return false;
+    size_t local = compressed.size() - LobRef::BTR_EXTERN_FIELD_REF_SIZE;
+    buf.assign(compressed.substr(0, local));
+    LobRef ref = LobRef::parse(
+        reinterpret_cast<const byte *>(compressed.data()) + local);
+    if (!LobStream::read(reader_, ref, buf, compressed_len))
+      return false;
+    compressed = buf;
+  }
+  if (compressed.size() != compressed_len ||
+      uncompressed_len > SDI_MAX_UNCOMPRESSED_LEN) {
+    LOG(ERROR) << "SDI " << rec.type_ << ":" << rec.id_ << " has "
+               << compressed.size() << " bytes, expected " << compressed_len
+               << " bytes, " << uncompressed_len << " uncompressed";
+    return false;
+  }
+  rec.json_.resize(uncompressed_len);
+  uLongf dest_len = uncompressed_len;
+  int ret = uncompress(reinterpret_cast<Bytef *>(&rec.json_[0]), &dest_len,
+                       reinterpret_cast<const Bytef *>(compressed.data()),
+                       compressed.size());
+  if (ret != Z_OK || dest_len != uncompressed_len) {
+    LOG(ERROR) << "fails to decompress SDI " << rec.type_ << ":" << rec.id_
+               << ", zlib error " << ret;
+    return false;
+  }
+  return true;
+}
+
+bool SdiReader::read_records(std::vector<SdiRecord> &records, uint64_t *lsn) {
+  ColumnBatch batch;
+  uint64_t newest = 0;
+  if (!read_compressed(batch, newest))
+    return false;
+  if (lsn)
+    *lsn = newest;
+  records.resize(batch.n_rows_);
+  for (size_t i = 0; i < batch.n_rows_; ++i) {
+    if (!decompress(batch, i, records[i]))
+      return false;
+  }
+  return true;
+}
+
+std::shared_ptr<const SdiSpace> SdiReader::space() {
+  ColumnBatch batch;
+  uint64_t lsn = 0;
+  if (!read_compressed(batch, lsn))
+    return nullptr;
+  uint32_t space_id = reader_->fetch_page(0).as<PageView>().space_id();
+  if (cache_) {
+    if (auto cached = cache_->get(space_id, lsn))
+      return cached;
+  }
+
+  auto space = std::make_shared<SdiSpace>();
+  space->space_id_ = space_id;
+  space->lsn_ = lsn;
+  SdiRecord rec;
+  JsonValue doc;
+  std::string err;
+  for (size_t i = 0; i < batch.n_rows_; ++i) {
+    if (!decompress(batch, i, rec))
+      return nullptr;
+    if (!parse_json(rec.json_, doc, &err)) {
+      LOG(ERROR) << "SDI " << rec.type_ << ":" << rec.id_
+                 << " isn't valid JSON, " << err;
+      return nullptr;
+    }
+    const JsonValue *dd_object = doc.get("dd_object");
+    if (!dd_object) {
+      LOG(ERROR) << "SDI " << rec.type_ << ":" << rec.id_
+                 << " has no dd_object";
+      return nullptr;
+    }
+    if (rec.type_ == SDI_TYPE_TABLESPACE) {
+      space->tablespace_name_ = dd_object->get_str("name");
+    } else if (rec.type_ == SDI_TYPE_TABLE) {
+      SdiTable table;
+      if (!SdiTable::from_json(*dd_object, table)) {
+        LOG(ERROR) << "SDI " << rec.type_ << ":" << rec.id_
+                   << " isn't a table definition";
+        return nullptr;
+      }
+      space->tables_.push_back(std::move(table));
+    }
+  }
+  if (cache_)
+    cache_->put(space);
+  return space;
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include "column_batch.h"
+#include "file_space_reader.h"
+#include "json.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace innodb {
+
+/// @brief a column of the serialized dictionary of a table
+struct SdiColumn {
+  /// dd::enum_column_types
+  enum Type : uint32_t {
+    DECIMAL = 1,
+    TINY,
+    SHORT,
+    LONG,
+    FLOAT,
+    DOUBLE,
+    TYPE_NULL,
+    TIMESTAMP,
+    LONGLONG,
+    INT24,
+    DATE,
+    TIME,
+    DATETIME,
+    YEAR,
+    NEWDATE,
+    VARCHAR,
+    BIT,
+    TIMESTAMP2,
+    DATETIME2,
+    TIME2,
+    NEWDECIMAL,
+    ENUM,
+    SET,
+    TINY_BLOB,
+    MEDIUM_BLOB,
+    LONG_BLOB,
+    BLOB,
+    VAR_STRING,
+    STRING,
+    GEOMETRY,
+    JSON,
+  };
+  /// dd::Column::enum_hidden_type
+  static constexpr uint32_t HT_VISIBLE = 1;
+  static constexpr uint32_t HT_HIDDEN_SE = 2;
+
+  std::string name_;
+  uint32_t type_ = 0;
+  std::string column_type_utf8_; // e.g. "varchar(100)"
+  bool nullable_ = false;
+  bool unsigned_ = false;
+  bool virtual_ = false;
+  uint32_t hidden_ = HT_VISIBLE;
+  uint32_t ordinal_position_ = 0;
+  uint32_t char_length_ = 0; // max bytes of a string column
+  uint32_t numeric_precision_ = 0;
+  uint32_t numeric_scale_ = 0;
+  uint32_t datetime_precision_ = 0;
+  uint32_t collation_id_ = 0;
+  uint32_t n_elements_ = 0; // of an ENUM or a SET
+
+  /// @brief how the column is stored in the clustered index records
+  /// @return false if the type is unknown
+  bool column_def(ColumnDef &def) const;
+};
+
+/// @brief a column of an index
+struct SdiIndexElement {
+  uint32_t column_opx_ = 0; // the position in SdiTable::columns_
+  uint32_t length_ = 0;     // the prefix length in bytes
+  bool hidden_ = false;     // added by innodb, not a key part
+};
+
+struct SdiIndex {
+  /// dd::Index::enum_index_type
+  static constexpr uint32_t IT_PRIMARY = 1;
+
+  std::string name_;
+  uint32_t type_ = 0;
+  uint64_t id_ = 0;                    // se_private_data id
+  uint32_t root_page_no_ = UINT32_MAX; // se_private_data root
+  std::vector<SdiIndexElement> elements_;
+};
+
+/// @brief the serialized dictionary of a table
+struct SdiTable {
+  std::string schema_name_;
+  std::string name_;
+  uint64_t table_id_ = 0; // se_private_data id
+  std::vector<SdiColumn> columns_;
+  std::vector<SdiIndex> indexes_;
+
+  /// @brief the clustered index, nullptr if none
+  const SdiIndex *primary() const;
+  /// @brief the clustered index record format for BatchDecoder, the
+  /// columns in the order of the index elements
+  /// @return false if there is no clustered index or a column type is
+  /// unknown
+  bool table_schema(TableSchema &schema) const;
+
+  /// @brief decode the dd_object of a Table SDI
+  static bool from_json(const JsonValue &dd_object, SdiTable &table);
+};
+
+/// @brief the serialized dictionary of one tablespace
+struct SdiSpace {
+  uint32_t space_id_ = 0;
+  uint64_t lsn_ = 0; // the newest page LSN of the SDI index
+  std::string tablespace_name_;
+  std::vector<SdiTable> tables_;
+
+  const SdiTable *find_table(const std::string &name) const;
+};
+
+/// @brief a record of the SDI index, the JSON decompressed
+struct SdiRecord {
+  uint32_t type_ = 0;
+  uint64_t id_ = 0;
+  std::string json_;
+};
+
+/// @brief the parsed dictionaries of the tablespaces, keyed by space id and
+/// the newest LSN of their SDI pages, a changed SDI index gets a new LSN
+/// and replaces the entry. Thread safe.
+class SdiCache {
+public:
+  static SdiCache &global();
+
+  /// @return nullptr if the space isn't cached with this LSN
+  std::shared_ptr<const SdiSpace> get(uint32_t space_id, uint64_t lsn);
+  void put(std::shared_ptr<const SdiSpace> space);
+  void clear();
+
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+private:
+  std::mutex mutex_;
+  std::map<uint32_t, std::shared_ptr<const SdiSpace>> spaces_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+/// @brief reads the SDI index of a MySQL 8 tablespace. Page 0 has the SDI
+/// version and the root page number of the index right after the xdes
+/// array and the encryption info. The records are (type, id, DB_TRX_ID,
+/// DB_ROLL_PTR, uncompressed_len, compressed_len, data) with the data the
+/// zlib compressed JSON, stored off page in SDI BLOB pages when it's long,
+/// read with a LobStream.
+class SdiReader {
+public:
+  static constexpr uint32_t SDI_VERSION = 1;
+  static constexpr uint32_t SDI_TYPE_TABLE = 1;
+  static constexpr uint32_t SDI_TYPE_TABLESPACE = 2;
+  /// Encryption::INFO_MAX_SIZE, the encryption info after the xdes array
+  static constexpr uint32_t ENCRYPTION_INFO_MAX_SIZE = 115;
+
+  /// @param cache nullptr not to cache
+  explicit SdiReader(FileSpaceReader *reader,
+                     SdiCache *cache = &SdiCache::global());
+
+  /// @brief the offset of the SDI header on page 0
+  static uint32_t sdi_offset(ulint page_size) {
+    return XDES_E::XDES_ARR_OFFSET +
+           XDES_E::entry_size(page_size) *
+               XDES_E::entries_per_page(page_size) +
+           ENCRYPTION_INFO_MAX_SIZE;
+  }
+  /// @return the root page of the SDI index, UINT32_MAX if the space has
+  /// none
+  static uint32_t sdi_root_page(const byte *page0, ulint page_size);
+
+  /// @brief the record format of the SDI index
+  static const TableSchema &sdi_schema();
+
+  /// @brief read and decompress all the SDI records
+  /// @param lsn set to the newest LSN of the SDI pages if not nullptr
+  /// @return false if the space has no SDI or it is corrupt
+  bool read_records(std::vector<SdiRecord> &records, uint64_t *lsn = nullptr);
+
+  /// @brief the parsed dictionary, from the cache if the SDI pages didn't
+  /// change since it was parsed
+  /// @return nullptr if the space has no SDI or it is corrupt
+  std::shared_ptr<const SdiSpace> space();
+
+private:
+  /// @brief the SDI records still compressed and the newest page LSN
+  bool read_compressed(ColumnBatch &batch, uint64_t &lsn);
+  bool decompress(const ColumnBatch &batch, size_t row, SdiRecord &rec);
+
+private:
+  FileSpaceReader *reader_;
+  SdiCache *cache_;
+};
+
+} // namespace innodb
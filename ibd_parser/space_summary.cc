@@ -0,0 +1,134 @@
+#include "space_summary.h"
+#include "checksum.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <memory>
+#include <unistd.h>
+
+using namespace innodb;
+
+namespace {
+
+/// @brief read until the buffer is full or the end of the file
+/// @return the bytes read, -1 for error
+long read_full(int fd, uint64_t offset, byte *buf, size_t size) {
+  size_t bytes_read = 0;
+  while (bytes_read < size) {
+    auto n = ::pread(fd, buf + bytes_read, size - bytes_read,
+                     offset + bytes_read);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (n == 0)
+      break;
+    bytes_read += n;
+  }
+  return bytes_read;
+}
+
+} // namespace
+
+void SpaceSummary::add_page(const byte *page) {
+  ++n_pages_;
+  // the checksum and the lsn of a page never written are 0, only those
+  // need the whole page compared
+  if (FILHeader::check_sum(page) == 0 &&
+      FILHeader::last_mod_page_lsn(page) == 0 &&
+      PageChecksum::is_empty(page, page_size_)) {
+    ++zero_pages_;
+    return;
+  }
+  const uint16_t type = FILHeader::page_type(page);
+  ++pages_by_type_[type];
+  if (type != FIL_PAGE_TYPE_ALOCATED) {
+    const uint64_t lsn = FILHeader::last_mod_page_lsn(page);
+    min_lsn_ = std::min(min_lsn_, lsn);
+    max_lsn_ = std::max(max_lsn_, lsn);
+  }
+  if (!fil_page_is_index(type) && type != FIL_PAGE_RTREE)
+    return;
+  IndexPageCount &index = indexes_[IndexHeader::index_id(page)];
+  ++index.n_pages_;
+  const uint16_t level = IndexHeader::page_level(page);
+  if (level > MAX_LEVEL) {
+    ++bad_level_pages_;
+    return;
+  }
+  if (index.pages_per_level_.size() <= level)
+    index.pages_per_level_.resize(level + 1);
+  ++index.pages_per_level_[level];
+}
+
+SpaceSummary SpaceSummary::of_file(const std::string &file,
+                                   size_t chunk_bytes) {
+  SpaceSummary s;
+  s.file_ = file;
+  int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(ERROR) << "file " << file << " isn't opened: " << strerror(errno);
+    return s;
+  }
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  // whole pages of any page size, the page size is known after the first
+  // read
+  chunk_bytes = std::max<size_t>(chunk_bytes / PAGE_SIZE_MAX, 1) *
+                PAGE_SIZE_MAX;
+  std::unique_ptr<byte[]> buf(new byte[chunk_bytes]);
+  uint64_t offset = 0;
+  for (;;) {
+    long n = read_full(fd, offset, buf.get(), chunk_bytes);
+    if (n < 0) {
+      LOG(ERROR) << "file read err " << file << " " << strerror(errno);
+      break;
+    }
+    if (offset == 0) {
+      if (n < PAGE_SIZE_MIN) {
+        LOG(ERROR) << "file " << file << " is smaller than a page";
+        break;
+      }
+      uint32_t flags = FSPHeader::space_flags(buf.get());
+      s.page_size_ = FSPHeader::page_size_from_flags(flags);
+      if (s.page_size_ == 0) {
+        LOG(ERROR) << "invalid page size in the space flags: " << flags
+                   << " of file " << file;
+        break;
+      }
+      s.space_id_ = FILHeader::space_id(buf.get());
+      s.valid_ = true;
+    }
+    const size_t n_full = n / s.page_size_;
+    for (size_t i = 0; i < n_full; ++i)
+      s.add_page(buf.get() + i * s.page_size_);
+    offset += n;
+    if ((size_t)n < chunk_bytes) {
+      s.tail_bytes_ = n - n_full * s.page_size_;
+      break;
+    }
+  }
+  ::close(fd);
+  return s;
+}
+
+void SpaceSummary::dump(std::ostringstream &oss) const {
+  oss << "SpaceSummary of " << file_ << " space " << space_id_
+      << ": page size: " << page_size_ << ", pages: " << n_pages_
+      << ", zero pages: " << zero_pages_ << ", tail bytes: " << tail_bytes_
+      << std::endl;
+  if (max_lsn_ != 0)
+    oss << "lsn: " << min_lsn_ << " - " << max_lsn_ << std::endl;
+  for (const auto &it : pages_by_type_)
+    oss << get_page_type_str(it.first) << ": " << it.second << std::endl;
+  for (const auto &it : indexes_) {
+    oss << "index " << it.first << ": pages: " << it.second.n_pages_
+        << ", levels:";
+    for (size_t l = 0; l < it.second.pages_per_level_.size(); ++l)
+      oss << " " << l << ": " << it.second.pages_per_level_[l];
+    oss << std::endl;
+  }
+  if (bad_level_pages_)
+    oss << "pages with a bad level: " << bad_level_pages_ << std::endl;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "headers.h"
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace innodb {
+
+/// @brief the pages of one index in a SpaceSummary
+struct IndexPageCount {
+  uint64_t n_pages_ = 0;
+  /// pages_per_level_[0] is the leaves
+  std::vector<uint64_t> pages_per_level_;
+};
+
+/// @brief a first look at a tablespace: what its pages are, which indexes
+/// they belong to and how old they are. The file is read sequentially in
+/// large chunks, with no page cache and no Page objects, every page is
+/// summed up from its header bytes, so it runs at the read bandwidth of
+/// the disk and the memory is one chunk whatever the size of the file.
+struct SpaceSummary {
+  /// large enough to keep the disk busy, small enough to stay in the L2/L3
+  static constexpr size_t DEFAULT_CHUNK_BYTES = 4UL * 1024 * 1024;
+  /// the levels above are counted as bad, a tree is never that high
+  static constexpr uint16_t MAX_LEVEL = 100;
+
+  std::string file_;
+  uint32_t space_id_ = 0;
+  uint32_t page_size_ = PAGE_SIZE;
+  uint64_t n_pages_ = 0;
+  std::map<uint16_t, uint64_t> pages_by_type_;
+  /// the index pages of the user indexes, the SDI and the R-trees
+  std::map<uint64_t, IndexPageCount> indexes_;
+  uint64_t bad_level_pages_ = 0;
+  /// of the pages written, the all zero and the allocated ones are skipped
+  uint64_t min_lsn_ = UINT64_MAX;
+  uint64_t max_lsn_ = 0;
+  uint64_t zero_pages_ = 0;
+  /// the bytes after the last whole page
+  uint64_t tail_bytes_ = 0;
+  bool valid_ = false;
+
+  /// @brief sum up one page
+  void add_page(const byte *page);
+
+  /// @brief the summary of one file, invalid if page 0 can't be read or
+  /// the page size in its space flags is invalid
+  /// @param chunk_bytes the size of the reads, rounded down to whole pages
+  static SpaceSummary of_file(const std::string &file,
+                              size_t chunk_bytes = DEFAULT_CHUNK_BYTES);
+
+  void dump(std::ostringstream &oss) const;
+};
+
+} // namespace innodb
@@ -0,0 +1,415 @@
+#include "catalog.h"
+#include "checksum.h"
+#include "parallel_scanner.h"
+#include "sdi.h"
+#include <algorithm>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <glog/logging.h>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace innodb {
+
+namespace {
+
+constexpr char CATALOG_MAGIC[8] = {'V', 'I', 'B', 'D', 'C', 'A', 'T', '\0'};
+/// the page cache of a reader opened to read the SDI of one file
+constexpr size_t SDI_READER_CACHE_BYTES = 1 << 20;
+
+bool has_ibd_suffix(const std::string &name) {
+  return name.size() > 4 && name.compare(name.size() - 4, 4, ".ibd") == 0;
+}
+
+std::string file_stem(const std::string &file) {
+  size_t slash = file.rfind('/');
+  std::string name = slash == std::string::npos ? file : file.substr(slash + 1);
+  return has_ibd_suffix(name) ? name.substr(0, name.size() - 4) : name;
+}
+
+std::string file_dir(const std::string &file) {
+  size_t slash = file.rfind('/');
+  return slash == std::string::npos ? "" : file.substr(0, slash);
+}
+
+/// @brief list the entries of a directory, skipping the hidden ones and the
+/// ones of innodb like #innodb_redo
+bool list_dir(const std::string &path, std::vector<std::string> &dirs,
+              std::vector<std::string> &ibd_files) {
+  DIR *dir = opendir(path.c_str());
+  if (!dir)
+    return false;
+  while (struct dirent *entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name.empty() || name[0] == '.' || name[0] == '#')
+      continue;
+    bool is_dir = entry->d_type == DT_DIR;
+    bool is_file = entry->d_type == DT_REG;
+    if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+      struct stat st;
+      if (stat((path + "/" + name).c_str(), &st) != 0)
+        continue;
+      is_dir = S_ISDIR(st.st_mode);
+      is_file = S_ISREG(st.st_mode);
+    }
+    if (is_dir)
+      dirs.push_back(name);
+    else if (is_file && has_ibd_suffix(name))
+      ibd_files.push_back(name);
+  }
+  closedir(dir);
+  std::sort(dirs.begin(), dirs.end());
+  std::sort(ibd_files.begin(), ibd_files.end());
+  return true;
+}
+
+/// @brief read the tables of one tablespace file from its SDI
+void catalog_file(const std::string &data_dir, const std::string &file,
+                  std::vector<CatalogTable> &tables) {
+  FileSpaceReader reader((data_dir + "/" + file).c_str(), ReadMode::PREAD,
+                         SDI_READER_CACHE_BYTES);
+  PageGuard page0 = reader.fetch_page(0);
+  if (!page0) {
+    LOG(ERROR) << "catalog skips " << file << ", page 0 is unreadable";
+    return;
+  }
+  uint32_t space_id = page0.as<PageView>().space_id();
+  page0 = PageGuard();
+  SdiReader sdi(&reader, nullptr);
+  auto space = sdi.space();
+  if (!space || space->tables_.empty()) {
+    // no dictionary, e.g. a file of 5.7, known by its file name only
+    CatalogTable table;
+    table.space_id_ = space_id;
+    table.file_ = file;
+    table.schema_name_ = file_dir(file);
+    table.name_ = file_stem(file);
+    tables.push_back(std::move(table));
+    return;
+  }
+  for (const auto &t : space->tables_) {
+    CatalogTable table;
+    table.space_id_ = space_id;
+    table.file_ = file;
+    table.schema_name_ = t.schema_name_;
+    table.name_ = t.name_;
+    table.table_id_ = t.table_id_;
+    for (const auto &i : t.indexes_) {
+      CatalogIndex index;
+      index.index_id_ = i.id_;
+      index.root_page_no_ = i.root_page_no_;
+      index.name_ = i.name_;
+      table.indexes_.push_back(std::move(index));
+    }
+    tables.push_back(std::move(table));
+  }
+}
+
+/// @brief the persisted catalog, big endian integers and length prefixed
+/// strings, ends with the crc32c of all the bytes before
+class CatalogWriter {
+public:
+  void u32(uint32_t v) {
+    for (int i = 3; i >= 0; --i)
+      buf_ += static_cast<char>(v >> (i * 8));
+  }
+  void u64(uint64_t v) {
+    u32(v >> 32);
+    u32(static_cast<uint32_t>(v));
+  }
+  void str(const std::string &s) {
+    u32(s.size());
+    buf_ += s;
+  }
+  void raw(const char *p, size_t n) { buf_.append(p, n); }
+  std::string &buf() { return buf_; }
+
+private:
+  std::string buf_;
+};
+
+class CatalogParser {
+public:
+  CatalogParser(const std::string &buf, size_t end) : buf_(buf), end_(end) {}
+  uint32_t u32() {
+    if (!check(4))
+      return 0;
+    uint32_t v = mach_read_from_4(
+        reinterpret_cast<const byte *>(buf_.data()) + pos_);
+    pos_ += 4;
+    return v;
+  }
+  uint64_t u64() {
+    uint64_t high = u32();
+    return high << 32 | u32();
+  }
+  std::string str() {
+    uint32_t len = u32();
+    if (!check(len))
+      return "";
+    std::string s = buf_.substr(pos_, len);
+    pos_ += len;
+    return s;
+  }
+  /// @brief a count of entries, each taking at least min_bytes
+  uint32_t count(uint32_t min_bytes) {
+    uint32_t n = u32();
+    if (ok_ && (uint64_t)n * min_bytes > end_ - pos_)
+      ok_ = false;
+    return ok_ ? n : 0;
+  }
+  bool ok() const { return ok_; }
+  bool at_end() const { return pos_ == end_; }
+
+private:
+  bool check(size_t n) {
+    if (!ok_ || n > end_ - pos_)
+      ok_ = false;
+    return ok_;
+  }
+  const std::string &buf_;
+  size_t end_;
+  size_t pos_ = sizeof(CATALOG_MAGIC);
+  bool ok_ = true;
+};
+
+} // namespace
+
+bool Catalog::dir_mtime(const std::string &path, int64_t &mtime_ns) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return false;
+  mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+bool Catalog::list_top(const std::string &data_dir,
+                       std::vector<std::string> &dirs,
+                       std::vector<std::string> &files) {
+  return list_dir(data_dir, dirs, files);
+}
+
+bool Catalog::build(const std::string &data_dir, uint32_t n_threads) {
+  data_dir_ = data_dir;
+  while (data_dir_.size() > 1 && data_dir_.back() == '/')
+    data_dir_.pop_back();
+  tables_.clear();
+  dirs_.clear();
+  top_files_.clear();
+  loaded_ = false;
+
+  std::vector<std::string> dirs;
+  if (!list_top(data_dir_, dirs, top_files_)) {
+    LOG(ERROR) << "fails to list the data directory " << data_dir_;
+    return false;
+  }
+  std::vector<std::string> files = top_files_;
+  for (const auto &d : dirs) {
+    DirStamp stamp;
+    stamp.dir_ = d;
+    std::string path = data_dir_ + "/" + d;
+    if (!dir_mtime(path, stamp.mtime_ns_))
+      continue;
+    std::vector<std::string> sub_dirs;
+    std::vector<std::string> sub_files;
+    if (!list_dir(path, sub_dirs, sub_files))
+      continue;
+    for (const auto &f : sub_files)
+      files.push_back(d + "/" + f);
+    dirs_.push_back(std::move(stamp));
+  }
+
+  std::vector<std::vector<CatalogTable>> results(files.size());
+  parallel_for(files.size(), n_threads, [&](size_t i) {
+    catalog_file(data_dir_, files[i], results[i]);
+  });
+
+  for (auto &r : results) {
+    for (auto &t : r)
+      tables_.push_back(std::move(t));
+  }
+  index_tables();
+  LOG(INFO) << "catalog of " << data_dir_ << ": " << files.size()
+            << " files, " << tables_.size() << " tables";
+  return true;
+}
+
+void Catalog::index_tables() {
+  by_name_.clear();
+  by_space_.clear();
+  by_index_.clear();
+  by_name_.reserve(tables_.size() * 2);
+  by_space_.reserve(tables_.size());
+  for (uint32_t i = 0; i < tables_.size(); ++i) {
+    const auto &t = tables_[i];
+    // the first wins, e.g. the first partition of a partitioned table
+    by_name_.emplace(t.schema_name_ + "/" + t.name_, i);
+    by_name_.emplace(file_dir(t.file_) + "/" + file_stem(t.file_), i);
+    by_space_.emplace(t.space_id_, i);
+    for (uint32_t j = 0; j < t.indexes_.size(); ++j) {
+      if (t.indexes_[j].index_id_ != 0)
+        by_index_.emplace(t.indexes_[j].index_id_, std::make_pair(i, j));
+    }
+  }
+}
+
+bool Catalog::is_fresh(const std::string &data_dir) const {
+  std::vector<std::string> dirs;
+  std::vector<std::string> files;
+  if (!list_top(data_dir, dirs, files) || files != top_files_ ||
+      dirs.size() != dirs_.size())
+    return false;
+  for (size_t i = 0; i < dirs.size(); ++i) {
+    int64_t mtime_ns = 0;
+    if (dirs[i] != dirs_[i].dir_ ||
+        !dir_mtime(data_dir + "/" + dirs[i], mtime_ns) ||
+        mtime_ns != dirs_[i].mtime_ns_)
+      return false;
+  }
+  return true;
+}
+
+bool Catalog::save(const std::string &path) const {
+  CatalogWriter w;
+  w.raw(CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+  w.u32(CATALOG_VERSION);
+  w.u32(top_files_.size());
+  for (const auto &f : top_files_)
+    w.str(f);
+  w.u32(dirs_.size());
+  for (const auto &d : dirs_) {
+    w.str(d.dir_);
+    w.u64(d.mtime_ns_);
+  }
+  w.u32(tables_.size());
+  for (const auto &t : tables_) {
+    w.u32(t.space_id_);
+    w.str(t.file_);
+    w.str(t.schema_name_);
+    w.str(t.name_);
+    w.u64(t.table_id_);
+    w.u32(t.indexes_.size());
+    for (const auto &i : t.indexes_) {
+      w.u64(i.index_id_);
+      w.u32(i.root_page_no_);
+      w.str(i.name_);
+    }
+  }
+  std::string &buf = w.buf();
+  w.u32(crc32c(reinterpret_cast<const byte *>(buf.data()), buf.size()));
+
+  // replace the old catalog only once the new one is complete
+  std::string tmp = path + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(buf.data(), buf.size());
+    if (!out) {
+      LOG(ERROR) << "fails to write the catalog " << tmp;
+      return false;
+    }
+  }
+  if (rename(tmp.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << "fails to rename the catalog to " << path;
+    remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool Catalog::load(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+  std::ostringstream oss;
+  oss << in.rdbuf();
+  const std::string buf = oss.str();
+  if (buf.size() < sizeof(CATALOG_MAGIC) + 8 ||
+      buf.compare(0, sizeof(CATALOG_MAGIC),
+                  std::string(CATALOG_MAGIC, sizeof(CATALOG_MAGIC))) != 0) {
+    LOG(ERROR) << path << " isn't a catalog";
+    return false;
+  }
+  const size_t end = buf.size() - 4;
+  const byte *p = reinterpret_cast<const byte *>(buf.data());
+  if (crc32c(p, end) != mach_read_from_4(p + end)) {
+    LOG(ERROR) << "the catalog " << path << " is corrupt";
+    return false;
+  }
+
+  CatalogParser r(buf, end);
+  if (r.u32() != CATALOG_VERSION) {
+    LOG(ERROR) << "the catalog " << path << " is of another version";
+    return false;
+  }
+  std::vector<std::string> top_files(r.count(4));
+  for (auto &f : top_files)
+    f = r.str();
+  std::vector<DirStamp> dirs(r.count(12));
+  for (auto &d : dirs) {
+    d.dir_ = r.str();
+    d.mtime_ns_ = r.u64();
+  }
+  std::vector<CatalogTable> tables(r.count(28));
+  for (auto &t : tables) {
+    t.space_id_ = r.u32();
+    t.file_ = r.str();
+    t.schema_name_ = r.str();
+    t.name_ = r.str();
+    t.table_id_ = r.u64();
+    t.indexes_.resize(r.count(16));
+    for (auto &i : t.indexes_) {
+      i.index_id_ = r.u64();
+      i.root_page_no_ = r.u32();
+      i.name_ = r.str();
+    }
+  }
+  if (!r.ok() || !r.at_end()) {
+    LOG(ERROR) << "the catalog " << path << " is truncated";
+    return false;
+  }
+  top_files_ = std::move(top_files);
+  dirs_ = std::move(dirs);
+  tables_ = std::move(tables);
+  index_tables();
+  return true;
+}
+
+bool Catalog::open(const std::string &data_dir,
+                   const std::string &catalog_file, uint32_t n_threads) {
+  data_dir_ = data_dir;
+  while (data_dir_.size() > 1 && data_dir_.back() == '/')
+    data_dir_.pop_back();
+  if (!catalog_file.empty() && load(catalog_file) && is_fresh(data_dir_)) {
+    loaded_ = true;
+    return true;
+  }
+  if (!build(data_dir_, n_threads))
+    return false;
+  if (!catalog_file.empty() && !save(catalog_file))
+    LOG(WARNING) << "the catalog of " << data_dir_
+                 << " is rebuilt on every open";
+  return true;
+}
+
+const CatalogTable *Catalog::find_table(const std::string &schema,
+                                        const std::string &table) const {
+  auto it = by_name_.find(schema + "/" + table);
+  return it == by_name_.end() ? nullptr : &tables_[it->second];
+}
+
+const CatalogTable *Catalog::find_space(uint32_t space_id) const {
+  auto it = by_space_.find(space_id);
+  return it == by_space_.end() ? nullptr : &tables_[it->second];
+}
+
+std::pair<const CatalogTable *, const CatalogIndex *>
+Catalog::find_index(uint64_t index_id) const {
+  auto it = by_index_.find(index_id);
+  if (it == by_index_.end())
+    return {nullptr, nullptr};
+  const CatalogTable &t = tables_[it->second.first];
+  return {&t, &t.indexes_[it->second.second]};
+}
+
+} // namespace innodb
@@ -0,0 +1,109 @@
+#pragma once
+#include "defines.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace innodb {
+
+struct CatalogIndex {
+  uint64_t index_id_ = 0;
+  uint32_t root_page_no_ = UINT32_MAX;
+  std::string name_;
+};
+
+/// @brief a table of a tablespace file, a file without SDI gets one entry
+/// named after the file and no indexes
+struct CatalogTable {
+  uint32_t space_id_ = 0;
+  std::string file_; // relative to the data directory
+  std::string schema_name_;
+  std::string name_;
+  uint64_t table_id_ = 0;
+  std::vector<CatalogIndex> indexes_;
+};
+
+/// @brief maps the tables, the space ids and the index ids of a data
+/// directory to their files and root pages. It is built from the SDI of
+/// every .ibd file and can be persisted to a cache file chosen by the
+/// caller, nothing is written into the data directory unless asked to. An
+/// open with a cache file loads it unless the files were added, dropped or
+/// renamed since: the top directory is listed and
+/// every database directory is checked by its mtime, one stat per database
+/// instead of one per table. An SDI changed in place, e.g. by an instant
+/// ALTER, keeps the names, the ids and the root pages. The lookups are
+/// hashed.
+class Catalog {
+public:
+  static constexpr uint32_t CATALOG_VERSION = 1;
+
+  /// @brief build the catalog of the data directory, or load it from the
+  /// cache file and rebuild and save it there if it is missing or stale
+  /// @param catalog_file empty to build it in memory only, a cache file
+  /// must not be inside a database directory
+  /// @return false if the catalog could be neither loaded nor built
+  bool open(const std::string &data_dir, const std::string &catalog_file = "",
+            uint32_t n_threads = 0);
+
+  /// @brief scan the .ibd files of the data directory and its database
+  /// directories and read their SDI
+  /// @param n_threads 0 for the number of cpus
+  /// @return false if the data directory can't be read
+  bool build(const std::string &data_dir, uint32_t n_threads = 0);
+
+  bool save(const std::string &path) const;
+  /// @return false if the file is missing, corrupt or of another version
+  bool load(const std::string &path);
+
+  /// @brief false if a directory holding the files changed since the
+  /// catalog was built
+  bool is_fresh(const std::string &data_dir) const;
+
+  /// @brief find a table by the schema and the table name of the SDI, or by
+  /// the database directory and the file name without .ibd
+  /// @return nullptr if not found
+  const CatalogTable *find_table(const std::string &schema,
+                                 const std::string &table) const;
+  /// @brief the first table of the tablespace
+  const CatalogTable *find_space(uint32_t space_id) const;
+  /// @return the table and the index, nullptrs if not found
+  std::pair<const CatalogTable *, const CatalogIndex *>
+  find_index(uint64_t index_id) const;
+
+  const std::vector<CatalogTable> &tables() const { return tables_; }
+  /// @brief the absolute path of the file of the table
+  std::string path_of(const CatalogTable &table) const {
+    return data_dir_ + "/" + table.file_;
+  }
+  /// @brief true if the last open loaded the persisted catalog
+  bool loaded() const { return loaded_; }
+
+private:
+  /// @brief a database directory and its modification time
+  struct DirStamp {
+    std::string dir_;
+    int64_t mtime_ns_ = 0;
+  };
+
+  void index_tables();
+  /// @brief list the database directories and the .ibd files of the data
+  /// directory, sorted
+  static bool list_top(const std::string &data_dir,
+                       std::vector<std::string> &dirs,
+                       std::vector<std::string> &files);
+  static bool dir_mtime(const std::string &path, int64_t &mtime_ns);
+
+private:
+  std::string data_dir_;
+  std::vector<std::string> top_files_; // the .ibd files of the data directory
+  std::vector<DirStamp> dirs_;
+  std::vector<CatalogTable> tables_;
+  std::unordered_map<std::string, uint32_t> by_name_;
+  std::unordered_map<uint32_t, uint32_t> by_space_;
+  std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> by_index_;
+  bool loaded_ = false;
+};
+
+} // namespace innodb
@@ -4,12 +4,13 @@
 namespace innodb {
 void Ibdata1Reader::init() {
   // Read and process the FSP header page
-  const auto* fsp_header_page = fsp_reader_.get_fsp_header_page();
+  PageGuard fsp_header_page = fsp_reader_.fetch_page(
+      FileSpaceReader::FSP_HEADER_PAGE_NUM);
   if (!fsp_header_page) {
     LOG(ERROR) << "Failed to get FSP header page from ibdata1 file.";
     return;
   }
-  const auto *dict_hdr_page = fsp_reader_.get_page(FSP_DICT_HDR_PAGE_NO);
+  PageGuard dict_hdr_page = fsp_reader_.fetch_page(FSP_DICT_HDR_PAGE_NO);
   if (!dict_hdr_page) {
     LOG(ERROR) << "Failed to get dictionary header page from ibdata1 file.";
     return;
@@ -1,12 +1,13 @@
 #include "table_reader.h"
 #include "glog/logging.h"
+#include <unistd.h>
 
 namespace innodb {
 TableReader::TableReader(const char *file, TableReader *ibdata1_reader)
     : file_name_(file), fsp_reader_(file), ibdata1_reader_(ibdata1_reader) {}
 
 void TableReader::dump_page(unsigned int index) {
-  auto page = fsp_reader_.get_page(index);
+  PageGuard page = fsp_reader_.fetch_page(index);
   if (page) {
     std::ostringstream oss;
     oss << "Dumping page " << index << " from table: " << file_name_ << "\n";
@@ -22,7 +23,21 @@ TableReader *MySQLDataReader::get_table_reader(const char *db_name,
                                                const char *table_name) {
   if (std::string(table_name) == "ibdata1")
     return ibdata1_reader_;
-  std::string full_path = data_dir_ + "/" + db_name + "/" + table_name + ".ibd";
+  std::string full_path =
+      data_dir_ + "/" + db_name + "/" + table_name + ".ibd";
+  // without a cache file the catalog is built by reading every file of the
+  // data directory, not worth it for a table found by its path
+  if (!catalog_file_.empty() || ::access(full_path.c_str(), R_OK) != 0) {
+    const CatalogTable *table = catalog().find_table(db_name, table_name);
+    if (table) {
+      full_path = catalog_.path_of(*table);
+    } else if (::access(full_path.c_str(), R_OK) != 0) {
+      // the catalog is missing, failed to build or is stale
+      LOG(ERROR) << "table " << db_name << "." << table_name
+                 << " not found in " << data_dir_;
+      return nullptr;
+    }
+  }
   LOG(INFO) << "Reading table from: " << full_path;
   auto it = table_readers_.find(full_path);
   if (it != table_readers_.end()) {
@@ -42,4 +57,13 @@ TableReader *MySQLDataReader::get_table_reader(const char *db_name,
   }
   return 0;
 }
+
+const Catalog &MySQLDataReader::catalog() {
+  if (!catalog_opened_) {
+    catalog_opened_ = true;
+    if (!catalog_.open(data_dir_, catalog_file_))
+      LOG(ERROR) << "fails to open the catalog of " << data_dir_;
+  }
+  return catalog_;
+}
 } // namespace innodb
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "catalog.h"
 #include "file_space_reader.h"
 #include <string>
 #include <unordered_map>
@@ -21,10 +22,15 @@ class MySQLDataReader {
 
   std::string ibdata1_file_;
   TableReader *ibdata1_reader_ = nullptr;
+  Catalog catalog_;
+  std::string catalog_file_;
+  bool catalog_opened_ = false;
 
 public:
-  MySQLDataReader(const char *data_dir)
-      : data_dir_(data_dir), table_readers_() {
+  /// @param catalog_file the cache file of the catalog, empty to build it in
+  /// memory on every open, see Catalog::open
+  MySQLDataReader(const char *data_dir, const char *catalog_file = "")
+      : data_dir_(data_dir), table_readers_(), catalog_file_(catalog_file) {
     ibdata1_file_ = data_dir_ + "/ibdata1";
     ibdata1_reader_ = new TableReader(ibdata1_file_.c_str(), nullptr);
   }
@@ -35,7 +41,15 @@ public:
     delete ibdata1_reader_; // Clean up ibdata1_reader_
   }
 
+  /// @brief find the file of the table in the catalog of the data directory,
+  /// or <data_dir>/<db_name>/<table_name>.ibd if the catalog doesn't have it.
+  /// Without a cache file the path is probed first, the catalog is only
+  /// built for a table not found by its path
+  /// @return nullptr if the table is not found
   TableReader *get_table_reader(const char *db_name, const char *table_name);
+  /// @brief the catalog, opened on the first call
+  const Catalog &catalog();
+  bool catalog_opened() const { return catalog_opened_; }
 };
 
 } // namespace innodb
\ No newline at end of file
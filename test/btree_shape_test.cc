@@ -0,0 +1,133 @@
+#include "btree_shape.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+using test_util::TestRecord;
+
+namespace {
+
+/// id INT PRIMARY KEY, no other column
+IndexDef id_index() {
+  IndexDef index;
+  index.index_id_ = 90;
+  index.fields_ = {FieldDef::fixed("id", 4),
+                   FieldDef::fixed("DB_TRX_ID", IndexDef::DATA_TRX_ID_LEN),
+                   FieldDef::fixed("DB_ROLL_PTR", IndexDef::DATA_ROLL_PTR_LEN)};
+  index.n_uniq_ = 1;
+  return index;
+}
+
+std::vector<TestRecord> rows(int32_t first, int32_t n) {
+  std::vector<TestRecord> recs;
+  for (int32_t id = first; id < first + n; ++id) {
+    TestRecord r;
+    std::string key = encode_int(id, 4, false);
+    r.data_.assign(key.begin(), key.end());
+    r.data_.resize(4 + IndexDef::DATA_TRX_ID_LEN + IndexDef::DATA_ROLL_PTR_LEN);
+    recs.push_back(r);
+  }
+  return recs;
+}
+
+std::vector<TestRecord> node_ptrs(const std::vector<int32_t> &ids,
+                                  const std::vector<uint32_t> &children) {
+  std::vector<TestRecord> recs;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    TestRecord r;
+    std::string key = encode_int(ids[i], 4, false);
+    r.data_.assign(key.begin(), key.end());
+    r.data_.resize(8);
+    test_util::mach_write_to_4(r.data_.data() + 4, children[i]);
+    r.status_ = REC_STATUS_NODE_PTR;
+    r.info_bits_ = i == 0 ? RecordHeader::REC_INFO_MIN_REC_FLAG : 0;
+    recs.push_back(r);
+  }
+  return recs;
+}
+
+/// @brief a tree of 3 levels, the root 3 points to 4 with one leaf of 10
+/// rows and 5 with three leaves of 2 rows, the leaves are 6, 7, 8 and 10
+std::string build_tree() {
+  const uint64_t id = id_index().index_id_;
+  test_util::SpaceBuilder builder(12);
+  builder.init_fsp_header_page();
+  builder.init_index_page(3, id, 2, node_ptrs({0, 10}, {4, 5}));
+  builder.init_index_page(4, id, 1, node_ptrs({0}, {6}), UINT32_MAX, 5);
+  builder.init_index_page(5, id, 1, node_ptrs({10, 12, 14}, {7, 8, 10}), 4);
+  builder.init_index_page(6, id, 0, rows(0, 10), UINT32_MAX, 7);
+  builder.init_index_page(7, id, 0, rows(10, 2), 6, 8);
+  builder.init_index_page(8, id, 0, rows(12, 2), 7, 10);
+  builder.init_index_page(10, id, 0, rows(14, 2), 8);
+  return builder.write_file();
+}
+
+} // namespace
+
+TEST(btree_shape, exact) {
+  auto file = build_tree();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader reader(file.c_str());
+  BTreeShapeAnalyzer analyzer(&reader, 3, id_index());
+  auto shape = analyzer.exact();
+  ASSERT_TRUE(shape.valid_);
+  EXPECT_TRUE(shape.exact_);
+  EXPECT_EQ(90u, shape.index_id_);
+  EXPECT_EQ(3u, shape.height_);
+  EXPECT_EQ(7u, shape.pages_read_);
+  ASSERT_EQ(3u, shape.pages_per_level_.size());
+  EXPECT_EQ(4, shape.pages_per_level_[0].value_);
+  EXPECT_EQ(2, shape.pages_per_level_[1].value_);
+  EXPECT_EQ(1, shape.pages_per_level_[2].value_);
+  EXPECT_EQ(2, shape.avg_fanout_.value_);
+  EXPECT_EQ(4, shape.recs_per_leaf_.value_);
+  EXPECT_DOUBLE_EQ(2.0 / 3, shape.leaf_contiguity_.value_);
+  EXPECT_EQ(shape.leaf_contiguity_.value_, shape.leaf_contiguity_.low_);
+  const double heap = PAGE_SIZE - PAGE_NEW_SUPREMUM_END - 8;
+  EXPECT_DOUBLE_EQ(16 * (17 + REC_N_EXTRA_BYTES) / (4 * heap),
+                   shape.fill_factor_.value_);
+
+  // a node pointer to a page of another index
+  BTreeShapeAnalyzer other(&reader, 3, [] {
+    IndexDef index = id_index();
+    index.index_id_ = 91;
+    return index;
+  }());
+  EXPECT_FALSE(other.exact().valid_);
+  unlink(file.c_str());
+}
+
+TEST(btree_shape, sample) {
+  auto file = build_tree();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader reader(file.c_str());
+  BTreeShapeAnalyzer analyzer(&reader, 3, id_index());
+  auto shape = analyzer.sample(4000, 7);
+  ASSERT_TRUE(shape.valid_);
+  EXPECT_FALSE(shape.exact_);
+  EXPECT_EQ(4000u, shape.n_samples_);
+  EXPECT_EQ(3 * 4000u, shape.pages_read_);
+  ASSERT_EQ(3u, shape.pages_per_level_.size());
+  // a descent through 4 estimates 2 leaves, one through 5 estimates 6
+  const auto &leaves = shape.pages_per_level_[0];
+  EXPECT_NEAR(4, leaves.value_, 0.2);
+  EXPECT_LE(leaves.low_, 4);
+  EXPECT_GE(leaves.high_, 4);
+  EXPECT_LT(leaves.high_ - leaves.low_, 0.5);
+  // every descent passes one root and estimates 2 pages below it
+  EXPECT_EQ(1, shape.pages_per_level_[2].value_);
+  EXPECT_EQ(2, shape.pages_per_level_[1].value_);
+  EXPECT_EQ(2, shape.pages_per_level_[1].high_);
+  EXPECT_NEAR(4, shape.recs_per_leaf_.value_, 0.3);
+  EXPECT_LE(shape.recs_per_leaf_.low_, 4);
+  EXPECT_GE(shape.recs_per_leaf_.high_, 4);
+  EXPECT_NEAR(2, shape.avg_fanout_.value_, 0.2);
+  EXPECT_NEAR(2.0 / 3, shape.leaf_contiguity_.value_, 0.1);
+  EXPECT_LE(shape.leaf_contiguity_.high_, 1);
+  std::ostringstream oss;
+  shape.dump(oss);
+  EXPECT_NE(std::string::npos, oss.str().find("sampled"));
+
+  EXPECT_FALSE(analyzer.sample(0).valid_);
+  unlink(file.c_str());
+}
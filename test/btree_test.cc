@@ -0,0 +1,368 @@
+#include "btree.h"
+#include "leaf_scanner.h"
+#include "range_scanner.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+using test_util::TestRecord;
+
+namespace {
+
+/// id INT PRIMARY KEY, name VARCHAR(100) NULL, age INT NULL, utf8mb4
+IndexDef people_index() {
+  IndexDef index;
+  index.index_id_ = 77;
+  index.fields_ = {FieldDef::fixed("id", 4),
+                   FieldDef::fixed("DB_TRX_ID", IndexDef::DATA_TRX_ID_LEN),
+                   FieldDef::fixed("DB_ROLL_PTR", IndexDef::DATA_ROLL_PTR_LEN),
+                   FieldDef::variable("name", 400, true),
+                   FieldDef::fixed("age", 4, true)};
+  index.n_uniq_ = 1;
+  return index;
+}
+
+TestRecord people_row(int32_t id) {
+  TestRecord r;
+  std::string key = encode_int(id, 4, false);
+  r.data_.assign(key.begin(), key.end());
+  r.data_.resize(4 + IndexDef::DATA_TRX_ID_LEN + IndexDef::DATA_ROLL_PTR_LEN);
+  uint8_t nulls = 0;
+  if (id % 3 == 0) {
+    nulls |= 1; // name is NULL
+  } else {
+    std::string name = "person " + std::to_string(id);
+    r.data_.insert(r.data_.end(), name.begin(), name.end());
+    r.extra_.push_back((unsigned char)name.size());
+  }
+  if (id % 5 == 0) {
+    nulls |= 2; // age is NULL
+  } else {
+    std::string age = encode_int(id % 90, 4, false);
+    r.data_.insert(r.data_.end(), age.begin(), age.end());
+  }
+  r.extra_.push_back(nulls);
+  return r;
+}
+
+TestRecord node_ptr(int32_t id, uint32_t child, bool min_rec) {
+  TestRecord r;
+  std::string key = encode_int(id, 4, false);
+  r.data_.assign(key.begin(), key.end());
+  r.data_.resize(8);
+  test_util::mach_write_to_4(r.data_.data() + 4, child);
+  r.extra_.push_back(0); // the null bitmap of the index
+  r.status_ = REC_STATUS_NODE_PTR;
+  r.info_bits_ = min_rec ? RecordHeader::REC_INFO_MIN_REC_FLAG : 0;
+  return r;
+}
+
+/// the secondary index on people(age), the age then the id
+IndexDef age_index() {
+  IndexDef index;
+  index.index_id_ = 78;
+  index.fields_ = {FieldDef::fixed("age", 4, true), FieldDef::fixed("id", 4)};
+  index.n_uniq_ = 2;
+  index.clustered_ = false;
+  return index;
+}
+
+/// @brief the age index record of people_row(id), a node pointer to child
+/// if it isn't UINT32_MAX
+TestRecord age_row(int32_t id, uint32_t child = UINT32_MAX,
+                   bool min_rec = false) {
+  TestRecord r;
+  std::string key;
+  if (id % 5)
+    key = encode_int(id % 90, 4, false);
+  key += encode_int(id, 4, false);
+  r.data_.assign(key.begin(), key.end());
+  r.extra_.push_back(id % 5 ? 0 : 1);
+  if (child != UINT32_MAX) {
+    r.data_.resize(r.data_.size() + 4);
+    test_util::mach_write_to_4(r.data_.data() + r.data_.size() - 4, child);
+    r.status_ = REC_STATUS_NODE_PTR;
+    r.info_bits_ = min_rec ? RecordHeader::REC_INFO_MIN_REC_FLAG : 0;
+  }
+  return r;
+}
+
+SearchKey key_of(int32_t id) {
+  SearchKey key;
+  key.add(encode_int(id, 4, false));
+  return key;
+}
+
+} // namespace
+
+TEST(btree, point_lookup) {
+  // the root 3 points to the leaves 4, 5 and 6, each with the even ids of
+  // a range of 60
+  const IndexDef index = people_index();
+  test_util::SpaceBuilder builder(8);
+  builder.init_fsp_header_page();
+  std::vector<TestRecord> ptrs;
+  for (uint32_t leaf = 0; leaf < 3; ++leaf) {
+    std::vector<TestRecord> rows;
+    for (int32_t id = leaf * 60; id < (int32_t)(leaf + 1) * 60; id += 2)
+      rows.push_back(people_row(id));
+    builder.init_index_page(4 + leaf, index.index_id_, 0, rows,
+                            leaf == 0 ? UINT32_MAX : 3 + leaf,
+                            leaf == 2 ? UINT32_MAX : 5 + leaf);
+    ptrs.push_back(node_ptr(leaf * 60, 4 + leaf, leaf == 0));
+  }
+  builder.init_index_page(3, index.index_id_, 1, ptrs);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str());
+  BTree tree(&reader, 3, index);
+  RecOffsets offsets;
+  for (int32_t id = -4; id < 190; ++id) {
+    auto cursor = tree.lookup(key_of(id));
+    if (id < 0 || id >= 180 || id % 2) {
+      EXPECT_FALSE(cursor.valid()) << id;
+      continue;
+    }
+    ASSERT_TRUE(cursor.valid()) << id;
+    EXPECT_EQ(2u, tree.pages_visited());
+    EXPECT_EQ(4 + id / 60, (int32_t)cursor.page_no_);
+    const byte *rec = cursor.rec_.data();
+    ASSERT_TRUE(offsets.init(rec, index));
+    EXPECT_EQ(id, decode_int(offsets.field(rec, 0), 4, false));
+    EXPECT_EQ(id % 3 == 0, offsets.is_null(3));
+    if (id % 3) {
+      std::string name((const char *)offsets.field(rec, 3), offsets.len(3));
+      EXPECT_EQ("person " + std::to_string(id), name);
+    }
+    EXPECT_EQ(id % 5 == 0, offsets.is_null(4));
+    if (id % 5) {
+      EXPECT_EQ(id % 90, decode_int(offsets.field(rec, 4), 4, false));
+    }
+  }
+
+  // L stops before an equal key, across the leaves
+  auto cursor = tree.search(key_of(60), SearchMode::L);
+  ASSERT_TRUE(cursor.valid());
+  EXPECT_EQ(4u, cursor.page_no_);
+  EXPECT_EQ(58, decode_int(cursor.rec_.data(), 4, false));
+  cursor = tree.search(key_of(61), SearchMode::LE);
+  ASSERT_TRUE(cursor.valid());
+  EXPECT_EQ(5u, cursor.page_no_);
+  EXPECT_EQ(60, decode_int(cursor.rec_.data(), 4, false));
+  // smaller than all the keys, the infimum of the first leaf
+  cursor = tree.search(key_of(-1), SearchMode::LE);
+  ASSERT_TRUE(cursor.valid());
+  EXPECT_EQ(4u, cursor.page_no_);
+  EXPECT_EQ(REC_STATUS_INFIMUM, cursor.rec_.status());
+  unlink(file.c_str());
+}
+
+TEST(btree, leaf_scan) {
+  // root 3 at level 2, the level 1 pages 4 and 5, 8 leaves of 20 rows
+  // with the 5th and 6th leaves swapped on disk
+  const IndexDef index = people_index();
+  const std::vector<uint32_t> leaves = {6, 7, 8, 9, 11, 10, 12, 13};
+  test_util::SpaceBuilder builder(14);
+  builder.init_fsp_header_page();
+  std::vector<TestRecord> parents[2];
+  for (uint32_t i = 0; i < leaves.size(); ++i) {
+    std::vector<TestRecord> rows;
+    for (int32_t id = i * 40; id < (int32_t)(i + 1) * 40; id += 2)
+      rows.push_back(people_row(id));
+    builder.init_index_page(leaves[i], index.index_id_, 0, rows,
+                            i == 0 ? UINT32_MAX : leaves[i - 1],
+                            i + 1 == leaves.size() ? UINT32_MAX
+                                                   : leaves[i + 1]);
+    parents[i / 4].push_back(node_ptr(i * 40, leaves[i], i == 0));
+  }
+  builder.init_index_page(4, index.index_id_, 1, parents[0], UINT32_MAX, 5);
+  builder.init_index_page(5, index.index_id_, 1, parents[1], 4, UINT32_MAX);
+  builder.init_index_page(3, index.index_id_, 2,
+                          {node_ptr(0, 4, true), node_ptr(160, 5, false)});
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str());
+  BTree tree(&reader, 3, index);
+  for (uint32_t readahead : {0u, 2u, 64u}) {
+    Prefetcher prefetcher(&reader, 2);
+    LeafScanner scanner(&tree, readahead ? &prefetcher : nullptr, readahead);
+    int32_t expected = 0;
+    std::vector<uint32_t> visited;
+    EXPECT_TRUE(scanner.for_each_record([&](const RecordView &rec,
+                                            uint32_t page_no) {
+      EXPECT_EQ(expected, decode_int(rec.data(), 4, false));
+      expected += 2;
+      if (visited.empty() || visited.back() != page_no)
+        visited.push_back(page_no);
+      return true;
+    }));
+    prefetcher.wait();
+    EXPECT_EQ(320, expected);
+    EXPECT_EQ(leaves, visited);
+    EXPECT_EQ(8u, scanner.leaves_scanned());
+    EXPECT_EQ(0u, scanner.readahead_misses());
+    // all but the first leaf, read by the descent, come from the parents
+    EXPECT_EQ(readahead ? 7u : 0u, scanner.leaves_prefetched());
+  }
+
+  // stop early
+  LeafScanner scanner(&tree);
+  uint32_t n = 0;
+  EXPECT_TRUE(scanner.for_each_leaf(
+      [&](uint32_t, const PageGuard &) { return ++n < 3; }));
+  EXPECT_EQ(3u, scanner.leaves_scanned());
+  unlink(file.c_str());
+
+  // a leaf that doesn't link back to its left sibling breaks the chain
+  builder.init_index_page(8, index.index_id_, 0, {people_row(80)}, 6, 9);
+  file = builder.write_file();
+  FileSpaceReader broken(file.c_str());
+  BTree broken_tree(&broken, 3, index);
+  LeafScanner broken_scanner(&broken_tree);
+  EXPECT_FALSE(broken_scanner.for_each_leaf(
+      [](uint32_t, const PageGuard &) { return true; }));
+  EXPECT_EQ(2u, broken_scanner.leaves_scanned());
+  unlink(file.c_str());
+}
+
+TEST(btree, range_scan) {
+  // the people tree of point_lookup, the root 3 and the leaves 4 to 6, and
+  // the age index, the root 7 and the leaves 8 and 9
+  const IndexDef index = people_index();
+  const IndexDef by_age = age_index();
+  test_util::SpaceBuilder builder(10);
+  builder.init_fsp_header_page();
+  std::vector<TestRecord> ptrs;
+  std::vector<int32_t> ids;
+  for (uint32_t leaf = 0; leaf < 3; ++leaf) {
+    std::vector<TestRecord> rows;
+    for (int32_t id = leaf * 60; id < (int32_t)(leaf + 1) * 60; id += 2) {
+      rows.push_back(people_row(id));
+      ids.push_back(id);
+    }
+    builder.init_index_page(4 + leaf, index.index_id_, 0, rows,
+                            leaf == 0 ? UINT32_MAX : 3 + leaf,
+                            leaf == 2 ? UINT32_MAX : 5 + leaf);
+    ptrs.push_back(node_ptr(leaf * 60, 4 + leaf, leaf == 0));
+  }
+  builder.init_index_page(3, index.index_id_, 1, ptrs);
+  // NULL ages first
+  auto age_order = [](int32_t id) {
+    return std::make_pair(id % 5 ? id % 90 : -1, id);
+  };
+  std::sort(ids.begin(), ids.end(), [&](int32_t a, int32_t b) {
+    return age_order(a) < age_order(b);
+  });
+  std::vector<TestRecord> age_leaves[2];
+  for (size_t i = 0; i < ids.size(); ++i)
+    age_leaves[i * 2 / ids.size()].push_back(age_row(ids[i]));
+  builder.init_index_page(8, by_age.index_id_, 0, age_leaves[0], UINT32_MAX,
+                          9);
+  builder.init_index_page(9, by_age.index_id_, 0, age_leaves[1], 8,
+                          UINT32_MAX);
+  builder.init_index_page(
+      7, by_age.index_id_, 1,
+      {age_row(ids[0], 8, true), age_row(ids[ids.size() / 2], 9)});
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str());
+  BTree tree(&reader, 3, index);
+  Prefetcher prefetcher(&reader, 2);
+  RangeScanner scanner(&tree, &prefetcher);
+  auto scan_ids = [&](const KeyRange &range) {
+    std::vector<int32_t> found;
+    EXPECT_TRUE(scanner.scan(range, [&](const RecordView &rec, uint32_t) {
+      found.push_back(decode_int(rec.data(), 4, false));
+      return true;
+    }));
+    return found;
+  };
+  auto evens = [](int32_t from, int32_t to) {
+    std::vector<int32_t> v;
+    for (int32_t id = from; id <= to; id += 2)
+      v.push_back(id);
+    return v;
+  };
+
+  KeyRange range;
+  range.low_.key_ = key_of(20);
+  range.high_.key_ = key_of(70);
+  range.high_.inclusive_ = false;
+  EXPECT_EQ(evens(20, 68), scan_ids(range));
+  EXPECT_EQ(2u, scanner.leaves_scanned());
+  // the records are compared up to the first one past the bound
+  EXPECT_EQ(26u, scanner.records_compared());
+  range.low_.inclusive_ = false;
+  range.high_.inclusive_ = true;
+  EXPECT_EQ(evens(22, 70), scan_ids(range));
+  range.low_.key_ = key_of(59);
+  range.high_.key_ = key_of(61);
+  EXPECT_EQ(evens(60, 60), scan_ids(range));
+  range.low_ = KeyBound();
+  range.high_.key_ = key_of(10);
+  EXPECT_EQ(evens(0, 10), scan_ids(range));
+  EXPECT_EQ(evens(0, 178), scan_ids(KeyRange::all()));
+  EXPECT_EQ(3u, scanner.leaves_scanned());
+  EXPECT_EQ(0u, scanner.records_compared());
+  EXPECT_TRUE(scan_ids(KeyRange::prefix(key_of(61))).empty());
+  range.low_.key_ = key_of(200);
+  range.high_ = KeyBound();
+  EXPECT_TRUE(scan_ids(range).empty());
+  // stop early
+  uint32_t n = 0;
+  EXPECT_TRUE(scanner.scan(KeyRange::all(), [&](const RecordView &,
+                                                uint32_t) { return ++n < 5; }));
+  EXPECT_EQ(5u, scanner.records_returned());
+  prefetcher.wait();
+
+  // the age index with a prefix of its key, the rows then looked up by
+  // their primary key
+  BTree age_tree(&reader, 7, by_age);
+  RangeScanner age_scanner(&age_tree, nullptr, {1});
+  SearchKey age;
+  age.add(encode_int(4, 4, false));
+  std::vector<int32_t> found;
+  EXPECT_TRUE(age_scanner.scan(KeyRange::prefix(age), [&](
+                                   const RecordView &rec, uint32_t) {
+    SearchKey pk;
+    EXPECT_TRUE(age_scanner.primary_key(rec, pk));
+    auto cursor = tree.lookup(pk);
+    EXPECT_TRUE(cursor.valid());
+    if (cursor.valid())
+      found.push_back(decode_int(cursor.rec_.data(), 4, false));
+    return true;
+  }));
+  EXPECT_EQ(std::vector<int32_t>({4, 94}), found);
+  // NULL ages sort first, every tenth id
+  SearchKey null_age;
+  null_age.add_null();
+  n = 0;
+  EXPECT_TRUE(age_scanner.scan(KeyRange::prefix(null_age),
+                               [&](const RecordView &rec, uint32_t) {
+                                 SearchKey pk;
+                                 EXPECT_TRUE(age_scanner.primary_key(rec, pk));
+                                 EXPECT_EQ(encode_int(n * 10, 4, false),
+                                           pk.fields_[0]);
+                                 ++n;
+                                 return true;
+                               }));
+  EXPECT_EQ(18u, n);
+  // the two rows of age 34 are on both leaves
+  KeyRange ages;
+  ages.low_.key_.add(encode_int(30, 4, false));
+  ages.high_.key_.add(encode_int(40, 4, false));
+  n = 0;
+  EXPECT_TRUE(age_scanner.scan(ages, [&](const RecordView &, uint32_t) {
+    ++n;
+    return true;
+  }));
+  // 32, 34, 36 and 38, twice each
+  EXPECT_EQ(8u, n);
+  EXPECT_EQ(2u, age_scanner.leaves_scanned());
+  SearchKey pk;
+  EXPECT_FALSE(scanner.primary_key(RecordView(), pk));
+  unlink(file.c_str());
+}
@@ -0,0 +1,153 @@
+#include "catalog.h"
+#include "sdi.h"
+#include "table_reader.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace innodb;
+
+namespace {
+
+std::string table_sdi(const std::string &schema, const std::string &name,
+                      uint64_t table_id, uint64_t index_id, uint32_t root) {
+  return R"({"dd_object_type": "Table", "dd_object": {"name": ")" + name +
+         R"(", "schema_ref": ")" + schema +
+         R"(", "se_private_data": "id=)" + std::to_string(table_id) +
+         R"(;", "columns": [{"name": "id", "type": 4, "hidden": 1}],
+         "indexes": [{"name": "PRIMARY", "type": 1, "se_private_data": "id=)" +
+         std::to_string(index_id) + ";root=" + std::to_string(root) +
+         R"(;", "elements": [{"column_opx": 0, "length": 4}]}]}})";
+}
+
+bool write_table(const std::string &path, uint32_t space_id,
+                 const std::string &schema, const std::string &name,
+                 uint64_t index_id) {
+  test_util::SpaceBuilder builder(5, space_id);
+  builder.init_fsp_header_page();
+  uint64_t table_id = space_id + 1000;
+  builder.init_sdi(3, {builder.sdi_record(
+                          SdiReader::SDI_TYPE_TABLE, table_id,
+                          table_sdi(schema, name, table_id, index_id, 4))});
+  return builder.write_file(path);
+}
+
+std::vector<std::string> list_entries(const std::string &dir) {
+  std::vector<std::string> names;
+  DIR *d = opendir(dir.c_str());
+  if (!d)
+    return names;
+  while (dirent *e = readdir(d)) {
+    if (e->d_name[0] != '.')
+      names.push_back(e->d_name);
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+} // namespace
+
+TEST(catalog, build_and_reopen) {
+  char tmpl[] = "/tmp/view_ibd_catalog_XXXXXX";
+  ASSERT_TRUE(mkdtemp(tmpl));
+  std::string dir = tmpl;
+  ASSERT_EQ(0, mkdir((dir + "/db1").c_str(), 0755));
+  ASSERT_EQ(0, mkdir((dir + "/db2").c_str(), 0755));
+  ASSERT_TRUE(write_table(dir + "/db1/t1.ibd", 11, "db1", "t1", 201));
+  ASSERT_TRUE(write_table(dir + "/db1/t2.ibd", 12, "db1", "t2", 202));
+  // the file name differs from the dictionary name, e.g. #p#p0 partitions
+  ASSERT_TRUE(write_table(dir + "/db2/t3@0020.ibd", 13, "db2", "t3 x", 203));
+  // a file without SDI is known by its name
+  test_util::SpaceBuilder plain(4, 14);
+  plain.init_fsp_header_page();
+  ASSERT_TRUE(plain.write_file(dir + "/db2/old.ibd"));
+
+  // the cache file lives outside the data directory
+  const std::string path = dir + ".catalog";
+  Catalog catalog;
+  ASSERT_TRUE(catalog.open(dir, path, 2));
+  EXPECT_FALSE(catalog.loaded());
+  ASSERT_EQ(4u, catalog.tables().size());
+  const CatalogTable *t1 = catalog.find_table("db1", "t1");
+  ASSERT_TRUE(t1);
+  EXPECT_EQ(11u, t1->space_id_);
+  EXPECT_EQ(dir + "/db1/t1.ibd", catalog.path_of(*t1));
+  ASSERT_EQ(1u, t1->indexes_.size());
+  EXPECT_EQ(4u, t1->indexes_[0].root_page_no_);
+  EXPECT_EQ(t1, catalog.find_table("db1", "t1"));
+  const CatalogTable *t3 = catalog.find_table("db2", "t3 x");
+  ASSERT_TRUE(t3);
+  EXPECT_EQ(t3, catalog.find_table("db2", "t3@0020"));
+  EXPECT_EQ(1013u, t3->table_id_);
+  const CatalogTable *old = catalog.find_space(14);
+  ASSERT_TRUE(old);
+  EXPECT_EQ("old", old->name_);
+  EXPECT_TRUE(old->indexes_.empty());
+  auto found = catalog.find_index(202);
+  ASSERT_TRUE(found.first && found.second);
+  EXPECT_EQ("t2", found.first->name_);
+  EXPECT_EQ("PRIMARY", found.second->name_);
+  EXPECT_FALSE(catalog.find_table("db1", "t9"));
+  EXPECT_FALSE(catalog.find_index(999).first);
+
+  // the second open loads the persisted catalog
+  Catalog reopened;
+  ASSERT_TRUE(reopened.open(dir, path));
+  EXPECT_TRUE(reopened.loaded());
+  ASSERT_EQ(4u, reopened.tables().size());
+  EXPECT_EQ(12u, reopened.find_index(202).first->space_id_);
+  EXPECT_EQ(dir + "/db2/old.ibd",
+            reopened.path_of(*reopened.find_table("db2", "old")));
+
+  {
+    MySQLDataReader reader(dir.c_str(), path.c_str());
+    EXPECT_TRUE(reader.catalog().loaded());
+    EXPECT_TRUE(reader.get_table_reader("db1", "t2"));
+    EXPECT_FALSE(reader.get_table_reader("db1", "missing"));
+  }
+  {
+    // without a cache file a table is found by its path, the catalog is
+    // built in memory on a miss, and nothing is written to the data directory
+    MySQLDataReader reader(dir.c_str());
+    EXPECT_TRUE(reader.get_table_reader("db1", "t1"));
+    EXPECT_FALSE(reader.catalog_opened());
+    EXPECT_FALSE(reader.get_table_reader("db1", "missing"));
+    EXPECT_TRUE(reader.catalog_opened());
+    EXPECT_FALSE(reader.catalog().loaded());
+    EXPECT_EQ(std::vector<std::string>({"db1", "db2"}), list_entries(dir));
+    // a table added after the catalog is found by its path
+    ASSERT_TRUE(write_table(dir + "/db1/t4.ibd", 15, "db1", "t4", 204));
+    EXPECT_FALSE(reader.catalog().find_table("db1", "t4"));
+    EXPECT_TRUE(reader.get_table_reader("db1", "t4"));
+  }
+
+  // the new table makes it stale
+  EXPECT_FALSE(reopened.is_fresh(dir));
+  Catalog rebuilt;
+  ASSERT_TRUE(rebuilt.open(dir, path));
+  EXPECT_FALSE(rebuilt.loaded());
+  EXPECT_TRUE(rebuilt.find_table("db1", "t4"));
+
+  // a corrupt catalog is rebuilt
+  FILE *f = fopen(path.c_str(), "r+b");
+  ASSERT_TRUE(f);
+  fseek(f, 20, SEEK_SET);
+  fputc('x', f);
+  fclose(f);
+  EXPECT_FALSE(Catalog().load(path));
+  Catalog repaired;
+  ASSERT_TRUE(repaired.open(dir, path));
+  EXPECT_EQ(5u, repaired.tables().size());
+
+  for (const char *f : {"/db1/t1.ibd", "/db1/t2.ibd", "/db1/t4.ibd",
+                        "/db2/t3@0020.ibd", "/db2/old.ibd"})
+    unlink((dir + f).c_str());
+  unlink(path.c_str());
+  rmdir((dir + "/db1").c_str());
+  rmdir((dir + "/db2").c_str());
+  rmdir(dir.c_str());
+}
@@ -0,0 +1,70 @@
+#include "checksum.h"
+#include "file_space_reader.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+
+TEST(checksum, crc32c) {
+  const char *s = "123456789";
+  EXPECT_EQ(0xE3069283U, crc32c((const byte *)s, 9));
+  // chained over the pieces, from an unaligned start
+  std::vector<unsigned char> buf(1000);
+  for (size_t i = 0; i < buf.size(); ++i)
+    buf[i] = (unsigned char)(i * 7 + 3);
+  const byte *b = (const byte *)buf.data();
+  uint32_t whole = crc32c(b + 1, 999);
+  EXPECT_EQ(whole, crc32c(b + 500, 500, crc32c(b + 1, 499)));
+  LOG(INFO) << "crc32c implementation: " << crc32c_impl();
+}
+
+TEST(checksum, verify_space) {
+  const uint32_t n_pages = 2 * XDES_E::PAGES_PER_EXTENT;
+  test_util::SpaceBuilder builder(n_pages);
+  builder.init_fsp_header_page();
+  for (uint32_t i = 0; i < n_pages; ++i) {
+    unsigned char *pg = builder.page(i);
+    if (i == 7) {
+      memset(pg, 0, PAGE_SIZE); // never written
+      continue;
+    }
+    builder.init_fil_header(i, FIL_PAGE_INDEX, 0x1234500000000ULL + i);
+    pg[1000] = (unsigned char)i;
+    if (i % 2 == 0) {
+      uint32_t checksum = PageChecksum::crc32((const byte *)pg, PAGE_SIZE);
+      test_util::mach_write_to_4(pg + FILHeader::FIL_PAGE_SPACE_OR_CHKSUM,
+                                 checksum);
+      test_util::mach_write_to_4(pg + PAGE_SIZE - 8, checksum);
+    } else {
+      // the old checksum covers the new one, write the new one first
+      test_util::mach_write_to_4(
+          pg + FILHeader::FIL_PAGE_SPACE_OR_CHKSUM,
+          PageChecksum::innodb_new((const byte *)pg, PAGE_SIZE));
+      test_util::mach_write_to_4(pg + PAGE_SIZE - 8,
+                                 PageChecksum::innodb_old((const byte *)pg));
+    }
+  }
+  EXPECT_EQ(ChecksumAlgorithm::CRC32,
+            PageChecksum::verify((const byte *)builder.page(0), PAGE_SIZE));
+  EXPECT_EQ(ChecksumAlgorithm::INNODB,
+            PageChecksum::verify((const byte *)builder.page(1), PAGE_SIZE));
+  EXPECT_EQ(ChecksumAlgorithm::EMPTY,
+            PageChecksum::verify((const byte *)builder.page(7), PAGE_SIZE));
+  // a flipped bit in the body and a torn write
+  builder.page(42)[5000] ^= 0x10;
+  builder.page(99)[PAGE_SIZE - 1] ^= 0x01;
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str(), ReadMode::PREAD, 16 * PAGE_SIZE);
+  auto report = verify_space_checksums(&reader, 4);
+  EXPECT_FALSE(report.ok());
+  EXPECT_EQ(n_pages, report.pages_checked_);
+  EXPECT_EQ(1u, report.empty_pages_);
+  EXPECT_EQ(std::vector<uint32_t>({42}), report.corrupt_pages_);
+  EXPECT_EQ(std::vector<uint32_t>({99}), report.lsn_mismatch_pages_);
+  EXPECT_EQ(n_pages / 2 - 1, report.crc32_pages_); // but page 42
+  // page 7 is empty, the torn page 99 still has a valid checksum
+  EXPECT_EQ(n_pages / 2 - 1, report.innodb_pages_);
+  unlink(file.c_str());
+}
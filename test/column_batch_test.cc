@@ -0,0 +1,152 @@
+#include "column_batch.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <cstring>
+
+using namespace innodb;
+using test_util::TestRecord;
+
+namespace {
+
+/// id INT PRIMARY KEY, name VARCHAR(100) NULL, score DOUBLE NULL,
+/// body TEXT NULL, flags TINYINT UNSIGNED
+TableSchema sample_schema() {
+  return TableSchema::clustered(
+      9, {ColumnDef::make("id", ColumnType::INT, 4)},
+      {ColumnDef::make("name", ColumnType::VARBINARY, 400, true),
+       ColumnDef::make("score", ColumnType::DOUBLE, 8, true),
+       ColumnDef::make("body", ColumnType::VARBINARY, 65535, true, true),
+       ColumnDef::make("flags", ColumnType::UINT, 1)});
+}
+
+std::string name_of(int i) { return "row " + std::to_string(i); }
+std::string body_of(int i) { return std::string(300 + i, 'a' + i % 26); }
+
+/// the 7th row keeps its body off page, 30 local bytes with the reference
+const int EXTERN_ROW = 7;
+
+TestRecord sample_row(int i) {
+  TestRecord r;
+  auto append = [&](const std::string &s) {
+    r.data_.insert(r.data_.end(), s.begin(), s.end());
+  };
+  std::vector<unsigned char> lens; // in the order they are read
+  uint8_t nulls = 0;
+  append(encode_int(i - 5, 4, false));
+  append(encode_int(1000 + i, IndexDef::DATA_TRX_ID_LEN, true));
+  append(encode_int((1LL << 52) | i, IndexDef::DATA_ROLL_PTR_LEN, true));
+  if (i % 4 == 0) {
+    nulls |= 1;
+  } else {
+    append(name_of(i));
+    lens.push_back(name_of(i).size());
+  }
+  if (i % 3 == 0) {
+    nulls |= 2;
+  } else {
+    double score = i * 1.5;
+    char buf[8];
+    memcpy(buf, &score, 8);
+    append(std::string(buf, 8));
+  }
+  if (i % 5 == 0) {
+    nulls |= 4;
+  } else {
+    std::string body = i == EXTERN_ROW ? std::string(30, 'x') : body_of(i);
+    append(body);
+    uint8_t flags = RecOffsets::REC_2BYTE_LEN_FLAG;
+    if (i == EXTERN_ROW)
+      flags |= RecOffsets::REC_EXTERN_FLAG;
+    lens.push_back(flags | (body.size() >> 8));
+    lens.push_back(body.size() & 0xff);
+  }
+  append(encode_int(200 + i, 1, true));
+  r.extra_.assign(lens.rbegin(), lens.rend());
+  r.extra_.push_back(nulls);
+  return r;
+}
+
+} // namespace
+
+TEST(column_batch, decode_page) {
+  const TableSchema schema = sample_schema();
+  ASSERT_EQ(7u, schema.columns_.size());
+  EXPECT_EQ(1, schema.find("DB_TRX_ID"));
+  EXPECT_EQ(2, schema.find("DB_ROLL_PTR"));
+
+  const int n_rows = 20;
+  std::vector<TestRecord> rows;
+  for (int i = 0; i < n_rows; ++i)
+    rows.push_back(sample_row(i));
+  rows[9].info_bits_ = RecordHeader::REC_INFO_DELETED_FLAG;
+  test_util::SpaceBuilder builder(4);
+  builder.init_index_page(3, schema.index_id_, 0, rows);
+  IndexPageView view((const byte *)builder.page(3));
+
+  BatchDecoder decoder(schema);
+  ASSERT_TRUE(decoder.valid());
+  ColumnBatch batch = decoder.make_batch();
+  EXPECT_EQ(n_rows - 1, decoder.decode_page(view, batch));
+  ASSERT_EQ(size_t(n_rows - 1), batch.n_rows_);
+  const auto &id = batch.columns_[0];
+  const auto &trx = batch.columns_[1];
+  const auto &roll = batch.columns_[2];
+  const auto &name = batch.columns_[3];
+  const auto &score = batch.columns_[4];
+  const auto &body = batch.columns_[5];
+  const auto &flags = batch.columns_[6];
+  ASSERT_EQ(size_t(n_rows - 1), id.ints_.size());
+  ASSERT_EQ(size_t(n_rows - 1), score.reals_.size());
+  ASSERT_EQ(size_t(n_rows), name.offsets_.size());
+  for (int row = 0; row < n_rows - 1; ++row) {
+    int i = row < 9 ? row : row + 1; // the 9th is delete marked
+    EXPECT_EQ(i - 5, id.ints_[row]);
+    EXPECT_EQ(1000 + i, trx.ints_[row]);
+    EXPECT_EQ((1LL << 52) | i, roll.ints_[row]);
+    EXPECT_EQ(i % 4 == 0, name.is_null(row));
+    EXPECT_EQ(i % 4 ? name_of(i) : "", name.str(row));
+    EXPECT_EQ(i % 3 == 0, score.is_null(row));
+    EXPECT_EQ(i % 3 ? i * 1.5 : 0, score.reals_[row]);
+    EXPECT_EQ(i % 5 == 0, body.is_null(row));
+    EXPECT_EQ(i == EXTERN_ROW, body.is_extern(row));
+    if (i % 5 && i != EXTERN_ROW) {
+      EXPECT_EQ(body_of(i), body.str(row));
+    }
+    EXPECT_EQ(200 + i, flags.ints_[row]);
+  }
+
+  // appends to the batch, with the delete marked row this time
+  EXPECT_EQ(n_rows, decoder.decode_page(view, batch, false));
+  EXPECT_EQ(size_t(2 * n_rows - 1), batch.n_rows_);
+  batch.clear();
+  EXPECT_EQ(0u, batch.columns_[0].size());
+  EXPECT_EQ(1u, batch.columns_[3].offsets_.size());
+}
+
+TEST(column_batch, projection) {
+  const TableSchema schema = sample_schema();
+  std::vector<TestRecord> rows;
+  for (int i = 1; i < 4; ++i)
+    rows.push_back(sample_row(i));
+  test_util::SpaceBuilder builder(4);
+  builder.init_index_page(3, schema.index_id_, 0, rows);
+  builder.init_index_page(2, schema.index_id_, 1, rows);
+  IndexPageView view((const byte *)builder.page(3));
+
+  BatchDecoder decoder(schema, {(uint16_t)schema.find("name"),
+                                (uint16_t)schema.find("id")});
+  ColumnBatch batch = decoder.make_batch();
+  ASSERT_EQ(2u, batch.columns_.size());
+  EXPECT_EQ(0, batch.find("name"));
+  EXPECT_EQ(1, batch.find("id"));
+  EXPECT_EQ(3, decoder.decode_page(view, batch));
+  EXPECT_EQ(name_of(2), batch.columns_[0].str(1));
+  EXPECT_EQ(-2, batch.columns_[1].ints_[2]);
+  // not a leaf
+  IndexPageView node_ptr_page((const byte *)builder.page(2));
+  EXPECT_EQ(-1, decoder.decode_page(node_ptr_page, batch));
+
+  BatchDecoder bad(TableSchema::clustered(
+      9, {ColumnDef::make("id", ColumnType::INT, 16)}, {}));
+  EXPECT_FALSE(bad.valid());
+}
@@ -0,0 +1,177 @@
+#include "column_filter.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <cmath>
+#include <glog/logging.h>
+#include <random>
+
+using namespace innodb;
+
+namespace {
+
+/// a tail of rows after the whole words of the bitmap
+constexpr size_t N_ROWS = 1000;
+
+ColumnVector int_column(ColumnType type, std::mt19937_64 &rng) {
+  ColumnVector col;
+  col.def_ = ColumnDef::make("c", type, 8, true);
+  for (size_t i = 0; i < N_ROWS; ++i) {
+    bool is_null = i % 7 == 3;
+    // small values repeat, so that the compares have equal ones
+    int64_t v = i % 3 ? (int64_t)(rng() % 41) - 20 : (int64_t)rng();
+    col.ints_.push_back(is_null ? 0 : v);
+    col.flags_.push_back(is_null ? ColumnVector::NULL_FLAG : 0);
+  }
+  return col;
+}
+
+template <typename Pred>
+void expect_rows(const ColumnVector &col, const SelectionBitmap &bitmap,
+                 Pred pred) {
+  ASSERT_EQ(col.size(), bitmap.n_rows_);
+  size_t n = 0;
+  for (size_t i = 0; i < col.size(); ++i) {
+    bool expected = !col.is_null(i) && pred(i);
+    EXPECT_EQ(expected, bitmap.test(i)) << filter_impl() << " row " << i;
+    n += expected;
+  }
+  EXPECT_EQ(n, bitmap.count());
+}
+
+template <typename T> bool compare(CompareOp op, T a, T b) {
+  switch (op) {
+  case CompareOp::EQ:
+    return a == b;
+  case CompareOp::NE:
+    return a != b;
+  case CompareOp::LT:
+    return a < b;
+  case CompareOp::LE:
+    return a <= b;
+  case CompareOp::GT:
+    return a > b;
+  case CompareOp::GE:
+    return a >= b;
+  }
+  return false;
+}
+
+const CompareOp OPS[] = {CompareOp::EQ, CompareOp::NE, CompareOp::LT,
+                         CompareOp::LE, CompareOp::GT, CompareOp::GE};
+
+} // namespace
+
+TEST(column_filter, kernels) {
+  LOG(INFO) << "filter kernels: " << filter_impl();
+  std::mt19937_64 rng(17);
+  ColumnVector ints = int_column(ColumnType::INT, rng);
+  ColumnVector uints = int_column(ColumnType::UINT, rng);
+  ColumnVector reals;
+  reals.def_ = ColumnDef::make("r", ColumnType::DOUBLE, 8, true);
+  for (size_t i = 0; i < N_ROWS; ++i) {
+    double v = i % 11 == 5 ? NAN : (double)(rng() % 100) / 4;
+    reals.reals_.push_back(i % 7 == 3 ? 0 : v);
+    reals.flags_.push_back(i % 7 == 3 ? ColumnVector::NULL_FLAG : 0);
+  }
+  std::vector<int64_t> short_list = {-20, 0, 3, 7, ints.ints_[1]};
+  std::vector<int64_t> long_list;
+  for (int64_t v = -20; v <= 20; v += 2)
+    long_list.push_back(v);
+
+  auto check = [&](const char *) {
+    SelectionBitmap bitmap;
+    for (CompareOp op : OPS) {
+      ASSERT_TRUE(filter_compare(ints, op, 3, bitmap));
+      expect_rows(ints, bitmap, [&](size_t i) {
+        return compare<int64_t>(op, ints.ints_[i], 3);
+      });
+      // unsigned, -5 is a huge value
+      ASSERT_TRUE(filter_compare(uints, op, -5, bitmap));
+      expect_rows(uints, bitmap, [&](size_t i) {
+        return compare<uint64_t>(op, uints.ints_[i], (uint64_t)-5);
+      });
+      ASSERT_TRUE(filter_compare_real(reals, op, 12.5, bitmap));
+      expect_rows(reals, bitmap, [&](size_t i) {
+        return compare<double>(op, reals.reals_[i], 12.5);
+      });
+    }
+    ASSERT_TRUE(filter_between(ints, -4, 9, bitmap));
+    expect_rows(ints, bitmap, [&](size_t i) {
+      return ints.ints_[i] >= -4 && ints.ints_[i] <= 9;
+    });
+    ASSERT_TRUE(filter_between(uints, 10, -1, bitmap));
+    expect_rows(uints, bitmap,
+                [&](size_t i) { return (uint64_t)uints.ints_[i] >= 10; });
+    ASSERT_TRUE(filter_between_real(reals, 2, 20.25, bitmap));
+    expect_rows(reals, bitmap, [&](size_t i) {
+      return reals.reals_[i] >= 2 && reals.reals_[i] <= 20.25;
+    });
+    for (const auto *list : {&short_list, &long_list}) {
+      ASSERT_TRUE(filter_in(ints, *list, bitmap));
+      expect_rows(ints, bitmap, [&](size_t i) {
+        return std::find(list->begin(), list->end(), ints.ints_[i]) !=
+               list->end();
+      });
+    }
+    filter_null(ints, true, bitmap);
+    EXPECT_EQ(143u, bitmap.count());
+    EXPECT_TRUE(bitmap.test(3));
+    filter_null(ints, false, bitmap);
+    EXPECT_EQ(N_ROWS - 143, bitmap.count());
+  };
+  EXPECT_LE(1u,
+            test_util::for_each_impl(filter_impl, set_filter_impl, check));
+}
+
+TEST(column_filter, binary_and_bitmaps) {
+  // DATE as innodb stores it, 3 bytes big endian
+  ColumnVector dates;
+  dates.def_ = ColumnDef::make("d", ColumnType::FIXED_BINARY, 3, true);
+  const char *values[] = {"\x0f\xc9\x21", "\x0f\xca\x41", "", "\x0f\xc9\x9f",
+                          "\x0f\xcb\x01"};
+  for (size_t i = 0; i < 5; ++i) {
+    dates.flags_.push_back(i == 2 ? ColumnVector::NULL_FLAG : 0);
+    dates.data_.append(values[i]);
+    dates.offsets_.push_back(dates.data_.size());
+  }
+  SelectionBitmap bitmap;
+  ASSERT_TRUE(
+      filter_compare_binary(dates, CompareOp::GE, "\x0f\xc9\x9f", bitmap));
+  EXPECT_EQ(3u, bitmap.count());
+  EXPECT_FALSE(bitmap.test(0));
+  EXPECT_FALSE(bitmap.test(2));
+  ASSERT_TRUE(
+      filter_between_binary(dates, "\x0f\xc9\x21", "\x0f\xca\x41", bitmap));
+  std::vector<size_t> rows;
+  bitmap.for_each_selected([&](size_t i) { rows.push_back(i); });
+  EXPECT_EQ(std::vector<size_t>({0, 1, 3}), rows);
+  // the NULL row doesn't match the empty value, a prefix isn't equal
+  ASSERT_TRUE(filter_in_binary(
+      dates, {"\x0f\xcb\x01", "", "\x0f\xc9", "\x0f\xc9\x21"}, bitmap));
+  rows.clear();
+  bitmap.for_each_selected([&](size_t i) { rows.push_back(i); });
+  EXPECT_EQ(std::vector<size_t>({0, 4}), rows);
+
+  // the filters check the column types
+  EXPECT_FALSE(filter_compare(dates, CompareOp::EQ, 1, bitmap));
+  EXPECT_FALSE(filter_compare_real(dates, CompareOp::EQ, 1, bitmap));
+  EXPECT_FALSE(filter_in(dates, {1}, bitmap));
+
+  SelectionBitmap all;
+  all.resize(130, true);
+  EXPECT_EQ(130u, all.count());
+  all.invert();
+  EXPECT_EQ(0u, all.count());
+  all.invert();
+  SelectionBitmap some;
+  some.resize(130);
+  some.set(0);
+  some.set(64);
+  some.set(129);
+  all.and_with(some);
+  EXPECT_EQ(3u, all.count());
+  some.resize(130);
+  some.set(1);
+  some.or_with(all);
+  EXPECT_EQ(4u, some.count());
+}
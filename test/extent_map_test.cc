@@ -0,0 +1,113 @@
+#include "extent_map.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <random>
+
+using namespace innodb;
+
+namespace {
+
+constexpr uint32_t SMALL_PAGE_SIZE = 4096;
+constexpr uint32_t SMALL_EXTENT = 256;
+
+/// @brief mark the first n_used pages of the extent used
+void use_pages(test_util::SpaceBuilder &builder, uint32_t extent,
+               uint32_t n_used) {
+  auto addr = builder.xdes_addr(extent);
+  unsigned char *bitmap =
+      builder.page(addr.page_number_) + addr.offset_ + XDES_E::XDES_BITMAP;
+  for (uint32_t i = 0; i < n_used; ++i)
+    bitmap[i / 4] &= ~(1 << (i % 4 * 2));
+}
+
+} // namespace
+
+TEST(extent_map, fragmentation_report) {
+  // 4K pages, an XDES page every 4096 pages and 256 pages per extent, the
+  // last two extents are described by the second XDES page
+  const uint32_t n_pages = SMALL_PAGE_SIZE + 2 * SMALL_EXTENT;
+  test_util::SpaceBuilder builder(n_pages, 5, SMALL_PAGE_SIZE);
+  builder.init_fsp_header_page();
+  builder.init_fil_header(SMALL_PAGE_SIZE, FIL_PAGE_TYPE_XDES);
+  unsigned char *fsp = builder.page(0) + FSPHeader::FSP_HEADER_OFFSET;
+  unsigned char seg_list[FLST_BASE_NODE_SIZE];
+  builder.init_xdes_list(fsp + FSPHeader::FSP_FREE_FRAG_LIST_BASE_NODE, {0},
+                         0, XDesEntryView::XDES_FREE_FRAG);
+  builder.init_xdes_list(fsp + FSPHeader::FSP_FREE_LIST_BASE_NODE, {4, 5}, 0,
+                         XDesEntryView::XDES_FREE);
+  builder.init_xdes_list(seg_list, {1, 2, 16}, 7, XDesEntryView::XDES_FSEG);
+  builder.init_xdes_list(seg_list, {3}, 9, XDesEntryView::XDES_FSEG);
+  use_pages(builder, 0, 3);
+  use_pages(builder, 1, SMALL_EXTENT);
+  use_pages(builder, 2, 100);
+  use_pages(builder, 3, 10);
+  use_pages(builder, 16, 200);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str());
+  ExtentMap map;
+  ASSERT_TRUE(map.load(&reader));
+  EXPECT_EQ(SMALL_EXTENT, map.extent_pages_);
+  EXPECT_EQ(8u, map.words_per_extent_);
+  ASSERT_EQ(18u, map.n_extents());
+  EXPECT_EQ(0u, map.bad_xdes_pages_);
+  EXPECT_EQ(7u, map.seg_ids_[16]);
+  EXPECT_EQ(XDesEntryView::XDES_NOT_INITED, map.states_[17]);
+  EXPECT_EQ(SMALL_EXTENT, map.n_free_[4]);
+  EXPECT_EQ(0u, map.n_free_[1]);
+  EXPECT_EQ(156u, map.n_free_[2]);
+  EXPECT_FALSE(map.is_page_free(SMALL_EXTENT));
+  EXPECT_FALSE(map.is_page_free(2 * SMALL_EXTENT + 99));
+  EXPECT_TRUE(map.is_page_free(2 * SMALL_EXTENT + 100));
+  EXPECT_FALSE(map.is_page_free(16 * SMALL_EXTENT + 199));
+  EXPECT_TRUE(map.is_page_free(16 * SMALL_EXTENT + 200));
+
+  auto report = FragmentationReport::build(map);
+  ASSERT_TRUE(report.valid_);
+  EXPECT_EQ(11u, report.extents_by_state_[XDesEntryView::XDES_NOT_INITED]);
+  EXPECT_EQ(2u, report.extents_by_state_[XDesEntryView::XDES_FREE]);
+  EXPECT_EQ(1u, report.extents_by_state_[XDesEntryView::XDES_FREE_FRAG]);
+  EXPECT_EQ(4u, report.extents_by_state_[XDesEntryView::XDES_FSEG]);
+  EXPECT_EQ(569u, report.used_pages_);
+  EXPECT_EQ(5 * SMALL_EXTENT - 569u, report.free_pages_in_use_);
+  EXPECT_DOUBLE_EQ(711.0 / 1280, report.fragmentation());
+  EXPECT_EQ(711u * SMALL_PAGE_SIZE, report.reclaimable_bytes());
+  ASSERT_EQ(2u, report.segments_.size());
+  EXPECT_EQ(7u, report.segments_[0].seg_id_);
+  EXPECT_EQ(3u, report.segments_[0].n_extents_);
+  EXPECT_EQ(556u, report.segments_[0].used_pages_);
+  EXPECT_EQ(212u, report.segments_[0].free_pages_);
+  EXPECT_EQ(9u, report.segments_[1].seg_id_);
+  EXPECT_DOUBLE_EQ(10.0 / SMALL_EXTENT, report.segments_[1].fill_factor());
+
+  auto reports = FragmentationReport::of_files({file, file + ".missing"}, 2);
+  ASSERT_EQ(2u, reports.size());
+  EXPECT_TRUE(reports[0].valid_);
+  EXPECT_EQ(5u, reports[0].space_id_);
+  EXPECT_EQ(n_pages, reports[0].n_pages_);
+  EXPECT_EQ(569u, reports[0].used_pages_);
+  EXPECT_FALSE(reports[1].valid_);
+  unlink(file.c_str());
+}
+
+TEST(extent_map, popcount_kernels) {
+  std::mt19937_64 rng(7);
+  ExtentMap map;
+  map.words_per_extent_ = 2;
+  // not a multiple of the vector widths
+  map.states_.resize(1003);
+  for (size_t i = 0; i < map.n_extents() * 2; ++i)
+    map.bitmaps_.push_back(rng());
+  std::vector<uint16_t> expected(map.n_extents());
+  for (size_t e = 0; e < map.n_extents(); ++e) {
+    for (uint32_t p = 0; p < map.extent_pages_; ++p)
+      expected[e] += map.is_page_free(e * map.extent_pages_ + p);
+  }
+  EXPECT_LE(1u, test_util::for_each_impl(popcount_impl, set_popcount_impl,
+                                         [&](const char *name) {
+                                           map.count_free();
+                                           EXPECT_EQ(expected, map.n_free_)
+                                               << name;
+                                         }));
+}
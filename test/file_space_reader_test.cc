@@ -0,0 +1,169 @@
+#include "file_space_reader.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+
+using namespace innodb;
+
+TEST(file_space_reader, mmap_mode) {
+  test_util::SpaceBuilder builder(8);
+  builder.init_fsp_header_page();
+  builder.init_fil_header(1, FIL_PAGE_IBUF_BITMAP);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader stream_reader(file.c_str());
+  FileSpaceReader mmap_reader(file.c_str(), ReadMode::MMAP);
+  ASSERT_EQ(0, mmap_reader.advise(AccessPattern::SEQUENTIAL));
+  EXPECT_EQ(8u, stream_reader.get_page_count());
+  EXPECT_EQ(8u, mmap_reader.get_page_count());
+
+  for (unsigned int i = 0; i < 2; ++i) {
+    auto *from_stream = stream_reader.get_page(i);
+    auto *from_mmap = mmap_reader.get_page(i);
+    ASSERT_NE(nullptr, from_stream);
+    ASSERT_NE(nullptr, from_mmap);
+    EXPECT_EQ(0, memcmp(from_stream->buf(), from_mmap->buf(), PAGE_SIZE));
+    EXPECT_EQ(i, from_mmap->get_fil_header().page_number_offset_);
+  }
+  EXPECT_EQ(nullptr, mmap_reader.get_page(8));
+  unlink(file.c_str());
+}
+
+TEST(file_space_reader, page_cache_eviction) {
+  test_util::SpaceBuilder builder(16);
+  builder.init_fsp_header_page();
+  for (uint32_t i = 1; i < 16; ++i)
+    builder.init_fil_header(i, FIL_PAGE_IBUF_BITMAP);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  // room for 4 pages only
+  FileSpaceReader reader(file.c_str(), ReadMode::PREAD, 4 * PAGE_SIZE);
+  auto pinned = reader.fetch_page(1);
+  ASSERT_TRUE(pinned);
+  for (unsigned int i = 2; i < 16; ++i) {
+    auto pg = reader.fetch_page(i);
+    ASSERT_TRUE(pg);
+    EXPECT_EQ(i, pg->get_fil_header().page_number_offset_);
+  }
+  const auto &cache = reader.get_page_cache();
+  // the pinned page may push its shard over the budget by one frame
+  EXPECT_LE(cache.size(), 5u);
+  EXPECT_GT(cache.evictions(), 0u);
+  // the pinned page is never evicted
+  auto hits = cache.hits();
+  auto again = reader.fetch_page(1);
+  EXPECT_EQ(pinned.get(), again.get());
+  EXPECT_EQ(hits + 1, cache.hits());
+  EXPECT_EQ(15u, cache.misses());
+  unlink(file.c_str());
+}
+
+TEST(file_space_reader, concurrent_fetch) {
+  test_util::SpaceBuilder builder(64);
+  builder.init_fsp_header_page();
+  for (uint32_t i = 1; i < 64; ++i)
+    builder.init_fil_header(i, FIL_PAGE_IBUF_BITMAP);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str(), ReadMode::PREAD, 16 * PAGE_SIZE);
+  std::atomic<uint32_t> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int round = 0; round < 50; ++round) {
+        for (uint32_t i = 1; i < 64; ++i) {
+          uint32_t page_no = (i * (t + 1)) % 63 + 1;
+          auto pg = reader.fetch_page(page_no);
+          if (!pg || pg->get_fil_header().page_number_offset_ != page_no)
+            ++mismatches;
+        }
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  EXPECT_EQ(0u, mismatches.load());
+  unlink(file.c_str());
+}
+
+TEST(file_space_reader, frame_pool) {
+  FramePool pool(false, 4 * PAGE_SIZE);
+  std::vector<unsigned char *> frames;
+  for (int i = 0; i < 6; ++i) {
+    auto *frame = pool.alloc();
+    ASSERT_NE(nullptr, frame);
+    EXPECT_EQ(0u, align_offset(frame, PAGE_SIZE));
+    frames.push_back(frame);
+  }
+  EXPECT_EQ(2u, pool.n_slabs());
+  EXPECT_EQ(6u, pool.n_used_frames());
+  pool.free(frames.back());
+  EXPECT_EQ(frames.back(), pool.alloc());
+  for (auto *frame : frames)
+    pool.free(frame);
+  EXPECT_EQ(0u, pool.n_used_frames());
+}
+
+TEST(file_space_reader, direct_mode) {
+  test_util::SpaceBuilder builder(8);
+  builder.init_fsp_header_page();
+  for (uint32_t i = 1; i < 8; ++i)
+    builder.init_fil_header(i, FIL_PAGE_IBUF_BITMAP);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str(), ReadMode::DIRECT, 4 * PAGE_SIZE);
+  for (uint32_t i = 0; i < 8; ++i) {
+    auto pg = reader.fetch_page(i);
+    ASSERT_TRUE(pg);
+    EXPECT_EQ(i, pg->get_fil_header().page_number_offset_);
+    EXPECT_EQ(0u, align_offset(pg->buf(), PAGE_SIZE));
+  }
+  // evicted pages give their frames back for reuse
+  EXPECT_LE(reader.get_frame_pool().n_used_frames(), 4u);
+  // pages 4 to 7 are still cached, nothing to read
+  EXPECT_EQ(0, reader.read_pages(4, 4));
+  unlink(file.c_str());
+}
+
+TEST(file_space_reader, page_sizes) {
+  for (uint32_t page_size : {4096U, 8192U, 16384U, 32768U, 65536U}) {
+    uint32_t extent_size = extent_pages(page_size);
+    test_util::SpaceBuilder builder(2 * extent_size, 1, page_size);
+    builder.init_fsp_header_page();
+    unsigned char *fsp = builder.page(0) + FSPHeader::FSP_HEADER_OFFSET;
+    builder.init_xdes_list(fsp + FSPHeader::FSP_FULL_FRAG_LIST_BASE_NODE, {1},
+                           0, 3 /*XDES_FULL_FRAG*/);
+    auto file = builder.write_file();
+    ASSERT_FALSE(file.empty());
+
+    for (auto mode : {ReadMode::PREAD, ReadMode::MMAP}) {
+      FileSpaceReader reader(file.c_str(), mode, 8 * page_size);
+      EXPECT_EQ(page_size, reader.get_page_size());
+      EXPECT_EQ(extent_size, reader.get_extent_size());
+      EXPECT_EQ(2 * extent_size, reader.get_page_count());
+      auto pg = reader.fetch_page(extent_size + 1);
+      ASSERT_TRUE(pg);
+      EXPECT_EQ(extent_size + 1, pg->get_fil_header().page_number_offset_);
+      EXPECT_EQ(page_size, pg->get_page_size());
+
+      auto fsp_page = reader.fetch_page(0);
+      ASSERT_TRUE(fsp_page);
+      uint32_t n_extents = 0;
+      reader.traverse_xdes_list(
+          static_cast<FSPHeaderPage *>(fsp_page.get())
+              ->fsp_header_.full_frag_list_base_node_,
+          [&](const XDES_E &, Addr addr) {
+            EXPECT_EQ(extent_size,
+                      XDES_E::extent_first_page(addr, page_size));
+            ++n_extents;
+          });
+      EXPECT_EQ(1u, n_extents);
+    }
+    unlink(file.c_str());
+  }
+}
@@ -0,0 +1,32 @@
+#include "kernel_dispatch.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+
+namespace {
+
+struct FakeKernels {
+  const char *name_;
+  int (*value_)();
+  bool (*supported_)();
+};
+
+const FakeKernels FAKE_KERNELS[] = {
+    {"wide", []() { return 3; }, []() { return false; }},
+    {"narrow", []() { return 2; }, []() { return true; }},
+    {"scalar", []() { return 1; }, []() { return true; }},
+};
+
+} // namespace
+
+TEST(kernel_dispatch, picks_fastest_supported) {
+  KernelTable<FakeKernels> kernels(FAKE_KERNELS);
+  EXPECT_STREQ("narrow", kernels.name());
+  EXPECT_EQ(2, kernels->value_());
+  EXPECT_TRUE(kernels.select("scalar"));
+  EXPECT_EQ(1, kernels->value_());
+  // unsupported or unknown kernels keep the current ones
+  EXPECT_FALSE(kernels.select("wide"));
+  EXPECT_FALSE(kernels.select("sse9"));
+  EXPECT_STREQ("scalar", kernels.name());
+}
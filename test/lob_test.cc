@@ -0,0 +1,258 @@
+#include "lob.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+using test_util::mach_write_to_1;
+using test_util::mach_write_to_4;
+using test_util::mach_write_to_8;
+
+namespace {
+
+std::string lob_value(size_t len) {
+  std::string v(len, 0);
+  for (size_t i = 0; i < len; ++i)
+    v[i] = 'a' + i * 7 % 26;
+  return v;
+}
+
+LobRef make_ref(uint32_t page_no, uint32_t offset, uint32_t len) {
+  unsigned char ref[LobRef::BTR_EXTERN_FIELD_REF_SIZE] = {};
+  mach_write_to_4(ref, 1);
+  mach_write_to_4(ref + LobRef::BTR_EXTERN_PAGE_NO, page_no);
+  mach_write_to_4(ref + LobRef::BTR_EXTERN_OFFSET, offset);
+  mach_write_to_8(ref + LobRef::BTR_EXTERN_LEN, len);
+  ref[LobRef::BTR_EXTERN_LEN] = LobRef::BTR_EXTERN_OWNER_FLAG;
+  return LobRef::parse(reinterpret_cast<const byte *>(ref));
+}
+
+/// @brief a BLOB chain of 5.7 over the pages, one part of the value each
+void init_blob_chain(test_util::SpaceBuilder &builder,
+                     const std::vector<uint32_t> &pages,
+                     const std::vector<std::string> &parts) {
+  for (size_t i = 0; i < pages.size(); ++i) {
+    builder.init_fil_header(pages[i], FIL_PAGE_TYPE_BLOB);
+    unsigned char *hdr = builder.page(pages[i]) + FILHeader::FIL_PAGE_DATA;
+    mach_write_to_4(hdr + BlobPage::BTR_BLOB_HDR_PART_LEN, parts[i].size());
+    mach_write_to_4(hdr + BlobPage::BTR_BLOB_HDR_NEXT_PAGE_NO,
+                    i + 1 < pages.size() ? pages[i + 1] : UINT32_MAX);
+    memcpy(hdr + BlobPage::BTR_BLOB_HDR_SIZE, parts[i].data(),
+           parts[i].size());
+  }
+}
+
+/// @brief a LOB of 8.0 with the first part on the first page and the
+/// others on the data pages, the index entries all on the first page
+void init_lob(test_util::SpaceBuilder &builder, uint32_t first,
+              const std::vector<uint32_t> &data_pages,
+              const std::vector<std::string> &parts) {
+  builder.init_fil_header(first, FIL_PAGE_TYPE_LOB_FIRST);
+  unsigned char *pg = builder.page(first);
+  LobFirstPageView view(reinterpret_cast<const byte *>(pg));
+  mach_write_to_1(pg + LobFirstPageView::OFFSET_VERSION, 0);
+  mach_write_to_4(pg + LobFirstPageView::OFFSET_DATA_LEN, parts[0].size());
+  memcpy(pg + view.data_offset(), parts[0].data(), parts[0].size());
+
+  unsigned char *list = pg + LobFirstPageView::OFFSET_INDEX_LIST;
+  mach_write_to_4(list, parts.size());
+  test_util::SpaceBuilder::write_addr(list + 4, first,
+                                      LobFirstPageView::LOB_PAGE_DATA);
+  for (size_t i = 0; i < parts.size(); ++i) {
+    uint16_t offset = LobFirstPageView::LOB_PAGE_DATA +
+                      i * LobIndexEntryView::SIZE;
+    unsigned char *e = pg + offset;
+    if (i + 1 < parts.size())
+      test_util::SpaceBuilder::write_addr(
+          e + LobIndexEntryView::OFFSET_NEXT, first,
+          offset + LobIndexEntryView::SIZE);
+    else
+      test_util::SpaceBuilder::write_addr(
+          e + LobIndexEntryView::OFFSET_NEXT, UINT32_MAX, 0);
+    uint32_t page_no = i == 0 ? first : data_pages[i - 1];
+    mach_write_to_4(e + LobIndexEntryView::OFFSET_PAGE_NO, page_no);
+    mach_write_to_4(e + LobIndexEntryView::OFFSET_DATA_LEN, parts[i].size());
+    mach_write_to_4(e + LobIndexEntryView::OFFSET_LOB_VERSION, 1);
+    if (i == 0)
+      continue;
+    builder.init_fil_header(page_no, FIL_PAGE_TYPE_LOB_DATA);
+    unsigned char *d = builder.page(page_no);
+    mach_write_to_4(d + LobDataPageView::OFFSET_DATA_LEN, parts[i].size());
+    memcpy(d + LobDataPageView::LOB_PAGE_DATA, parts[i].data(),
+           parts[i].size());
+  }
+}
+
+std::vector<std::string> split(const std::string &v,
+                               const std::vector<size_t> &lens) {
+  std::vector<std::string> parts;
+  size_t pos = 0;
+  for (size_t len : lens) {
+    parts.push_back(v.substr(pos, len));
+    pos += len;
+  }
+  return parts;
+}
+
+} // namespace
+
+TEST(lob, blob_chain) {
+  const std::string value = lob_value(40000);
+  auto parts = split(value, {16000, 16000, 8000});
+  test_util::SpaceBuilder builder(8);
+  builder.init_fsp_header_page();
+  // not in page order, the chain decides
+  init_blob_chain(builder, {5, 2, 6}, parts);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader reader(file.c_str());
+
+  LobRef ref = make_ref(5, FILHeader::FIL_PAGE_DATA, value.size());
+  EXPECT_FALSE(ref.is_zero());
+  LobStream stream(&reader, ref);
+  std::string_view part;
+  size_t n = 0;
+  while (stream.next(part)) {
+    ASSERT_LT(n, parts.size());
+    EXPECT_EQ(parts[n], part);
+    ++n;
+  }
+  EXPECT_FALSE(stream.failed());
+  EXPECT_EQ(3u, n);
+  EXPECT_EQ(value.size(), stream.offset());
+  EXPECT_EQ(3u, stream.pages_read());
+
+  std::string out = "x";
+  ASSERT_TRUE(LobStream::read(&reader, ref, out));
+  EXPECT_EQ("x" + value, out);
+  // too long for the caller
+  out.clear();
+  EXPECT_FALSE(LobStream::read(&reader, ref, out, value.size() - 1));
+  // the reference is longer than the chain
+  EXPECT_FALSE(
+      LobStream::read(&reader, make_ref(5, FILHeader::FIL_PAGE_DATA,
+                                        value.size() + 1), out));
+  // a shorter one stops early, the last part would overflow it
+  out.clear();
+  EXPECT_FALSE(LobStream::read(
+      &reader, make_ref(5, FILHeader::FIL_PAGE_DATA, 20000), out));
+  // the chain doesn't start on a BLOB page
+  EXPECT_FALSE(LobStream::read(
+      &reader, make_ref(1, FILHeader::FIL_PAGE_DATA, value.size()), out));
+  unlink(file.c_str());
+}
+
+TEST(lob, broken_chains) {
+  const std::string value = lob_value(20000);
+  auto parts = split(value, {10000, 10000});
+  test_util::SpaceBuilder builder(8);
+  builder.init_fsp_header_page();
+  init_blob_chain(builder, {2, 3}, parts);
+  // a loop, 4 -> 5 -> 4
+  init_blob_chain(builder, {4, 5}, parts);
+  mach_write_to_4(builder.page(5) + FILHeader::FIL_PAGE_DATA +
+                      BlobPage::BTR_BLOB_HDR_NEXT_PAGE_NO,
+                  4);
+  builder.init_fil_header(6, FIL_PAGE_TYPE_ZLOB_FIRST);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader reader(file.c_str());
+
+  std::string out;
+  EXPECT_TRUE(LobStream::read(
+      &reader, make_ref(2, FILHeader::FIL_PAGE_DATA, value.size()), out));
+  // the second page of the chain isn't a BLOB page anymore
+  builder.init_fil_header(3, FIL_PAGE_INDEX);
+  ASSERT_TRUE(builder.write_file(file));
+  FileSpaceReader changed(file.c_str());
+  out.clear();
+  EXPECT_FALSE(LobStream::read(
+      &changed, make_ref(2, FILHeader::FIL_PAGE_DATA, value.size()), out));
+
+  LobStream loop(&changed,
+                 make_ref(4, FILHeader::FIL_PAGE_DATA, UINT32_MAX));
+  std::string_view part;
+  while (loop.next(part))
+    ;
+  EXPECT_TRUE(loop.failed());
+  EXPECT_LE(loop.pages_read(), changed.get_page_count());
+
+  LobStream zlob(&changed, make_ref(6, 0, 100));
+  EXPECT_FALSE(zlob.next(part));
+  EXPECT_TRUE(zlob.failed());
+  unlink(file.c_str());
+
+  // BLOB pages pointing to themselves, the next part is on the pinned page
+  test_util::SpaceBuilder loops(8);
+  loops.init_fsp_header_page();
+  init_blob_chain(loops, {2}, {""});
+  mach_write_to_4(loops.page(2) + FILHeader::FIL_PAGE_DATA +
+                      BlobPage::BTR_BLOB_HDR_NEXT_PAGE_NO,
+                  2);
+  init_blob_chain(loops, {3}, {lob_value(100)});
+  mach_write_to_4(loops.page(3) + FILHeader::FIL_PAGE_DATA +
+                      BlobPage::BTR_BLOB_HDR_NEXT_PAGE_NO,
+                  3);
+  // a LOB index entry of no data pointing to itself
+  init_lob(loops, 4, {}, {""});
+  unsigned char *entry = loops.page(4) + LobFirstPageView::LOB_PAGE_DATA;
+  test_util::SpaceBuilder::write_addr(entry + LobIndexEntryView::OFFSET_NEXT,
+                                      4, LobFirstPageView::LOB_PAGE_DATA);
+  file = loops.write_file();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader looped(file.c_str());
+  const LobRef refs[] = {make_ref(2, FILHeader::FIL_PAGE_DATA, 100),
+                         make_ref(3, FILHeader::FIL_PAGE_DATA, UINT32_MAX),
+                         make_ref(4, 1, 100)};
+  for (const LobRef &ref : refs) {
+    LobStream stream(&looped, ref);
+    uint32_t n = 0;
+    while (stream.next(part))
+      ++n;
+    EXPECT_TRUE(stream.failed());
+    EXPECT_LE(n, looped.get_page_count());
+  }
+  unlink(file.c_str());
+}
+
+TEST(lob, lob_index_entries) {
+  LobFirstPageView probe(nullptr);
+  const std::string value = lob_value(probe.max_data_len() + 30000);
+  auto parts = split(value, {probe.max_data_len(), 16000, 14000});
+  test_util::SpaceBuilder builder(8);
+  builder.init_fsp_header_page();
+  init_lob(builder, 3, {6, 4}, parts);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader reader(file.c_str());
+
+  auto first = reader.fetch_page(3);
+  ASSERT_TRUE(first);
+  EXPECT_EQ(3u, first.as<LobFirstPageView>().index_list_len());
+  EXPECT_EQ(parts[0].size(), first.as<LobFirstPageView>().data_len());
+
+  // the LOB version is in the offset field of the reference
+  LobRef ref = make_ref(3, 1, value.size());
+  LobStream stream(&reader, ref);
+  std::string_view part;
+  size_t n = 0;
+  while (stream.next(part)) {
+    ASSERT_LT(n, parts.size());
+    EXPECT_EQ(parts[n], part);
+    ++n;
+  }
+  EXPECT_FALSE(stream.failed());
+  EXPECT_EQ(3u, n);
+  // the first page is read once for its entries and its part
+  EXPECT_EQ(3u, stream.pages_read());
+
+  std::string out;
+  ASSERT_TRUE(LobStream::read(&reader, ref, out));
+  EXPECT_EQ(value, out);
+  // a data page of another type
+  builder.init_fil_header(4, FIL_PAGE_TYPE_BLOB);
+  ASSERT_TRUE(builder.write_file(file));
+  FileSpaceReader changed(file.c_str());
+  out.clear();
+  EXPECT_FALSE(LobStream::read(&changed, ref, out));
+  unlink(file.c_str());
+}
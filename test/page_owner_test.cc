@@ -0,0 +1,114 @@
+#include "page_owner.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+using test_util::mach_write_to_4;
+using test_util::mach_write_to_8;
+
+namespace {
+
+const uint32_t INODE_PAGE = 2;
+
+/// @brief a used inode at the index of the inode page
+unsigned char *init_inode(test_util::SpaceBuilder &builder, uint32_t index,
+                          uint64_t seg_id,
+                          const std::vector<uint32_t> &frag_pages) {
+  unsigned char *e =
+      builder.page(INODE_PAGE) + INodePageView::inode_entry_offset(index);
+  mach_write_to_8(e + INodeEntryView::FSEG_ID, seg_id);
+  for (auto off : {INodeEntryView::FSEG_FREE, INodeEntryView::FSEG_NOT_FULL,
+                   INodeEntryView::FSEG_FULL})
+    test_util::SpaceBuilder::init_empty_list(e + off);
+  mach_write_to_4(e + INode_E::MAGIC_NUMBER_OFFSET, INode_E::MAGIC_NUMBER);
+  memset(e + INodeEntryView::FSEG_FRAG_ARR, 0xff,
+         INode_E::FRAG_ARRAY_SIZE * 4);
+  for (size_t i = 0; i < frag_pages.size(); ++i)
+    mach_write_to_4(e + INodeEntryView::FSEG_FRAG_ARR + i * 4,
+                    frag_pages[i]);
+  return e;
+}
+
+} // namespace
+
+TEST(page_owner, segments_of_an_index) {
+  const uint32_t n_pages = 5 * XDES_E::PAGES_PER_EXTENT;
+  test_util::SpaceBuilder builder(n_pages);
+  builder.init_fsp_header_page();
+  unsigned char *fsp = builder.page(0) + FSPHeader::FSP_HEADER_OFFSET;
+  builder.init_xdes_list(fsp + FSPHeader::FSP_FREE_FRAG_LIST_BASE_NODE, {0},
+                         0, XDesEntryView::XDES_FREE_FRAG);
+
+  // one inode page with the two segments of index 100 and a segment no
+  // index root points to
+  builder.init_fil_header(INODE_PAGE, FIL_PAGE_TYPE_INODE);
+  unsigned char *inodes = fsp + FSPHeader::FSP_FREE_INODES_LIST_BASE_NODE;
+  mach_write_to_4(inodes, 1);
+  mach_write_to_4(inodes + 4, INODE_PAGE);
+  test_util::mach_write_to_2(inodes + 8, FILHeader::FIL_PAGE_DATA);
+  test_util::SpaceBuilder::write_addr(
+      builder.page(INODE_PAGE) + FILHeader::FIL_PAGE_DATA + 6, UINT32_MAX, 0);
+  init_inode(builder, 0, 11, {3});
+  unsigned char *leaf = init_inode(builder, 1, 12, {4, 5});
+  builder.init_xdes_list(leaf + INodeEntryView::FSEG_FULL, {2}, 12,
+                         XDesEntryView::XDES_FSEG);
+  builder.init_xdes_list(leaf + INodeEntryView::FSEG_NOT_FULL, {3}, 12,
+                         XDesEntryView::XDES_FSEG);
+  // page 5 is claimed twice
+  unsigned char *other = init_inode(builder, 2, 13, {6, 5});
+  builder.init_xdes_list(other + INodeEntryView::FSEG_FREE, {4}, 13,
+                         XDesEntryView::XDES_FSEG);
+
+  // the root points to the inodes of its segments
+  builder.init_index_page(3, 100, 1, {});
+  unsigned char *seg_hdr = builder.page(3) + PAGE_HEADER + PAGE_BTR_SEG_LEAF;
+  mach_write_to_4(seg_hdr + FSEG_HEADER::FSEG_HDR_LEAF_PAGE_NO, INODE_PAGE);
+  test_util::mach_write_to_2(seg_hdr + FSEG_HEADER::FSEG_HDR_LEAF_OFFSET,
+                             INodePageView::inode_entry_offset(1));
+  mach_write_to_4(seg_hdr + FSEG_HEADER::FSEG_HDR_INTERNAL_PAGE_NO,
+                  INODE_PAGE);
+  test_util::mach_write_to_2(seg_hdr + FSEG_HEADER::FSEG_HDR_INTERNAL_OFFSET,
+                             INodePageView::inode_entry_offset(0));
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str());
+  PageOwnerIndex index;
+  ASSERT_TRUE(index.build(&reader));
+  ASSERT_EQ(3u, index.segments().size());
+  EXPECT_EQ(1u, index.conflicts());
+
+  const SegmentOwner *top = index.owner(3);
+  ASSERT_NE(nullptr, top);
+  EXPECT_EQ(11u, top->seg_id_);
+  EXPECT_EQ(SegmentRole::NON_LEAF, top->role_);
+  EXPECT_EQ(100u, top->index_id_);
+  EXPECT_EQ(3u, top->root_page_no_);
+
+  const SegmentOwner *leaves = index.find_segment(12);
+  ASSERT_NE(nullptr, leaves);
+  EXPECT_EQ(SegmentRole::LEAF, leaves->role_);
+  EXPECT_EQ(100u, leaves->index_id_);
+  EXPECT_EQ(2u, leaves->n_extents_);
+  EXPECT_EQ(2u, leaves->n_frag_pages_);
+  EXPECT_EQ(leaves, index.owner(4));
+  EXPECT_EQ(leaves, index.owner(5));
+  EXPECT_EQ(leaves, index.owner(2 * XDES_E::PAGES_PER_EXTENT + 10));
+  EXPECT_EQ(leaves, index.owner(4 * XDES_E::PAGES_PER_EXTENT - 1));
+  EXPECT_EQ(100u, index.index_id(3 * XDES_E::PAGES_PER_EXTENT));
+
+  const SegmentOwner *unknown = index.owner(6);
+  ASSERT_NE(nullptr, unknown);
+  EXPECT_EQ(13u, unknown->seg_id_);
+  EXPECT_EQ(SegmentRole::UNKNOWN, unknown->role_);
+  EXPECT_EQ(1u, unknown->n_frag_pages_);
+  EXPECT_EQ(unknown, index.owner(5 * XDES_E::PAGES_PER_EXTENT - 1));
+  EXPECT_EQ(0u, index.index_id(6));
+
+  // the pages of the fragment extent no segment holds and past the end
+  EXPECT_EQ(nullptr, index.owner(0));
+  EXPECT_EQ(nullptr, index.owner(7));
+  EXPECT_EQ(nullptr, index.owner(n_pages));
+  EXPECT_EQ(nullptr, index.find_segment(99));
+  unlink(file.c_str());
+}
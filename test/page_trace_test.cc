@@ -0,0 +1,95 @@
+#include "page_trace.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+
+TEST(page_trace, record_and_replay) {
+  test_util::SpaceBuilder builder(16);
+  builder.init_fsp_header_page();
+  for (uint32_t i = 1; i < 16; ++i)
+    builder.init_fil_header(i, FIL_PAGE_IBUF_BITMAP);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  PageTrace trace(6);
+  EXPECT_EQ(8u, trace.capacity());
+  {
+    FileSpaceReader reader(file.c_str());
+    reader.set_trace(&trace);
+    for (uint32_t page_no : {1, 2, 1, 3})
+      ASSERT_TRUE(reader.fetch_page(page_no));
+    EXPECT_EQ(nullptr, reader.get_page(16));
+    reader.set_trace(nullptr);
+    reader.fetch_page(4);
+  }
+  auto accesses = trace.snapshot();
+  ASSERT_EQ(5u, accesses.size());
+  EXPECT_EQ(2u, accesses[1].page_no_);
+  EXPECT_FALSE(accesses[1].hit());
+  EXPECT_TRUE(accesses[2].hit());
+  EXPECT_FALSE(accesses[2].error());
+  EXPECT_EQ(16u, accesses[4].page_no_);
+  EXPECT_TRUE(accesses[4].error());
+  EXPECT_EQ(PageAccess::MAX_LATENCY_NS,
+            PageAccess(1, true, false, UINT64_MAX).latency_ns());
+
+  // the oldest accesses are overwritten
+  for (uint32_t i = 0; i < 5; ++i)
+    trace.record(PageAccess(5 + i, false, false, 100));
+  EXPECT_EQ(10u, trace.recorded());
+  EXPECT_EQ(2u, trace.dropped());
+  accesses = trace.snapshot();
+  ASSERT_EQ(8u, accesses.size());
+  EXPECT_EQ(1u, accesses[0].page_no_);
+  EXPECT_EQ(9u, accesses[7].page_no_);
+  EXPECT_EQ(100u, accesses[7].latency_ns());
+
+  const std::string trace_file = file + ".trace";
+  ASSERT_TRUE(trace.save(trace_file, PAGE_SIZE));
+  PageTraceFile loaded;
+  ASSERT_TRUE(loaded.load(trace_file));
+  EXPECT_EQ(PAGE_SIZE, loaded.page_size_);
+  ASSERT_EQ(8u, loaded.accesses_.size());
+  EXPECT_EQ(accesses[3].pack(), loaded.accesses_[3].pack());
+  EXPECT_FALSE(PageTraceFile().load(file));
+  unlink(trace_file.c_str());
+  EXPECT_TRUE(PageTraceReplayer(file, loaded).replay({}).valid_);
+  // a trace of another page size
+  loaded.page_size_ = 8192;
+  auto other = PageTraceReplayer(file, loaded).replay({});
+  EXPECT_FALSE(other.valid_);
+  EXPECT_EQ(0u, other.accesses_);
+
+  // a leaf scan of pages 1 to 15
+  std::vector<PageAccess> scan;
+  for (uint32_t i = 1; i < 16; ++i)
+    scan.emplace_back(i, false, false, 0);
+  PageTraceReplayer replayer(file, scan);
+  ReplayConfig no_readahead;
+  ReplayConfig readahead;
+  readahead.readahead_pages_ = 8;
+  auto results = replayer.replay_all({no_readahead, readahead});
+  ASSERT_EQ(2u, results.size());
+  EXPECT_TRUE(results[0].valid_);
+  EXPECT_EQ(15u, results[0].accesses_);
+  EXPECT_EQ(15u, results[0].misses_);
+  EXPECT_EQ(0u, results[0].errors_);
+  // pages 1 to 8, then 9 to 15 in one read each
+  EXPECT_EQ(2u, results[1].misses_);
+  EXPECT_EQ(13u, results[1].hits_);
+  EXPECT_EQ(0u, results[1].wasted_pages_);
+
+  // the readahead of jumps reads pages never used
+  PageTraceReplayer jumps(file, {PageAccess(1, false, false, 0),
+                                 PageAccess(9, false, false, 0),
+                                 PageAccess(3, false, false, 0)});
+  readahead.readahead_pages_ = 4;
+  auto r = jumps.replay(readahead);
+  EXPECT_EQ(2u, r.misses_);
+  EXPECT_EQ(5u, r.wasted_pages_);
+  std::ostringstream oss;
+  r.dump(oss);
+  EXPECT_NE(std::string::npos, oss.str().find("readahead: 4"));
+  unlink(file.c_str());
+}
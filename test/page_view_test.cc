@@ -0,0 +1,126 @@
+#include "file_space_reader.h"
+#include "page_view.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+using namespace test_util;
+
+TEST(page_view, xdes_entry_bits) {
+  SpaceBuilder builder(2 * XDES_E::PAGES_PER_EXTENT);
+  builder.init_fsp_header_page();
+  unsigned char *fsp = builder.page(0) + FSPHeader::FSP_HEADER_OFFSET;
+  builder.init_xdes_list(fsp + FSPHeader::FSP_FREE_FRAG_LIST_BASE_NODE, {1},
+                         7, 2 /*XDES_FREE_FRAG*/);
+  auto addr = builder.xdes_addr(1);
+  // page 1 of the extent is used, page 2 used and not clean
+  unsigned char *bitmap =
+      builder.page(0) + addr.offset_ + XDesEntryView::XDES_BITMAP;
+  bitmap[0] = 0xff & ~(1 << 2) & ~(3 << 4);
+
+  FSPHeaderPageView view((const byte *)builder.page(0));
+  EXPECT_EQ(builder.n_pages(), view.fsp_size());
+  EXPECT_EQ(1u, view.free_frag_list().list_length_);
+  auto entry = view.xdes_entry(1);
+  EXPECT_EQ(7u, entry.seg_id());
+  EXPECT_EQ(2u, entry.state());
+  EXPECT_FALSE(entry.next().valid());
+  EXPECT_TRUE(entry.is_page_free(0));
+  EXPECT_FALSE(entry.is_page_free(1));
+  EXPECT_TRUE(entry.is_page_clean(1));
+  EXPECT_FALSE(entry.is_page_free(2));
+  EXPECT_FALSE(entry.is_page_clean(2));
+  EXPECT_TRUE(entry.is_page_free(63));
+  // the decoded copy reads the same bits
+  XDES_E decoded = entry.decode();
+  EXPECT_TRUE(decoded.is_page_free(0));
+  EXPECT_FALSE(decoded.is_page_free(1));
+  EXPECT_FALSE(decoded.is_page_free(2));
+  EXPECT_TRUE(decoded.is_page_free(3));
+  EXPECT_TRUE(decoded.is_page_free(63));
+  EXPECT_FALSE(decoded.is_page_free(64));
+}
+
+TEST(page_view, guard_builds_page_on_demand) {
+  SpaceBuilder builder(4);
+  builder.init_fsp_header_page();
+  builder.init_fil_header(1, FIL_PAGE_IBUF_BITMAP);
+  // page 4 has free space level 1 and buffered changes, page 5 level 2,
+  // the first bit of the level is its high bit
+  builder.page(1)[IBufBitMapPageView::IBUF_BITMAP + 2] = 0x16;
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str());
+  auto guard = reader.fetch_page(1);
+  ASSERT_TRUE(guard);
+  auto view = guard.as<IBufBitMapPageView>();
+  EXPECT_EQ(1u, view.page_no());
+  EXPECT_EQ(FIL_PAGE_IBUF_BITMAP, view.page_type());
+  EXPECT_EQ(1u, view.free_space(4));
+  EXPECT_TRUE(view.buffered(4));
+  EXPECT_EQ(2u, view.free_space(5));
+  EXPECT_FALSE(view.buffered(5));
+  EXPECT_EQ(0u, view.free_space(6));
+
+  auto *page = static_cast<IBufBitMapPage *>(guard.get());
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(PageType::IBUF_BITMAP, page->get_type());
+  EXPECT_EQ(1, page->bitmap(4).free_space);
+  EXPECT_EQ(1, page->bitmap(4).buffered_flag);
+  EXPECT_EQ(2, page->bitmap(5).free_space);
+  EXPECT_EQ(0, page->bitmap(5).change_buf_fg);
+  EXPECT_LT(sizeof(IBufBitMapPage), 1024u);
+  unlink(file.c_str());
+}
+
+TEST(page_view, record_iterator) {
+  SpaceBuilder builder(4);
+  builder.init_fsp_header_page();
+  std::vector<TestRecord> recs;
+  for (uint32_t i = 0; i < 10; ++i) {
+    TestRecord r;
+    r.data_.resize(4 + i);
+    test_util::mach_write_to_4(r.data_.data(), i);
+    if (i == 3)
+      r.info_bits_ = RecordHeader::REC_INFO_DELETED_FLAG;
+    recs.push_back(r);
+  }
+  auto offsets = builder.init_index_page(3, 42, 0, recs);
+
+  IndexPageView view((const byte *)builder.page(3));
+  EXPECT_EQ(42u, view.index_id());
+  EXPECT_EQ(10u, view.n_recs());
+  uint32_t n = 0;
+  auto range = view.records();
+  for (auto it = range.begin(); it != range.end(); ++it, ++n) {
+    const RecordView &rec = *it;
+    ASSERT_LT(n, offsets.size());
+    EXPECT_EQ(offsets[n], rec.offset());
+    EXPECT_EQ(n, mach_read_from_4(rec.data()));
+    EXPECT_EQ(n + 2, rec.heap_no());
+    EXPECT_EQ(REC_STATUS_ORDINARY, rec.status());
+    EXPECT_EQ(n == 3, rec.is_deleted());
+    EXPECT_EQ(n % 4 == 3 && n < 8 ? 4u : 0u, rec.n_owned());
+    EXPECT_FALSE(it.broken());
+  }
+  EXPECT_EQ(10u, n);
+
+  // a runtime page size goes through for_each_record
+  n = 0;
+  view.for_each_record([&](const RecordView &rec) {
+    EXPECT_TRUE(rec.is_user_rec());
+    ++n;
+  });
+  EXPECT_EQ(10u, n);
+
+  // a next pointer into the page header ends the walk
+  test_util::mach_write_to_2(builder.page(3) + offsets[5] - 2,
+                             (uint16_t)(30 - offsets[5]));
+  n = 0;
+  auto it = range.begin();
+  for (; it != range.end(); ++it)
+    ++n;
+  EXPECT_EQ(6u, n);
+  EXPECT_TRUE(it.broken());
+}
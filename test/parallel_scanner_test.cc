@@ -0,0 +1,57 @@
+#include "parallel_scanner.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <map>
+
+using namespace innodb;
+
+TEST(parallel_scanner, page_type_histogram) {
+  const uint32_t n_pages = 5 * XDES_E::PAGES_PER_EXTENT + 7;
+  test_util::SpaceBuilder builder(n_pages);
+  builder.init_fsp_header_page();
+  for (uint32_t i = 1; i < n_pages; i += 3)
+    builder.init_fil_header(i, FIL_PAGE_INDEX);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  // the cache is smaller than the space, pages are evicted while scanning
+  FileSpaceReader reader(file.c_str(), ReadMode::PREAD, 64 * PAGE_SIZE);
+  ParallelScanner scanner(&reader, 4);
+  scanner.set_unit_pages(16);
+  using Histogram = std::map<uint16_t, uint32_t>;
+  auto histogram = scanner.scan<Histogram>(
+      [](Histogram &h, uint32_t page_no, const PageGuard &pg) {
+        EXPECT_EQ(page_no, pg.as<PageView>().page_no());
+        ++h[pg.as<PageView>().page_type()];
+      },
+      [](Histogram &into, Histogram &from) {
+        for (auto &it : from)
+          into[it.first] += it.second;
+      });
+  EXPECT_EQ(n_pages, scanner.pages_scanned());
+  EXPECT_EQ(0u, scanner.page_errors());
+  EXPECT_EQ(1u, histogram[FIL_PAGE_TYPE_FSP_HDR]);
+  EXPECT_EQ((n_pages + 1) / 3, histogram[FIL_PAGE_INDEX]);
+  EXPECT_EQ(n_pages - 1 - (n_pages + 1) / 3,
+            histogram[FIL_PAGE_TYPE_ALOCATED]);
+
+  // a sub range, clamped to the end of the space
+  std::atomic<uint32_t> n{0};
+  scanner.for_each_page([&](uint32_t, const PageGuard &) { ++n; },
+                        n_pages - 10, 100);
+  EXPECT_EQ(10u, n.load());
+  unlink(file.c_str());
+}
+
+TEST(parallel_scanner, parallel_for) {
+  std::vector<std::atomic<uint32_t>> calls(1000);
+  parallel_for(calls.size(), 4, [&](size_t i) { ++calls[i]; });
+  for (auto &n : calls)
+    EXPECT_EQ(1u, n.load());
+  // more threads than items, and no item
+  std::vector<uint32_t> one(1);
+  parallel_for(one.size(), 0, [&](size_t i) { ++one[i]; });
+  EXPECT_EQ(1u, one[0]);
+  parallel_for(0, 4, [](size_t) { FAIL(); });
+}
@@ -0,0 +1,41 @@
+#include "file_space_reader.h"
+#include "prefetcher.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+
+TEST(prefetcher, xdes_list_extents) {
+  test_util::SpaceBuilder builder(3 * XDES_E::PAGES_PER_EXTENT);
+  builder.init_fsp_header_page();
+  unsigned char *fsp = builder.page(0) + FSPHeader::FSP_HEADER_OFFSET;
+  builder.init_xdes_list(fsp + FSPHeader::FSP_FULL_FRAG_LIST_BASE_NODE, {1, 2},
+                         0, 3 /*XDES_FULL_FRAG*/);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  FileSpaceReader reader(file.c_str());
+  auto fsp_page = reader.fetch_page(0);
+  ASSERT_TRUE(fsp_page);
+  const XDesEntryList &header = static_cast<FSPHeaderPage *>(fsp_page.get())
+                                    ->fsp_header_.full_frag_list_base_node_;
+  ASSERT_EQ(2u, header.list_length_);
+  {
+    Prefetcher prefetcher(&reader, 2);
+    prefetcher.prefetch_xdes_list(header);
+    prefetcher.wait();
+    EXPECT_EQ(2 * XDES_E::PAGES_PER_EXTENT, prefetcher.pages_read());
+    // both extents are adjacent, one coalesced read
+    EXPECT_EQ(1u, prefetcher.batches());
+  }
+  const auto &cache = reader.get_page_cache();
+  auto misses = cache.misses();
+  for (uint32_t i = XDES_E::PAGES_PER_EXTENT;
+       i < 3 * XDES_E::PAGES_PER_EXTENT; ++i) {
+    auto pg = reader.fetch_page(i);
+    ASSERT_TRUE(pg);
+    EXPECT_EQ(i, pg->get_fil_header().page_number_offset_);
+  }
+  EXPECT_EQ(misses, cache.misses());
+  unlink(file.c_str());
+}
@@ -0,0 +1,130 @@
+#include "reclaim.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+using test_util::TestRecord;
+using test_util::mach_write_to_2;
+using test_util::mach_write_to_4;
+using test_util::mach_write_to_8;
+
+namespace {
+
+const uint32_t INODE_PAGE = 2;
+
+/// @brief mark the pages used in the bitmap of their extent
+void use_pages(test_util::SpaceBuilder &builder,
+               const std::vector<uint32_t> &pages) {
+  for (uint32_t page_no : pages) {
+    auto addr = builder.xdes_addr(page_no / XDES_E::PAGES_PER_EXTENT);
+    unsigned char *bitmap =
+        builder.page(addr.page_number_) + addr.offset_ + XDES_E::XDES_BITMAP;
+    uint32_t i = page_no % XDES_E::PAGES_PER_EXTENT;
+    bitmap[i / 4] &= ~(1 << (i % 4 * 2));
+  }
+}
+
+unsigned char *init_inode(test_util::SpaceBuilder &builder, uint32_t index,
+                          uint64_t seg_id,
+                          const std::vector<uint32_t> &frag_pages) {
+  unsigned char *e =
+      builder.page(INODE_PAGE) + INodePageView::inode_entry_offset(index);
+  mach_write_to_8(e + INodeEntryView::FSEG_ID, seg_id);
+  for (auto off : {INodeEntryView::FSEG_FREE, INodeEntryView::FSEG_NOT_FULL,
+                   INodeEntryView::FSEG_FULL})
+    test_util::SpaceBuilder::init_empty_list(e + off);
+  mach_write_to_4(e + INode_E::MAGIC_NUMBER_OFFSET, INode_E::MAGIC_NUMBER);
+  memset(e + INodeEntryView::FSEG_FRAG_ARR, 0xff,
+         INode_E::FRAG_ARRAY_SIZE * 4);
+  for (size_t i = 0; i < frag_pages.size(); ++i)
+    mach_write_to_4(e + INodeEntryView::FSEG_FRAG_ARR + i * 4,
+                    frag_pages[i]);
+  return e;
+}
+
+std::vector<TestRecord> records(size_t n, size_t size, uint8_t status) {
+  TestRecord r;
+  r.data_.assign(size, 'a');
+  r.status_ = status;
+  return std::vector<TestRecord>(n, r);
+}
+
+} // namespace
+
+TEST(reclaim, index_reclaim) {
+  test_util::SpaceBuilder builder(3 * XDES_E::PAGES_PER_EXTENT);
+  builder.init_fsp_header_page();
+  unsigned char *fsp = builder.page(0) + FSPHeader::FSP_HEADER_OFFSET;
+  builder.init_xdes_list(fsp + FSPHeader::FSP_FREE_FRAG_LIST_BASE_NODE, {0},
+                         0, XDesEntryView::XDES_FREE_FRAG);
+
+  // the inodes of index 100, the leaves hold an extent with 2 pages used
+  builder.init_fil_header(INODE_PAGE, FIL_PAGE_TYPE_INODE);
+  unsigned char *inodes = fsp + FSPHeader::FSP_FULL_INODES_LIST_BASE_NODE;
+  mach_write_to_4(inodes, 1);
+  mach_write_to_4(inodes + 4, INODE_PAGE);
+  mach_write_to_2(inodes + 8, FILHeader::FIL_PAGE_DATA);
+  test_util::SpaceBuilder::write_addr(
+      builder.page(INODE_PAGE) + FILHeader::FIL_PAGE_DATA + 6, UINT32_MAX, 0);
+  init_inode(builder, 0, 11, {3});
+  unsigned char *leaf = init_inode(builder, 1, 12, {4, 5});
+  builder.init_xdes_list(leaf + INodeEntryView::FSEG_NOT_FULL, {1}, 12,
+                         XDesEntryView::XDES_FSEG);
+  use_pages(builder, {0, 1, 2, 3, 4, 5, 64, 65});
+
+  builder.init_index_page(3, 100, 1, records(4, 12, REC_STATUS_NODE_PTR));
+  unsigned char *seg_hdr = builder.page(3) + PAGE_HEADER + PAGE_BTR_SEG_LEAF;
+  mach_write_to_4(seg_hdr + FSEG_HEADER::FSEG_HDR_LEAF_PAGE_NO, INODE_PAGE);
+  mach_write_to_2(seg_hdr + FSEG_HEADER::FSEG_HDR_LEAF_OFFSET,
+                  INodePageView::inode_entry_offset(1));
+  mach_write_to_4(seg_hdr + FSEG_HEADER::FSEG_HDR_INTERNAL_PAGE_NO,
+                  INODE_PAGE);
+  mach_write_to_2(seg_hdr + FSEG_HEADER::FSEG_HDR_INTERNAL_OFFSET,
+                  INodePageView::inode_entry_offset(0));
+  for (uint32_t page_no : {4, 5, 64, 65})
+    builder.init_index_page(page_no, 100, 0,
+                            records(4, 100, REC_STATUS_ORDINARY));
+  mach_write_to_2(builder.page(4) + PAGE_HEADER + IndexHeader::PAGE_DIRECTION,
+                  IndexPageView::PAGE_NO_DIRECTION);
+  mach_write_to_2(builder.page(5) + PAGE_HEADER + IndexHeader::PAGE_GARBAGE,
+                  100);
+  // freed, the old header is left behind
+  builder.init_index_page(66, 100, 0, records(4, 100, REC_STATUS_ORDINARY));
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  auto report = ReclaimReport::of_file(file, 2);
+  ASSERT_TRUE(report.valid_);
+  ASSERT_EQ(1u, report.indexes_.size());
+  const IndexReclaim *index = report.find_index(100);
+  ASSERT_NE(nullptr, index);
+  EXPECT_EQ(3u, index->root_page_no_);
+  EXPECT_EQ(4u, index->leaf_pages_);
+  EXPECT_EQ(1u, index->non_leaf_pages_);
+  EXPECT_EQ(16u, index->leaf_recs_);
+  EXPECT_EQ(4u, index->non_leaf_recs_);
+  EXPECT_EQ(4 * 4 * (100 + REC_N_EXTRA_BYTES) - 100u,
+            index->leaf_record_bytes_);
+  EXPECT_EQ(100u, index->garbage_bytes_);
+  EXPECT_EQ(1u, index->random_insert_leaves_);
+  EXPECT_EQ(XDES_E::PAGES_PER_EXTENT - 2u, index->free_extent_pages_);
+  // all the records fit in one page
+  EXPECT_EQ(1u, index->rebuilt_pages_);
+  EXPECT_EQ(4u + XDES_E::PAGES_PER_EXTENT - 2, index->reclaimable_pages());
+  EXPECT_EQ(index->reclaimable_pages() * PAGE_SIZE,
+            report.reclaimable_bytes());
+  EXPECT_EQ(nullptr, report.find_index(200));
+
+  EXPECT_FALSE(ReclaimReport::of_file(file, 2, 0).valid_);
+  unlink(file.c_str());
+}
+
+TEST(reclaim, rebuilt_level_pages) {
+  // 16256 usable bytes a page, 15240 at 15/16, and a slot every 4 records
+  EXPECT_EQ(6595u, ReclaimReport::rebuilt_level_pages(
+                       100000000, 1000000, PAGE_SIZE,
+                       ReclaimReport::DEFAULT_FILL_FACTOR));
+  EXPECT_EQ(1u, ReclaimReport::rebuilt_level_pages(
+                    10, 1, PAGE_SIZE, ReclaimReport::DEFAULT_FILL_FACTOR));
+  EXPECT_EQ(0u, ReclaimReport::rebuilt_level_pages(0, 0, PAGE_SIZE, 1));
+}
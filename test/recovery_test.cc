@@ -0,0 +1,210 @@
+#include "recovery.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <map>
+
+using namespace innodb;
+using test_util::TestRecord;
+
+namespace {
+
+/// id INT PRIMARY KEY, name VARCHAR(100) NULL
+TableSchema people_schema() {
+  return TableSchema::clustered(
+      21, {ColumnDef::make("id", ColumnType::INT, 4)},
+      {ColumnDef::make("name", ColumnType::VARBINARY, 400, true)});
+}
+
+std::string name_of(int id) { return "person " + std::to_string(id); }
+
+TestRecord person(int id) {
+  TestRecord r;
+  auto append = [&](const std::string &s) {
+    r.data_.insert(r.data_.end(), s.begin(), s.end());
+  };
+  append(encode_int(id, 4, false));
+  append(encode_int(500 + id, IndexDef::DATA_TRX_ID_LEN, true));
+  append(encode_int(id, IndexDef::DATA_ROLL_PTR_LEN, true));
+  append(name_of(id));
+  r.extra_ = {(unsigned char)name_of(id).size(), 0};
+  return r;
+}
+
+/// @brief a leaf of the ids, the records at the indexes in freed are moved
+/// from the record list to the PAGE_FREE list, in that order
+void init_leaf(test_util::SpaceBuilder &builder, uint32_t page_no,
+               uint64_t index_id, const std::vector<int> &ids,
+               const std::vector<int> &deleted,
+               const std::vector<size_t> &freed) {
+  using test_util::mach_write_to_2;
+  std::vector<TestRecord> recs;
+  for (int id : ids)
+    recs.push_back(person(id));
+  for (size_t i : deleted)
+    recs[i].info_bits_ = RecordHeader::REC_INFO_DELETED_FLAG;
+  auto offsets = builder.init_index_page(page_no, index_id, 0, recs);
+  unsigned char *pg = builder.page(page_no);
+  auto is_freed = [&](size_t i) {
+    return std::find(freed.begin(), freed.end(), i) != freed.end();
+  };
+  uint16_t prev = PAGE_NEW_INFIMUM;
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    if (is_freed(i))
+      continue;
+    mach_write_to_2(pg + prev - 2, (uint16_t)(offsets[i] - prev));
+    prev = offsets[i];
+  }
+  mach_write_to_2(pg + prev - 2, (uint16_t)(PAGE_NEW_SUPREMUM - prev));
+  unsigned char *h = pg + IndexHeader::PAGE_HEADER;
+  mach_write_to_2(h + IndexHeader::PAGE_N_RECS, ids.size() - freed.size());
+  mach_write_to_2(h + IndexHeader::PAGE_FREE,
+                  freed.empty() ? 0 : offsets[freed[0]]);
+  for (size_t n = 0; n < freed.size(); ++n) {
+    uint16_t off = offsets[freed[n]];
+    uint16_t next = n + 1 < freed.size() ? offsets[freed[n + 1]] : 0;
+    mach_write_to_2(pg + off - 2, next ? (uint16_t)(next - off) : 0);
+  }
+}
+
+} // namespace
+
+TEST(recovery, free_list_walk) {
+  test_util::SpaceBuilder builder(4);
+  init_leaf(builder, 3, 21, {1, 2, 3, 4, 5, 6}, {1, 4}, {4, 0});
+  IndexPageView page((const byte *)builder.page(3));
+  std::vector<uint16_t> seen;
+  page.for_each_free_record([&](const RecordView &rec) {
+    seen.push_back(rec.offset());
+    EXPECT_EQ(REC_STATUS_ORDINARY, rec.status());
+  });
+  ASSERT_EQ(2u, seen.size());
+  EXPECT_TRUE(RecordView(page.buf(), seen[0]).is_deleted());
+  EXPECT_FALSE(RecordView(page.buf(), seen[1]).is_deleted());
+  size_t n_recs = 0;
+  page.for_each_record([&](const RecordView &) { ++n_recs; });
+  EXPECT_EQ(4u, n_recs);
+
+  // a cycle ends the walk
+  test_util::mach_write_to_2(builder.page(3) + seen[1] - 2,
+                             (uint16_t)(seen[0] - seen[1]));
+  size_t n = 0;
+  page.for_each_free_record([&](const RecordView &) { ++n; });
+  EXPECT_LE(n, PAGE_SIZE / REC_N_EXTRA_BYTES);
+  // a pointer out of the heap too
+  test_util::mach_write_to_2(builder.page(3) + IndexHeader::PAGE_HEADER +
+                                 IndexHeader::PAGE_FREE,
+                             page.heap_top() + 10);
+  n = 0;
+  page.for_each_free_record([&](const RecordView &) { ++n; });
+  EXPECT_EQ(0u, n);
+}
+
+TEST(recovery, parallel_scan) {
+  const TableSchema schema = people_schema();
+  const uint32_t n_pages = 3 * XDES_E::PAGES_PER_EXTENT;
+  test_util::SpaceBuilder builder(n_pages);
+  builder.init_fsp_header_page();
+  // the first record of the heap is freed too
+  init_leaf(builder, 3, 21, {1, 2, 3, 4, 5}, {1}, {3, 0});
+  init_leaf(builder, 70, 21, {10, 11, 12, 13}, {0, 2}, {1, 3});
+  init_leaf(builder, 150, 21, {20, 21}, {}, {});
+  // another index and a non leaf page with deleted records
+  init_leaf(builder, 100, 22, {30, 31}, {0}, {1});
+  TestRecord upper = person(40);
+  upper.info_bits_ = RecordHeader::REC_INFO_DELETED_FLAG;
+  builder.init_index_page(120, 21, 1, {upper});
+  // a free record whose length runs past the heap is skipped
+  init_leaf(builder, 130, 21, {50, 51}, {}, {1});
+  unsigned char *bad = builder.page(130) +
+                       IndexPageView((const byte *)builder.page(130))
+                           .free_rec_offset() -
+                       REC_N_EXTRA_BYTES - 2;
+  bad[0] = 0xff; // the length byte
+  bad[1] = 0;    // the null bitmap
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader reader(file.c_str());
+
+  DeletedRecordScanner scanner(&reader, schema, 4);
+  scanner.set_batch_rows(2);
+  std::map<int, std::pair<RecoverySource, uint32_t>> found;
+  size_t n_batches = 0;
+  ASSERT_TRUE(scanner.scan([&](const RecoveredRows &rows) {
+    ++n_batches;
+    EXPECT_LE(rows.size(), 2u);
+    const auto &id = rows.batch_.columns_[0];
+    const auto &trx = rows.batch_.columns_[1];
+    const auto &name = rows.batch_.columns_[3];
+    for (size_t i = 0; i < rows.size(); ++i) {
+      EXPECT_EQ(500 + id.ints_[i], trx.ints_[i]);
+      EXPECT_EQ(name_of(id.ints_[i]), name.str(i));
+      EXPECT_TRUE(found
+                      .emplace(id.ints_[i], std::make_pair(rows.sources_[i],
+                                                           rows.page_nos_[i]))
+                      .second);
+    }
+  }));
+  std::map<int, std::pair<RecoverySource, uint32_t>> expected = {
+      {1, {RecoverySource::FREE_LIST, 3}},
+      {2, {RecoverySource::DELETE_MARKED, 3}},
+      {4, {RecoverySource::FREE_LIST, 3}},
+      {10, {RecoverySource::DELETE_MARKED, 70}},
+      {12, {RecoverySource::DELETE_MARKED, 70}},
+      {11, {RecoverySource::FREE_LIST, 70}},
+      {13, {RecoverySource::FREE_LIST, 70}}};
+  EXPECT_EQ(expected, found);
+  EXPECT_GE(n_batches, 3u);
+  EXPECT_EQ(n_pages, scanner.pages_scanned());
+  EXPECT_EQ(4u, scanner.leaves_scanned());
+  EXPECT_EQ(3u, scanner.delete_marked());
+  EXPECT_EQ(4u, scanner.free_list());
+  EXPECT_EQ(1u, scanner.bad_records());
+
+  // only the free lists
+  scanner.set_sources(false, true);
+  size_t n_rows = 0;
+  ASSERT_TRUE(scanner.scan(
+      [&](const RecoveredRows &rows) { n_rows += rows.size(); }));
+  EXPECT_EQ(4u, n_rows);
+  EXPECT_EQ(0u, scanner.delete_marked());
+  unlink(file.c_str());
+}
+
+TEST(recovery, low_free_offset_of_wide_table) {
+  // 100 nullable VARBINARY(400) columns, a record has up to 218 extra bytes
+  std::vector<ColumnDef> columns;
+  for (int i = 0; i < 100; ++i)
+    columns.push_back(ColumnDef::make("c" + std::to_string(i),
+                                      ColumnType::VARBINARY, 400, true));
+  const TableSchema schema = TableSchema::clustered(
+      23, {ColumnDef::make("id", ColumnType::INT, 4)}, columns);
+  EXPECT_EQ(REC_N_EXTRA_BYTES + 13u + 200,
+            RecOffsets::max_extra_size(schema.index_def()));
+
+  test_util::SpaceBuilder builder(4);
+  builder.init_fsp_header_page();
+  builder.init_index_page(3, 23, 0, {});
+  // a free list pointing right after the supremum, its null bitmap and
+  // lengths would be read before the page
+  unsigned char *pg = builder.page(3);
+  const uint16_t garbage = PAGE_NEW_SUPREMUM_END + REC_N_EXTRA_BYTES;
+  unsigned char *h = pg + IndexHeader::PAGE_HEADER;
+  test_util::mach_write_to_2(h + IndexHeader::PAGE_FREE, garbage);
+  test_util::mach_write_to_2(h + IndexHeader::PAGE_HEAP_TOP, garbage + 300);
+  test_util::mach_write_to_2(pg + garbage - 2, 0);
+  pg[garbage - 3] = REC_STATUS_ORDINARY;
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+  FileSpaceReader reader(file.c_str());
+
+  DeletedRecordScanner scanner(&reader, schema, 1);
+  size_t n_rows = 0;
+  ASSERT_TRUE(scanner.scan(
+      [&](const RecoveredRows &rows) { n_rows += rows.size(); }));
+  EXPECT_EQ(0u, n_rows);
+  EXPECT_EQ(1u, scanner.leaves_scanned());
+  EXPECT_EQ(0u, scanner.free_list());
+  EXPECT_EQ(1u, scanner.bad_records());
+  unlink(file.c_str());
+}
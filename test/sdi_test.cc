@@ -0,0 +1,167 @@
+#include "json.h"
+#include "sdi.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+
+using namespace innodb;
+using test_util::TestRecord;
+
+namespace {
+
+/// CREATE TABLE t1 (id INT PRIMARY KEY, name VARCHAR(100)) utf8mb4
+const char *T1_SDI = R"sdi({
+  "mysqld_version_id": 80032, "dd_version": 80023, "sdi_version": 80019,
+  "dd_object_type": "Table",
+  "dd_object": {
+    "name": "t1", "schema_ref": "test",
+    "se_private_data": "autoinc=0;version=0;id=1066;",
+    "columns": [
+      {"name": "id", "type": 4, "is_nullable": false, "is_unsigned": false,
+       "hidden": 1, "ordinal_position": 1, "char_length": 11,
+       "column_type_utf8": "int", "collation_id": 255},
+      {"name": "name", "type": 16, "is_nullable": true, "hidden": 1,
+       "ordinal_position": 2, "char_length": 400,
+       "column_type_utf8": "varchar(100)", "collation_id": 255,
+       "comment": "the \"full\" name é"},
+      {"name": "DB_TRX_ID", "type": 10, "is_nullable": false, "hidden": 2,
+       "ordinal_position": 3, "char_length": 6},
+      {"name": "DB_ROLL_PTR", "type": 9, "is_nullable": false, "hidden": 2,
+       "ordinal_position": 4, "char_length": 7}
+    ],
+    "indexes": [
+      {"name": "PRIMARY", "type": 1,
+       "se_private_data": "id=150;root=5;space_id=7;table_id=1066;",
+       "elements": [
+         {"ordinal_position": 1, "length": 4, "hidden": false,
+          "column_opx": 0},
+         {"ordinal_position": 2, "length": 4294967295, "hidden": true,
+          "column_opx": 2},
+         {"ordinal_position": 3, "length": 4294967295, "hidden": true,
+          "column_opx": 3},
+         {"ordinal_position": 4, "length": 4294967295, "hidden": true,
+          "column_opx": 1}
+       ]}
+    ]
+  }
+})sdi";
+
+const char *SPACE_SDI = R"({"dd_object_type": "Tablespace",
+  "dd_object": {"name": "test/t1",
+                "files": [{"filename": "./test/t1.ibd"}]}})";
+
+/// page 3 is the SDI root, page 4 a SDI BLOB page, page 5 the root of t1
+test_util::SpaceBuilder sdi_space(uint64_t sdi_lsn) {
+  test_util::SpaceBuilder builder(6, 7);
+  builder.init_fsp_header_page();
+  builder.init_sdi(
+      3,
+      {builder.sdi_record(SdiReader::SDI_TYPE_TABLE, 1066, T1_SDI, 4),
+       builder.sdi_record(SdiReader::SDI_TYPE_TABLESPACE, 7, SPACE_SDI)},
+      sdi_lsn);
+
+  std::vector<TestRecord> rows;
+  for (int32_t id = 1; id <= 3; ++id) {
+    TestRecord r;
+    std::string key = encode_int(id, 4, false);
+    r.data_.assign(key.begin(), key.end());
+    r.data_.resize(key.size() + IndexDef::DATA_TRX_ID_LEN +
+                   IndexDef::DATA_ROLL_PTR_LEN);
+    std::string name = "name" + std::to_string(id);
+    r.data_.insert(r.data_.end(), name.begin(), name.end());
+    r.extra_ = {(unsigned char)name.size(), 0};
+    rows.push_back(r);
+  }
+  builder.init_index_page(5, 150, 0, rows);
+  return builder;
+}
+
+} // namespace
+
+TEST(sdi, json) {
+  JsonValue v;
+  std::string err;
+  ASSERT_TRUE(parse_json(
+      R"({"a": [1, -2, 3.5, true, null], "b": {"c": "x\nyé"},
+          "big": 18446744073709551615})",
+      v, &err))
+      << err;
+  const JsonValue *a = v.get("a");
+  ASSERT_TRUE(a && a->is_array());
+  ASSERT_EQ(5u, a->arr_.size());
+  EXPECT_EQ(-2, a->arr_[1].int_);
+  EXPECT_DOUBLE_EQ(3.5, a->arr_[2].num_);
+  EXPECT_TRUE(a->arr_[3].bool_);
+  EXPECT_TRUE(a->arr_[4].is_null());
+  EXPECT_EQ("x\ny\xc3\xa9", v.get("b")->get_str("c"));
+  EXPECT_EQ(UINT64_MAX, (uint64_t)v.get_int("big"));
+  EXPECT_EQ(42, v.get_int("missing", 42));
+  EXPECT_FALSE(parse_json(R"({"a": [1, 2})", v, &err));
+  EXPECT_FALSE(parse_json(R"({"a": 1} x)", v));
+  EXPECT_FALSE(parse_json(R"("unterminated)", v));
+}
+
+TEST(sdi, read_space) {
+  EXPECT_EQ(10505u, SdiReader::sdi_offset(16384));
+  auto builder = sdi_space(1000);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+
+  SdiCache cache;
+  FileSpaceReader reader(file.c_str());
+  SdiReader sdi(&reader, &cache);
+  std::vector<SdiRecord> records;
+  uint64_t lsn = 0;
+  ASSERT_TRUE(sdi.read_records(records, &lsn));
+  EXPECT_EQ(1000u, lsn);
+  ASSERT_EQ(2u, records.size());
+  EXPECT_EQ(SdiReader::SDI_TYPE_TABLE, records[0].type_);
+  EXPECT_EQ(1066u, records[0].id_);
+  EXPECT_EQ(T1_SDI, records[0].json_); // from the SDI BLOB page
+  EXPECT_EQ(SPACE_SDI, records[1].json_);
+
+  auto space = sdi.space();
+  ASSERT_TRUE(space);
+  EXPECT_EQ(7u, space->space_id_);
+  EXPECT_EQ("test/t1", space->tablespace_name_);
+  const SdiTable *t1 = space->find_table("t1");
+  ASSERT_TRUE(t1);
+  EXPECT_EQ("test", t1->schema_name_);
+  EXPECT_EQ(1066u, t1->table_id_);
+  ASSERT_EQ(4u, t1->columns_.size());
+  EXPECT_EQ(SdiColumn::VARCHAR, t1->columns_[1].type_);
+  EXPECT_TRUE(t1->columns_[1].nullable_);
+  const SdiIndex *primary = t1->primary();
+  ASSERT_TRUE(primary);
+  EXPECT_EQ(150u, primary->id_);
+  EXPECT_EQ(5u, primary->root_page_no_);
+
+  // the dictionary decodes the rows of the table
+  TableSchema schema;
+  ASSERT_TRUE(t1->table_schema(schema));
+  ASSERT_EQ(4u, schema.columns_.size());
+  EXPECT_EQ(1u, schema.n_pk_);
+  EXPECT_EQ(ColumnType::TRX_ID, schema.columns_[1].type_);
+  EXPECT_EQ(ColumnType::VARBINARY, schema.columns_[3].type_);
+  BatchDecoder decoder(schema);
+  ColumnBatch batch = decoder.make_batch();
+  auto root = reader.fetch_page(primary->root_page_no_);
+  ASSERT_EQ(3, decoder.decode_page(root.as<IndexPageView>(), batch));
+  EXPECT_EQ(2, batch.columns_[0].ints_[1]);
+  EXPECT_EQ("name3", batch.columns_[batch.find("name")].str(2));
+
+  // parsed once, then from the cache until the SDI pages change
+  EXPECT_EQ(1u, cache.misses());
+  FileSpaceReader reopened(file.c_str());
+  EXPECT_EQ(space, SdiReader(&reopened, &cache).space());
+  EXPECT_EQ(1u, cache.hits());
+  unlink(file.c_str());
+
+  file = sdi_space(2000).write_file();
+  FileSpaceReader changed(file.c_str());
+  auto reparsed = SdiReader(&changed, &cache).space();
+  ASSERT_TRUE(reparsed);
+  EXPECT_NE(space, reparsed);
+  EXPECT_EQ(2000u, reparsed->lsn_);
+  EXPECT_EQ(2u, cache.misses());
+  unlink(file.c_str());
+}
@@ -0,0 +1,58 @@
+#include "space_summary.h"
+#include "test_util.h"
+#include "gtest/gtest.h"
+#include <fstream>
+
+using namespace innodb;
+using test_util::mach_write_to_8;
+
+TEST(space_summary, of_file) {
+  test_util::SpaceBuilder builder(12);
+  builder.init_fsp_header_page();
+  mach_write_to_8(builder.page(0) + FILHeader::FIL_PAGE_LSN, 500);
+  memset(builder.page(2), 0, PAGE_SIZE);
+  memset(builder.page(10), 0, PAGE_SIZE);
+  builder.init_index_page(3, 100, 1, {});
+  for (uint32_t i = 4; i < 7; ++i)
+    builder.init_index_page(i, 100, 0, {});
+  builder.init_index_page(7, 200, 0, {});
+  builder.init_index_page(8, 100, 300, {});
+  for (uint32_t i = 3; i < 9; ++i)
+    mach_write_to_8(builder.page(i) + FILHeader::FIL_PAGE_LSN, 600 + i * 50);
+  auto file = builder.write_file();
+  ASSERT_FALSE(file.empty());
+  {
+    std::ofstream out(file, std::ios::binary | std::ios::app);
+    out << std::string(100, 'x');
+  }
+
+  // 4 pages a read, the last one is short
+  auto s = SpaceSummary::of_file(file, 4 * PAGE_SIZE);
+  ASSERT_TRUE(s.valid_);
+  EXPECT_EQ(1u, s.space_id_);
+  EXPECT_EQ(PAGE_SIZE, s.page_size_);
+  EXPECT_EQ(12u, s.n_pages_);
+  EXPECT_EQ(100u, s.tail_bytes_);
+  EXPECT_EQ(2u, s.zero_pages_);
+  EXPECT_EQ(1u, s.pages_by_type_[FIL_PAGE_TYPE_FSP_HDR]);
+  EXPECT_EQ(3u, s.pages_by_type_[FIL_PAGE_TYPE_ALOCATED]);
+  EXPECT_EQ(6u, s.pages_by_type_[FIL_PAGE_INDEX]);
+  EXPECT_EQ(500u, s.min_lsn_);
+  EXPECT_EQ(1000u, s.max_lsn_);
+  ASSERT_EQ(2u, s.indexes_.size());
+  EXPECT_EQ(5u, s.indexes_[100].n_pages_);
+  EXPECT_EQ((std::vector<uint64_t>{3, 1}), s.indexes_[100].pages_per_level_);
+  EXPECT_EQ(1u, s.indexes_[200].n_pages_);
+  EXPECT_EQ(1u, s.bad_level_pages_);
+
+  // the default chunk holds the whole file
+  auto whole = SpaceSummary::of_file(file);
+  EXPECT_EQ(s.n_pages_, whole.n_pages_);
+  EXPECT_EQ(s.pages_by_type_, whole.pages_by_type_);
+  std::ostringstream oss;
+  whole.dump(oss);
+  EXPECT_NE(std::string::npos, oss.str().find("index 200: pages: 1"));
+
+  EXPECT_FALSE(SpaceSummary::of_file(file + ".missing").valid_);
+  unlink(file.c_str());
+}
@@ -0,0 +1,355 @@
+#pragma once
+#include "defines.h"
+#include "headers.h"
+#include "index_def.h"
+#include "lob.h"
+#include "sdi.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+namespace test_util {
+
+static inline void mach_write_to_1(unsigned char *b, uint8_t v) { b[0] = v; }
+
+static inline void mach_write_to_2(unsigned char *b, uint16_t v) {
+  b[0] = (unsigned char)(v >> 8);
+  b[1] = (unsigned char)v;
+}
+
+static inline void mach_write_to_4(unsigned char *b, uint32_t v) {
+  b[0] = (unsigned char)(v >> 24);
+  b[1] = (unsigned char)(v >> 16);
+  b[2] = (unsigned char)(v >> 8);
+  b[3] = (unsigned char)v;
+}
+
+static inline void mach_write_to_8(unsigned char *b, uint64_t v) {
+  mach_write_to_4(b, (uint32_t)(v >> 32));
+  mach_write_to_4(b + 4, (uint32_t)v);
+}
+
+/// @brief run f(name) once with every kernel set of a KernelTable the cpu
+/// supports, picked by its set_*_impl, then restore the one picked before
+/// @return the kernel sets run, the scalar one at least
+template <typename F>
+uint32_t for_each_impl(const char *(*current)(),
+                       bool (*select)(const std::string &), F f) {
+  const std::string picked = current();
+  uint32_t n = 0;
+  for (const char *name : {"avx512", "avx2", "scalar"}) {
+    if (!select(name))
+      continue;
+    ++n;
+    f(name);
+  }
+  select(picked);
+  return n;
+}
+
+/// @brief a compact record to put on an index page
+struct TestRecord {
+  /// the bytes before the 5 byte header in disk order, i.e. the variable
+  /// field lengths reversed then the null bitmap
+  std::vector<unsigned char> extra_;
+  std::vector<unsigned char> data_; // the fields from the origin on
+  uint8_t info_bits_ = 0;
+  uint8_t status_ = innodb::REC_STATUS_ORDINARY;
+};
+
+/// @brief in memory tablespace, written into a temp file for the reader
+struct SpaceBuilder {
+  std::vector<unsigned char> data_;
+  uint32_t space_id_;
+  uint32_t page_size_;
+
+  SpaceBuilder(uint32_t n_pages, uint32_t space_id = 1,
+               uint32_t page_size = PAGE_SIZE)
+      : data_((size_t)n_pages * page_size, 0), space_id_(space_id),
+        page_size_(page_size) {
+    for (uint32_t i = 0; i < n_pages; ++i) {
+      init_fil_header(i, innodb::FIL_PAGE_TYPE_ALOCATED);
+    }
+  }
+
+  uint32_t n_pages() const { return data_.size() / page_size_; }
+
+  unsigned char *page(uint32_t page_no) {
+    return data_.data() + (size_t)page_no * page_size_;
+  }
+
+  void init_fil_header(uint32_t page_no, uint16_t page_type,
+                       uint64_t lsn = 0) {
+    using innodb::FILHeader;
+    unsigned char *pg = page(page_no);
+    mach_write_to_4(pg + FILHeader::FIL_PAGE_OFFSET, page_no);
+    mach_write_to_4(pg + FILHeader::FIL_PAGE_PREV, UINT32_MAX);
+    mach_write_to_4(pg + FILHeader::FIL_PAGE_NEXT, UINT32_MAX);
+    mach_write_to_8(pg + FILHeader::FIL_PAGE_LSN, lsn);
+    mach_write_to_2(pg + FILHeader::FIL_PAGE_TYPE, page_type);
+    mach_write_to_4(pg + FILHeader::FIL_PAGE_SPACE_ID, space_id_);
+    mach_write_to_4(pg + page_size_ - 4, (uint32_t)lsn);
+  }
+
+  /// @brief page 0 with an empty fsp header, all lists empty
+  void init_fsp_header_page() {
+    using innodb::FSPHeader;
+    init_fil_header(0, innodb::FIL_PAGE_TYPE_FSP_HDR);
+    unsigned char *h = page(0) + FSPHeader::FSP_HEADER_OFFSET;
+    mach_write_to_4(h + FSPHeader::FSP_SPACE_ID, space_id_);
+    mach_write_to_4(h + FSPHeader::FSP_SIZE, n_pages());
+    mach_write_to_4(h + FSPHeader::FSP_FREE_LIMIT, n_pages());
+    // ssize is 0 for 16K pages, log2(page_size / 512) otherwise
+    uint32_t ssize = 0;
+    if (page_size_ != 16384) {
+      while ((512U << ssize) < page_size_)
+        ++ssize;
+    }
+    mach_write_to_4(h + FSPHeader::FSP_SPACE_FLAGS,
+                    ssize << FSPHeader::FSP_FLAGS_POS_PAGE_SSIZE);
+    for (auto off : {FSPHeader::FSP_FREE_LIST_BASE_NODE,
+                     FSPHeader::FSP_FREE_FRAG_LIST_BASE_NODE,
+                     FSPHeader::FSP_FULL_FRAG_LIST_BASE_NODE,
+                     FSPHeader::FSP_FULL_INODES_LIST_BASE_NODE,
+                     FSPHeader::FSP_FREE_INODES_LIST_BASE_NODE}) {
+      init_empty_list(h + off);
+    }
+  }
+
+  static void init_empty_list(unsigned char *base) {
+    mach_write_to_4(base, 0);
+    mach_write_to_4(base + 4, UINT32_MAX);
+    mach_write_to_2(base + 8, 0);
+    mach_write_to_4(base + 10, UINT32_MAX);
+    mach_write_to_2(base + 14, 0);
+  }
+
+  static void write_addr(unsigned char *p, uint32_t page_no, uint16_t offset) {
+    mach_write_to_4(p, page_no);
+    mach_write_to_2(p + 4, offset);
+  }
+
+  /// @brief address of the xdes entry describing the extent
+  innodb::Addr xdes_addr(uint32_t extent) const {
+    using innodb::XDES_E;
+    uint32_t per_xdes_page = XDES_E::entries_per_page(page_size_);
+    return innodb::Addr((extent / per_xdes_page) * page_size_,
+                        XDES_E::XDES_ARR_OFFSET +
+                            (extent % per_xdes_page) *
+                                XDES_E::entry_size(page_size_));
+  }
+
+  /// @brief link the xdes entries of the extents into a list hanging off
+  /// base, the page bitmaps are all set to free and clean
+  void init_xdes_list(unsigned char *base, const std::vector<uint32_t> &extents,
+                      uint64_t seg_id, uint32_t state) {
+    using innodb::XDES_E;
+    init_empty_list(base);
+    if (extents.empty())
+      return;
+    mach_write_to_4(base, extents.size());
+    auto first = xdes_addr(extents.front());
+    auto last = xdes_addr(extents.back());
+    write_addr(base + 4, first.page_number_, first.offset_);
+    write_addr(base + 10, last.page_number_, last.offset_);
+    for (size_t i = 0; i < extents.size(); ++i) {
+      auto addr = xdes_addr(extents[i]);
+      unsigned char *e = page(addr.page_number_) + addr.offset_;
+      mach_write_to_8(e, seg_id);
+      if (i > 0) {
+        auto prev = xdes_addr(extents[i - 1]);
+        write_addr(e + 8, prev.page_number_, prev.offset_);
+      } else {
+        write_addr(e + 8, UINT32_MAX, 0);
+      }
+      if (i + 1 < extents.size()) {
+        auto next = xdes_addr(extents[i + 1]);
+        write_addr(e + 14, next.page_number_, next.offset_);
+      } else {
+        write_addr(e + 14, UINT32_MAX, 0);
+      }
+      mach_write_to_4(e + 20, state);
+      memset(e + XDES_E::XDES_BITMAP, 0xff,
+             XDES_E::entry_size(page_size_) - XDES_E::XDES_BITMAP);
+    }
+  }
+
+  static void write_rec_header(unsigned char *origin, uint8_t info_bits,
+                               uint8_t n_owned, uint16_t heap_no,
+                               uint8_t status) {
+    origin[-5] = (unsigned char)(info_bits | n_owned);
+    mach_write_to_2(origin - 4, (uint16_t)(heap_no << 3 | status));
+  }
+
+  /// @brief a compact index page holding the records in the given order,
+  /// the directory has a slot every 4 records
+  /// @return the offsets of the record origins
+  std::vector<uint16_t> init_index_page(uint32_t page_no, uint64_t index_id,
+                                        uint16_t level,
+                                        const std::vector<TestRecord> &recs,
+                                        uint32_t prev = UINT32_MAX,
+                                        uint32_t next = UINT32_MAX) {
+    using namespace innodb;
+    init_fil_header(page_no, FIL_PAGE_INDEX);
+    unsigned char *pg = page(page_no);
+    mach_write_to_4(pg + FILHeader::FIL_PAGE_PREV, prev);
+    mach_write_to_4(pg + FILHeader::FIL_PAGE_NEXT, next);
+    // infimum and supremum
+    write_rec_header(pg + PAGE_NEW_INFIMUM, 0, 1, 0, REC_STATUS_INFIMUM);
+    memcpy(pg + PAGE_NEW_INFIMUM, "infimum", 8);
+    memcpy(pg + PAGE_NEW_SUPREMUM, "supremum", 8);
+
+    std::vector<uint16_t> offsets;
+    uint16_t heap_top = PAGE_NEW_SUPREMUM_END;
+    for (size_t i = 0; i < recs.size(); ++i) {
+      const auto &r = recs[i];
+      // memcpy mustn't be given the null data() of an empty vector
+      std::copy(r.extra_.begin(), r.extra_.end(), pg + heap_top);
+      uint16_t origin = heap_top + r.extra_.size() + REC_N_EXTRA_BYTES;
+      std::copy(r.data_.begin(), r.data_.end(), pg + origin);
+      write_rec_header(pg + origin, r.info_bits_, 0, i + 2, r.status_);
+      offsets.push_back(origin);
+      heap_top = origin + r.data_.size();
+    }
+    // chain the records
+    uint16_t prev_rec = PAGE_NEW_INFIMUM;
+    for (auto off : offsets) {
+      mach_write_to_2(pg + prev_rec - 2, (uint16_t)(off - prev_rec));
+      prev_rec = off;
+    }
+    mach_write_to_2(pg + prev_rec - 2, (uint16_t)(PAGE_NEW_SUPREMUM - prev_rec));
+    mach_write_to_2(pg + PAGE_NEW_SUPREMUM - 2, 0);
+
+    // the directory, the infimum owns itself, the last slot the supremum
+    std::vector<uint16_t> slots{(uint16_t)PAGE_NEW_INFIMUM};
+    size_t n_full = recs.size() / 4;
+    for (size_t i = 0; i < n_full; ++i) {
+      uint16_t owner = offsets[i * 4 + 3];
+      pg[owner - 5] |= 4;
+      slots.push_back(owner);
+    }
+    uint8_t sup_owned = recs.size() - n_full * 4 + 1;
+    write_rec_header(pg + PAGE_NEW_SUPREMUM, 0, sup_owned, 1,
+                     REC_STATUS_SUPREMUM);
+    slots.push_back(PAGE_NEW_SUPREMUM);
+    for (size_t i = 0; i < slots.size(); ++i)
+      mach_write_to_2(pg + page_size_ - 8 - (i + 1) * 2, slots[i]);
+
+    unsigned char *h = pg + IndexHeader::PAGE_HEADER;
+    mach_write_to_2(h + IndexHeader::PAGE_N_DIR_SLOTS, slots.size());
+    mach_write_to_2(h + IndexHeader::PAGE_HEAP_TOP, heap_top);
+    mach_write_to_2(h + IndexHeader::PAGE_N_HEAP,
+                    (uint16_t)(0x8000 | (recs.size() + 2)));
+    mach_write_to_2(h + IndexHeader::PAGE_N_RECS, recs.size());
+    mach_write_to_2(h + IndexHeader::PAGE_LEVEL, level);
+    mach_write_to_8(h + IndexHeader::PAGE_INDEX_ID, index_id);
+    return offsets;
+  }
+
+  /// @brief a record of the SDI index holding the zlib compressed json
+  /// @param blob_page keep the data off page on this SDI BLOB page,
+  /// UINT32_MAX to keep it in the record
+  TestRecord sdi_record(uint32_t type, uint64_t id, const std::string &json,
+                        uint32_t blob_page = UINT32_MAX) {
+    using namespace innodb;
+    TestRecord r;
+    auto append = [&](const std::string &s) {
+      r.data_.insert(r.data_.end(), s.begin(), s.end());
+    };
+    uLongf zipped_len = compressBound(json.size());
+    std::string zipped(zipped_len, '\0');
+    compress((Bytef *)&zipped[0], &zipped_len, (const Bytef *)json.data(),
+             json.size());
+    zipped.resize(zipped_len);
+    append(encode_int(type, 4, true));
+    append(encode_int(id, 8, true));
+    r.data_.resize(r.data_.size() + IndexDef::DATA_TRX_ID_LEN +
+                   IndexDef::DATA_ROLL_PTR_LEN);
+    append(encode_int(json.size(), 4, true));
+    append(encode_int(zipped.size(), 4, true));
+    if (blob_page == UINT32_MAX) {
+      append(zipped);
+      r.extra_ = {(unsigned char)(zipped.size() & 0xff),
+                  (unsigned char)(0x80 | zipped.size() >> 8)};
+      return r;
+    }
+    // the first 10 bytes stay local then the reference
+    const uint32_t local = 10;
+    const uint32_t blob_len = zipped.size() - local;
+    append(zipped.substr(0, local));
+    unsigned char ref[LobRef::BTR_EXTERN_FIELD_REF_SIZE] = {};
+    mach_write_to_4(ref, space_id_);
+    mach_write_to_4(ref + LobRef::BTR_EXTERN_PAGE_NO, blob_page);
+    mach_write_to_4(ref + LobRef::BTR_EXTERN_OFFSET,
+                    FILHeader::FIL_PAGE_DATA);
+    mach_write_to_8(ref + LobRef::BTR_EXTERN_LEN, blob_len);
+    r.data_.insert(r.data_.end(), ref, ref + sizeof(ref));
+    uint32_t len = local + sizeof(ref);
+    r.extra_ = {(unsigned char)(len & 0xff), (unsigned char)(0xc0 | len >> 8)};
+
+    init_fil_header(blob_page, FIL_PAGE_SDI_BLOB);
+    unsigned char *hdr = page(blob_page) + FILHeader::FIL_PAGE_DATA;
+    mach_write_to_4(hdr + BlobPage::BTR_BLOB_HDR_PART_LEN, blob_len);
+    mach_write_to_4(hdr + BlobPage::BTR_BLOB_HDR_NEXT_PAGE_NO, UINT32_MAX);
+    memcpy(hdr + BlobPage::BTR_BLOB_HDR_SIZE, zipped.data() + local,
+           blob_len);
+    return r;
+  }
+
+  /// @brief the SDI index of a single leaf, page 0 points to it, call after
+  /// init_fsp_header_page
+  void init_sdi(uint32_t root, const std::vector<TestRecord> &recs,
+                uint64_t lsn = 0) {
+    using namespace innodb;
+    unsigned char *sdi = page(0) + SdiReader::sdi_offset(page_size_);
+    mach_write_to_4(sdi, SdiReader::SDI_VERSION);
+    mach_write_to_4(sdi + 4, root);
+    init_index_page(root, 0, 0, recs);
+    mach_write_to_2(page(root) + FILHeader::FIL_PAGE_TYPE, FIL_PAGE_TYPE_SDI);
+    mach_write_to_8(page(root) + FILHeader::FIL_PAGE_LSN, lsn);
+  }
+
+  /// @brief write the space into the file, created or truncated
+  /// @return false on error
+  bool write_file(const std::string &name) const {
+    int fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return false;
+    bool ok = write_fd(fd);
+    ::close(fd);
+    return ok;
+  }
+
+  /// @brief write the space into a temp file
+  /// @return the file name, empty on error
+  std::string write_file() const {
+    char name[] = "/tmp/view_ibd_test_XXXXXX";
+    int fd = mkstemp(name);
+    if (fd < 0)
+      return "";
+    bool ok = write_fd(fd);
+    ::close(fd);
+    return ok ? name : "";
+  }
+
+private:
+  bool write_fd(int fd) const {
+    size_t left = data_.size();
+    const unsigned char *p = data_.data();
+    while (left > 0) {
+      auto n = ::write(fd, p, left);
+      if (n <= 0)
+        return false;
+      left -= n;
+      p += n;
+    }
+    return true;
+  }
+};
+
+} // namespace test_util